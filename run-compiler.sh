@@ -6,10 +6,14 @@ dir=`pwd`
 mkdir -p tmp
 
 TARGET="touchpad"
+THREADS=${THREADS:-4}
 
 scp shaders/*.fs shaders/*.vs $TARGET:$dir/shaders
+scp shaders-gles3/* $TARGET:$dir/shaders-gles3
+# compile the whole corpus in one go, capturing the program binaries
+# in compiler.rd (see BATCH in test-compiler.c).  For cmdstream captures
+# of the individual shaders use "run-tests.sh test-compiler" instead.
 # note: the android linked binaries give bogus return values, so ignore the result of
 # running test-compiler
-ssh $TARGET "(cd $dir ; LD_PRELOAD=$dir/libwrap.so ./test-compiler ; ./run-cffdump.sh compiler*.rd)"
-scp $TARGET:$dir/compiler-\*-pgmdump.txt ./tmp
-
+ssh $TARGET "(cd $dir ; BATCH=compiler.rd THREADS=$THREADS ./test-compiler > compiler.log ; ./pgmdump compiler.rd > compiler-pgmdump.txt ; ./pgmdump --json compiler.rd > compiler.json)"
+scp $TARGET:$dir/compiler.log $TARGET:$dir/compiler.rd.idx $TARGET:$dir/compiler-pgmdump.txt $TARGET:$dir/compiler.json ./tmp
@@ -1,20 +1,148 @@
 #!/bin/sh
+#
+# Run the test-* programs under libwrap to capture .rd files.
+#
+# usage: run-tests.sh [-j jobs] [-o outdir] [-f] [test-name...]
+#
+#   -j jobs    number of tests to run concurrently (default: # of cpus)
+#   -o outdir  where to collect the compressed .rd's and logs (default:
+#              captures)
+#   -f         re-run tests even if their inputs haven't changed
+#
+# The number of tests in each program using TEST_END() is queried up
+# front (TESTCOUNT env variable), other programs are run once as a single
+# test.  Each TESTNUM is run as a separate job, in its own scratch
+# directory so concurrent jobs don't step on each other's files, with
+# the contents of the test directory (shaders/, replay.txt, etc) linked
+# into it.  The resulting .rd's are gzip'd (cffdump reads them as-is),
+# replacing the ones from the previous run of the same job.  A job is
+# skipped if the hash of the test binary, the wrapper lib, the test
+# number and the WRAP_* env variables matches the one recorded the last
+# time it was run.
+#
+# If there is no real gpu (/dev/kgsl-3d0), libwrapfake.so is used.
 
-#LD_PRELOAD=`pwd`/libwrap.so ./test-quad-flat > test-quad-flat.log
-
-for f in test-*; do
-	if [ -x $f ]; then
-		echo "Running: $f"
-		i=0
-		while `true`; do
-			echo "Running: $f ($i)"
-			TESTNAME=${f#test-} TESTNUM=$i LD_PRELOAD=`pwd`/libwrap.so ./$f > $f.$i.log
-			if [ "$?" = "42" ]; then
-				break;
-			fi
-			sync
-			i=$((i+1))
-		done
+dir=`cd \`dirname $0\`; pwd`
+
+# internal: run a single test number, called via xargs:
+if [ "$1" = "--run-one" ]; then
+	test=$2
+	num=$3
+	key=$4
+	out=$5
+	wrap=$6
+
+	name=$test-$num
+	if [ -z "$FORCE" ] && [ -f $out/$name.key ] && \
+			[ "`cat $out/$name.key`" = "$key" ]; then
+		echo "Skipping: $test ($num), unchanged"
+		exit 0
+	fi
+
+	echo "Running: $test ($num)"
+	tmp=`mktemp -d $out/.$name.XXXXXX`
+
+	# tests read their inputs relative to the working directory.  Old
+	# captures are not linked, so the test doesn't write through them:
+	for f in $dir/*; do
+		case $f in
+		*.rd) ;;
+		*) ln -s $f $tmp/ ;;
+		esac
+	done
+
+	(cd $tmp; TESTNAME=${test#test-} TESTNUM=$num LD_PRELOAD=$wrap \
+			$dir/$test > $out/$test.$num.log 2>&1)
+	ret=$?
+
+	# remove the captures of the previous run:
+	rm -f $out/$name.key
+	if [ -f $out/$name.files ]; then
+		(cd $out; rm -f `cat $name.files`)
+		rm -f $out/$name.files
+	fi
+
+	found=""
+	for f in $tmp/*.rd; do
+		if [ -f $f ] && [ ! -h $f ]; then
+			gzip -c $f > $out/`basename $f`.gz
+			echo `basename $f`.gz >> $out/$name.files
+			found=1
+		fi
+	done
+	rm -rf $tmp
+
+	# only remember tests which actually produced a capture, so failed
+	# runs get retried next time:
+	if [ -n "$found" ]; then
+		echo $key > $out/$name.key
+	else
+		echo "Failed: $test ($num), exit code $ret, see $out/$test.$num.log"
 	fi
+	exit 0
+fi
+
+jobs=`nproc 2>/dev/null || echo 4`
+out=captures
+FORCE=""
+
+while getopts "j:o:f" opt; do
+	case $opt in
+	j) jobs=$OPTARG ;;
+	o) out=$OPTARG ;;
+	f) FORCE=1 ;;
+	*) echo "usage: $0 [-j jobs] [-o outdir] [-f] [test-name...]"; exit 1 ;;
+	esac
 done
+shift $((OPTIND - 1))
+export FORCE
+
+mkdir -p $out
+out=`cd $out; pwd`
+
+wrap=$dir/libwrap.so
+if [ ! -e /dev/kgsl-3d0 ] && [ -e $dir/libwrapfake.so ]; then
+	echo "No gpu found, using libwrapfake.so"
+	wrap=$dir/libwrapfake.so
+fi
+
+tests="$*"
+if [ -z "$tests" ]; then
+	tests=`cd $dir; ls test-* | grep -v '\.'`
+fi
+
+wrapenv=`env | grep '^WRAP_' | sort`
+
+# build the job list, one line per test number:
+for f in $tests; do
+	f=`basename $f`
+	if [ ! -x $dir/$f ]; then
+		continue
+	fi
+
+	# programs not using TEST_END() would run all the way through when
+	# probed, they only have a single test:
+	count=""
+	if grep -q "TESTCOUNT" $dir/$f; then
+		count=`cd $dir; TESTCOUNT=1 ./$f 2>/dev/null | sed -n 's/^TESTCOUNT: //p'`
+	fi
+	if [ -z "$count" ]; then
+		count=1
+	fi
+
+	# test-compiler also depends on the shader sources:
+	inputs="$dir/$f $wrap"
+	if [ $f = "test-compiler" ]; then
+		inputs="$inputs `ls $dir/shaders/* $dir/shaders-gles3/* 2>/dev/null`"
+	fi
+	hash=`cat $inputs | sha1sum | cut -d' ' -f1`
+
+	i=0
+	while [ $i -lt $count ]; do
+		key=`echo "$hash $i $wrapenv" | sha1sum | cut -d' ' -f1`
+		echo "$f $i $key"
+		i=$((i + 1))
+	done
+done | xargs -n 3 -P $jobs sh -c "$dir/run-tests.sh --run-one \$0 \$1 \$2 $out $wrap"
 
+sync
@@ -22,6 +22,11 @@
  */
 
 #include <GLES3/gl31.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
 #include "test-util-3d.h"
 
 int openfile(const char *fmt, int i)
@@ -231,6 +236,343 @@ int test_compiler(int n)
 	return 0;
 }
 
+/* ************************************************************************* */
+/* batch mode: with BATCH=<file.rd> set, the whole shader corpus (shaders/
+ * and shaders-gles3/) is compiled and linked in a single process, without
+ * drawing, and the program binaries (GL_PROGRAM_BINARY) are written along
+ * with their source to <file.rd>, in the rd format pgmdump understands.
+ * A text index (<file.rd>.idx) records the file offset and size of each
+ * program's sections, plus the compile and link times.
+ *
+ * With THREADS=<n>, the corpus is split between n threads, each with its
+ * own context.  Results are written out in corpus order once all threads
+ * are done, so the output doesn't depend on the number of threads.
+ */
+
+static const char *corpus_dirs[] = {
+		"shaders", "shaders-gles3",
+};
+
+static const struct {
+	const char *ext;
+	GLenum type;
+	enum rd_sect_type sect;
+} stages[] = {
+		{ "vs",  GL_VERTEX_SHADER, RD_VERT_SHADER },
+		{ "tcs", 0x8E88/*GL_TESS_CONTROL_SHADER*/, RD_TESS_CTRL_SHADER },
+		{ "tes", 0x8E87/*GL_TESS_EVALUATION_SHADER*/, RD_TESS_EVAL_SHADER },
+		{ "gs",  0x8DD9/*GL_GEOMETRY_SHADER*/, RD_GEOM_SHADER },
+		{ "fs",  GL_FRAGMENT_SHADER, RD_FRAG_SHADER },
+};
+#define VS 0
+#define FS (ARRAY_SIZE(stages) - 1)
+
+struct batch_entry {
+	char name[64];
+	char *src[ARRAY_SIZE(stages)];
+	uint64_t compile_ns, link_ns;
+	GLint binary_len;
+	GLenum binary_format;
+	void *binary;
+	char *log;             /* compile/link error log, if failed */
+};
+
+static struct batch_entry *entries;
+static int nentries, next_entry;
+static pthread_mutex_t entry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static EGLConfig config;
+
+static char *readfile(const char *dir, int n, const char *ext)
+{
+	char path[256], *buf;
+	struct stat st;
+	int fd, ret;
+
+	snprintf(path, sizeof(path), "%s/%04d.%s", dir, n, ext);
+	fd = open(path, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || !(buf = malloc(st.st_size + 1))) {
+		close(fd);
+		return NULL;
+	}
+
+	ret = read(fd, buf, st.st_size);
+	close(fd);
+	if (ret < 0) {
+		free(buf);
+		return NULL;
+	}
+	buf[ret] = '\0';
+
+	return buf;
+}
+
+/* corpus entries are numbered from 0000, up to the first missing vs/fs: */
+static void load_corpus(void)
+{
+	int d, n, max = 0;
+
+	for (d = 0; d < ARRAY_SIZE(corpus_dirs); d++) {
+		for (n = 0; ; n++) {
+			struct batch_entry *e;
+			char *vs, *fs;
+			int i;
+
+			vs = readfile(corpus_dirs[d], n, stages[VS].ext);
+			fs = readfile(corpus_dirs[d], n, stages[FS].ext);
+			if (!vs || !fs) {
+				free(vs);
+				free(fs);
+				break;
+			}
+
+			if (nentries == max) {
+				max = max ? max * 2 : 64;
+				entries = realloc(entries, max * sizeof(*entries));
+			}
+
+			e = &entries[nentries++];
+			memset(e, 0, sizeof(*e));
+			snprintf(e->name, sizeof(e->name), "%s/%04d", corpus_dirs[d], n);
+			e->src[VS] = vs;
+			e->src[FS] = fs;
+			for (i = VS + 1; i < FS; i++)
+				e->src[i] = readfile(corpus_dirs[d], n, stages[i].ext);
+		}
+	}
+}
+
+static char *get_log(GLuint obj, int program)
+{
+	GLint len = 0;
+	char *log;
+
+	if (program)
+		glGetProgramiv(obj, GL_INFO_LOG_LENGTH, &len);
+	else
+		glGetShaderiv(obj, GL_INFO_LOG_LENGTH, &len);
+
+	log = calloc(1, len + 1);
+	if (program)
+		glGetProgramInfoLog(obj, len, NULL, log);
+	else
+		glGetShaderInfoLog(obj, len, NULL, log);
+
+	return log;
+}
+
+/* called from the worker threads, so use the plain GL calls rather than
+ * GCHK() (which isn't thread safe, and would be counted in the timing):
+ */
+static void batch_compile(struct batch_entry *e)
+{
+	GLuint program, shader;
+	GLint ret;
+	uint64_t t;
+	int i;
+
+	program = glCreateProgram();
+
+	for (i = 0; i < ARRAY_SIZE(stages); i++) {
+		const GLchar *src = e->src[i];
+
+		if (!src)
+			continue;
+
+		t = __bench_ns(CLOCK_MONOTONIC);
+		shader = glCreateShader(stages[i].type);
+		glShaderSource(shader, 1, &src, NULL);
+		glCompileShader(shader);
+		/* querying the status waits for the compile to finish, if the
+		 * driver compiles asynchronously:
+		 */
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &ret);
+		e->compile_ns += __bench_ns(CLOCK_MONOTONIC) - t;
+
+		if (!ret) {
+			e->log = get_log(shader, 0);
+			glDeleteShader(shader);
+			glDeleteProgram(program);
+			return;
+		}
+
+		glAttachShader(program, shader);
+		glDeleteShader(shader);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(attrnames); i++)
+		glBindAttribLocation(program, i, attrnames[i]);
+	/* clear any errors, just in case: */
+	while (glGetError() != GL_NO_ERROR) {}
+
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	t = __bench_ns(CLOCK_MONOTONIC);
+	glLinkProgram(program);
+	glGetProgramiv(program, GL_LINK_STATUS, &ret);
+	e->link_ns = __bench_ns(CLOCK_MONOTONIC) - t;
+
+	if (!ret) {
+		e->log = get_log(program, 1);
+		glDeleteProgram(program);
+		return;
+	}
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &e->binary_len);
+	if (e->binary_len > 0) {
+		e->binary = calloc(1, e->binary_len);
+		glGetProgramBinary(program, e->binary_len, &e->binary_len,
+				&e->binary_format, e->binary);
+	}
+
+	glDeleteProgram(program);
+}
+
+static void *batch_thread(void *arg)
+{
+	EGLContext context = arg;
+	EGLSurface surface;
+	EGLint pbuffer_attribute_list[] = {
+		EGL_WIDTH, 16,
+		EGL_HEIGHT, 16,
+		EGL_NONE
+	};
+
+	surface = eglCreatePbufferSurface(display, config, pbuffer_attribute_list);
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		ERROR_MSG("eglMakeCurrent failed: 0x%04x", eglGetError());
+		return NULL;
+	}
+
+	while (1) {
+		int n;
+
+		pthread_mutex_lock(&entry_lock);
+		n = next_entry++;
+		pthread_mutex_unlock(&entry_lock);
+
+		if (n >= nentries)
+			break;
+
+		batch_compile(&entries[n]);
+	}
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroySurface(display, surface);
+
+	return NULL;
+}
+
+static void write_section(FILE *f, enum rd_sect_type type,
+		const void *buf, uint32_t sz)
+{
+	uint32_t hdr[2] = { type, sz };
+	fwrite(hdr, sizeof(hdr), 1, f);
+	fwrite(buf, sz, 1, f);
+}
+
+static void batch_write(const char *file)
+{
+	char idxfile[256];
+	const char *renderer;
+	uint64_t compile_ns = 0, link_ns = 0;
+	unsigned gpu_id;
+	FILE *f, *idx;
+	int i, j, failed = 0;
+
+	snprintf(idxfile, sizeof(idxfile), "%s.idx", file);
+
+	f = fopen(file, "w");
+	idx = fopen(idxfile, "w");
+	if (!f || !idx) {
+		ERROR_MSG("could not open %s: %m", f ? idxfile : file);
+		exit(-1);
+	}
+
+	/* so pgmdump picks the right disassembler: */
+	renderer = (const char *)glGetString(GL_RENDERER);
+	if (renderer && (sscanf(renderer, "Adreno (TM) %u", &gpu_id) == 1))
+		write_section(f, RD_GPU_ID, &gpu_id, sizeof(gpu_id));
+
+	fprintf(idx, "# name offset size binary_size binary_format compile_us link_us\n");
+
+	for (i = 0; i < nentries; i++) {
+		struct batch_entry *e = &entries[i];
+		long start = ftell(f);
+
+		if (e->log) {
+			printf("%s: FAILED\n%s\n", e->name, e->log);
+			failed++;
+			continue;
+		}
+
+		printf("%s: compile %.3f ms, link %.3f ms, binary %d bytes\n",
+				e->name, e->compile_ns / 1e6, e->link_ns / 1e6,
+				e->binary_len);
+
+		write_section(f, RD_TEST, e->name, strlen(e->name) + 1);
+		for (j = 0; j < ARRAY_SIZE(stages); j++)
+			if (e->src[j])
+				write_section(f, stages[j].sect, e->src[j],
+						strlen(e->src[j]) + 1);
+		if (e->binary_len > 0)
+			write_section(f, RD_PROGRAM, e->binary, e->binary_len);
+
+		fprintf(idx, "%s %ld %ld %d 0x%04x %"PRIu64" %"PRIu64"\n",
+				e->name, start, ftell(f) - start, e->binary_len,
+				e->binary_format, e->compile_ns / 1000, e->link_ns / 1000);
+
+		compile_ns += e->compile_ns;
+		link_ns += e->link_ns;
+	}
+
+	printf("%d programs (%d failed): compile %.3f ms, link %.3f ms total\n",
+			nentries, failed, compile_ns / 1e6, link_ns / 1e6);
+
+	fclose(idx);
+	fclose(f);
+}
+
+static void batch(const char *file, const EGLint *context_attribute_list)
+{
+	const char *env = getenv("THREADS");
+	int i, nthreads = env ? strtol(env, NULL, 0) : 1;
+	pthread_t *threads;
+	EGLContext *contexts;
+	uint64_t wall;
+
+	if (nthreads < 1)
+		nthreads = 1;
+
+	load_corpus();
+
+	threads = calloc(nthreads, sizeof(*threads));
+	contexts = calloc(nthreads, sizeof(*contexts));
+
+	for (i = 0; i < nthreads; i++) {
+		ECHK(contexts[i] = eglCreateContext(display, config, EGL_NO_CONTEXT,
+				context_attribute_list));
+	}
+
+	wall = __bench_ns(CLOCK_MONOTONIC);
+	for (i = 0; i < nthreads; i++)
+		pthread_create(&threads[i], NULL, batch_thread, contexts[i]);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	wall = __bench_ns(CLOCK_MONOTONIC) - wall;
+
+	batch_write(file);
+
+	printf("compiled in %.3f ms wall time, with %d thread(s)\n",
+			wall / 1e6, nthreads);
+
+	for (i = 0; i < nthreads; i++)
+		ECHK(eglDestroyContext(display, contexts[i]));
+}
+
 int main(int argc, char *argv[])
 {
 	GLint width, height;
@@ -253,11 +595,31 @@ int main(int argc, char *argv[])
 		EGL_CONTEXT_CLIENT_VERSION, 3,
 		EGL_NONE
 	};
-	EGLConfig config;
 	EGLint num_config;
 	EGLContext context;
+	const char *batch_file = getenv("BATCH");
 	TEST_START();
 
+	/* one test per shaders/ pair, relative to the working directory like
+	 * test_compiler(), which run-tests.sh links the test directory into:
+	 */
+	if (__test == -2) {
+		char *vs, *fs;
+		int n;
+
+		for (n = 0; ; n++) {
+			vs = readfile("shaders", n, "vs");
+			fs = readfile("shaders", n, "fs");
+			free(vs);
+			free(fs);
+			if (!vs || !fs)
+				break;
+		}
+
+		printf("TESTCOUNT: %d\n", n);
+		exit(0);
+	}
+
 	display = get_display();
 
 	/* get an appropriate EGL frame buffer configuration */
@@ -277,7 +639,9 @@ int main(int argc, char *argv[])
 	ECHK(eglMakeCurrent(display, surface, surface, context));
 	GCHK(glFlush());
 
-	if (__test == -1) {
+	if (batch_file) {
+		batch(batch_file, context_attribute_list);
+	} else if (__test == -1) {
 		int i;
 		for (i = 0; ; i++) {
 			int ret = 0;
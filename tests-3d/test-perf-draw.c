@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* driver overhead of draw calls, with and without a state change between
+ * each draw.  The size is the number of draws between flushes.
+ */
+
+#include "test-util-3d.h"
+
+static EGLint const config_attribute_list[] = {
+	EGL_RED_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_BLUE_SIZE, 8,
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_DEPTH_SIZE, 8,
+	EGL_NONE
+};
+
+static const EGLint context_attribute_list[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 2,
+	EGL_NONE
+};
+
+static EGLDisplay display;
+static EGLConfig config;
+static EGLint num_config;
+static EGLContext context;
+static EGLSurface surface;
+static GLuint program[2];
+static GLint width, height;
+const char *vertex_shader_source =
+	"attribute vec4 aPosition;    \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_Position = aPosition; \n"
+	"}                            \n";
+const char *fragment_shader_source[] = {
+	"precision highp float;       \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0);\n"
+	"}                            \n",
+
+	"precision highp float;       \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+	"}                            \n",
+};
+
+enum state_change {
+	CHANGE_NONE,
+	CHANGE_BLEND,
+	CHANGE_DEPTH,
+	CHANGE_PROGRAM,
+};
+
+static const char *names[] = {
+	[CHANGE_NONE]    = "draw",
+	[CHANGE_BLEND]   = "draw+blend",
+	[CHANGE_DEPTH]   = "draw+depth",
+	[CHANGE_PROGRAM] = "draw+program",
+};
+
+static const GLenum depth_funcs[] = { GL_LESS, GL_LEQUAL };
+
+void test_perf_draw(enum state_change change, int batch, int ops)
+{
+	static const GLfloat vertices[] = {
+			-0.45, -0.75, 0.0,
+			 0.45, -0.75, 0.0,
+			-0.45,  0.75, 0.0,
+			 0.45,  0.75, 0.0,
+	};
+	int i;
+
+	RD_START("perf-draw", "%s, batch=%d", names[change], batch);
+	display = get_display();
+
+	/* get an appropriate EGL frame buffer configuration */
+	ECHK(eglChooseConfig(display, config_attribute_list, &config, 1, &num_config));
+	DEBUG_MSG("num_config: %d", num_config);
+
+	/* create an EGL rendering context */
+	ECHK(context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribute_list));
+
+	surface = make_window(display, config, 256, 256);
+
+	ECHK(eglQuerySurface(display, surface, EGL_WIDTH, &width));
+	ECHK(eglQuerySurface(display, surface, EGL_HEIGHT, &height));
+
+	DEBUG_MSG("Buffer: %dx%d", width, height);
+
+	/* connect the context to the surface */
+	ECHK(eglMakeCurrent(display, surface, surface, context));
+
+	for (i = 0; i < ARRAY_SIZE(program); i++) {
+		program[i] = get_program(vertex_shader_source, fragment_shader_source[i]);
+		GCHK(glBindAttribLocation(program[i], 0, "aPosition"));
+		link_program(program[i]);
+	}
+
+	GCHK(glUseProgram(program[0]));
+	GCHK(glViewport(0, 0, width, height));
+	GCHK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	GCHK(glEnable(GL_DEPTH_TEST));
+
+	GCHK(glClearColor(0.0, 0.0, 0.0, 1.0));
+	GCHK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+	GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices));
+	GCHK(glEnableVertexAttribArray(0));
+
+	PERF_LOOP(names[change], batch, ops, i, {
+		switch (change) {
+		case CHANGE_NONE:
+			break;
+		case CHANGE_BLEND:
+			if (i & 1)
+				glEnable(GL_BLEND);
+			else
+				glDisable(GL_BLEND);
+			break;
+		case CHANGE_DEPTH:
+			glDepthFunc(depth_funcs[i & 1]);
+			break;
+		case CHANGE_PROGRAM:
+			glUseProgram(program[i & 1]);
+			break;
+		}
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		if ((i % batch) == (batch - 1))
+			glFlush();
+	});
+
+	ECHK(eglSwapBuffers(display, surface));
+	GCHK(glFlush());
+
+	ECHK(eglDestroySurface(display, surface));
+
+	ECHK(eglTerminate(display));
+
+	RD_END();
+}
+
+int main(int argc, char *argv[])
+{
+	TEST_START();
+	TEST(test_perf_draw(CHANGE_NONE,       1, 10000));
+	TEST(test_perf_draw(CHANGE_NONE,      16, 10000));
+	TEST(test_perf_draw(CHANGE_NONE,     256, 10000));
+	TEST(test_perf_draw(CHANGE_NONE,    4096, 10000));
+	TEST(test_perf_draw(CHANGE_BLEND,      1, 10000));
+	TEST(test_perf_draw(CHANGE_BLEND,     16, 10000));
+	TEST(test_perf_draw(CHANGE_BLEND,    256, 10000));
+	TEST(test_perf_draw(CHANGE_BLEND,   4096, 10000));
+	TEST(test_perf_draw(CHANGE_DEPTH,      1, 10000));
+	TEST(test_perf_draw(CHANGE_DEPTH,     16, 10000));
+	TEST(test_perf_draw(CHANGE_DEPTH,    256, 10000));
+	TEST(test_perf_draw(CHANGE_DEPTH,   4096, 10000));
+	TEST(test_perf_draw(CHANGE_PROGRAM,    1, 10000));
+	TEST(test_perf_draw(CHANGE_PROGRAM,   16, 10000));
+	TEST(test_perf_draw(CHANGE_PROGRAM,  256, 10000));
+	TEST(test_perf_draw(CHANGE_PROGRAM, 4096, 10000));
+	TEST_END();
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* driver overhead of render target switches.  Each op binds the next of
+ * nfbo framebuffer objects (so nfbo=1 is the no-switch baseline) and
+ * draws a quad to it.  The size is the width/height of the fbo's.
+ */
+
+#include "test-util-3d.h"
+
+static EGLint const config_attribute_list[] = {
+	EGL_RED_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_BLUE_SIZE, 8,
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_DEPTH_SIZE, 8,
+	EGL_NONE
+};
+
+static const EGLint context_attribute_list[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 2,
+	EGL_NONE
+};
+
+static EGLDisplay display;
+static EGLConfig config;
+static EGLint num_config;
+static EGLContext context;
+static EGLSurface surface;
+static GLuint program;
+static GLint width, height;
+const char *vertex_shader_source =
+	"attribute vec4 aPosition;    \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_Position = aPosition; \n"
+	"}                            \n";
+const char *fragment_shader_source =
+	"precision highp float;       \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0);\n"
+	"}                            \n";
+
+#define MAX_FBO 4
+
+void test_perf_fbo(int nfbo, int size, int ops)
+{
+	static const GLfloat vertices[] = {
+			-0.45, -0.75, 0.0,
+			 0.45, -0.75, 0.0,
+			-0.45,  0.75, 0.0,
+			 0.45,  0.75, 0.0,
+	};
+	GLuint fbo[MAX_FBO], tex[MAX_FBO];
+	char name[32];
+	int i;
+
+	RD_START("perf-fbo", "nfbo=%d, size=%d", nfbo, size);
+	display = get_display();
+
+	/* get an appropriate EGL frame buffer configuration */
+	ECHK(eglChooseConfig(display, config_attribute_list, &config, 1, &num_config));
+	DEBUG_MSG("num_config: %d", num_config);
+
+	/* create an EGL rendering context */
+	ECHK(context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribute_list));
+
+	surface = make_window(display, config, 64, 64);
+
+	ECHK(eglQuerySurface(display, surface, EGL_WIDTH, &width));
+	ECHK(eglQuerySurface(display, surface, EGL_HEIGHT, &height));
+
+	DEBUG_MSG("Buffer: %dx%d", width, height);
+
+	/* connect the context to the surface */
+	ECHK(eglMakeCurrent(display, surface, surface, context));
+
+	program = get_program(vertex_shader_source, fragment_shader_source);
+
+	GCHK(glBindAttribLocation(program, 0, "aPosition"));
+
+	link_program(program);
+
+	GCHK(glGenFramebuffers(nfbo, fbo));
+	GCHK(glGenTextures(nfbo, tex));
+
+	for (i = 0; i < nfbo; i++) {
+		GLenum status;
+
+		GCHK(glBindTexture(GL_TEXTURE_2D, tex[i]));
+		GCHK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+		GCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+
+		GCHK(glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]));
+		GCHK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				GL_TEXTURE_2D, tex[i], 0));
+
+		GCHK(status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			ERROR_MSG("framebuffer %d incomplete: 0x%04x", i, status);
+			exit(-1);
+		}
+	}
+
+	GCHK(glViewport(0, 0, size, size));
+	GCHK(glClearColor(0.0, 0.0, 0.0, 1.0));
+
+	GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices));
+	GCHK(glEnableVertexAttribArray(0));
+
+	snprintf(name, sizeof(name), "fbo-switch/%d", nfbo);
+	PERF_LOOP(name, size, ops, i, {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo[i % nfbo]);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	});
+
+	GCHK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GCHK(glDeleteFramebuffers(nfbo, fbo));
+	GCHK(glDeleteTextures(nfbo, tex));
+
+	ECHK(eglSwapBuffers(display, surface));
+	GCHK(glFlush());
+
+	ECHK(eglDestroySurface(display, surface));
+
+	ECHK(eglTerminate(display));
+
+	RD_END();
+}
+
+int main(int argc, char *argv[])
+{
+	TEST_START();
+	TEST(test_perf_fbo(1,   64, 1000));
+	TEST(test_perf_fbo(2,   64, 1000));
+	TEST(test_perf_fbo(4,   64, 1000));
+	TEST(test_perf_fbo(1,  256, 1000));
+	TEST(test_perf_fbo(2,  256, 1000));
+	TEST(test_perf_fbo(4,  256, 1000));
+	TEST(test_perf_fbo(1, 1024,  100));
+	TEST(test_perf_fbo(2, 1024,  100));
+	TEST(test_perf_fbo(4, 1024,  100));
+	TEST_END();
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* driver overhead of instanced draws, versus the same number of quads
+ * drawn with one non-instanced draw call each (updating the offset
+ * attribute in between).  The size is the number of instances.
+ */
+
+#include <GLES3/gl3.h>
+#include "test-util-3d.h"
+
+static EGLint const config_attribute_list[] = {
+	EGL_RED_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_BLUE_SIZE, 8,
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_DEPTH_SIZE, 8,
+	EGL_NONE
+};
+
+static const EGLint context_attribute_list[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 3,
+	EGL_NONE
+};
+
+static EGLDisplay display;
+static EGLConfig config;
+static EGLint num_config;
+static EGLContext context;
+static EGLSurface surface;
+static GLuint program;
+static GLint width, height;
+const char *vertex_shader_source =
+	"#version 300 es              \n"
+	"in vec4 aPosition;           \n"
+	"in vec4 aOffset;             \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_Position = aPosition + aOffset;\n"
+	"}                            \n";
+const char *fragment_shader_source =
+	"#version 300 es              \n"
+	"precision highp float;       \n"
+	"out vec4 fragColor;          \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    fragColor = vec4(1.0, 0.0, 0.0, 1.0);\n"
+	"}                            \n";
+
+void test_perf_instanced(int instanced, int instances, int ops)
+{
+	static const GLfloat vertices[] = {
+			-0.05, -0.05, 0.0,
+			 0.05, -0.05, 0.0,
+			-0.05,  0.05, 0.0,
+			 0.05,  0.05, 0.0,
+	};
+	GLfloat *offsets;
+	int i, j;
+
+	RD_START("perf-instanced", "%s, instances=%d",
+			instanced ? "instanced" : "non-instanced", instances);
+	display = get_display();
+
+	/* get an appropriate EGL frame buffer configuration */
+	ECHK(eglChooseConfig(display, config_attribute_list, &config, 1, &num_config));
+	DEBUG_MSG("num_config: %d", num_config);
+
+	/* create an EGL rendering context */
+	ECHK(context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribute_list));
+
+	surface = make_window(display, config, 256, 256);
+
+	ECHK(eglQuerySurface(display, surface, EGL_WIDTH, &width));
+	ECHK(eglQuerySurface(display, surface, EGL_HEIGHT, &height));
+
+	DEBUG_MSG("Buffer: %dx%d", width, height);
+
+	/* connect the context to the surface */
+	ECHK(eglMakeCurrent(display, surface, surface, context));
+
+	program = get_program(vertex_shader_source, fragment_shader_source);
+
+	GCHK(glBindAttribLocation(program, 0, "aPosition"));
+	GCHK(glBindAttribLocation(program, 1, "aOffset"));
+
+	link_program(program);
+
+	GCHK(glViewport(0, 0, width, height));
+
+	GCHK(glClearColor(0.0, 0.0, 0.0, 1.0));
+	GCHK(glClear(GL_COLOR_BUFFER_BIT));
+
+	offsets = malloc(instances * 4 * sizeof(GLfloat));
+	for (i = 0; i < instances; i++) {
+		offsets[i * 4 + 0] = (GLfloat)(i % 16) / 8.0 - 1.0;
+		offsets[i * 4 + 1] = (GLfloat)((i / 16) % 16) / 8.0 - 1.0;
+		offsets[i * 4 + 2] = 0.0;
+		offsets[i * 4 + 3] = 0.0;
+	}
+
+	GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices));
+	GCHK(glEnableVertexAttribArray(0));
+
+	if (instanced) {
+		GCHK(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, offsets));
+		GCHK(glVertexAttribDivisor(1, 1));
+		GCHK(glEnableVertexAttribArray(1));
+
+		PERF_LOOP("instanced", instances, ops, i, {
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances);
+		});
+	} else {
+		PERF_LOOP("non-instanced", instances, ops, i, {
+			for (j = 0; j < instances; j++) {
+				glVertexAttrib4fv(1, &offsets[j * 4]);
+				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			}
+		});
+	}
+
+	free(offsets);
+
+	ECHK(eglSwapBuffers(display, surface));
+	GCHK(glFlush());
+
+	ECHK(eglDestroySurface(display, surface));
+
+	ECHK(eglTerminate(display));
+
+	RD_END();
+}
+
+int main(int argc, char *argv[])
+{
+	TEST_START();
+	TEST(test_perf_instanced(1,    1, 1000));
+	TEST(test_perf_instanced(0,    1, 1000));
+	TEST(test_perf_instanced(1,   16, 1000));
+	TEST(test_perf_instanced(0,   16, 1000));
+	TEST(test_perf_instanced(1,  256,  100));
+	TEST(test_perf_instanced(0,  256,  100));
+	TEST(test_perf_instanced(1, 1024,  100));
+	TEST(test_perf_instanced(0, 1024,  100));
+	TEST_END();
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* driver overhead of uniform updates, size is the number of vec4's
+ * updated (with glUniform4fv()) before each draw.
+ */
+
+#include "test-util-3d.h"
+
+static EGLint const config_attribute_list[] = {
+	EGL_RED_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_BLUE_SIZE, 8,
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_DEPTH_SIZE, 8,
+	EGL_NONE
+};
+
+static const EGLint context_attribute_list[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 2,
+	EGL_NONE
+};
+
+static EGLDisplay display;
+static EGLConfig config;
+static EGLint num_config;
+static EGLContext context;
+static EGLSurface surface;
+static GLuint program;
+static GLint width, height;
+static int uniform_location;
+const char *vertex_shader_source =
+	"attribute vec4 aPosition;    \n"
+	"uniform vec4 uColor[%d];     \n"
+	"varying vec4 vColor;         \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    int i;                   \n"
+	"    vColor = vec4(0.0);      \n"
+	"    for (i = 0; i < %d; i++) \n"
+	"        vColor += uColor[i]; \n"
+	"    gl_Position = aPosition; \n"
+	"}                            \n";
+const char *fragment_shader_source =
+	"precision highp float;       \n"
+	"varying vec4 vColor;         \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_FragColor = vColor;   \n"
+	"}                            \n";
+
+void test_perf_uniform(int nvec4, int ops)
+{
+	static const GLfloat vertices[] = {
+			-0.45, -0.75, 0.0,
+			 0.45, -0.75, 0.0,
+			-0.45,  0.75, 0.0,
+			 0.45,  0.75, 0.0,
+	};
+	char vs[1024];
+	GLfloat *data;
+	int i;
+
+	RD_START("perf-uniform", "nvec4=%d", nvec4);
+	display = get_display();
+
+	/* get an appropriate EGL frame buffer configuration */
+	ECHK(eglChooseConfig(display, config_attribute_list, &config, 1, &num_config));
+	DEBUG_MSG("num_config: %d", num_config);
+
+	/* create an EGL rendering context */
+	ECHK(context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribute_list));
+
+	surface = make_window(display, config, 256, 256);
+
+	ECHK(eglQuerySurface(display, surface, EGL_WIDTH, &width));
+	ECHK(eglQuerySurface(display, surface, EGL_HEIGHT, &height));
+
+	DEBUG_MSG("Buffer: %dx%d", width, height);
+
+	/* connect the context to the surface */
+	ECHK(eglMakeCurrent(display, surface, surface, context));
+
+	snprintf(vs, sizeof(vs), vertex_shader_source, nvec4, nvec4);
+	program = get_program(vs, fragment_shader_source);
+
+	GCHK(glBindAttribLocation(program, 0, "aPosition"));
+
+	link_program(program);
+
+	GCHK(glViewport(0, 0, width, height));
+
+	GCHK(glClearColor(0.0, 0.0, 0.0, 1.0));
+	GCHK(glClear(GL_COLOR_BUFFER_BIT));
+
+	GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices));
+	GCHK(glEnableVertexAttribArray(0));
+
+	GCHK(uniform_location = glGetUniformLocation(program, "uColor"));
+
+	/* two sets of values, so each update actually changes something: */
+	data = calloc(2 * nvec4 * 4, sizeof(GLfloat));
+	for (i = 0; i < 2 * nvec4 * 4; i++)
+		data[i] = (GLfloat)i / (2 * nvec4 * 4);
+
+	PERF_LOOP("uniform", nvec4, ops, i, {
+		glUniform4fv(uniform_location, nvec4, &data[(i & 1) * nvec4 * 4]);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	});
+
+	free(data);
+
+	ECHK(eglSwapBuffers(display, surface));
+	GCHK(glFlush());
+
+	ECHK(eglDestroySurface(display, surface));
+
+	ECHK(eglTerminate(display));
+
+	RD_END();
+}
+
+int main(int argc, char *argv[])
+{
+	TEST_START();
+	TEST(test_perf_uniform(  1, 10000));
+	TEST(test_perf_uniform(  4, 10000));
+	TEST(test_perf_uniform( 16, 10000));
+	TEST(test_perf_uniform( 64, 10000));
+	TEST(test_perf_uniform(128, 10000));
+	TEST_END();
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* driver overhead of texture and buffer uploads.  Each upload is followed
+ * by a draw using it, so the driver can't just skip the upload.  The
+ * size is the texture width/height, or the buffer size in bytes.
+ */
+
+#include <string.h>
+
+#include "test-util-3d.h"
+
+static EGLint const config_attribute_list[] = {
+	EGL_RED_SIZE, 8,
+	EGL_GREEN_SIZE, 8,
+	EGL_BLUE_SIZE, 8,
+	EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+	EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	EGL_DEPTH_SIZE, 8,
+	EGL_NONE
+};
+
+static const EGLint context_attribute_list[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 2,
+	EGL_NONE
+};
+
+static EGLDisplay display;
+static EGLConfig config;
+static EGLint num_config;
+static EGLContext context;
+static EGLSurface surface;
+static GLuint program;
+static GLint width, height;
+const char *vertex_shader_source =
+	"attribute vec4 aPosition;    \n"
+	"varying vec2 vTexCoord;      \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    vTexCoord = aPosition.xy;\n"
+	"    gl_Position = aPosition; \n"
+	"}                            \n";
+const char *fragment_shader_source =
+	"precision highp float;       \n"
+	"uniform sampler2D uTexture;  \n"
+	"varying vec2 vTexCoord;      \n"
+	"                             \n"
+	"void main()                  \n"
+	"{                            \n"
+	"    gl_FragColor = texture2D(uTexture, vTexCoord);\n"
+	"}                            \n";
+
+enum upload {
+	UPLOAD_TEXTURE,
+	UPLOAD_BUFFER,
+};
+
+void test_perf_upload(enum upload upload, int size, int ops)
+{
+	static const GLfloat vertices[] = {
+			-0.45, -0.75, 0.0,
+			 0.45, -0.75, 0.0,
+			-0.45,  0.75, 0.0,
+			 0.45,  0.75, 0.0,
+	};
+	GLuint tex, buf;
+	uint8_t *data;
+	int i, n;
+
+	RD_START("perf-upload", "%s, size=%d",
+			(upload == UPLOAD_TEXTURE) ? "texture" : "buffer", size);
+	display = get_display();
+
+	/* get an appropriate EGL frame buffer configuration */
+	ECHK(eglChooseConfig(display, config_attribute_list, &config, 1, &num_config));
+	DEBUG_MSG("num_config: %d", num_config);
+
+	/* create an EGL rendering context */
+	ECHK(context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribute_list));
+
+	surface = make_window(display, config, 256, 256);
+
+	ECHK(eglQuerySurface(display, surface, EGL_WIDTH, &width));
+	ECHK(eglQuerySurface(display, surface, EGL_HEIGHT, &height));
+
+	DEBUG_MSG("Buffer: %dx%d", width, height);
+
+	/* connect the context to the surface */
+	ECHK(eglMakeCurrent(display, surface, surface, context));
+
+	program = get_program(vertex_shader_source, fragment_shader_source);
+
+	GCHK(glBindAttribLocation(program, 0, "aPosition"));
+
+	link_program(program);
+
+	GCHK(glViewport(0, 0, width, height));
+
+	GCHK(glClearColor(0.0, 0.0, 0.0, 1.0));
+	GCHK(glClear(GL_COLOR_BUFFER_BIT));
+
+	n = (upload == UPLOAD_TEXTURE) ? (size * size * 4) : size;
+	data = malloc(n);
+	for (i = 0; i < n; i++)
+		data[i] = i;
+
+	/* for the buffer upload case, the vertices are at the start of the
+	 * buffer, followed by padding up to the requested size:
+	 */
+	if (upload == UPLOAD_BUFFER)
+		memcpy(data, vertices, min(sizeof(vertices), n));
+
+	GCHK(glActiveTexture(GL_TEXTURE0));
+	GCHK(glGenTextures(1, &tex));
+	GCHK(glBindTexture(GL_TEXTURE_2D, tex));
+	GCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+
+	if (upload == UPLOAD_TEXTURE) {
+		GCHK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, data));
+
+		GCHK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+		GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices));
+		GCHK(glEnableVertexAttribArray(0));
+
+		PERF_LOOP("texture-upload", size, ops, i, {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size,
+					GL_RGBA, GL_UNSIGNED_BYTE, data);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+	} else {
+		GCHK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, data));
+
+		GCHK(glGenBuffers(1, &buf));
+		GCHK(glBindBuffer(GL_ARRAY_BUFFER, buf));
+		GCHK(glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW));
+		GCHK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0));
+		GCHK(glEnableVertexAttribArray(0));
+
+		PERF_LOOP("buffer-upload", size, ops, i, {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+
+		GCHK(glDeleteBuffers(1, &buf));
+	}
+
+	GCHK(glDeleteTextures(1, &tex));
+	free(data);
+
+	ECHK(eglSwapBuffers(display, surface));
+	GCHK(glFlush());
+
+	ECHK(eglDestroySurface(display, surface));
+
+	ECHK(eglTerminate(display));
+
+	RD_END();
+}
+
+int main(int argc, char *argv[])
+{
+	TEST_START();
+	TEST(test_perf_upload(UPLOAD_TEXTURE,      16, 1000));
+	TEST(test_perf_upload(UPLOAD_TEXTURE,      64, 1000));
+	TEST(test_perf_upload(UPLOAD_TEXTURE,     256, 1000));
+	TEST(test_perf_upload(UPLOAD_TEXTURE,    1024,  100));
+	TEST(test_perf_upload(UPLOAD_BUFFER,       64, 1000));
+	TEST(test_perf_upload(UPLOAD_BUFFER,     4096, 1000));
+	TEST(test_perf_upload(UPLOAD_BUFFER,    65536, 1000));
+	TEST(test_perf_upload(UPLOAD_BUFFER,  1048576,  100));
+	TEST_END();
+
+	return 0;
+}
@@ -34,15 +34,93 @@
 #endif
 
 #include <ctype.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 /*****************************************************************************/
 
+/* benchmark mode state, see TEST() below: */
+static struct {
+	int warmup, iters;     /* BENCH_WARMUP and BENCH env variables */
+	int iter;              /* current iteration, counting warm-up */
+	uint64_t gl, egl;      /* time spent inside GCHK()/ECHK() calls, in ns */
+	unsigned gl_calls, egl_calls;
+	uint64_t idle;         /* time asleep between calls, see __bench_gap() */
+	uint64_t mark_wall, mark_cpu;  /* at the end of the last call */
+} __bench;
+
+/* gettimeofday() and clock() rather than clock_gettime(), which the
+ * -std=c99 builds don't get without feature macros:
+ */
+static inline uint64_t __bench_wall_ns(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return ((uint64_t)tv.tv_sec * 1000000000) + ((uint64_t)tv.tv_usec * 1000);
+}
+
+static inline uint64_t __bench_cpu_ns(void)
+{
+	return (uint64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+}
+
+/* only the measured iterations count, not warm-up: */
+static inline int __bench_measuring(void)
+{
+	return __bench.iters && (__bench.iter >= __bench.warmup);
+}
+
+/* tests sleep after rendering, to give the capture time to complete,
+ * which would swamp the measurement.  So wall-clock time between the
+ * GCHK()/ECHK() calls that isn't spent on the CPU either (more than a
+ * millisecond of it) is counted as idle, and left out.  Waiting for the
+ * GPU happens inside the GL calls, so that still counts:
+ */
+#define BENCH_IDLE_NS 1000000
+
+static inline void __bench_mark(void)
+{
+	__bench.mark_wall = __bench_wall_ns();
+	__bench.mark_cpu = __bench_cpu_ns();
+}
+
+static inline uint64_t __bench_gap(void)
+{
+	uint64_t wall = __bench_wall_ns();
+	uint64_t gap = wall - __bench.mark_wall;
+	uint64_t busy = __bench_cpu_ns() - __bench.mark_cpu;
+
+	if (gap > (busy + BENCH_IDLE_NS))
+		__bench.idle += gap - busy;
+
+	return wall;
+}
+
+static inline uint64_t __bench_start(void)
+{
+	return __bench_measuring() ? __bench_gap() : 0;
+}
+
+static inline void __bench_stop(uint64_t start, uint64_t *total, unsigned *calls)
+{
+	if (!__bench_measuring())
+		return;
+	__bench_mark();
+	*total += __bench.mark_wall - start;
+	(*calls)++;
+}
+
 #define ECHK(x) do { \
 		EGLBoolean status; \
+		uint64_t __t; \
 		DEBUG_MSG(">>> %s", #x); \
-		RD_WRITE_SECTION(RD_CMD, #x, strlen(#x)); \
+		if (!__quiet) \
+			RD_WRITE_SECTION(RD_CMD, #x, strlen(#x)); \
+		__t = __bench_start(); \
 		status = (EGLBoolean)(x); \
+		__bench_stop(__t, &__bench.egl, &__bench.egl_calls); \
 		if (!status) { \
 			EGLint err = eglGetError(); \
 			ERROR_MSG("<<< %s: failed: 0x%04x (%s)", #x, err, eglStrError(err)); \
@@ -53,9 +131,13 @@
 
 #define GCHK(x) do { \
 		GLenum err; \
+		uint64_t __t; \
 		DEBUG_MSG(">>> %s", #x); \
-		RD_WRITE_SECTION(RD_CMD, #x, strlen(#x)); \
+		if (!__quiet) \
+			RD_WRITE_SECTION(RD_CMD, #x, strlen(#x)); \
+		__t = __bench_start(); \
 		x; \
+		__bench_stop(__t, &__bench.gl, &__bench.gl_calls); \
 		err = glGetError(); \
 		if (err != GL_NO_ERROR) { \
 			ERROR_MSG("<<< %s: failed: 0x%04x (%s)", #x, err, glStrError(err)); \
@@ -681,16 +763,18 @@ link_program(GLuint program)
 	GCHK(glUseProgram(program));
 
 #ifdef BIONIC
-	/* dump program binary: */
+	/* dump program binary, once in benchmark mode: */
 	// TODO move this into wrap-gles.c .. just putting it here for now
 	// since I haven't created wrap-gles.c yet
-	GCHK(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &len));
-	binary = calloc(1, len);
-	GCHK(glGetProgramBinaryOES(program, len, &ret, &binary_format, binary));
-	DEBUG_MSG("program dump: len=%d, actual len=%d", len, ret);
-	hexdump(binary, len);
-	RD_WRITE_SECTION(RD_PROGRAM, binary, len);
-	free(binary);
+	if (!__quiet) {
+		GCHK(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &len));
+		binary = calloc(1, len);
+		GCHK(glGetProgramBinaryOES(program, len, &ret, &binary_format, binary));
+		DEBUG_MSG("program dump: len=%d, actual len=%d", len, ret);
+		hexdump(binary, len);
+		RD_WRITE_SECTION(RD_PROGRAM, binary, len);
+		free(binary);
+	}
 #endif
 }
 
@@ -698,28 +782,144 @@ link_program(GLuint program)
 /* helper macros for tests, to let test-runner select test to run via
  * TESTNUM env variable.  Note env variable used because passing args
  * when tests are compiled for bionic doesn't really work.
+ *
+ * Setting BENCH=<iterations> (and optionally BENCH_WARMUP=<iterations>,
+ * default 1) turns the selected test(s) into a benchmark: the test body
+ * is run for the warm-up iterations plus the measured iterations, and
+ * the CPU time, wall-clock time (less the idle time, see __bench_gap())
+ * and time spent inside the GCHK()/ECHK() wrapped calls are reported per
+ * iteration.  Only the first iteration writes debug output and RD_CMD
+ * markers, and the rd capture (if any) is kept open across all
+ * iterations.
  */
 
 static inline int __gettest(void)
 {
 	const char *testnum = getenv("TESTNUM");
+	/* with TESTCOUNT set, no test is run, and TEST_END() just reports the
+	 * number of tests (see run-tests.sh):
+	 */
+	if (getenv("TESTCOUNT"))
+		return -2;
 	if (testnum)
 		return strtol(testnum, NULL, 0);
 	return -1;
 }
 
+static inline void __getbench(void)
+{
+	const char *iters = getenv("BENCH");
+	const char *warmup = getenv("BENCH_WARMUP");
+	if (iters)
+		__bench.iters = strtol(iters, NULL, 0);
+	__bench.warmup = warmup ? strtol(warmup, NULL, 0) : 1;
+}
+
+/* in benchmark mode, only open the rd file on the first iteration and
+ * close it after the last, so all iterations land in the same capture:
+ */
+#undef RD_START
+#define RD_START(n,f,...) do { \
+		if (rd_start && !__bench.iter) \
+			rd_start(n,f,##__VA_ARGS__); \
+	} while (0)
+#undef RD_END
+#define RD_END() do { \
+		if (rd_end && (!__bench.iters || \
+				(__bench.iter == (__bench.warmup + __bench.iters - 1)))) \
+			rd_end(); \
+	} while (0)
+
+static inline void __bench_report(int test, uint64_t cpu, uint64_t wall)
+{
+	double n = __bench.iters;
+
+	printf("BENCH: test %d: %d iterations (+%d warm-up): "
+			"cpu %.3f ms, wall %.3f ms (%.1f frames/s), idle %.3f ms, "
+			"gl %.3f ms (%.0f calls), egl %.3f ms (%.0f calls) per iteration\n",
+			test, __bench.iters, __bench.warmup,
+			cpu / n / 1e6, wall / n / 1e6, n * 1e9 / wall, __bench.idle / n / 1e6,
+			__bench.gl / n / 1e6, __bench.gl_calls / n,
+			__bench.egl / n / 1e6, __bench.egl_calls / n);
+}
+
 #define TEST_START() \
-	int __n = 0, __test = __gettest()
+	int __n = 0, __test = __gettest(); \
+	__getbench()
 
 #define TEST(t) do { \
 		if ((__test == __n++) || (__test == -1)) { \
-			t; \
+			uint64_t __cpu = 0, __wall = 0; \
+			int __total = __bench.warmup + __bench.iters; \
+			if (!__bench.iters) { \
+				t; \
+				break; \
+			} \
+			__bench.gl = __bench.egl = 0; \
+			__bench.gl_calls = __bench.egl_calls = 0; \
+			__bench.idle = 0; \
+			for (__bench.iter = 0; __bench.iter < __total; __bench.iter++) { \
+				if (__bench.iter == __bench.warmup) { \
+					__cpu = __bench_cpu_ns(); \
+					__wall = __bench_wall_ns(); \
+					__bench_mark(); \
+				} \
+				__quiet = (__bench.iter > 0); \
+				t; \
+			} \
+			__bench_gap(); \
+			__cpu = __bench_cpu_ns() - __cpu; \
+			__wall = __bench_wall_ns() - __wall - __bench.idle; \
+			__bench.iter = __quiet = 0; \
+			__bench_report(__n - 1, __cpu, __wall); \
 		} \
 	} while (0)
 
 #define TEST_END() do { \
+		if (__test == -2) { \
+			printf("TESTCOUNT: %d\n", __n); \
+			exit(0); \
+		} \
 		if (__test >= __n++) \
 			exit(42); \
 	} while (0)
 
+/* ************************************************************************* */
+/* helpers for the test-perf-* driver overhead microbenchmarks.  The loop
+ * body is run once untimed (to get any one-time validation/allocation out
+ * of the way), then 'ops' times between two glFinish(), so that deferred
+ * work in the driver is included in the ns/op.  The body should use the
+ * raw GL calls rather than GCHK(), to not measure the error checking and
+ * RD_CMD markers; errors are checked once at the end.
+ */
+
+static inline void
+perf_report(const char *name, int size, int ops, uint64_t wall, uint64_t cpu)
+{
+	printf("PERF: %-24s size=%-8d %8d ops: %10.1f ns/op (cpu %10.1f ns/op)\n",
+			name, size, ops, (double)wall / ops, (double)cpu / ops);
+}
+
+#define PERF_LOOP(name, size, ops, i, body) do { \
+		uint64_t __wall, __cpu; \
+		GLenum __err; \
+		(i) = 0; \
+		body; \
+		glFinish(); \
+		__cpu = __bench_cpu_ns(); \
+		__wall = __bench_wall_ns(); \
+		for ((i) = 0; (i) < (ops); (i)++) { \
+			body; \
+		} \
+		glFinish(); \
+		__wall = __bench_wall_ns() - __wall; \
+		__cpu = __bench_cpu_ns() - __cpu; \
+		__err = glGetError(); \
+		if (__err != GL_NO_ERROR) { \
+			ERROR_MSG("%s: failed: 0x%04x (%s)", name, __err, glStrError(__err)); \
+			exit(-1); \
+		} \
+		perf_report(name, size, ops, __wall, __cpu); \
+	} while (0)
+
 #endif /* TEST_UTIL_3D_H_ */
@@ -0,0 +1,639 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sub license,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Benchmark harness for the kernels in opencl/kernels (or any other .cl
+ * file).  Configured via env variables, since passing args when tests
+ * are compiled for bionic doesn't really work:
+ *
+ *   KERNEL=<file.cl>    kernel to run (default: every .cl file in
+ *                       opencl/kernels)
+ *   KERNEL_NAME=<name>  kernel function (default: first one in the file)
+ *   GLOBAL=<x[,y[,z]]>  global work size (default: 65536)
+ *   LOCAL=<x[,y[,z]]>   local work size (default: chosen by the driver), or
+ *                       "sweep" to try every power of two local size in x
+ *   ITERS=<n>           timed launches per configuration (default: 100)
+ *   BUFSIZE=<bytes>     size of each buffer argument (default: 16 bytes
+ *                       per work item)
+ *   FLOPS=<n>, BYTES=<n>  flops and bytes of memory traffic per work item,
+ *                       to report GFLOP/s and GB/s
+ *   DEVICE=cpu|gpu      device type (default: first device found)
+ *   CL_OPTS=<opts>      build options
+ *
+ * Buffer (__global/__constant pointer) arguments get a buffer of BUFSIZE
+ * bytes filled with 1.0f, integer (scalar or vector) arguments are set to
+ * the number of work items (so a "count" argument covers the whole range)
+ * and float ones to 1.0.  Kernels taking images, samplers or argument
+ * types it doesn't know are skipped.
+ *
+ * Kernel execution time comes from the profiling events, so it does not
+ * depend on how the implementation batches up launches.  The wall-clock
+ * time per launch (including the enqueue overhead) is reported too.
+ */
+
+#include <CL/opencl.h>
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "test-util-common.h"
+
+#define CCHK(x) do { \
+		int __err; \
+		DEBUG_MSG(">>> %s", #x); \
+		RD_WRITE_SECTION(RD_CMD, #x, strlen(#x)); \
+		__err = x; \
+		if (__err != CL_SUCCESS) { \
+			ERROR_MSG("<<< %s: failed: %d", #x, __err); \
+			exit(-1); \
+		} \
+		DEBUG_MSG("<<< %s: succeeded", #x); \
+	} while (0)
+
+#define MAX_ARGS 16
+#define MAX_NAME 128
+
+static cl_device_id device_id;
+static cl_context context;
+static cl_command_queue commands;
+
+static struct {
+	size_t global[3], local[3];
+	cl_uint workdim;
+	int sweep;
+	int iters;
+	size_t bufsize;
+	double flops, bytes;
+	const char *opts;
+} cfg;
+
+enum arg_type {
+	ARG_BUFFER,
+	ARG_INT,
+	ARG_FLOAT,
+};
+
+struct arg {
+	enum arg_type type;
+	unsigned size;          /* size of each component */
+	unsigned n;             /* number of components, 3 is padded to 4 */
+};
+
+static const struct {
+	const char *name;
+	enum arg_type type;
+	unsigned size;
+} scalar_types[] = {
+		{ "char",   ARG_INT,   1 },
+		{ "uchar",  ARG_INT,   1 },
+		{ "short",  ARG_INT,   2 },
+		{ "ushort", ARG_INT,   2 },
+		{ "int",    ARG_INT,   4 },
+		{ "uint",   ARG_INT,   4 },
+		{ "long",   ARG_INT,   8 },
+		{ "ulong",  ARG_INT,   8 },
+		{ "float",  ARG_FLOAT, 4 },
+		{ "double", ARG_FLOAT, 8 },
+};
+
+static uint64_t gettime_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static cl_uint parse_size(const char *str, size_t *size)
+{
+	cl_uint n = 0;
+
+	while (str && *str && (n < 3)) {
+		char *end;
+		size[n++] = strtoul(str, &end, 0);
+		str = (*end == ',') ? end + 1 : NULL;
+	}
+
+	return n;
+}
+
+static char *size_str(char *buf, const size_t *size, cl_uint workdim)
+{
+	char *p = buf;
+	cl_uint i;
+
+	if (!size)
+		return strcpy(buf, "auto");
+
+	for (i = 0; i < workdim; i++)
+		p += sprintf(p, "%s%u", i ? "x" : "", (unsigned)size[i]);
+
+	return buf;
+}
+
+static char *readfile(const char *path)
+{
+	struct stat st;
+	char *src;
+	int fd, ret;
+
+	fd = open(path, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || !(src = calloc(1, st.st_size + 1))) {
+		close(fd);
+		return NULL;
+	}
+
+	ret = read(fd, src, st.st_size);
+	close(fd);
+	if (ret < 0) {
+		free(src);
+		return NULL;
+	}
+
+	return src;
+}
+
+/* parse a scalar or vector type name, ie. "uint" or "float4": */
+static int parse_type(const char *word, int len, struct arg *arg)
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(scalar_types) / sizeof(scalar_types[0]); i++) {
+		int n = strlen(scalar_types[i].name);
+		unsigned long width = 1;
+
+		if ((len < n) || strncmp(word, scalar_types[i].name, n))
+			continue;
+
+		if (len > n) {
+			char *end;
+			width = strtoul(word + n, &end, 10);
+			if ((end != word + len) || ((width != 2) && (width != 3) &&
+					(width != 4) && (width != 8) && (width != 16)))
+				continue;
+		}
+
+		arg->type = scalar_types[i].type;
+		arg->size = scalar_types[i].size;
+		arg->n = (width == 3) ? 4 : width;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Figure out the kernel's name and argument types from the source.  This
+ * avoids depending on clGetKernelArgInfo() (OpenCL 1.2), and on 32b the
+ * size of a cl_mem matches an int, so clSetKernelArg() can't tell us
+ * either.  Returns the number of args, -1 if it is something we can't
+ * set up (images, samplers, etc), or -2 if there is no such kernel:
+ */
+static int parse_kernel(const char *src, const char *name, char *kname,
+		struct arg *args)
+{
+	const char *p = src;
+	int nargs = 0;
+
+	while ((p = strstr(p, "kernel"))) {
+		const char *start;
+		int len;
+
+		p += strlen("kernel");
+		if (!isspace(*p))
+			continue;
+
+		/* skip return type: */
+		while (isspace(*p)) p++;
+		while (isalnum(*p) || (*p == '_')) p++;
+		while (isspace(*p)) p++;
+
+		start = p;
+		while (isalnum(*p) || (*p == '_')) p++;
+		len = p - start;
+
+		if (!len || (name && ((strlen(name) != len) || strncmp(name, start, len))))
+			continue;
+
+		snprintf(kname, MAX_NAME, "%.*s", len, start);
+		break;
+	}
+
+	if (!p)
+		return -2;
+
+	p = strchr(p, '(');
+	if (!p)
+		return -2;
+
+	while (*p && (*p != ')')) {
+		const char *end = p + 1, *w, *e;
+		char arg[256];
+		int is_unsigned = 0, found = 0;
+
+		while (*end && (*end != ',') && (*end != ')'))
+			end++;
+
+		snprintf(arg, sizeof(arg), "%.*s", (int)(end - p - 1), p + 1);
+		p = end;
+
+		if (nargs == MAX_ARGS)
+			return -1;
+
+		if (strstr(arg, "image") || strstr(arg, "sampler") ||
+				strstr(arg, "local"))
+			return -1;
+
+		if (strchr(arg, '*')) {
+			args[nargs++].type = ARG_BUFFER;
+			continue;
+		}
+
+		if (strspn(arg, " \t\n") == strlen(arg))
+			continue;
+
+		/* the first word which is a type, or plain "unsigned": */
+		for (w = arg; *w && !found; w = e) {
+			while (*w && !isalnum(*w) && (*w != '_')) w++;
+			for (e = w; isalnum(*e) || (*e == '_'); e++) ;
+			if (e == w)
+				break;
+			if ((e - w == 8) && !strncmp(w, "unsigned", 8))
+				is_unsigned = 1;
+			else
+				found = parse_type(w, e - w, &args[nargs]);
+		}
+
+		if (!found && is_unsigned)
+			found = parse_type("uint", 4, &args[nargs]);
+		if (!found)
+			return -1;
+
+		nargs++;
+	}
+
+	return nargs;
+}
+
+static void setup_device(void)
+{
+	cl_platform_id platforms[8];
+	cl_device_type type = CL_DEVICE_TYPE_ALL;
+	const char *dev = getenv("DEVICE");
+	static char buf[1024];
+	cl_uint i, num_platforms = 0;
+	int err;
+
+	if (dev && !strcmp(dev, "cpu"))
+		type = CL_DEVICE_TYPE_CPU;
+	else if (dev && !strcmp(dev, "gpu"))
+		type = CL_DEVICE_TYPE_GPU;
+
+	CCHK(clGetPlatformIDs(8, platforms, &num_platforms));
+
+	for (i = 0; i < num_platforms; i++)
+		if (clGetDeviceIDs(platforms[i], type, 1, &device_id, NULL) == CL_SUCCESS)
+			break;
+
+	if (i == num_platforms) {
+		ERROR_MSG("no %s device found", dev ? dev : "CL");
+		exit(-1);
+	}
+
+	CCHK(clGetDeviceInfo(device_id, CL_DEVICE_NAME, sizeof(buf), buf, NULL));
+	printf("device: %s", buf);
+	CCHK(clGetDeviceInfo(device_id, CL_DEVICE_VERSION, sizeof(buf), buf, NULL));
+	printf(" (%s)\n", buf);
+
+	context = clCreateContext(0, 1, &device_id, NULL, NULL, &err);
+	CCHK(err);
+	commands = clCreateCommandQueue(context, device_id,
+			CL_QUEUE_PROFILING_ENABLE, &err);
+	CCHK(err);
+}
+
+static void report(const char *name, const size_t *local, uint64_t total,
+		uint64_t min, uint64_t wall)
+{
+	double avg = (double)total / cfg.iters;
+	double items = cfg.global[0];
+	char gbuf[64], lbuf[64];
+	cl_uint i;
+
+	for (i = 1; i < cfg.workdim; i++)
+		items *= cfg.global[i];
+
+	printf("KERNEL: %s: global=%s, local=%s: avg %.3f us, min %.3f us, "
+			"wall %.3f us/launch, %.3f Gitems/s",
+			name, size_str(gbuf, cfg.global, cfg.workdim),
+			size_str(lbuf, local, cfg.workdim),
+			avg / 1000, min / 1000.0, wall / 1000.0 / cfg.iters,
+			items / avg);
+	if (cfg.flops)
+		printf(", %.3f GFLOP/s", items * cfg.flops / avg);
+	if (cfg.bytes)
+		printf(", %.3f GB/s", items * cfg.bytes / avg);
+	printf("\n");
+}
+
+/* one warm-up launch (with the usual CCHK() and RD_CMD markers), then
+ * cfg.iters timed launches with the raw calls, so the error checking
+ * isn't part of the wall-clock time:
+ */
+static void run_kernel(cl_kernel kernel, const char *name, const size_t *local)
+{
+	cl_event *events = calloc(cfg.iters, sizeof(*events));
+	uint64_t total = 0, min = ~0ULL, wall;
+	char buf[64];
+	int i, err = CL_SUCCESS;
+
+	RD_START("kernel", "%s-%s", name, size_str(buf, local, cfg.workdim));
+
+	CCHK(clEnqueueNDRangeKernel(commands, kernel, cfg.workdim, NULL,
+			cfg.global, local, 0, NULL, NULL));
+	CCHK(clFinish(commands));
+
+	wall = gettime_ns();
+	for (i = 0; (i < cfg.iters) && (err == CL_SUCCESS); i++)
+		err = clEnqueueNDRangeKernel(commands, kernel, cfg.workdim, NULL,
+				cfg.global, local, 0, NULL, &events[i]);
+	CCHK(clFinish(commands));
+	wall = gettime_ns() - wall;
+	CCHK(err);
+
+	for (i = 0; i < cfg.iters; i++) {
+		cl_ulong start, end;
+
+		CCHK(clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START,
+				sizeof(start), &start, NULL));
+		CCHK(clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END,
+				sizeof(end), &end, NULL));
+		clReleaseEvent(events[i]);
+
+		total += end - start;
+		if ((end - start) < min)
+			min = end - start;
+	}
+
+	RD_END();
+
+	report(name, local, total, min, wall);
+
+	free(events);
+}
+
+/* every component set to 'ival' for integer args, or 1.0 for float args: */
+static void fill_arg(const struct arg *arg, cl_ulong ival, uint8_t *val)
+{
+	unsigned i;
+
+	for (i = 0; i < arg->n; i++) {
+		uint8_t *p = val + i * arg->size;
+		cl_uchar u8 = ival;
+		cl_ushort u16 = ival;
+		cl_uint u32 = ival;
+		cl_float f32 = 1.0;
+		cl_double f64 = 1.0;
+
+		if (arg->type == ARG_FLOAT) {
+			if (arg->size == 4)
+				memcpy(p, &f32, 4);
+			else
+				memcpy(p, &f64, 8);
+		} else if (arg->size == 1) {
+			memcpy(p, &u8, 1);
+		} else if (arg->size == 2) {
+			memcpy(p, &u16, 2);
+		} else if (arg->size == 4) {
+			memcpy(p, &u32, 4);
+		} else {
+			memcpy(p, &ival, 8);
+		}
+	}
+}
+
+static void test_kernel(const char *path)
+{
+	struct arg args[MAX_ARGS];
+	cl_mem bufs[MAX_ARGS];
+	char kname[MAX_NAME], name[256];
+	cl_program program;
+	cl_kernel kernel;
+	size_t items, wgsize, max_items[3];
+	float *data;
+	char *src;
+	int i, nargs, nbufs = 0, err;
+
+	src = readfile(path);
+	if (!src) {
+		ERROR_MSG("could not read %s", path);
+		return;
+	}
+
+	nargs = parse_kernel(src, getenv("KERNEL_NAME"), kname, args);
+	if (nargs == -2) {
+		const char *kernel = getenv("KERNEL_NAME");
+		if (kernel)
+			ERROR_MSG("%s: no kernel named %s", path, kernel);
+		else
+			ERROR_MSG("%s: no kernel found", path);
+		free(src);
+		return;
+	} else if (nargs < 0) {
+		printf("%s: skipped, unsupported kernel arguments\n", path);
+		free(src);
+		return;
+	}
+
+	snprintf(name, sizeof(name), "%s:%s", path, kname);
+
+	program = clCreateProgramWithSource(context, 1, (const char **)&src, NULL, &err);
+	CCHK(err);
+	err = clBuildProgram(program, 0, NULL, cfg.opts, NULL, NULL);
+	if (err != CL_SUCCESS) {
+		static char log[16 * 1024];
+		clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG,
+				sizeof(log), log, NULL);
+		printf("%s: build failed:\n%s\n", name, log);
+		clReleaseProgram(program);
+		free(src);
+		return;
+	}
+
+	kernel = clCreateKernel(program, kname, &err);
+	CCHK(err);
+
+	items = cfg.global[0];
+	for (i = 1; i < cfg.workdim; i++)
+		items *= cfg.global[i];
+
+	data = malloc(cfg.bufsize);
+	for (i = 0; i < cfg.bufsize / sizeof(float); i++)
+		data[i] = 1.0;
+
+	for (i = 0; i < nargs; i++) {
+		uint8_t val[16 * 8];
+
+		switch (args[i].type) {
+		case ARG_BUFFER:
+			bufs[nbufs] = clCreateBuffer(context,
+					CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+					cfg.bufsize, data, &err);
+			CCHK(err);
+			err = clSetKernelArg(kernel, i, sizeof(cl_mem), &bufs[nbufs]);
+			nbufs++;
+			break;
+		case ARG_INT:
+		case ARG_FLOAT:
+			fill_arg(&args[i], items, val);
+			err = clSetKernelArg(kernel, i, args[i].size * args[i].n, val);
+			break;
+		}
+
+		if (err != CL_SUCCESS)
+			break;
+	}
+
+	/* if we got an argument type wrong, skip the kernel rather than
+	 * the rest of the sweep:
+	 */
+	if (i < nargs) {
+		printf("%s: skipped, could not set argument %d: %d\n",
+				name, i, err);
+	} else if (cfg.sweep) {
+		size_t local[3] = { 1, 1, 1 };
+
+		CCHK(clGetKernelWorkGroupInfo(kernel, device_id,
+				CL_KERNEL_WORK_GROUP_SIZE, sizeof(wgsize), &wgsize, NULL));
+		CCHK(clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_SIZES,
+				sizeof(max_items), max_items, NULL));
+		if (max_items[0] < wgsize)
+			wgsize = max_items[0];
+
+		for (local[0] = 1; local[0] <= wgsize; local[0] *= 2) {
+			if (cfg.global[0] % local[0])
+				break;
+			run_kernel(kernel, name, local);
+		}
+	} else {
+		run_kernel(kernel, name, cfg.local[0] ? cfg.local : NULL);
+	}
+
+	for (i = 0; i < nbufs; i++)
+		clReleaseMemObject(bufs[i]);
+	clReleaseKernel(kernel);
+	clReleaseProgram(program);
+	free(data);
+	free(src);
+}
+
+static int filter_cl(const struct dirent *d)
+{
+	int len = strlen(d->d_name);
+	return (len > 3) && !strcmp(d->d_name + len - 3, ".cl");
+}
+
+int main(int argc, char **argv)
+{
+	const char *env, *kernel = getenv("KERNEL");
+	cl_uint n;
+
+	/* always a single test, see run-tests.sh: */
+	if (getenv("TESTCOUNT")) {
+		printf("TESTCOUNT: 1\n");
+		return 0;
+	}
+
+	cfg.workdim = 1;
+	cfg.global[0] = 65536;
+	cfg.iters = 100;
+
+	if ((env = getenv("GLOBAL")))
+		cfg.workdim = parse_size(env, cfg.global);
+	if ((env = getenv("LOCAL"))) {
+		if (!strcmp(env, "sweep"))
+			cfg.sweep = 1;
+		else if ((n = parse_size(env, cfg.local)) != cfg.workdim)
+			ERROR_MSG("LOCAL has %u dimensions, GLOBAL has %u", n, cfg.workdim);
+	}
+	if ((env = getenv("ITERS")))
+		cfg.iters = strtol(env, NULL, 0);
+	if ((env = getenv("FLOPS")))
+		cfg.flops = strtod(env, NULL);
+	if ((env = getenv("BYTES")))
+		cfg.bytes = strtod(env, NULL);
+	cfg.opts = getenv("CL_OPTS");
+
+	if (cfg.iters < 1)
+		cfg.iters = 1;
+
+	cfg.bufsize = cfg.global[0] * 16;
+	for (n = 1; n < cfg.workdim; n++)
+		cfg.bufsize *= cfg.global[n];
+	if ((env = getenv("BUFSIZE")))
+		cfg.bufsize = strtoul(env, NULL, 0);
+	if (cfg.bufsize < 4096)
+		cfg.bufsize = 4096;
+
+	setup_device();
+
+	if (kernel) {
+		test_kernel(kernel);
+	} else {
+		struct dirent **list;
+		int i, count;
+
+		count = scandir("opencl/kernels", &list, filter_cl, alphasort);
+		if (count < 0) {
+			ERROR_MSG("could not read opencl/kernels, set KERNEL");
+			return -1;
+		}
+
+		for (i = 0; i < count; i++) {
+			char path[512];
+			snprintf(path, sizeof(path), "opencl/kernels/%s", list[i]->d_name);
+			test_kernel(path);
+			free(list[i]);
+		}
+		free(list);
+	}
+
+	clReleaseCommandQueue(commands);
+	clReleaseContext(context);
+
+	return 0;
+}
+
+#ifdef BIONIC
+void _start(int argc, char **argv)
+{
+	exit(main(argc, argv));
+}
+#endif
@@ -0,0 +1,457 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+#include "apicost.h"
+#include "util.h"
+
+static int enabled;
+
+struct cost {
+	uint64_t dwords, packets, regs, draws;
+};
+
+struct call {
+	char name[48];
+	unsigned calls, submits;
+	uint64_t buffer_bytes;
+	struct cost cost;
+};
+
+static struct call *calls;
+static unsigned ncalls, maxcalls;
+
+/* the call of the last RD_CMD marker, and the one which flushed the
+ * current submit:
+ */
+static int cur_call, flush_call;
+
+/* draw calls since the previous submit: */
+static unsigned *pending;
+static unsigned npending, maxpending;
+
+#define NSTACK 32
+
+/* IBs currently being executed, stack[0] is the submit itself.  IBs
+ * nested deeper than the stack are folded into the innermost tracked
+ * IB:
+ */
+static struct {
+	struct cost acc;        /* since the last draw in this IB */
+	struct cost *draws;     /* cost of each draw in this IB */
+	unsigned ndraws, maxdraws;
+	int repeat;             /* already executed earlier in the submit */
+} stack[NSTACK];
+static int depth;
+static int warned;
+
+/* IBs executed in the current submit.  With GMEM binning the same IB is
+ * executed once per bin, but was only emitted once by the CPU:
+ */
+static struct {
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+} *seen;
+static unsigned nseen, maxseen;
+
+/* contents of each buffer when it was last dumped, the whole set of
+ * buffers is dumped again at every submit:
+ */
+static struct buffer {
+	uint64_t gpuaddr;
+	uint32_t sizebytes;
+	uint64_t hash;
+} *buffers;
+static unsigned nbuffers, maxbuffers;
+static unsigned *buffer_idx;     /* open addressing, index + 1 into buffers */
+static unsigned buffer_idx_size;
+
+static unsigned matched, unmatched;
+
+static void add(struct cost *a, const struct cost *b)
+{
+	a->dwords  += b->dwords;
+	a->packets += b->packets;
+	a->regs    += b->regs;
+	a->draws   += b->draws;
+}
+
+void apicost_enable(void)
+{
+	enabled = 1;
+}
+
+/* the innermost tracked IB: */
+static int top(void)
+{
+	return (depth < NSTACK) ? depth : NSTACK - 1;
+}
+
+/* find (or create) the entry for the function called in str, which is
+ * the stringified expression, ie. "glDrawArrays(GL_TRIANGLES, 0, 3)"
+ * or "program = glCreateProgram()":
+ */
+static int find_call(const char *str)
+{
+	const char *end = strchr(str, '('), *start;
+	char name[sizeof(calls[0].name)];
+	unsigned i;
+
+	if (end) {
+		while ((end > str) && isspace((unsigned char)end[-1]))
+			end--;
+		for (start = end; (start > str) &&
+				(isalnum((unsigned char)start[-1]) || (start[-1] == '_')); start--)
+			;
+	} else {
+		start = str;
+		end = str + strlen(str);
+	}
+
+	if (end == start) {
+		start = "<unknown>";
+		end = start + strlen(start);
+	}
+
+	snprintf(name, sizeof(name), "%.*s", (int)(end - start), start);
+
+	for (i = 0; i < ncalls; i++)
+		if (!strcmp(calls[i].name, name))
+			return i;
+
+	if (ncalls == maxcalls) {
+		maxcalls = maxcalls ? maxcalls * 2 : 64;
+		calls = xrealloc(calls, maxcalls * sizeof(calls[0]));
+	}
+
+	memset(&calls[ncalls], 0, sizeof(calls[0]));
+	strcpy(calls[ncalls].name, name);
+
+	return ncalls++;
+}
+
+/* cmdstream before the first RD_CMD is attributed to "<none>": */
+static int current_call(void)
+{
+	if (cur_call < 0)
+		cur_call = find_call("<none>");
+	return cur_call;
+}
+
+void apicost_cmd(const char *call)
+{
+	if (!enabled)
+		return;
+
+	cur_call = find_call(call);
+	calls[cur_call].calls++;
+
+	if (!strncmp(calls[cur_call].name, "glDraw", 6)) {
+		if (npending == maxpending) {
+			maxpending = maxpending ? maxpending * 2 : 256;
+			pending = xrealloc(pending, maxpending * sizeof(pending[0]));
+		}
+		pending[npending++] = cur_call;
+	}
+}
+
+static uint64_t hash_buf(const void *buf, uint32_t sizebytes)
+{
+	const uint8_t *p = buf;
+	uint64_t h = mix(sizebytes);
+	uint32_t i;
+
+	for (i = 0; i + 8 <= sizebytes; i += 8) {
+		uint64_t v;
+		memcpy(&v, p + i, sizeof(v));
+		h = mix(h ^ v);
+	}
+	for (; i < sizebytes; i++)
+		h = mix(h ^ p[i]);
+
+	return h;
+}
+
+static struct buffer * lookup_buffer(uint64_t gpuaddr, int *is_new)
+{
+	unsigned i;
+
+	if ((nbuffers * 2) >= buffer_idx_size) {
+		/* grow and rehash: */
+		unsigned j;
+		buffer_idx_size = buffer_idx_size ? buffer_idx_size * 2 : 1024;
+		free(buffer_idx);
+		buffer_idx = calloc(buffer_idx_size, sizeof(buffer_idx[0]));
+		for (j = 0; j < nbuffers; j++) {
+			for (i = mix(buffers[j].gpuaddr) % buffer_idx_size; buffer_idx[i];
+					i = (i + 1) % buffer_idx_size)
+				;
+			buffer_idx[i] = j + 1;
+		}
+	}
+
+	*is_new = 0;
+
+	for (i = mix(gpuaddr) % buffer_idx_size; buffer_idx[i];
+			i = (i + 1) % buffer_idx_size)
+		if (buffers[buffer_idx[i] - 1].gpuaddr == gpuaddr)
+			return &buffers[buffer_idx[i] - 1];
+
+	if (nbuffers == maxbuffers) {
+		maxbuffers = maxbuffers ? maxbuffers * 2 : 1024;
+		buffers = xrealloc(buffers, maxbuffers * sizeof(buffers[0]));
+	}
+
+	memset(&buffers[nbuffers], 0, sizeof(buffers[0]));
+	buffers[nbuffers].gpuaddr = gpuaddr;
+	buffer_idx[i] = nbuffers + 1;
+	*is_new = 1;
+
+	return &buffers[nbuffers++];
+}
+
+void apicost_buffer(uint64_t gpuaddr, const void *buf, uint32_t sizebytes)
+{
+	struct buffer *b;
+	uint64_t hash;
+	int is_new;
+
+	if (!enabled)
+		return;
+
+	/* only what was uploaded since the previous submit counts: */
+	hash = hash_buf(buf, sizebytes);
+	b = lookup_buffer(gpuaddr, &is_new);
+	if (!is_new && (b->sizebytes == sizebytes) && (b->hash == hash))
+		return;
+
+	b->sizebytes = sizebytes;
+	b->hash = hash;
+
+	calls[current_call()].buffer_bytes += sizebytes;
+}
+
+void apicost_start_submit(void)
+{
+	if (!enabled)
+		return;
+
+	flush_call = current_call();
+	calls[flush_call].submits++;
+
+	depth = 0;
+	memset(&stack[0].acc, 0, sizeof(stack[0].acc));
+	stack[0].ndraws = 0;
+	stack[0].repeat = 0;
+	nseen = 0;
+}
+
+void apicost_advance(uint32_t sizedwords)
+{
+	if (!enabled || (depth < 0) || stack[top()].repeat)
+		return;
+
+	stack[top()].acc.dwords += sizedwords;
+	stack[top()].acc.packets++;
+}
+
+void apicost_reg(void)
+{
+	if (!enabled || (depth < 0) || stack[top()].repeat)
+		return;
+
+	stack[top()].acc.regs++;
+}
+
+void apicost_draw(uint32_t num_indices)
+{
+	int d = top();
+
+	if (!enabled || (depth < 0) || stack[d].repeat)
+		return;
+
+	stack[d].acc.draws++;
+
+	/* blits, etc, are not draw calls, and are attributed along with
+	 * the following draw:
+	 */
+	if (!num_indices)
+		return;
+
+	if (stack[d].ndraws == stack[d].maxdraws) {
+		stack[d].maxdraws = stack[d].maxdraws ? stack[d].maxdraws * 2 : 256;
+		stack[d].draws = xrealloc(stack[d].draws,
+				stack[d].maxdraws * sizeof(stack[d].draws[0]));
+	}
+
+	stack[d].draws[stack[d].ndraws++] = stack[d].acc;
+	memset(&stack[d].acc, 0, sizeof(stack[d].acc));
+}
+
+/* attribute the draws of the IB at level d to the draw calls, and what
+ * remains after the last draw to the parent:
+ */
+static void finish(int d, struct cost *parent)
+{
+	unsigned i;
+
+	if (stack[d].ndraws) {
+		int match = (stack[d].ndraws == npending);
+
+		for (i = 0; i < stack[d].ndraws; i++)
+			add(&calls[match ? pending[i] : flush_call].cost, &stack[d].draws[i]);
+
+		if (match)
+			matched++;
+		else
+			unmatched++;
+	}
+
+	add(parent, &stack[d].acc);
+}
+
+/* returns whether the IB was already executed in this submit: */
+static int check_seen(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	unsigned i;
+
+	for (i = 0; i < nseen; i++)
+		if ((seen[i].gpuaddr == gpuaddr) && (seen[i].sizedwords == sizedwords))
+			return 1;
+
+	if (nseen == maxseen) {
+		maxseen = maxseen ? maxseen * 2 : 256;
+		seen = xrealloc(seen, maxseen * sizeof(seen[0]));
+	}
+
+	seen[nseen].gpuaddr = gpuaddr;
+	seen[nseen].sizedwords = sizedwords;
+	nseen++;
+
+	return 0;
+}
+
+void apicost_begin_ib(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	if (!enabled || (depth < 0))
+		return;
+
+	depth++;
+
+	if (depth >= NSTACK) {
+		if (!warned)
+			fprintf(stderr, "apicost: IBs nested more than %d deep, "
+					"folding the inner ones into the outer IB\n", NSTACK);
+		warned = 1;
+		return;
+	}
+
+	memset(&stack[depth].acc, 0, sizeof(stack[depth].acc));
+	stack[depth].ndraws = 0;
+	stack[depth].repeat = stack[depth-1].repeat ||
+			check_seen(gpuaddr, sizedwords);
+}
+
+void apicost_end_ib(void)
+{
+	if (!enabled || (depth <= 0))
+		return;
+
+	if (depth < NSTACK)
+		finish(depth, &stack[depth-1].acc);
+	depth--;
+}
+
+void apicost_end_submit(void)
+{
+	if (!enabled || (depth < 0))
+		return;
+
+	while (depth > 0)
+		apicost_end_ib();
+
+	finish(0, &calls[flush_call].cost);
+	depth = -1;
+	npending = 0;
+}
+
+void apicost_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	ncalls = npending = nbuffers = 0;
+	if (buffer_idx)
+		memset(buffer_idx, 0, buffer_idx_size * sizeof(buffer_idx[0]));
+	matched = unmatched = 0;
+	cur_call = -1;
+	depth = -1;
+
+	printf("api call cost for %s:\n", name);
+}
+
+static int cmp_call(const void *a, const void *b)
+{
+	const struct call *ca = a, *cb = b;
+	if (ca->cost.dwords != cb->cost.dwords)
+		return (ca->cost.dwords < cb->cost.dwords) ? 1 : -1;
+	return (int)cb->calls - (int)ca->calls;
+}
+
+void apicost_end_cmdstream(void)
+{
+	unsigned i;
+
+	if (!enabled)
+		return;
+
+	qsort(calls, ncalls, sizeof(calls[0]), cmp_call);
+
+	printf("%-24s %8s %10s %9s %9s %9s %7s %12s %8s\n", "call", "calls",
+			"dwords", "dw/call", "packets", "regs", "draws", "upload bytes",
+			"submits");
+	for (i = 0; i < ncalls; i++) {
+		struct call *c = &calls[i];
+		printf("%-24s %8u %10"PRIu64" %9.1f %9"PRIu64" %9"PRIu64" %7"PRIu64
+				" %12"PRIu64" %8u\n", c->name, c->calls, c->cost.dwords,
+				c->calls ? (double)c->cost.dwords / c->calls : 0.0,
+				c->cost.packets, c->cost.regs, c->cost.draws,
+				c->buffer_bytes, c->submits);
+	}
+
+	if (unmatched)
+		printf("%u of %u IBs with draws did not match the draw calls, and were "
+				"attributed to the flushing call\n", unmatched, matched + unmatched);
+
+	ncalls = 0;
+}
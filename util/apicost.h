@@ -0,0 +1,85 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef APICOST_H_
+#define APICOST_H_
+
+#include <stdint.h>
+
+/* Attribute the cmdstream cost (dwords, packets, register writes, draws)
+ * and buffer uploads of a capture to the GL/EGL calls recorded as RD_CMD
+ * sections (ie. by the GCHK()/ECHK() macros in tests-3d), aggregated per
+ * API entrypoint.
+ *
+ * Buffers and submits between two RD_CMD markers are attributed to the
+ * call of the first marker.  Since the driver defers the cmdstream until
+ * a flush, the draws executed by a submit are in addition matched up in
+ * order with the glDraw* calls made since the previous submit, and the
+ * cmdstream leading up to each draw (within the IB containing the draw)
+ * is attributed to that draw call instead of the flushing call.  If the
+ * number of draws in an IB doesn't match the number of draw calls, the
+ * IB is attributed to the flushing call.
+ *
+ * An IB executed more than once in a submit (ie. the draws replayed for
+ * each bin) is only counted the first time, as it was only emitted once.
+ * Buffer contents are dumped at every submit, so only buffers which are
+ * new or changed since the previous submit are counted, against the
+ * flushing call.
+ */
+
+/* called at start to enable the report: */
+void apicost_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void apicost_start_cmdstream(const char *name);
+void apicost_end_cmdstream(void);
+
+/* called for each RD_CMD section: */
+void apicost_cmd(const char *call);
+
+/* called for each RD_BUFFER_CONTENTS section: */
+void apicost_buffer(uint64_t gpuaddr, const void *buf, uint32_t sizebytes);
+
+/* called at start/end of each submit: */
+void apicost_start_submit(void);
+void apicost_end_submit(void);
+
+/* called at start/end of each IB or draw-state group: */
+void apicost_begin_ib(uint64_t gpuaddr, uint32_t sizedwords);
+void apicost_end_ib(void);
+
+/* called for each packet decoded, before the packet handler runs: */
+void apicost_advance(uint32_t sizedwords);
+
+/* called for each register write: */
+void apicost_reg(void);
+
+/* called at each draw/blit/dispatch: */
+void apicost_draw(uint32_t num_indices);
+
+#endif /* APICOST_H_ */
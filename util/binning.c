@@ -0,0 +1,399 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "binning.h"
+#include "util.h"
+
+#include "adreno_common.xml.h"
+#include "adreno_pm4.xml.h"
+#include "a3xx.xml.h"
+
+#define MAX_SIZES 16
+#define MAX_PIPES 8
+
+struct binning_stats {
+	unsigned submits;
+	unsigned bins;
+	unsigned draws[3];
+	uint64_t indices[3];
+	uint64_t dwords[3];      /* state setup dwords attributed to each pass */
+	uint64_t preamble;       /* dwords from CP_SET_BIN to first draw in bin */
+	uint64_t epilogue;       /* dwords after last draw in bin (resolve, etc) */
+	uint64_t total;
+	unsigned vis_cull_draws; /* gmem draws with VIS_CULL set */
+	unsigned unpiped_draws;  /* .. of those, in bins no VSC pipe covers */
+	unsigned piped_bins;     /* bins covered by a VSC pipe */
+	unsigned pipes;          /* mask of VSC pipes covering a bin */
+	unsigned empty_bins;
+	unsigned min_bin_draws, max_bin_draws;
+	unsigned first_bin_draws;
+	struct {
+		uint32_t w, h;
+		unsigned count;
+	} sizes[MAX_SIZES];
+	unsigned nsizes;
+};
+
+static const char *pass_name[] = {
+		[BINNING_PASS_BYPASS]  = "bypass",
+		[BINNING_PASS_BINNING] = "binning",
+		[BINNING_PASS_GMEM]    = "gmem",
+};
+
+static int enabled;
+static int submit_nr;
+static struct binning_stats frame, capture;
+
+/* current bin: */
+static int in_bin;
+static unsigned bin_draws;
+
+/* dwords since last draw (or bin start): */
+static uint64_t pending;
+
+/* VSC_PIPE[n].CONFIG, the rectangle of bins (in units of bins) that each
+ * pipe's visibility stream covers:
+ */
+static uint32_t pipe_config[MAX_PIPES];
+
+/* size of the bin at the origin, to turn bin coordinates into a bin
+ * position, and the pipe covering the current bin (or -1):
+ */
+static uint32_t bin_w, bin_h;
+static int bin_pipe;
+
+void binning_enable(void)
+{
+	enabled = 1;
+}
+
+static void add_size(struct binning_stats *s, uint32_t w, uint32_t h,
+		unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < s->nsizes; i++) {
+		if ((s->sizes[i].w == w) && (s->sizes[i].h == h)) {
+			s->sizes[i].count += count;
+			return;
+		}
+	}
+
+	/* just lump odd sizes into the last slot if we run out: */
+	if (i == MAX_SIZES)
+		i--;
+	else
+		s->nsizes++;
+
+	s->sizes[i].w = w;
+	s->sizes[i].h = h;
+	s->sizes[i].count += count;
+}
+
+static void accumulate(struct binning_stats *dst, const struct binning_stats *src)
+{
+	unsigned i;
+
+	if (src->bins) {
+		if (!dst->bins || (src->min_bin_draws < dst->min_bin_draws))
+			dst->min_bin_draws = src->min_bin_draws;
+		if (src->max_bin_draws > dst->max_bin_draws)
+			dst->max_bin_draws = src->max_bin_draws;
+	}
+
+	dst->submits += src->submits;
+	dst->bins += src->bins;
+	for (i = 0; i < 3; i++) {
+		dst->draws[i] += src->draws[i];
+		dst->indices[i] += src->indices[i];
+		dst->dwords[i] += src->dwords[i];
+	}
+	dst->preamble += src->preamble;
+	dst->epilogue += src->epilogue;
+	dst->total += src->total;
+	dst->vis_cull_draws += src->vis_cull_draws;
+	dst->unpiped_draws += src->unpiped_draws;
+	dst->piped_bins += src->piped_bins;
+	dst->pipes |= src->pipes;
+	dst->empty_bins += src->empty_bins;
+	dst->first_bin_draws += src->first_bin_draws;
+
+	for (i = 0; i < src->nsizes; i++)
+		add_size(dst, src->sizes[i].w, src->sizes[i].h, src->sizes[i].count);
+}
+
+static void print_stats(const char *prefix, const struct binning_stats *s)
+{
+	unsigned i;
+
+	printf("%s%u bins", prefix, s->bins);
+	for (i = 0; i < s->nsizes; i++)
+		printf("%s%ux%u: %u", i ? ", " : " (", s->sizes[i].w,
+				s->sizes[i].h, s->sizes[i].count);
+	printf("%s\n", s->nsizes ? ")" : "");
+
+	printf("\tdraws:");
+	for (i = 0; i < 3; i++)
+		printf(" %s=%u", pass_name[i], s->draws[i]);
+	printf("\n");
+
+	if (s->bins) {
+		unsigned gmem = s->draws[BINNING_PASS_GMEM];
+		printf("\tdraws per bin: min %u, avg %.1f, max %u, %u empty bins\n",
+				s->min_bin_draws, (double)gmem / s->bins,
+				s->max_bin_draws, s->empty_bins);
+		/* the visibility streams are written by the GPU in the binning
+		 * pass, so how many of these draws were actually visible in a
+		 * bin (and skipped otherwise) is not in the capture:
+		 */
+		printf("\tdraws with VIS_CULL: %u of %u (%.1f%%), %u in bins "
+				"without a VSC pipe\n", s->vis_cull_draws, gmem,
+				pct(s->vis_cull_draws, gmem), s->unpiped_draws);
+		printf("\tVSC pipes: %d used, covering %u of %u bins\n",
+				__builtin_popcount(s->pipes), s->piped_bins, s->bins);
+		printf("\tper-bin preamble: %"PRIu64" dwords (%.1f avg), epilogue: "
+				"%"PRIu64" dwords (%.1f avg), %.1f%% of cmdstream\n",
+				s->preamble, (double)s->preamble / s->bins,
+				s->epilogue, (double)s->epilogue / s->bins,
+				pct(s->preamble + s->epilogue, s->total));
+		/* if the same draws are replayed for every bin, bypass would
+		 * have executed roughly one bin worth of draws:
+		 */
+		if (s->first_bin_draws)
+			printf("\tdraw replay factor vs bypass: %.2fx (%u draws "
+					"in first bin)\n", (double)gmem / s->first_bin_draws,
+					s->first_bin_draws);
+	}
+
+	if (s->draws[BINNING_PASS_BINNING]) {
+		uint64_t idx = s->indices[BINNING_PASS_BINNING];
+		uint64_t all = idx + s->indices[BINNING_PASS_GMEM] +
+				s->indices[BINNING_PASS_BYPASS];
+		printf("\tbinning pass: %u draws, %"PRIu64" indices (%.1f%% of "
+				"all), %"PRIu64" dwords (%.1f%% of cmdstream)\n",
+				s->draws[BINNING_PASS_BINNING], idx, pct(idx, all),
+				s->dwords[BINNING_PASS_BINNING],
+				pct(s->dwords[BINNING_PASS_BINNING], s->total));
+	}
+
+	printf("\tcmdstream: %"PRIu64" dwords (", s->total);
+	for (i = 0; i < 3; i++)
+		printf("%s%s=%"PRIu64, i ? ", " : "", pass_name[i], s->dwords[i]);
+	printf(")\n");
+}
+
+static void end_bin(void)
+{
+	if (!in_bin)
+		return;
+
+	/* whatever was emitted after the last draw belongs to the bin's
+	 * epilogue (resolve, etc), in a bin without draws it is all
+	 * setup:
+	 */
+	if (bin_draws)
+		frame.epilogue += pending;
+	else
+		frame.preamble += pending;
+	pending = 0;
+
+	if (frame.bins == 1)
+		frame.first_bin_draws = bin_draws;
+	if ((frame.bins == 1) || (bin_draws < frame.min_bin_draws))
+		frame.min_bin_draws = bin_draws;
+	if (bin_draws > frame.max_bin_draws)
+		frame.max_bin_draws = bin_draws;
+	if (!bin_draws)
+		frame.empty_bins++;
+
+	in_bin = 0;
+}
+
+void binning_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	memset(&capture, 0, sizeof(capture));
+	memset(pipe_config, 0, sizeof(pipe_config));
+	bin_w = bin_h = 0;
+	printf("binning report for %s:\n", name);
+}
+
+void binning_end_cmdstream(void)
+{
+	if (!enabled)
+		return;
+
+	print_stats("total: ", &capture);
+}
+
+void binning_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.submits = 1;
+	submit_nr = submit;
+	in_bin = 0;
+	pending = 0;
+}
+
+void binning_vsc_pipe(unsigned n, uint32_t config)
+{
+	if (n < MAX_PIPES)
+		pipe_config[n] = config;
+}
+
+static int find_pipe(uint32_t bx, uint32_t by)
+{
+	unsigned i;
+
+	for (i = 0; i < MAX_PIPES; i++) {
+		uint32_t c = pipe_config[i];
+		uint32_t x = (c & A3XX_VSC_PIPE_CONFIG_X__MASK) >> A3XX_VSC_PIPE_CONFIG_X__SHIFT;
+		uint32_t y = (c & A3XX_VSC_PIPE_CONFIG_Y__MASK) >> A3XX_VSC_PIPE_CONFIG_Y__SHIFT;
+		uint32_t w = (c & A3XX_VSC_PIPE_CONFIG_W__MASK) >> A3XX_VSC_PIPE_CONFIG_W__SHIFT;
+		uint32_t h = (c & A3XX_VSC_PIPE_CONFIG_H__MASK) >> A3XX_VSC_PIPE_CONFIG_H__SHIFT;
+
+		if ((bx >= x) && (bx < x + w) && (by >= y) && (by < y + h))
+			return i;
+	}
+
+	return -1;
+}
+
+void binning_end_submit(void)
+{
+	char prefix[32];
+
+	if (!enabled)
+		return;
+
+	end_bin();
+	frame.epilogue += pending;
+	pending = 0;
+
+	snprintf(prefix, sizeof(prefix), "frame %d: ", submit_nr);
+	print_stats(prefix, &frame);
+
+	accumulate(&capture, &frame);
+}
+
+void binning_advance(uint32_t sizedwords)
+{
+	pending += sizedwords;
+	frame.total += sizedwords;
+}
+
+void binning_bin(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+		uint32_t sizedwords)
+{
+	if (!enabled)
+		return;
+
+	/* the CP_SET_BIN packet itself was already counted, but it starts
+	 * the new bin's preamble rather than ending the previous bin:
+	 */
+	if (sizedwords > pending)
+		sizedwords = pending;
+	pending -= sizedwords;
+
+	end_bin();
+
+	in_bin = 1;
+	bin_draws = 0;
+	frame.bins++;
+	add_size(&frame, x2 - x1, y2 - y1, 1);
+
+	/* bins are all the same size, apart from the ones clipped at the
+	 * right/bottom edge.  Rounding copes with x2/y2 being inclusive or
+	 * not:
+	 */
+	if ((x1 == 0) && (y1 == 0)) {
+		bin_w = x2 + 1;
+		bin_h = y2 + 1;
+	}
+	if (bin_w && bin_h)
+		bin_pipe = find_pipe((x1 + bin_w / 2) / bin_w, (y1 + bin_h / 2) / bin_h);
+	else
+		bin_pipe = -1;
+
+	if (bin_pipe >= 0) {
+		frame.piped_bins++;
+		frame.pipes |= 1 << bin_pipe;
+	}
+
+	/* counted as preamble at the bin's first draw: */
+	pending = sizedwords;
+}
+
+enum binning_pass binning_a3xx_pass(uint32_t gras_sc_control)
+{
+	uint32_t mode = (gras_sc_control & A3XX_GRAS_SC_CONTROL_RENDER_MODE__MASK) >>
+			A3XX_GRAS_SC_CONTROL_RENDER_MODE__SHIFT;
+	return (mode == RB_TILING_PASS) ? BINNING_PASS_BINNING : BINNING_PASS_BYPASS;
+}
+
+void binning_draw(enum binning_pass pass, int use_visibility,
+		uint32_t num_indices)
+{
+	if (!enabled)
+		return;
+
+	/* the binning pass happens before the first bin, and draws
+	 * outside of any bin are direct rendering:
+	 */
+	if (in_bin && (pass != BINNING_PASS_BINNING))
+		pass = BINNING_PASS_GMEM;
+
+	if (in_bin && (pass == BINNING_PASS_GMEM) && !bin_draws)
+		frame.preamble += pending;
+	else
+		frame.dwords[pass] += pending;
+	pending = 0;
+
+	frame.draws[pass]++;
+	frame.indices[pass] += num_indices;
+
+	if (in_bin && (pass == BINNING_PASS_GMEM)) {
+		bin_draws++;
+		if (use_visibility) {
+			frame.vis_cull_draws++;
+			if (bin_pipe < 0)
+				frame.unpiped_draws++;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#ifndef BINNING_H_
+#define BINNING_H_
+
+#include <stdint.h>
+
+/* Per-frame (submit) report on tiled rendering efficiency: number and
+ * size of bins, draws executed per bin, per-bin preamble overhead, the
+ * GMEM vs bypass split and the cost of the binning pass.
+ */
+
+enum binning_pass {
+	BINNING_PASS_BYPASS,     /* direct rendering, no bins */
+	BINNING_PASS_BINNING,    /* visibility (binning) pass */
+	BINNING_PASS_GMEM,       /* per-bin rendering pass */
+};
+
+/* called at start to enable the report: */
+void binning_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void binning_start_cmdstream(const char *name);
+void binning_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void binning_start_submit(int submit);
+void binning_end_submit(void);
+
+/* called for each packet decoded, before the packet handler runs: */
+void binning_advance(uint32_t sizedwords);
+
+/* CP_SET_BIN, sizedwords is the size of the packet (including the
+ * header), which was already passed to binning_advance():
+ */
+void binning_bin(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+		uint32_t sizedwords);
+
+/* VSC_PIPE[n].CONFIG register write (a3xx/a4xx share the layout): */
+void binning_vsc_pipe(unsigned n, uint32_t config);
+
+/* the pass of an a3xx/a4xx draw, from GRAS_SC_CONTROL.RENDER_MODE.  Only
+ * the binning pass can be told apart, gmem vs bypass is worked out from
+ * CP_SET_BIN.  The a3xx and a4xx register headers can't be included in
+ * the same file, so the a4xx one lives in binning-a4xx.c:
+ */
+enum binning_pass binning_a3xx_pass(uint32_t gras_sc_control);
+enum binning_pass binning_a4xx_pass(uint32_t gras_sc_control);
+
+/* called at each draw, with the pass the draw belongs to and whether
+ * the draw is subject to visibility culling:
+ */
+void binning_draw(enum binning_pass pass, int use_visibility,
+		uint32_t num_indices);
+
+#endif /* BINNING_H_ */
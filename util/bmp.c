@@ -115,5 +115,6 @@ wrap_bmp_dump(char *buffer, int width, int height, int pitch, const char *filena
 		write(fd, ptr, width * 4);
 	}
 
+	close(fd);
 }
 
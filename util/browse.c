@@ -0,0 +1,1016 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <curses.h>
+
+#include "browse.h"
+#include "util.h"
+#include "pm4.h"
+#include "io.h"
+
+const char *regname(uint32_t regbase, int color);
+uint32_t reg_val(uint32_t regbase);
+uint32_t reg_written(uint32_t regbase);
+
+#define NREGS 0x10000
+
+static bool enabled;
+static const char *filename;
+
+/* the file we read sections back from, either the original capture or
+ * a spool file for compressed captures:
+ */
+static FILE *file;
+static bool spool;
+
+/*
+ * The index:
+ */
+
+struct submit {
+	/* range of sections containing the buffers for this submit: */
+	uint64_t bufs_start, bufs_end;
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+	int first_draw, ndraws;
+	/* registers written by this submit, with final value: */
+	uint32_t first_delta, ndeltas;
+};
+
+static struct submit *submits;
+static int nsubmits, maxsubmits;
+static uint64_t bufs_start;
+static bool new_bufs = true;
+static int last_draw_count;
+
+static struct {
+	uint32_t reg, val;
+} *deltas;
+static uint32_t ndeltas, maxdeltas;
+
+/* snapshots of the register state at the start of every
+ * CHECKPOINT_INTERVAL'th submit, taken as submit_state() passes them,
+ * so stepping backwards doesn't re-apply the deltas from submit 0:
+ */
+#define CHECKPOINT_INTERVAL 64
+
+static struct checkpoint {
+	uint32_t *state;
+	uint8_t *known;
+} *checkpoints;
+static int ncheckpoints;
+
+static uint32_t dirty[NREGS];
+static uint8_t dirty_mask[NREGS / 8];
+static uint32_t dirty_vals[NREGS];
+static unsigned ndirty;
+
+/*
+ * The UI tree, only expanded nodes have children:
+ */
+
+enum node_type {
+	NODE_SUBMIT,
+	NODE_IB,
+	NODE_PACKET,
+	NODE_TEXT,
+};
+
+struct node {
+	enum node_type type;
+	struct node *parent;
+	struct node **children;
+	int nchildren;
+	bool expanded;
+	int submit;
+	int depth;
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+	char *label;
+};
+
+static struct node **roots;
+static struct node **rows;
+static int nrows, maxrows;
+static int cursor, top;
+
+/* state of the submit whose buffers are currently loaded: */
+static int loaded_bufs = -1;
+static uint32_t state[NREGS];
+static uint8_t state_known[NREGS / 8];
+static int state_submit = -1;
+static struct node *state_node;
+static bool show_state = true;
+static int state_top;
+
+static struct {
+	uint32_t reg;
+	int submit, nth;
+	bool active;
+} search;
+
+static char status[256];
+
+static char *format(const char *fmt, ...)
+{
+	char buf[512];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	return strdup(buf);
+}
+
+void browse_enable(void)
+{
+	enabled = true;
+}
+
+void browse_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	if (filename) {
+		fprintf(stderr, "browse: only a single cmdstream file is supported\n");
+		exit(1);
+	}
+
+	filename = strdup(name);
+
+	/* uncompressed captures can be read back directly: */
+	if (check_extension(name, ".rd") && strcmp(name, "-"))
+		file = fopen(name, "r");
+
+	if (!file) {
+		file = tmpfile();
+		spool = true;
+	}
+
+	if (!file) {
+		fprintf(stderr, "browse: could not open %s\n", name);
+		exit(1);
+	}
+}
+
+void browse_end_cmdstream(void)
+{
+}
+
+void browse_section(enum rd_sect_type type, const void *buf, int sz,
+		uint64_t offset)
+{
+	if (!file)
+		return;
+
+	if (spool) {
+		uint32_t hdr[2] = { type, sz };
+		offset = ftello(file);
+		fwrite(hdr, sizeof(hdr), 1, file);
+		fwrite(buf, sz, 1, file);
+	}
+
+	if (type == RD_GPUADDR) {
+		/* first buffer after a submit starts a new set of buffers: */
+		if (new_bufs)
+			bufs_start = offset;
+		new_bufs = false;
+	} else if (type == RD_CMDSTREAM_ADDR) {
+		const uint32_t *dwords = buf;
+		struct submit *s;
+
+		if (nsubmits == maxsubmits) {
+			maxsubmits = maxsubmits ? maxsubmits * 2 : 256;
+			submits = xrealloc(submits, maxsubmits * sizeof(submits[0]));
+		}
+
+		s = &submits[nsubmits++];
+		memset(s, 0, sizeof(*s));
+		s->bufs_start = bufs_start;
+		s->bufs_end = offset;
+		s->gpuaddr = dwords[0];
+		s->sizedwords = dwords[1];
+		if (sz > 8)
+			s->gpuaddr |= ((uint64_t)dwords[2]) << 32;
+		s->first_draw = last_draw_count;
+
+		new_bufs = true;
+	}
+}
+
+void browse_reg(uint32_t regbase, uint32_t val)
+{
+	if (!file)
+		return;
+
+	regbase &= NREGS - 1;
+	dirty_vals[regbase] = val;
+
+	if (dirty_mask[regbase / 8] & (1 << (regbase % 8)))
+		return;
+
+	dirty_mask[regbase / 8] |= (1 << (regbase % 8));
+	dirty[ndirty++] = regbase;
+}
+
+void browse_end_submit(int draw_count)
+{
+	struct submit *s;
+	unsigned i;
+
+	if (!file || !nsubmits)
+		return;
+
+	s = &submits[nsubmits - 1];
+	s->ndraws = draw_count - s->first_draw;
+	last_draw_count = draw_count;
+
+	if ((ndeltas + ndirty) > maxdeltas) {
+		while ((ndeltas + ndirty) > maxdeltas)
+			maxdeltas = maxdeltas ? maxdeltas * 2 : 16384;
+		deltas = xrealloc(deltas, maxdeltas * sizeof(deltas[0]));
+	}
+
+	s->first_delta = ndeltas;
+	s->ndeltas = ndirty;
+
+	for (i = 0; i < ndirty; i++) {
+		uint32_t reg = dirty[i];
+		deltas[ndeltas].reg = reg;
+		deltas[ndeltas].val = dirty_vals[reg];
+		ndeltas++;
+		dirty_mask[reg / 8] &= ~(1 << (reg % 8));
+	}
+	ndirty = 0;
+}
+
+/*
+ * Decoding on demand:
+ */
+
+static int saved_fds[2];
+static FILE *capture;
+
+/* redirect stdout/stderr into the capture file: */
+static void capture_begin(void)
+{
+	if (!capture)
+		capture = tmpfile();
+
+	fflush(stdout);
+	fflush(stderr);
+	saved_fds[0] = dup(STDOUT_FILENO);
+	saved_fds[1] = dup(STDERR_FILENO);
+
+	ftruncate(fileno(capture), 0);
+	lseek(fileno(capture), 0, SEEK_SET);
+	dup2(fileno(capture), STDOUT_FILENO);
+	dup2(fileno(capture), STDERR_FILENO);
+}
+
+static void capture_end(void)
+{
+	fflush(stdout);
+	fflush(stderr);
+	dup2(saved_fds[0], STDOUT_FILENO);
+	dup2(saved_fds[1], STDERR_FILENO);
+	close(saved_fds[0]);
+	close(saved_fds[1]);
+	rewind(capture);
+}
+
+static void load_buffers(int n)
+{
+	struct submit *s = &submits[n];
+	uint64_t offset = s->bufs_start;
+	uint64_t gpuaddr = 0;
+	uint32_t len = 0;
+
+	if ((loaded_bufs >= 0) && (submits[loaded_bufs].bufs_start == s->bufs_start))
+		return;
+
+	cffdump_reset_buffers();
+
+	fseeko(file, offset, SEEK_SET);
+	while (offset < s->bufs_end) {
+		uint32_t hdr[2], addr[3] = {0};
+		void *buf;
+
+		if (fread(hdr, sizeof(hdr), 1, file) != 1)
+			break;
+
+		if (hdr[0] == RD_GPUADDR) {
+			fread(addr, min(hdr[1], sizeof(addr)), 1, file);
+			if (hdr[1] > sizeof(addr))
+				fseeko(file, hdr[1] - sizeof(addr), SEEK_CUR);
+			gpuaddr = addr[0];
+			len = addr[1];
+			if (hdr[1] > 8)
+				gpuaddr |= ((uint64_t)addr[2]) << 32;
+		} else if (hdr[0] == RD_BUFFER_CONTENTS) {
+			buf = xrealloc(NULL, hdr[1] + 1);
+			fread(buf, hdr[1], 1, file);
+			cffdump_add_buffer(gpuaddr, len, buf);
+		} else {
+			fseeko(file, hdr[1], SEEK_CUR);
+		}
+
+		offset += sizeof(hdr) + hdr[1];
+	}
+
+	loaded_bufs = n;
+}
+
+/* save the current state as checkpoint k, ie. the state at the start
+ * of submit k * CHECKPOINT_INTERVAL:
+ */
+static void save_checkpoint(int k)
+{
+	if (k >= ncheckpoints) {
+		checkpoints = xrealloc(checkpoints, (k + 1) * sizeof(checkpoints[0]));
+		memset(&checkpoints[ncheckpoints], 0,
+				(k + 1 - ncheckpoints) * sizeof(checkpoints[0]));
+		ncheckpoints = k + 1;
+	}
+
+	if (checkpoints[k].state)
+		return;
+
+	checkpoints[k].state = xrealloc(NULL, sizeof(state));
+	checkpoints[k].known = xrealloc(NULL, sizeof(state_known));
+	memcpy(checkpoints[k].state, state, sizeof(state));
+	memcpy(checkpoints[k].known, state_known, sizeof(state_known));
+}
+
+/* compute the register state at the start of submit n, by applying
+ * the registers written by each earlier submit, starting from the
+ * closest checkpoint when going backwards:
+ */
+static void submit_state(int n)
+{
+	int i, k;
+	uint32_t j;
+
+	/* state_submit is the last submit applied to state[]: */
+	if (state_submit >= n) {
+		k = min(n / CHECKPOINT_INTERVAL, ncheckpoints - 1);
+		while ((k > 0) && !checkpoints[k].state)
+			k--;
+
+		if (k > 0) {
+			memcpy(state, checkpoints[k].state, sizeof(state));
+			memcpy(state_known, checkpoints[k].known, sizeof(state_known));
+			state_submit = k * CHECKPOINT_INTERVAL - 1;
+		} else {
+			memset(state, 0, sizeof(state));
+			memset(state_known, 0, sizeof(state_known));
+			state_submit = -1;
+		}
+	}
+
+	for (i = state_submit + 1; i < n; i++) {
+		for (j = 0; j < submits[i].ndeltas; j++) {
+			uint32_t reg = deltas[submits[i].first_delta + j].reg;
+			state[reg] = deltas[submits[i].first_delta + j].val;
+			state_known[reg / 8] |= (1 << (reg % 8));
+		}
+
+		if (((i + 1) % CHECKPOINT_INTERVAL) == 0)
+			save_checkpoint((i + 1) / CHECKPOINT_INTERVAL);
+	}
+
+	state_submit = n - 1;
+}
+
+/* set up the buffers and register state of submit n, and replay up to
+ * the stop condition:
+ */
+static bool replay(int n, struct browse_stop *stop)
+{
+	bool ret;
+
+	load_buffers(n);
+	submit_state(n);
+	cffdump_set_regs(state);
+
+	/* the decoder's register state no longer matches the state pane: */
+	state_node = NULL;
+
+	capture_begin();
+	ret = cffdump_replay(submits[n].gpuaddr, submits[n].sizedwords,
+			submits[n].first_draw, stop);
+	capture_end();
+
+	return ret;
+}
+
+static struct node *new_node(struct node *parent, enum node_type type,
+		uint64_t gpuaddr, uint32_t sizedwords, char *label)
+{
+	struct node *node = calloc(1, sizeof(*node));
+
+	node->type = type;
+	node->parent = parent;
+	node->gpuaddr = gpuaddr;
+	node->sizedwords = sizedwords;
+	node->label = label;
+
+	if (parent) {
+		node->submit = parent->submit;
+		node->depth = parent->depth + 1;
+		parent->children = xrealloc(parent->children,
+				(parent->nchildren + 1) * sizeof(parent->children[0]));
+		parent->children[parent->nchildren++] = node;
+	}
+
+	return node;
+}
+
+static void free_children(struct node *node)
+{
+	int i;
+	for (i = 0; i < node->nchildren; i++) {
+		if (node->children[i] == state_node)
+			state_node = NULL;
+		free_children(node->children[i]);
+		free(node->children[i]->label);
+		free(node->children[i]);
+	}
+	free(node->children);
+	node->children = NULL;
+	node->nchildren = 0;
+	node->expanded = false;
+}
+
+static char *packet_label(uint64_t gpuaddr, uint32_t *dwords, uint32_t *count)
+{
+	char *label;
+	const char *name;
+
+	if (pkt_is_type0(dwords[0])) {
+		*count = type0_pkt_size(dwords[0]) + 1;
+		name = regname(type0_pkt_offset(dwords[0]), 0);
+		label = format("%016"PRIx64": write %s%s (%u)", gpuaddr,
+				name ? name : "?", (dwords[0] & 0x8000) ? " (same register)" : "",
+				*count - 1);
+	} else if (pkt_is_type4(dwords[0])) {
+		*count = type4_pkt_size(dwords[0]) + 1;
+		name = regname(type4_pkt_offset(dwords[0]), 0);
+		label = format("%016"PRIx64": write %s (%u)", gpuaddr,
+				name ? name : "?", *count - 1);
+	} else if (pkt_is_type3(dwords[0]) || pkt_is_type7(dwords[0])) {
+		uint32_t opcode;
+		if (pkt_is_type3(dwords[0])) {
+			*count = type3_pkt_size(dwords[0]) + 1;
+			opcode = cp_type3_opcode(dwords[0]);
+		} else {
+			*count = type7_pkt_size(dwords[0]) + 1;
+			opcode = cp_type7_opcode(dwords[0]);
+		}
+		name = cffdump_opcode_name(opcode);
+		label = format("%016"PRIx64": %s (%u dwords)", gpuaddr,
+				name ? name : "?", *count);
+	} else if (pkt_is_type2(dwords[0])) {
+		*count = 1;
+		label = format("%016"PRIx64": nop", gpuaddr);
+	} else {
+		*count = 0;
+		label = format("%016"PRIx64": bad type! %08x", gpuaddr, dwords[0]);
+	}
+
+	return label;
+}
+
+/* list the packets in an IB (or the submit's top level cmdstream): */
+static void expand_ib(struct node *node)
+{
+	uint32_t *dwords = cffdump_hostptr(node->gpuaddr);
+	uint64_t gpuaddr = node->gpuaddr;
+	int dwords_left = node->sizedwords;
+
+	if (!dwords) {
+		new_node(node, NODE_TEXT, 0, 0, format("could not find buffer"));
+		return;
+	}
+
+	while (dwords_left > 0) {
+		uint32_t count;
+		char *label = packet_label(gpuaddr, dwords, &count);
+
+		new_node(node, count ? NODE_PACKET : NODE_TEXT, gpuaddr, count, label);
+		if (!count)
+			break;
+
+		dwords += count;
+		gpuaddr += count * 4;
+		dwords_left -= count;
+	}
+}
+
+static void add_ib(struct node *node, uint64_t gpuaddr, uint32_t sizedwords)
+{
+	char *label = format("ib %016"PRIx64" (%u dwords)", gpuaddr, sizedwords);
+	new_node(node, NODE_IB, gpuaddr, sizedwords, label);
+}
+
+/* decode a single packet, plus nodes for the IBs it references: */
+static void expand_packet(struct node *node)
+{
+	struct browse_stop stop = { .gpuaddr = node->gpuaddr, .draw = -1, .reg = -1 };
+	uint32_t *dwords;
+	char *line = NULL;
+	size_t n = 0;
+	ssize_t len;
+
+	/* get the state (draw count, etc) right before the packet: */
+	replay(node->submit, &stop);
+
+	capture_begin();
+	cffdump_decode(node->gpuaddr, node->sizedwords);
+	capture_end();
+
+	while ((len = getline(&line, &n, capture)) > 0) {
+		char buf[512];
+		int i, j;
+
+		/* expand tabs, so we know how wide the line is: */
+		for (i = 0, j = 0; (i < len) && (j < (int)sizeof(buf) - 9); i++) {
+			if (line[i] == '\n')
+				break;
+			if (line[i] == '\t') {
+				do {
+					buf[j++] = ' ';
+				} while (j % 8);
+			} else {
+				buf[j++] = line[i];
+			}
+		}
+		buf[j] = '\0';
+
+		new_node(node, NODE_TEXT, 0, 0, strdup(buf));
+	}
+	free(line);
+
+	dwords = cffdump_hostptr(node->gpuaddr);
+	if (pkt_is_type3(dwords[0]) || pkt_is_type7(dwords[0])) {
+		bool is_64b = pkt_is_type7(dwords[0]);
+		uint32_t opcode = is_64b ? cp_type7_opcode(dwords[0]) :
+				cp_type3_opcode(dwords[0]);
+		uint32_t i;
+
+		switch (opcode) {
+		case CP_INDIRECT_BUFFER_PFE:
+		case CP_INDIRECT_BUFFER_PFD:
+			if (is_64b)
+				add_ib(node, dwords[1] | ((uint64_t)dwords[2] << 32), dwords[3]);
+			else
+				add_ib(node, dwords[1], dwords[2]);
+			break;
+		case CP_SET_DRAW_STATE:
+			for (i = 1; i < node->sizedwords; i += is_64b ? 3 : 2) {
+				uint32_t count = dwords[i] & CP_SET_DRAW_STATE_0_COUNT__MASK;
+				if (!count)
+					continue;
+				if (is_64b)
+					add_ib(node, dwords[i+1] | ((uint64_t)dwords[i+2] << 32), count);
+				else
+					add_ib(node, dwords[i+1], count);
+			}
+			break;
+		}
+	}
+}
+
+static void expand(struct node *node)
+{
+	if (node->expanded || (node->type == NODE_TEXT))
+		return;
+
+	load_buffers(node->submit);
+
+	if (node->type == NODE_PACKET)
+		expand_packet(node);
+	else
+		expand_ib(node);
+
+	node->expanded = true;
+}
+
+static void add_rows(struct node *node)
+{
+	int i;
+
+	if (nrows == maxrows) {
+		maxrows = maxrows ? maxrows * 2 : 1024;
+		rows = xrealloc(rows, maxrows * sizeof(rows[0]));
+	}
+	rows[nrows++] = node;
+
+	if (node->expanded)
+		for (i = 0; i < node->nchildren; i++)
+			add_rows(node->children[i]);
+}
+
+static void update_rows(void)
+{
+	int i;
+	nrows = 0;
+	for (i = 0; i < nsubmits; i++)
+		add_rows(roots[i]);
+	cursor = min(cursor, nrows - 1);
+}
+
+static int find_row(struct node *node)
+{
+	int i;
+	for (i = 0; i < nrows; i++)
+		if (rows[i] == node)
+			return i;
+	return 0;
+}
+
+/* find the child leading to gpuaddr, descending into the IB nodes of
+ * expanded packets:
+ */
+static struct node *find_child(struct node *node, uint64_t gpuaddr)
+{
+	int i;
+
+	expand(node);
+
+	for (i = 0; i < node->nchildren; i++) {
+		struct node *child = node->children[i];
+		if (child->type == NODE_PACKET) {
+			if (child->gpuaddr == gpuaddr)
+				return child;
+		} else if (child->type == NODE_IB) {
+			if ((child->gpuaddr <= gpuaddr) &&
+					(gpuaddr < (child->gpuaddr + child->sizedwords * 4))) {
+				struct node *found = find_child(child, gpuaddr);
+				if (found)
+					return found;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* expand the tree along the path of the stop point, and move the
+ * cursor there:
+ */
+static void goto_path(int n, struct browse_stop *stop)
+{
+	struct node *node = roots[n];
+	int i;
+
+	for (i = 0; i < stop->depth; i++) {
+		struct node *child = find_child(node, stop->path[i]);
+		if (!child)
+			break;
+		node->expanded = true;
+		node = child;
+	}
+
+	update_rows();
+	cursor = find_row(node);
+}
+
+static void goto_draw(int draw)
+{
+	struct browse_stop stop = { .draw = draw, .reg = -1 };
+	int lo = 0, hi = nsubmits - 1;
+
+	/* find the submit containing the draw: */
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (submits[mid].first_draw <= draw)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	if (!nsubmits || (draw < submits[lo].first_draw) ||
+			(draw >= (submits[lo].first_draw + submits[lo].ndraws))) {
+		snprintf(status, sizeof(status), "draw %d not found", draw);
+		return;
+	}
+
+	if (replay(lo, &stop))
+		goto_path(lo, &stop);
+}
+
+static bool submit_writes(int n, uint32_t reg)
+{
+	uint32_t i;
+	for (i = 0; i < submits[n].ndeltas; i++)
+		if (deltas[submits[n].first_delta + i].reg == reg)
+			return true;
+	return false;
+}
+
+static void search_next(void)
+{
+	int n = search.submit;
+	int nth = search.nth + 1;
+
+	while (n < nsubmits) {
+		if (submit_writes(n, search.reg)) {
+			struct browse_stop stop = { .draw = -1, .reg = search.reg, .nth = nth };
+			if (replay(n, &stop)) {
+				search.submit = n;
+				search.nth = nth;
+				goto_path(n, &stop);
+				return;
+			}
+		}
+		n++;
+		nth = 1;
+	}
+
+	snprintf(status, sizeof(status), "no more writes to %s",
+			regname(search.reg, 0) ? regname(search.reg, 0) : "?");
+}
+
+static struct node *cursor_node(void)
+{
+	return (cursor < nrows) ? rows[cursor] : NULL;
+}
+
+/* register state before the packet at the cursor: */
+static void update_state(void)
+{
+	struct node *node = cursor_node();
+
+	while (node && (node->type != NODE_PACKET) && (node->type != NODE_SUBMIT))
+		node = node->parent;
+
+	if (!node || (node == state_node))
+		return;
+
+	if (node->type == NODE_PACKET) {
+		struct browse_stop stop = { .gpuaddr = node->gpuaddr, .draw = -1, .reg = -1 };
+		replay(node->submit, &stop);
+	} else {
+		load_buffers(node->submit);
+		submit_state(node->submit);
+		cffdump_set_regs(state);
+	}
+
+	state_node = node;
+	state_top = 0;
+}
+
+static bool state_reg(uint32_t reg)
+{
+	return reg_written(reg) || (state_known[reg / 8] & (1 << (reg % 8)));
+}
+
+static char *prompt(const char *msg)
+{
+	static char buf[128];
+
+	move(LINES - 1, 0);
+	clrtoeol();
+	printw("%s", msg);
+	echo();
+	curs_set(1);
+	getnstr(buf, sizeof(buf) - 1);
+	noecho();
+	curs_set(0);
+
+	return buf;
+}
+
+static void draw_screen(void)
+{
+	struct node *node = cursor_node();
+	int height = LINES - 1;
+	int width = show_state ? (COLS * 3) / 5 : COLS;
+	int i;
+
+	if (cursor < top)
+		top = cursor;
+	if (cursor >= (top + height))
+		top = cursor - height + 1;
+
+	erase();
+
+	for (i = 0; (i < height) && ((top + i) < nrows); i++) {
+		struct node *row = rows[top + i];
+		const char *marker = (row->type == NODE_TEXT) ? "  " :
+				row->expanded ? "- " : "+ ";
+
+		if ((top + i) == cursor)
+			attron(A_REVERSE);
+		mvprintw(i, 0, "%*s%s%.*s", row->depth * 2, "", marker,
+				max(width - row->depth * 2 - 3, 0), row->label);
+		if ((top + i) == cursor)
+			attroff(A_REVERSE);
+	}
+
+	if (show_state && state_node) {
+		uint32_t reg;
+		int skip = state_top, y = 0;
+
+		mvvline(0, width, ACS_VLINE, height);
+		for (reg = 0; (reg < NREGS) && (y < height); reg++) {
+			const char *name;
+			if (!state_reg(reg))
+				continue;
+			if (skip-- > 0)
+				continue;
+			name = regname(reg, 0);
+			mvprintw(y++, width + 2, "%08x %.*s", reg_val(reg),
+					max(COLS - width - 12, 0), name ? name : "?");
+		}
+	}
+
+	attron(A_REVERSE);
+	mvprintw(height, 0, "%-*.*s", COLS, COLS, status);
+	attroff(A_REVERSE);
+
+	if (!status[0] && node) {
+		move(height, 0);
+		attron(A_REVERSE);
+		printw("submit %d/%d, draws %d-%d | g:draw /:reg n:next s:state [/]:scroll q:quit",
+				node->submit, nsubmits,
+				submits[node->submit].first_draw,
+				submits[node->submit].first_draw + submits[node->submit].ndraws - 1);
+		attroff(A_REVERSE);
+	}
+
+	refresh();
+}
+
+void browse_run(void)
+{
+	FILE *tty;
+	SCREEN *scr;
+	int i;
+
+	if (!enabled || !file)
+		return;
+
+	if (!nsubmits) {
+		fprintf(stderr, "browse: no submits found\n");
+		return;
+	}
+
+	roots = xrealloc(NULL, nsubmits * sizeof(roots[0]));
+	for (i = 0; i < nsubmits; i++) {
+		char *label;
+		label = format("submit %d: %016"PRIx64" (%u dwords, %d draws)", i,
+				submits[i].gpuaddr, submits[i].sizedwords, submits[i].ndraws);
+		roots[i] = new_node(NULL, NODE_SUBMIT, submits[i].gpuaddr,
+				submits[i].sizedwords, label);
+		roots[i]->submit = i;
+	}
+	update_rows();
+
+	/* keep stdout free for capturing the decoder output: */
+	tty = fopen("/dev/tty", "r+");
+	if (!tty) {
+		fprintf(stderr, "browse: could not open /dev/tty\n");
+		return;
+	}
+
+	scr = newterm(NULL, tty, tty);
+	set_term(scr);
+	cbreak();
+	noecho();
+	keypad(stdscr, TRUE);
+	curs_set(0);
+
+	while (true) {
+		struct node *node;
+		char *str;
+		int c;
+
+		if (show_state)
+			update_state();
+		draw_screen();
+		status[0] = '\0';
+
+		c = getch();
+		node = cursor_node();
+
+		switch (c) {
+		case 'q':
+			goto out;
+		case KEY_UP:
+		case 'k':
+			cursor = max(cursor - 1, 0);
+			break;
+		case KEY_DOWN:
+		case 'j':
+			cursor = min(cursor + 1, nrows - 1);
+			break;
+		case KEY_PPAGE:
+			cursor = max(cursor - (LINES - 1), 0);
+			break;
+		case KEY_NPAGE:
+			cursor = min(cursor + (LINES - 1), nrows - 1);
+			break;
+		case KEY_HOME:
+			cursor = 0;
+			break;
+		case KEY_END:
+			cursor = nrows - 1;
+			break;
+		case KEY_RIGHT:
+		case '\n':
+		case ' ':
+		case 'l':
+			if (node && (node->type != NODE_TEXT)) {
+				if (node->expanded && (c != KEY_RIGHT) && (c != 'l'))
+					free_children(node);
+				else
+					expand(node);
+				update_rows();
+			}
+			break;
+		case KEY_LEFT:
+		case 'h':
+			/* collapse, or go to (and collapse) the parent: */
+			if (node && !node->expanded)
+				node = node->parent;
+			if (node) {
+				free_children(node);
+				update_rows();
+				cursor = find_row(node);
+			}
+			break;
+		case 'g':
+			str = prompt("goto draw: ");
+			if (str[0])
+				goto_draw(strtol(str, NULL, 0));
+			break;
+		case '/':
+			str = prompt("register: ");
+			if (!str[0])
+				break;
+			search.reg = cffdump_regbase(str);
+			if (!search.reg)
+				search.reg = strtoul(str, NULL, 16);
+			search.submit = node ? node->submit : 0;
+			search.nth = 0;
+			search.active = true;
+			search_next();
+			break;
+		case 'n':
+			if (search.active)
+				search_next();
+			break;
+		case 's':
+			show_state = !show_state;
+			break;
+		case '[':
+			state_top = max(state_top - (LINES - 1), 0);
+			break;
+		case ']':
+			state_top += LINES - 1;
+			break;
+		}
+	}
+
+out:
+	endwin();
+	delscreen(scr);
+	fclose(tty);
+}
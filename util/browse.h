@@ -0,0 +1,98 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef BROWSE_H_
+#define BROWSE_H_
+
+#include <stdint.h>
+
+#include "redump.h"
+
+/* Interactive (curses) trace browser.
+ *
+ * The capture is scanned once (with decoding output suppressed) to
+ * build an index of submits, the file offsets of the buffers they use,
+ * the draws they contain and the registers they write.  After that,
+ * only the packets which are expanded in the UI are decoded, by
+ * reloading the submit's buffers from the file and replaying the
+ * submit up to the packet of interest.  So memory use and latency
+ * depend on the size of a submit, not on the size of the capture.
+ *
+ * Compressed captures are spooled to a temporary file while indexing,
+ * to allow random access.
+ */
+
+/* called at start to enable the browser: */
+void browse_enable(void);
+
+/* called at start/end of the cmdstream file (only one is supported): */
+void browse_start_cmdstream(const char *name);
+void browse_end_cmdstream(void);
+
+/* called for each section read, offset is the offset of the section
+ * header in the (uncompressed) file:
+ */
+void browse_section(enum rd_sect_type type, const void *buf, int sz,
+		uint64_t offset);
+
+/* called for each register write: */
+void browse_reg(uint32_t regbase, uint32_t val);
+
+/* called after each submit is decoded, with the total draw count: */
+void browse_end_submit(int draw_count);
+
+/* called after last cmdstream file to run the UI: */
+void browse_run(void);
+
+/*
+ * provided by cffdump.c, for decoding on demand:
+ */
+
+struct browse_stop {
+	uint64_t gpuaddr;     /* stop before this packet, if non-zero */
+	int draw;             /* stop after this draw, if >= 0 */
+	int reg, nth;         /* stop after the nth write to reg, if reg >= 0 */
+
+	/* returned gpuaddr of the packet at each IB level, leading to the
+	 * point where the replay stopped:
+	 */
+	uint64_t path[8];
+	int depth;
+};
+
+void cffdump_reset_buffers(void);
+void cffdump_add_buffer(uint64_t gpuaddr, uint32_t len, void *hostptr);
+void *cffdump_hostptr(uint64_t gpuaddr);
+void cffdump_set_regs(const uint32_t *vals);
+int cffdump_replay(uint64_t gpuaddr, uint32_t sizedwords, int first_draw,
+		struct browse_stop *stop);
+void cffdump_decode(uint64_t gpuaddr, uint32_t sizedwords);
+const char *cffdump_opcode_name(uint32_t opcode);
+uint32_t cffdump_regbase(const char *name);
+
+#endif /* BROWSE_H_ */
@@ -0,0 +1,456 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "census.h"
+#include "statehash.h"
+#include "util.h"
+
+#define NREGS STATEHASH_NREGS
+#define NTOP  10
+
+static int enabled;
+static int include_consts, include_addrs;
+
+/* registers and uploaded state are all hashed in a single class: */
+static struct statehash sh;
+
+/* 0 - not classified yet, 1 - included, 2 - excluded: */
+static uint8_t reg_class[NREGS];
+
+struct state {
+	uint64_t hash;
+	unsigned id;
+	unsigned draws, frames;
+	int last_frame, first_draw;
+};
+
+static struct state *states;
+static unsigned nstates, maxstates;
+static unsigned *state_idx;      /* open addressing, index + 1 into states */
+static unsigned state_idx_size;
+
+struct transition {
+	unsigned from, to;
+	unsigned count;
+};
+
+static struct transition *transitions;
+static unsigned ntransitions, maxtransitions;
+static unsigned *trans_idx;
+static unsigned trans_idx_size;
+
+static int prev_state;
+
+struct census_stats {
+	unsigned draws, unique, new_states, changes;
+};
+static struct census_stats frame, capture;
+static int submit_nr;
+
+int census_enable(const char *flags)
+{
+	char *str = strdup(flags), *tok, *saveptr;
+
+	for (tok = strtok_r(str, ",", &saveptr); tok;
+			tok = strtok_r(NULL, ",", &saveptr)) {
+		if (!strcmp(tok, "consts")) {
+			include_consts = 1;
+		} else if (!strcmp(tok, "addrs")) {
+			include_addrs = 1;
+		} else if (strcmp(tok, "default")) {
+			free(str);
+			return -1;
+		}
+	}
+
+	free(str);
+	statehash_init(&sh, "census", 4096);
+	enabled = 1;
+	return 0;
+}
+
+/* registers holding gpu addresses, which differ between otherwise
+ * identical draws that use different buffers.  Entries are { first
+ * register, number of consecutive registers, array length, array
+ * stride }:
+ */
+struct addr_regs {
+	uint32_t reg, width, count, stride;
+};
+
+static const struct addr_regs a2xx_addr_regs[] = {
+	{ 0x0c07, 1,  8, 3 },   /* VSC_PIPE[].DATA_ADDRESS */
+	{ 0x2006, 1,  1, 1 },   /* COHER_DEST_BASE_0 */
+	{ 0x2319, 1,  1, 1 },   /* RB_COPY_DEST_BASE */
+	{ 0 },
+};
+
+static const struct addr_regs a3xx_addr_regs[] = {
+	{ 0x0c02, 1,  1, 1 },   /* VSC_SIZE_ADDRESS */
+	{ 0x0c07, 1,  8, 3 },   /* VSC_PIPE[].DATA_ADDRESS */
+	{ 0x0e23, 1,  1, 1 },   /* SP_GLOBAL_MEM_ADDR */
+	{ 0x20ed, 1,  1, 1 },   /* RB_COPY_DEST_BASE */
+	{ 0x2111, 1,  1, 1 },   /* RB_SAMPLE_COUNT_ADDR */
+	{ 0x2247, 1, 16, 2 },   /* VFD_FETCH[].INSTR_1 */
+	{ 0x22d5, 1,  1, 1 },   /* SP_VS_OBJ_START_REG */
+	{ 0x22d7, 1,  1, 1 },   /* SP_VS_PVT_MEM_ADDR_REG */
+	{ 0x22e3, 1,  1, 1 },   /* SP_FS_OBJ_START_REG */
+	{ 0x22e5, 1,  1, 1 },   /* SP_FS_PVT_MEM_ADDR_REG */
+	{ 0x2341, 1,  2, 2 },   /* TPL1_TP_{VS,FS}_BORDER_COLOR_BASE_ADDR */
+	{ 0 },
+};
+
+static const struct addr_regs a4xx_addr_regs[] = {
+	{ 0x0c01, 2,  1, 1 },   /* VSC_SIZE_ADDRESS, VSC_SIZE_ADDRESS2 */
+	{ 0x0c10, 1,  8, 1 },   /* VSC_PIPE_DATA_ADDRESS[] */
+	{ 0x0d08, 1,  1, 1 },   /* PC_TESSFACTOR_ADDR */
+	{ 0x20fd, 1,  1, 1 },   /* RB_COPY_DEST_BASE */
+	{ 0x220b, 1, 32, 4 },   /* VFD_FETCH[].INSTR_1 */
+	{ 0x22e1, 1,  2, 2 },   /* SP_VS_OBJ_START, SP_VS_PVT_MEM_ADDR */
+	{ 0x22eb, 1,  2, 2 },   /* SP_FS_OBJ_START, SP_FS_PVT_MEM_ADDR */
+	{ 0x2302, 1,  2, 2 },   /* SP_CS_OBJ_START, SP_CS_PVT_MEM_ADDR */
+	{ 0x230e, 1,  2, 2 },   /* SP_HS_OBJ_START, SP_HS_PVT_MEM_ADDR */
+	{ 0x2335, 1,  2, 2 },   /* SP_DS_OBJ_START, SP_DS_PVT_MEM_ADDR */
+	{ 0x235c, 1,  2, 2 },   /* SP_GS_OBJ_START, SP_GS_PVT_MEM_ADDR */
+	{ 0x2384, 1,  4, 3 },   /* TPL1_TP_{VS,HS,DS,GS}_BORDER_COLOR_BASE_ADDR */
+	{ 0x23a1, 1,  1, 1 },   /* TPL1_TP_FS_BORDER_COLOR_BASE_ADDR */
+	{ 0x23a4, 3,  1, 1 },   /* TPL1_TP_CS_{BORDER_COLOR,SAMPLER,TEXMEMOBJ}_BASE_ADDR */
+	{ 0 },
+};
+
+/* on a5xx addresses are LO/HI register pairs: */
+static const struct addr_regs a5xx_addr_regs[] = {
+	{ 0x2108, 2,  1, 1 },   /* RB_2D_SRC */
+	{ 0x2111, 2,  1, 1 },   /* RB_2D_DST */
+	{ 0x2140, 2,  1, 1 },   /* RB_2D_SRC_FLAGS */
+	{ 0x2143, 2,  1, 1 },   /* RB_2D_DST_FLAGS */
+	{ 0xe101, 2,  1, 1 },   /* GRAS_LRZ_BUFFER_BASE */
+	{ 0xe104, 2,  1, 1 },   /* GRAS_LRZ_FAST_CLEAR_BUFFER_BASE */
+	{ 0xe155, 2,  8, 7 },   /* RB_MRT[].BASE */
+	{ 0xe1b3, 2,  1, 1 },   /* RB_DEPTH_BUFFER_BASE */
+	{ 0xe214, 2,  1, 1 },   /* RB_BLIT_DST */
+	{ 0xe240, 2,  1, 1 },   /* RB_DEPTH_FLAG_BUFFER_BASE */
+	{ 0xe243, 2,  8, 4 },   /* RB_MRT_FLAG_BUFFER[].ADDR */
+	{ 0xe263, 2,  1, 1 },   /* RB_BLIT_FLAG_DST */
+	{ 0xe2a7, 2,  1, 1 },   /* VPC_SO_BUFFER_BASE_0 */
+	{ 0xe2ac, 2,  1, 1 },   /* VPC_SO_FLUSH_BASE_0 */
+	{ 0xe40a, 2, 32, 4 },   /* VFD_FETCH[].BASE */
+	{ 0xe5ac, 2,  1, 1 },   /* SP_VS_OBJ_START */
+	{ 0xe5c3, 2,  1, 1 },   /* SP_FS_OBJ_START */
+	{ 0xe722, 2,  1, 1 },   /* TPL1_VS_TEX_SAMP */
+	{ 0xe72a, 2,  1, 1 },   /* TPL1_VS_TEX_CONST */
+	{ 0xe75a, 2,  1, 1 },   /* TPL1_FS_TEX_CONST */
+	{ 0xe75e, 2,  1, 1 },   /* TPL1_FS_TEX_SAMP */
+	{ 0 },
+};
+
+/* captures without a gpu id are a2xx, like in cffdump: */
+static const struct addr_regs *addr_regs = a2xx_addr_regs;
+
+void census_set_gpu(unsigned gpu_id)
+{
+	if (gpu_id >= 500)
+		addr_regs = a5xx_addr_regs;
+	else if (gpu_id >= 400)
+		addr_regs = a4xx_addr_regs;
+	else if (gpu_id >= 300)
+		addr_regs = a3xx_addr_regs;
+	else
+		addr_regs = a2xx_addr_regs;
+
+	/* the classification depends on the generation: */
+	memset(reg_class, 0, sizeof(reg_class));
+}
+
+static int is_addr_reg(uint32_t reg)
+{
+	const struct addr_regs *r;
+
+	for (r = addr_regs; r->count; r++) {
+		uint32_t off = reg - r->reg;
+		if ((reg >= r->reg) &&
+				(off < ((r->count - 1) * r->stride + r->width)) &&
+				((off % r->stride) < r->width))
+			return 1;
+	}
+
+	return 0;
+}
+
+static int reg_included(uint32_t reg)
+{
+	if (!reg_class[reg])
+		reg_class[reg] = (!include_addrs && is_addr_reg(reg)) ? 2 : 1;
+	return reg_class[reg] == 1;
+}
+
+void census_reg(uint32_t regbase, uint32_t val)
+{
+	if (!enabled)
+		return;
+
+	regbase &= NREGS - 1;
+	if (!reg_included(regbase))
+		return;
+
+	statehash_reg(&sh, 0, regbase, val);
+}
+
+void census_state(uint32_t slot, enum census_class cls, const void *buf,
+		uint32_t sizedwords)
+{
+	if (!enabled || !buf)
+		return;
+	if ((cls == CENSUS_CONSTS) && !include_consts)
+		return;
+	if ((cls == CENSUS_ADDRS) && !include_addrs)
+		return;
+
+	statehash_state(&sh, 0, slot, buf, sizedwords);
+}
+
+static unsigned lookup_state(uint64_t hash, int draw)
+{
+	unsigned i;
+
+	if ((nstates * 2) >= state_idx_size) {
+		/* grow and rehash: */
+		unsigned j;
+		state_idx_size = state_idx_size ? state_idx_size * 2 : 1024;
+		free(state_idx);
+		state_idx = calloc(state_idx_size, sizeof(state_idx[0]));
+		for (j = 0; j < nstates; j++) {
+			for (i = mix(states[j].hash) % state_idx_size; state_idx[i];
+					i = (i + 1) % state_idx_size)
+				;
+			state_idx[i] = j + 1;
+		}
+	}
+
+	for (i = mix(hash) % state_idx_size; state_idx[i];
+			i = (i + 1) % state_idx_size)
+		if (states[state_idx[i] - 1].hash == hash)
+			return state_idx[i] - 1;
+
+	if (nstates == maxstates) {
+		maxstates = maxstates ? maxstates * 2 : 1024;
+		states = xrealloc(states, maxstates * sizeof(states[0]));
+	}
+
+	memset(&states[nstates], 0, sizeof(states[0]));
+	states[nstates].hash = hash;
+	states[nstates].id = nstates;
+	states[nstates].first_draw = draw;
+	states[nstates].last_frame = -1;
+	state_idx[i] = nstates + 1;
+
+	frame.new_states++;
+
+	return nstates++;
+}
+
+static void add_transition(unsigned from, unsigned to)
+{
+	uint64_t key = ((uint64_t)from << 32) | to;
+	unsigned i;
+
+	if ((ntransitions * 2) >= trans_idx_size) {
+		unsigned j;
+		trans_idx_size = trans_idx_size ? trans_idx_size * 2 : 1024;
+		free(trans_idx);
+		trans_idx = calloc(trans_idx_size, sizeof(trans_idx[0]));
+		for (j = 0; j < ntransitions; j++) {
+			uint64_t k = ((uint64_t)transitions[j].from << 32) | transitions[j].to;
+			for (i = mix(k) % trans_idx_size; trans_idx[i];
+					i = (i + 1) % trans_idx_size)
+				;
+			trans_idx[i] = j + 1;
+		}
+	}
+
+	for (i = mix(key) % trans_idx_size; trans_idx[i];
+			i = (i + 1) % trans_idx_size) {
+		struct transition *t = &transitions[trans_idx[i] - 1];
+		if ((t->from == from) && (t->to == to)) {
+			t->count++;
+			return;
+		}
+	}
+
+	if (ntransitions == maxtransitions) {
+		maxtransitions = maxtransitions ? maxtransitions * 2 : 1024;
+		transitions = xrealloc(transitions,
+				maxtransitions * sizeof(transitions[0]));
+	}
+
+	transitions[ntransitions].from = from;
+	transitions[ntransitions].to = to;
+	transitions[ntransitions].count = 1;
+	trans_idx[i] = ++ntransitions;
+}
+
+void census_draw(int draw)
+{
+	struct state *s;
+	unsigned id;
+
+	if (!enabled)
+		return;
+
+	id = lookup_state(sh.hash[0], draw);
+	s = &states[id];
+
+	s->draws++;
+	if (s->last_frame != submit_nr) {
+		s->last_frame = submit_nr;
+		s->frames++;
+		frame.unique++;
+	}
+
+	if ((prev_state >= 0) && (prev_state != (int)id)) {
+		add_transition(prev_state, id);
+		frame.changes++;
+	}
+	prev_state = id;
+
+	frame.draws++;
+}
+
+static void print_stats(const char *prefix, const struct census_stats *s)
+{
+	printf("%s%u draws, %u unique states (%u new), %u state changes (%.1f%%)\n",
+			prefix, s->draws, s->unique, s->new_states, s->changes,
+			pct(s->changes, s->draws));
+}
+
+void census_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	memset(&capture, 0, sizeof(capture));
+	statehash_reset(&sh);
+	nstates = ntransitions = 0;
+	if (state_idx)
+		memset(state_idx, 0, state_idx_size * sizeof(state_idx[0]));
+	if (trans_idx)
+		memset(trans_idx, 0, trans_idx_size * sizeof(trans_idx[0]));
+	prev_state = -1;
+
+	printf("state census for %s (%s constants, %s addresses):\n", name,
+			include_consts ? "including" : "excluding",
+			include_addrs ? "including" : "excluding");
+}
+
+static int cmp_state(const void *a, const void *b)
+{
+	const struct state *sa = a, *sb = b;
+	return (int)sb->draws - (int)sa->draws;
+}
+
+static int cmp_transition(const void *a, const void *b)
+{
+	const struct transition *ta = a, *tb = b;
+	return (int)tb->count - (int)ta->count;
+}
+
+void census_end_cmdstream(void)
+{
+	unsigned i, once = 0, top = 0;
+	struct state *sorted;
+
+	if (!enabled)
+		return;
+
+	capture.unique = nstates;
+	print_stats("total: ", &capture);
+
+	if (!nstates)
+		return;
+
+	sorted = xrealloc(NULL, nstates * sizeof(sorted[0]));
+	memcpy(sorted, states, nstates * sizeof(sorted[0]));
+	qsort(sorted, nstates, sizeof(sorted[0]), cmp_state);
+
+	for (i = 0; i < nstates; i++) {
+		if (sorted[i].draws == 1)
+			once++;
+		if (i < NTOP)
+			top += sorted[i].draws;
+	}
+
+	printf("\tstates used by a single draw: %u (%.1f%% of states)\n",
+			once, pct(once, nstates));
+	printf("\ttop %u states cover %.1f%% of draws:\n", (nstates < NTOP) ? nstates : NTOP,
+			pct(top, capture.draws));
+	for (i = 0; (i < nstates) && (i < NTOP); i++)
+		printf("\t\tstate %u: %u draws (%.1f%%), %u frames, first at draw %d\n",
+				sorted[i].id, sorted[i].draws, pct(sorted[i].draws, capture.draws),
+				sorted[i].frames, sorted[i].first_draw);
+	free(sorted);
+
+	if (ntransitions) {
+		qsort(transitions, ntransitions, sizeof(transitions[0]), cmp_transition);
+		printf("\tmost frequent transitions (of %u distinct):\n", ntransitions);
+		for (i = 0; (i < ntransitions) && (i < NTOP); i++)
+			printf("\t\tstate %u -> state %u: %u times (%.1f%% of changes)\n",
+					transitions[i].from, transitions[i].to, transitions[i].count,
+					pct(transitions[i].count, capture.changes));
+		/* the index is not valid anymore after sorting: */
+		ntransitions = 0;
+	}
+}
+
+void census_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	submit_nr = submit;
+}
+
+void census_end_submit(void)
+{
+	char prefix[32];
+
+	if (!enabled)
+		return;
+
+	snprintf(prefix, sizeof(prefix), "frame %d: ", submit_nr);
+	print_stats(prefix, &frame);
+
+	capture.draws += frame.draws;
+	capture.new_states += frame.new_states;
+	capture.changes += frame.changes;
+}
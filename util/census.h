@@ -0,0 +1,87 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef CENSUS_H_
+#define CENSUS_H_
+
+#include <stdint.h>
+
+/* Census of unique pipeline states.
+ *
+ * The state at each draw (registers, plus shaders, texture state, etc
+ * uploaded with CP_LOAD_STATE or CP_SET_CONSTANT) is hashed and interned
+ * into state objects, to report the number of unique states per frame,
+ * how often each state is reused, and the most frequent transitions
+ * between states.
+ *
+ * The hash is updated incrementally as state is written (each register
+ * or state upload contributes hash(slot, value), combined with xor), so
+ * the cost per draw does not depend on the size of the state.
+ */
+
+/* called at start to enable the census.  flags is a comma separated
+ * list of "consts" (include shader constants) and "addrs" (include
+ * registers with addresses), or "default":
+ */
+int census_enable(const char *flags);
+
+/* called when the gpu id is known, to select the registers holding
+ * addresses:
+ */
+void census_set_gpu(unsigned gpu_id);
+
+/* called at start/end of each cmdstream file: */
+void census_start_cmdstream(const char *name);
+void census_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void census_start_submit(int submit);
+void census_end_submit(void);
+
+/* called for each register write: */
+void census_reg(uint32_t regbase, uint32_t val);
+
+/* what a state upload contains, shader constants and buffer addresses
+ * are only hashed if enabled with the "consts" and "addrs" flags:
+ */
+enum census_class {
+	CENSUS_STATE,
+	CENSUS_CONSTS,
+	CENSUS_ADDRS,
+};
+
+/* called for each state upload, where slot identifies the state that
+ * is replaced (ie. state block and offset):
+ */
+void census_state(uint32_t slot, enum census_class cls, const void *buf,
+		uint32_t sizedwords);
+
+/* called at each draw: */
+void census_draw(int draw);
+
+#endif /* CENSUS_H_ */
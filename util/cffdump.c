@@ -39,8 +39,26 @@
 #include "redump.h"
 #include "disasm.h"
 #include "script.h"
+#include "timeline.h"
+#include "binning.h"
+#include "rewrite.h"
+#include "statediff.h"
+#include "census.h"
+#include "drawmerge.h"
+#include "ibreuse.h"
+#include "apicost.h"
+#include "texdesc.h"
+#include "texexport.h"
+#include "texinv.h"
+#include "constuse.h"
+#include "vsrun.h"
+#include "pktstats.h"
+#include "browse.h"
+#include "vtxcache.h"
 #include "io.h"
 #include "rnnutil.h"
+#include "pm4.h"
+#include "pm4-decode.h"
 
 /* ************************************************************************* */
 /* originally based on kernel recovery dump code: */
@@ -84,6 +102,16 @@ static int draw_filter;
 static int draw_count;
 static int current_draw_count;
 
+/* for --browse, decoding single packets and replaying up to a given
+ * point (see cffdump_decode() and cffdump_replay()):
+ */
+static bool no_recurse;
+static struct browse_stop *stop;
+static uint32_t *stop_ptr;
+static int stop_reg_count;
+static bool stopped;
+static uint32_t *pkt_stack[ARRAY_SIZE(stop->path)];
+
 /* query mode.. to handle symbolic register name queries, we need to
  * defer parsing query string until after gpu_id is know and rnn db
  * loaded:
@@ -94,13 +122,16 @@ int nquery;
 
 static char *script;
 
+/* analysis/export modes which don't want the decoded cmdstream: */
+static bool analyze = false;
+
 static bool quiet(int lvl)
 {
 	if ((draw_filter != -1) && (draw_filter != current_draw_count))
 		return true;
-	if ((lvl >= 3) && (summary || querystrs || script))
+	if ((lvl >= 3) && (summary || querystrs || script || analyze))
 		return true;
-	if ((lvl >= 2) && (querystrs || script))
+	if ((lvl >= 2) && (querystrs || script || analyze))
 		return true;
 	return false;
 }
@@ -201,7 +232,7 @@ static const char *fmt_name[] = {
 
 static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level);
 static void dump_register_val(uint32_t regbase, uint32_t dword, int level);
-static const char *regname(uint32_t regbase, int color);
+const char *regname(uint32_t regbase, int color);
 static uint32_t regbase(const char *name);
 
 struct buffer {
@@ -387,18 +418,39 @@ uint32_t reg_val(uint32_t regbase)
 	return type0_reg_vals[regbase];
 }
 
+static void set_stopped(void)
+{
+	int i;
+
+	if (stopped)
+		return;
+
+	stopped = true;
+	stop->depth = min(ib + 1, ARRAY_SIZE(stop->path));
+	for (i = 0; i < stop->depth; i++)
+		stop->path[i] = gpuaddr(pkt_stack[i]);
+}
+
 static void reg_set(uint32_t regbase, uint32_t val)
 {
 	type0_reg_vals[regbase] = val;
 	type0_reg_written[regbase/8] |= (1 << (regbase % 8));
 	type0_reg_rewritten[regbase/8] |= (1 << (regbase % 8));
+	statediff_reg(regbase, val);
+	census_reg(regbase, val);
+	drawmerge_reg(regbase, val);
+	apicost_reg();
+	browse_reg(regbase, val);
+
+	if (stop && (stop->reg == regbase) && (++stop_reg_count == stop->nth))
+		set_stopped();
 }
 
 static struct {
 	uint32_t config;
 	uint32_t address;
 	uint32_t length;
-} vsc_pipe_data[7];
+} vsc_pipe_data[8];
 
 static void reg_vsc_pipe_config(const char *name, uint32_t dword, int level)
 {
@@ -407,6 +459,7 @@ static void reg_vsc_pipe_config(const char *name, uint32_t dword, int level)
 		sscanf(name, "VSC_PIPE[0x%x].CONFIG", &idx) ||
 		sscanf(name, "VSC_PIPE[%d].CONFIG", &idx);
 	vsc_pipe_data[idx].config = dword;
+	binning_vsc_pipe(idx, dword);
 }
 
 static void reg_vsc_pipe_data_address(const char *name, uint32_t dword, int level)
@@ -514,6 +567,13 @@ static void reg_dump_scratch(const char *name, uint32_t dword, int level)
 
 static inline uint32_t REG_A5XX_CP_SCRATCH_REG(uint32_t i0) { return 0x00000b78 + 0x1*i0; }
 
+/* MRT0 BUF_INFO (format/tiling/pitch), we can't include the a3xx/a4xx/a5xx
+ * headers together:
+ */
+static inline uint32_t REG_A3XX_RB_MRT_BUF_INFO(uint32_t i0) { return 0x000020c5 + 0x4*i0; }
+static inline uint32_t REG_A4XX_RB_MRT_BUF_INFO(uint32_t i0) { return 0x000020a5 + 0x5*i0; }
+static inline uint32_t REG_A5XX_RB_MRT_BUF_INFO(uint32_t i0) { return 0x0000e152 + 0x7*i0; }
+
 static void reg_dump_scratch5(const char *name, uint32_t dword, int level)
 {
 	unsigned regbase;
@@ -850,6 +910,7 @@ static struct {
 
 static bool initialized = false;
 static struct rnn *rnn;
+static struct pm4_colors pm4_colors;
 
 static void init_rnn(const char *gpuname)
 {
@@ -857,6 +918,13 @@ static void init_rnn(const char *gpuname)
 
 	rnn_load(rnn, gpuname);
 
+	pm4_colors.reset = rnn->vc->colors->reset;
+	pm4_colors.err   = rnn->vc->colors->err;
+	pm4_colors.rname = rnn->vc->colors->rname;
+	pm4_colors.mod   = rnn->vc->colors->mod;
+	pm4_colors.num   = rnn->vc->colors->num;
+	pm4_colors.eval  = rnn->vc->colors->eval;
+
 	initialized = true;
 
 	if (querystrs) {
@@ -923,7 +991,7 @@ static void init(void)
 	}
 }
 
-static const char *regname(uint32_t regbase, int color)
+const char *regname(uint32_t regbase, int color)
 {
 	init();
 	return rnn_regname(rnn, regbase, color);
@@ -1057,11 +1125,82 @@ static void dump_domain(uint32_t *dwords, uint32_t sizedwords, int level,
 }
 
 
+static const char *packet_name(uint32_t val)
+{
+	const char *name = pm4_packet_name(gpu_id / 100, val);
+	if (!name)
+		name = rnn_enumname(rnn, "adreno_pm4_type3_packets", val);
+	return name;
+}
+
+/* decode the packet payload with the generated decoder, falling back
+ * to the generic rnn path for packets it doesn't know about:
+ */
+static void dump_packet(uint32_t *dwords, uint32_t sizedwords, int level,
+		uint32_t val, const char *name)
+{
+	if (pm4_decode_packet(gpu_id / 100, val, dwords, sizedwords,
+			levels[level], &pm4_colors) < 0)
+		dump_domain(dwords, sizedwords, level, name);
+}
+
+
 static uint32_t bin_x1, bin_x2, bin_y1, bin_y2;
 static unsigned mode;
 static unsigned render_mode;
 
-/* well, actually query and script..
+/* a5xx CP_SET_RENDER_MODE modes: */
+#define RENDER_MODE_BINNING 2
+
+static enum binning_pass current_pass(void)
+{
+	static uint32_t sc_control;
+	uint32_t val;
+
+	if (gpu_id >= 500) {
+		if ((render_mode & CP_SET_RENDER_MODE_0_MODE__MASK) == RENDER_MODE_BINNING)
+			return BINNING_PASS_BINNING;
+		if (mode & CP_SET_RENDER_MODE_3_GMEM_ENABLE)
+			return BINNING_PASS_GMEM;
+		return BINNING_PASS_BYPASS;
+	}
+
+	/* a2xx has no binning pass or bypass, draws render to EDRAM unless
+	 * it is doing a resolve:
+	 */
+	if (gpu_id < 300) {
+		val = (reg_val(REG_A2XX_RB_MODECONTROL) &
+				A2XX_RB_MODECONTROL_EDRAM_MODE__MASK) >>
+				A2XX_RB_MODECONTROL_EDRAM_MODE__SHIFT;
+		if ((val == COLOR_DEPTH) || (val == DEPTH_ONLY))
+			return BINNING_PASS_GMEM;
+		return BINNING_PASS_BYPASS;
+	}
+
+	if (!sc_control)
+		sc_control = regbase("GRAS_SC_CONTROL");
+
+	/* binning.c figures out gmem vs bypass based on CP_SET_BIN: */
+	if (gpu_id >= 400)
+		return binning_a4xx_pass(reg_val(sc_control));
+	return binning_a3xx_pass(reg_val(sc_control));
+}
+
+/* identify the render target, without the address (which differs
+ * between captures):
+ */
+static uint32_t current_rt(void)
+{
+	if (gpu_id >= 500)
+		return reg_val(REG_A5XX_RB_MRT_BUF_INFO(0));
+	if (gpu_id >= 400)
+		return reg_val(REG_A4XX_RB_MRT_BUF_INFO(0));
+	if (gpu_id >= 300)
+		return reg_val(REG_A3XX_RB_MRT_BUF_INFO(0));
+	return reg_val(REG_A2XX_RB_COLOR_INFO) & ~A2XX_RB_COLOR_INFO_BASE__MASK;
+}
+
+/* well, actually query and script (and statediff)..
  * NOTE: call this before dump_register_summary()
  */
 static void do_query(const char *primtype, uint32_t num_indices)
@@ -1097,6 +1236,14 @@ static void do_query(const char *primtype, uint32_t num_indices)
 
 	if (num_indices > 0)
 		script_draw(primtype, num_indices);
+
+	statediff_draw(primtype, current_rt(), draw_count);
+	census_draw(draw_count);
+	drawmerge_draw(draw_count, primtype, num_indices);
+	apicost_draw(num_indices);
+	texexport_draw(draw_count);
+	texinv_draw(draw_count);
+	constuse_draw(draw_count);
 }
 
 static void cp_im_loadi(uint32_t *dwords, uint32_t sizedwords, int level)
@@ -1121,6 +1268,10 @@ static void cp_im_loadi(uint32_t *dwords, uint32_t sizedwords, int level)
 		type = "<unknown>"; break;
 	}
 
+	if (ext)
+		statediff_shader(dwords[0] ? STATEDIFF_FS : STATEDIFF_VS,
+				dwords + 2, sizedwords - 2);
+
 	printf("%s%s shader, start=%04x, size=%04x\n", levels[level], type, start, size);
 	disasm_a2xx(dwords + 2, sizedwords - 2, level+2, disasm_type);
 
@@ -1140,6 +1291,28 @@ static void cp_wide_reg_write(uint32_t *dwords, uint32_t sizedwords, int level)
 	}
 }
 
+/* size of the CP_LOAD_STATE payload, in dwords: */
+static uint32_t load_state_dwords(enum adreno_state_block state_block_id,
+		enum adreno_state_type state_type, uint32_t num_unit)
+{
+	switch (state_block_id) {
+	case SB_FRAG_SHADER:
+	case SB_GEOM_SHADER:
+	case SB_VERT_SHADER:
+	case SB_COMPUTE_SHADER:
+		if (state_type == ST_SHADER)
+			return num_unit * 2 * ((gpu_id >= 400) ? 16 : (gpu_id >= 300) ? 4 : 1);
+		return num_unit * 2 * ((gpu_id >= 400) ? 2 : 1);
+	case SB_FRAG_TEX:
+	case SB_VERT_TEX:
+		if (state_type == ST_SHADER)
+			return num_unit * ((gpu_id >= 500) ? 4 : 2);
+		return num_unit * ((gpu_id >= 500) ? 12 : (gpu_id >= 400) ? 8 : 4);
+	default:
+		return num_unit;
+	}
+}
+
 static void cp_load_state(uint32_t *dwords, uint32_t sizedwords, int level)
 {
 	enum adreno_state_block state_block_id = (dwords[0] >> 19) & 0x7;
@@ -1147,10 +1320,8 @@ static void cp_load_state(uint32_t *dwords, uint32_t sizedwords, int level)
 	uint32_t num_unit = (dwords[0] >> 22) & 0x1ff;
 	uint64_t ext_src_addr;
 	void *contents = NULL;
-	int i;
-
-	if (quiet(2))
-		return;
+	uint32_t slot;
+	int i, is_const;
 
 	if (is_64b()) {
 		ext_src_addr = dwords[1] & 0xfffffffc;
@@ -1170,6 +1341,79 @@ static void cp_load_state(uint32_t *dwords, uint32_t sizedwords, int level)
 	if (!contents)
 		return;
 
+	/* hash state for --diff, --census and --merge, even when not decoding: */
+	slot = (state_block_id << 18) | (state_type << 16) | (dwords[0] & 0xffff);
+	is_const = (state_type == ST_CONSTANTS) && (state_block_id >= SB_VERT_SHADER);
+	census_state(slot, is_const ? CENSUS_CONSTS : CENSUS_STATE, contents,
+			load_state_dwords(state_block_id, state_type, num_unit));
+	drawmerge_state(slot, is_const ? DRAWMERGE_CONSTS : DRAWMERGE_STATE, contents,
+			load_state_dwords(state_block_id, state_type, num_unit));
+	if (ext_src_addr)
+		ibreuse_ref(contents, load_state_dwords(state_block_id, state_type, num_unit));
+
+	/* constants, for --const-usage.  The offset is in units of 2 dwords
+	 * on a3xx, and vec4 on a4xx+:
+	 */
+	if ((state_type == ST_CONSTANTS) &&
+			((state_block_id == SB_VERT_SHADER) || (state_block_id == SB_FRAG_SHADER))) {
+		constuse_upload((state_block_id == SB_VERT_SHADER) ? CONSTUSE_VS : CONSTUSE_FS,
+				(dwords[0] & 0xffff) * ((gpu_id >= 400) ? 4 : 2), contents,
+				load_state_dwords(state_block_id, state_type, num_unit));
+		if (state_block_id == SB_VERT_SHADER)
+			vsrun_consts((dwords[0] & 0xffff) * 2, contents,
+					load_state_dwords(state_block_id, state_type, num_unit));
+	}
+
+	/* texture descriptors and mipmap addresses, for --export-textures and
+	 * --tex-inventory:
+	 */
+	if (state_type == ST_CONSTANTS) {
+		switch (state_block_id) {
+		case SB_VERT_TEX:
+			texdesc_tex_const(TEXDESC_VS, dwords[0] & 0xffff, contents, num_unit);
+			break;
+		case SB_FRAG_TEX:
+			texdesc_tex_const(TEXDESC_FS, dwords[0] & 0xffff, contents, num_unit);
+			break;
+		case SB_VERT_MIPADDR:
+			texdesc_mipaddr(TEXDESC_VS, dwords[0] & 0xffff, contents, num_unit);
+			break;
+		case SB_FRAG_MIPADDR:
+			texdesc_mipaddr(TEXDESC_FS, dwords[0] & 0xffff, contents, num_unit);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (state_type == ST_SHADER) {
+		uint32_t shader_dwords =
+				load_state_dwords(state_block_id, state_type, num_unit);
+
+		switch (state_block_id) {
+		case SB_VERT_SHADER:
+			statediff_shader(STATEDIFF_VS, contents, shader_dwords);
+			constuse_shader(CONSTUSE_VS, contents, shader_dwords);
+			vsrun_shader(contents, shader_dwords);
+			break;
+		case SB_GEOM_SHADER:
+			statediff_shader(STATEDIFF_GS, contents, shader_dwords);
+			break;
+		case SB_FRAG_SHADER:
+			statediff_shader(STATEDIFF_FS, contents, shader_dwords);
+			constuse_shader(CONSTUSE_FS, contents, shader_dwords);
+			break;
+		case SB_COMPUTE_SHADER:
+			statediff_shader(STATEDIFF_CS, contents, shader_dwords);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (quiet(2))
+		return;
+
 	switch (state_block_id) {
 	case SB_FRAG_SHADER:
 	case SB_GEOM_SHADER:
@@ -1310,6 +1554,9 @@ static void cp_set_bin(uint32_t *dwords, uint32_t sizedwords, int level)
 	bin_y1 = dwords[1] >> 16;
 	bin_x2 = dwords[2] & 0xffff;
 	bin_y2 = dwords[2] >> 16;
+
+	timeline_bin(bin_x1, bin_y1, bin_x2, bin_y2);
+	binning_bin(bin_x1, bin_y1, bin_x2, bin_y2, sizedwords + 1);
 }
 
 static void dump_tex_const(uint32_t *dwords, uint32_t sizedwords, uint32_t val, int level)
@@ -1402,6 +1649,31 @@ static void dump_shader_const(uint32_t *dwords, uint32_t sizedwords, uint32_t va
 static void cp_set_const(uint32_t *dwords, uint32_t sizedwords, int level)
 {
 	uint32_t val = dwords[0] & 0xffff;
+
+	/* registers (type 4) are accounted for by reg_set(): */
+	if (((dwords[0] >> 16) & 0xf) != 0x4) {
+		enum drawmerge_class cls = DRAWMERGE_CONSTS;
+		enum census_class census_cls = CENSUS_CONSTS;
+
+		/* fetch constants, textures below 0x78 and vertex buffers above,
+		 * both of which contain buffer addresses:
+		 */
+		if (((dwords[0] >> 16) & 0xf) == 0x1) {
+			cls = (val < 0x78) ? DRAWMERGE_STATE : DRAWMERGE_VBO;
+			census_cls = CENSUS_ADDRS;
+		}
+
+		census_state((1 << 24) | (dwords[0] & 0xfffff), census_cls,
+				dwords + 1, sizedwords - 1);
+		drawmerge_state((1 << 24) | (dwords[0] & 0xfffff), cls,
+				dwords + 1, sizedwords - 1);
+	}
+
+	/* ALU constants, vs uses the first 256 vec4 and ps the rest: */
+	if (((dwords[0] >> 16) & 0xf) == 0x0)
+		constuse_upload((val < 0x400) ? CONSTUSE_VS : CONSTUSE_FS, val & 0x3ff,
+				dwords + 1, sizedwords - 1);
+
 	switch((dwords[0] >> 16) & 0xf) {
 	case 0x0:
 		dump_float((float *)(dwords+1), sizedwords-1, level+1);
@@ -1449,12 +1721,15 @@ static void cp_set_const(uint32_t *dwords, uint32_t sizedwords, int level)
 }
 
 static void dump_register_summary(int level);
+static void emu_draw_states(int level);
 
 static void cp_event_write(uint32_t *dwords, uint32_t sizedwords, int level)
 {
 	const char *name = rnn_enumname(rnn, "vgt_event_type", dwords[0]);
 	printl(2, "%sevent %s\n", levels[level], name);
 
+	timeline_event(name);
+
 	if (name && (gpu_id > 500)) {
 		char eventname[64];
 		snprintf(eventname, sizeof(eventname), "EVENT:%s", name);
@@ -1462,6 +1737,7 @@ static void cp_event_write(uint32_t *dwords, uint32_t sizedwords, int level)
 			bool saved_summary = summary;
 			summary = false;
 			do_query(eventname, 0);
+			timeline_draw("blit", eventname, 0, draw_count);
 			dump_register_summary(level);
 			draw_count++;
 			summary = saved_summary;
@@ -1513,6 +1789,9 @@ static uint32_t draw_indx_common(uint32_t *dwords, int level)
 	primtype = rnn_enumname(rnn, "pc_di_primtype", prim_type);
 
 	do_query(primtype, num_indices);
+	timeline_draw("draw", primtype, num_indices, draw_count);
+	binning_draw(current_pass(),
+			!!(dwords[1] & CP_DRAW_INDX_1_VIS_CULL__MASK), num_indices);
 
 	printl(2, "%sdraw:          %d\n", levels[level], draws[ib]);
 	printl(2, "%sprim_type:     %s (%d)\n", levels[level], primtype,
@@ -1530,9 +1809,12 @@ static uint32_t draw_indx_common(uint32_t *dwords, int level)
 }
 static void cp_draw_indx(uint32_t *dwords, uint32_t sizedwords, int level)
 {
-	uint32_t num_indices = draw_indx_common(dwords, level);
+	uint32_t num_indices;
 	bool saved_summary = summary;
 
+	emu_draw_states(level);
+	num_indices = draw_indx_common(dwords, level);
+
 	assert(!is_64b());
 
 	summary = false;
@@ -1545,6 +1827,14 @@ static void cp_draw_indx(uint32_t *dwords, uint32_t sizedwords, int level)
 		if (ptr) {
 			enum pc_di_index_size size =
 					((dwords[1] >> 11) & 1) | ((dwords[1] >> 12) & 2);
+			uint32_t idx_bytes = min(dwords[4], hostlen(dwords[3]));
+			uint32_t idx_size = (size == INDEX_SIZE_8_BIT) ? 1 :
+					(size == INDEX_SIZE_32_BIT) ? 4 : 2;
+			vtxcache_draw(draw_count, dwords[1] & 0x1f, ptr, idx_size,
+					min(num_indices, idx_bytes / idx_size));
+			vsrun_draw(draw_count, dwords[1] & 0x1f, ptr, idx_size,
+					min(num_indices, idx_bytes / idx_size));
+			ibreuse_ref(ptr, idx_bytes / 4);
 			if (!quiet(2)) {
 				int i;
 				printf("%sidxs:         ", levels[level]);
@@ -1567,6 +1857,10 @@ static void cp_draw_indx(uint32_t *dwords, uint32_t sizedwords, int level)
 		}
 	}
 
+	/* auto-index draws, for --run-vs: */
+	if (((dwords[1] >> 6) & 0x3) == DI_SRC_SEL_AUTO_INDEX)
+		vsrun_draw(draw_count, dwords[1] & 0x1f, NULL, 0, num_indices);
+
 	/* don't bother dumping registers for the dummy draw_indx's.. */
 	if (num_indices > 0)
 		dump_register_summary(level);
@@ -1579,17 +1873,27 @@ static void cp_draw_indx(uint32_t *dwords, uint32_t sizedwords, int level)
 
 static void cp_draw_indx_2(uint32_t *dwords, uint32_t sizedwords, int level)
 {
-	uint32_t num_indices = draw_indx_common(dwords, level);
+	uint32_t num_indices, idx_size, idx_count;
 	enum pc_di_index_size size =
 			((dwords[1] >> 11) & 1) | ((dwords[1] >> 12) & 2);
 	void *ptr = &dwords[3];
 	int sz = 0;
 	bool saved_summary = summary;
 
+	emu_draw_states(level);
+	num_indices = draw_indx_common(dwords, level);
+
 	assert(!is_64b());
 
 	summary = false;
 
+	/* the inline indices can't extend past the end of the packet: */
+	idx_size = (size == INDEX_SIZE_8_BIT) ? 1 : (size == INDEX_SIZE_32_BIT) ? 4 : 2;
+	idx_count = (sizedwords > 3) ? min(num_indices, (sizedwords - 3) * 4 / idx_size) : 0;
+
+	vtxcache_draw(draw_count, dwords[1] & 0x1f, ptr, idx_size, idx_count);
+	vsrun_draw(draw_count, dwords[1] & 0x1f, ptr, idx_size, idx_count);
+
 	/* CP_DRAW_INDX_2 has embedded/inline idx buffer: */
 	if (!quiet(2)) {
 		int i;
@@ -1626,9 +1930,38 @@ static void cp_draw_indx_offset(uint32_t *dwords, uint32_t sizedwords, int level
 {
 	uint32_t num_indices = dwords[2];
 	uint32_t prim_type = dwords[0] & 0x1f;
+	const char *primtype = rnn_enumname(rnn, "pc_di_primtype", prim_type);
 	bool saved_summary = summary;
 
-	do_query(rnn_enumname(rnn, "pc_di_primtype", prim_type), num_indices);
+	emu_draw_states(level);
+
+	do_query(primtype, num_indices);
+	timeline_draw("draw", primtype, num_indices, draw_count);
+	binning_draw(current_pass(),
+			!!(dwords[0] & CP_DRAW_INDX_OFFSET_0_VIS_CULL__MASK), num_indices);
+
+	/* index buffer, 64b address on a5xx: */
+	if ((((dwords[0] & CP_DRAW_INDX_OFFSET_0_SOURCE_SELECT__MASK) >>
+			CP_DRAW_INDX_OFFSET_0_SOURCE_SELECT__SHIFT) == DI_SRC_SEL_DMA) &&
+			(sizedwords >= (is_64b() ? 7 : 6))) {
+		enum a4xx_index_size size = (dwords[0] &
+				CP_DRAW_INDX_OFFSET_0_INDEX_SIZE__MASK) >>
+				CP_DRAW_INDX_OFFSET_0_INDEX_SIZE__SHIFT;
+		uint32_t idx_size = (size == INDEX4_SIZE_8_BIT) ? 1 :
+				(size == INDEX4_SIZE_32_BIT) ? 4 : 2;
+		uint64_t addr = dwords[4];
+		uint32_t idx_bytes = dwords[5];
+
+		if (is_64b()) {
+			addr |= ((uint64_t)dwords[5]) << 32;
+			idx_bytes = dwords[6];
+		}
+
+		idx_bytes = min(idx_bytes, hostlen(addr));
+		vtxcache_draw(draw_count, prim_type, hostptr(addr), idx_size,
+				min(num_indices, idx_bytes / idx_size));
+		ibreuse_ref(hostptr(addr), idx_bytes / 4);
+	}
 
 	summary = false;
 
@@ -1650,6 +1983,7 @@ static void cp_run_cl(uint32_t *dwords, uint32_t sizedwords, int level)
 	bool saved_summary = summary;
 
 	do_query("COMPUTE", 1);
+	timeline_draw("compute", "COMPUTE", 1, draw_count);
 
 	summary = false;
 
@@ -1719,10 +2053,18 @@ static void cp_indirect(uint32_t *dwords, uint32_t sizedwords, int level)
 		}
 	}
 
-	if (ptr) {
+	if (no_recurse) {
+		/* browse mode, IBs are expanded separately */
+	} else if (ptr) {
+		timeline_begin(TIMELINE_IB, ibaddr, ibsize);
+		ibreuse_begin(ibaddr, ptr, ibsize);
+		apicost_begin_ib(ibaddr, ibsize);
 		ib++;
 		dump_commands(ptr, ibsize, level);
 		ib--;
+		apicost_end_ib();
+		ibreuse_end();
+		timeline_end(TIMELINE_IB);
 	} else {
 		fprintf(stderr, "could not find: %016lx (%d)\n", ibaddr, ibsize);
 	}
@@ -1733,21 +2075,332 @@ static void cp_wfi(uint32_t *dwords, uint32_t sizedwords, int level)
 	needs_wfi = false;
 }
 
+/*
+ * CP emulation, for --emulate.  Normally every packet is decoded as if
+ * it was executed.  With --emulate, COND_EXEC predication, COND_WRITE,
+ * WAIT_REG_MEM, the memory side effects of MEM_WRITE/REG_TO_MEM/
+ * MEM_TO_REG, and the draw-state groups of SET_DRAW_STATE are evaluated
+ * against the register file and the captured buffers, so the state the
+ * analysis modes see is what the CP would actually have executed.
+ *
+ * Memory writes go straight into the captured buffer contents, which
+ * are reloaded for each submit.  So later packets in the same submit
+ * see them, but so does everything else looking at those buffers: an IB
+ * written by the CP hashes differently for --reuse, for example.  And
+ * since the enabled draw-state groups are executed again at each draw,
+ * like the CP does, they are counted once per draw by --reuse, --apicost
+ * and --timeline instead of once per SET_DRAW_STATE.  Results of those
+ * modes with and without --emulate are not directly comparable.
+ */
+
+static bool emulate = false;
+
+static struct {
+	unsigned cond_exec, cond_exec_skipped, dwords_skipped;
+	unsigned cond_write, cond_write_taken;
+	unsigned wait, wait_unsatisfied;
+	unsigned mem_writes, mem_dwords;
+	unsigned draw_states;
+	unsigned unresolved;
+} emu_stats;
+
+/* dwords following the current packet which the CP skips: */
+static uint32_t skip_dwords;
+
+/* CP_SET_DRAW_STATE groups, executed before each draw: */
+static struct {
+	uint64_t addr;
+	uint32_t count;
+	bool enabled;
+} draw_state[32];
+
+static void emu_reset(void)
+{
+	memset(&emu_stats, 0, sizeof(emu_stats));
+	memset(draw_state, 0, sizeof(draw_state));
+	skip_dwords = 0;
+}
+
+/* size of a gpu address in the packet, 64b on a5xx: */
+static int addr_dwords(void)
+{
+	return is_64b() ? 2 : 1;
+}
+
+/* read a gpu address from the packet, returns # of dwords: */
+static int emu_addr(uint32_t *dwords, uint64_t *addr)
+{
+	*addr = dwords[0];
+	if (is_64b()) {
+		*addr |= ((uint64_t)dwords[1]) << 32;
+		return 2;
+	}
+	return 1;
+}
+
+static uint32_t *emu_mem(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	uint32_t *ptr = hostptr(gpuaddr);
+
+	if (!ptr || (hostlen(gpuaddr) < (sizedwords * 4))) {
+		emu_stats.unresolved++;
+		return NULL;
+	}
+
+	return ptr;
+}
+
+static void emu_mem_write(uint64_t gpuaddr, uint32_t *vals, uint32_t sizedwords)
+{
+	uint32_t *ptr = emu_mem(gpuaddr, sizedwords);
+
+	if (!ptr)
+		return;
+
+	memcpy(ptr, vals, sizedwords * 4);
+	emu_stats.mem_writes++;
+	emu_stats.mem_dwords += sizedwords;
+}
+
+/* compare function used by WAIT_REG_MEM and COND_WRITE: */
+static bool emu_compare(uint32_t function, uint32_t val, uint32_t ref,
+		uint32_t mask)
+{
+	val &= mask;
+	switch (function & 0x7) {
+	case 0:  return true;
+	case 1:  return val <  ref;
+	case 2:  return val <= ref;
+	case 3:  return val == ref;
+	case 4:  return val != ref;
+	case 5:  return val >= ref;
+	case 6:  return val >  ref;
+	default: return false;
+	}
+}
+
+static const char *compare_names[] = {
+		"always", "<", "<=", "==", "!=", ">=", ">", "reserved",
+};
+
+/* poll a register or memory location, for WAIT_REG_MEM/COND_WRITE.
+ * Unresolvable memory is treated as passing, so the packets after it
+ * are still decoded:
+ */
+static bool emu_poll(bool memory, uint64_t addr, uint32_t function,
+		uint32_t ref, uint32_t mask, uint32_t *val)
+{
+	if (memory) {
+		uint32_t *ptr = emu_mem(addr & ~(uint64_t)0x3, 1);
+		if (!ptr)
+			return true;
+		*val = *ptr;
+	} else {
+		*val = reg_val(addr & regcnt());
+	}
+	return emu_compare(function, *val, ref, mask);
+}
+
+static void draw_state_exec(uint64_t addr, uint32_t count, int level)
+{
+	uint32_t *ptr = hostptr(addr);
+
+	if (!ptr || no_recurse)
+		return;
+
+	if (!quiet(2))
+		dump_hex(ptr, count, level+1);
+
+	timeline_begin(TIMELINE_IB, addr, count);
+	ibreuse_begin(addr, ptr, count);
+	apicost_begin_ib(addr, count);
+	ib++;
+	dump_commands(ptr, count, level+1);
+	ib--;
+	apicost_end_ib();
+	ibreuse_end();
+	timeline_end(TIMELINE_IB);
+}
+
+/* the CP (re)loads the enabled draw-state groups at each draw: */
+static void emu_draw_states(int level)
+{
+	int i;
+
+	if (!emulate)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(draw_state); i++) {
+		if (!draw_state[i].enabled || !draw_state[i].count)
+			continue;
+		printl(3, "%sdraw state group %d: %016llx (%u dwords)\n",
+				levels[level], i,
+				(unsigned long long)draw_state[i].addr, draw_state[i].count);
+		draw_state_exec(draw_state[i].addr, draw_state[i].count, level);
+		emu_stats.draw_states++;
+	}
+}
+
+static void cp_cond_exec(uint32_t *dwords, uint32_t sizedwords, int level)
+{
+	uint64_t addr0, addr1;
+	uint32_t ref, count, *ptr;
+	bool exec = true;
+	int i = 0;
+
+	/* a5xx: ADDR0, ADDR1 (64b), REF, DWORDS; executes if [ADDR0] != 0
+	 * and [ADDR1] < REF.  Older gens only have 32b ADDR0/ADDR1 (dword
+	 * addresses), which as far as we know just check [ADDR0] != 0:
+	 */
+	if (sizedwords < (2 * addr_dwords() + 2))
+		return;
+
+	if (is_64b()) {
+		i += emu_addr(&dwords[i], &addr0);
+		i += emu_addr(&dwords[i], &addr1);
+	} else {
+		addr0 = (uint64_t)dwords[i++] << 2;
+		addr1 = (uint64_t)dwords[i++] << 2;
+	}
+
+	ref   = dwords[i++];
+	count = dwords[i++];
+
+	printl(3, "%saddr0: %016llx\n", levels[level], (unsigned long long)addr0);
+	printl(3, "%saddr1: %016llx\n", levels[level], (unsigned long long)addr1);
+	printl(3, "%sref:   %u\n", levels[level], ref);
+	printl(3, "%sdwords: %u\n", levels[level], count);
+
+	if (!emulate)
+		return;
+
+	emu_stats.cond_exec++;
+
+	if ((ptr = emu_mem(addr0, 1)))
+		exec = exec && (*ptr != 0);
+	if (is_64b() && (ptr = emu_mem(addr1, 1)))
+		exec = exec && (*ptr < ref);
+
+	if (!exec) {
+		printl(3, "%scondition false, skipping %u dwords\n", levels[level], count);
+		emu_stats.cond_exec_skipped++;
+		emu_stats.dwords_skipped += count;
+		skip_dwords = count;
+	}
+}
+
+static void cp_cond_write(uint32_t *dwords, uint32_t sizedwords, int level)
+{
+	uint32_t function;
+	bool poll_memory, write_memory;
+	uint64_t poll_addr, write_addr;
+	uint32_t ref, mask, data, val;
+	int i = 1;
+
+	/* FUNCTION, POLL_ADDR, REF, MASK, WRITE_ADDR, DATA: */
+	if (sizedwords < (2 * addr_dwords() + 4))
+		return;
+
+	function     = dwords[0];
+	poll_memory  = !!(function & (1 << 4));
+	write_memory = !!(function & (1 << 8));
+
+	i += emu_addr(&dwords[i], &poll_addr);
+	ref  = dwords[i++];
+	mask = dwords[i++];
+	i += emu_addr(&dwords[i], &write_addr);
+	data = dwords[i++];
+
+	printl(3, "%spoll: %s%s %s 0x%08x (mask 0x%08x)\n", levels[level],
+			poll_memory ? "mem " : "",
+			poll_memory ? "" : regname(poll_addr & regcnt(), 1),
+			compare_names[function & 0x7], ref, mask);
+	if (poll_memory)
+		printl(3, "%spoll addr: %016llx\n", levels[level],
+				(unsigned long long)poll_addr);
+	printl(3, "%swrite: %s 0x%08x\n", levels[level],
+			write_memory ? "mem" : regname(write_addr & regcnt(), 1), data);
+
+	if (!emulate)
+		return;
+
+	emu_stats.cond_write++;
+
+	if (!emu_poll(poll_memory, poll_addr, function, ref, mask, &val))
+		return;
+
+	emu_stats.cond_write_taken++;
+
+	if (write_memory)
+		emu_mem_write(write_addr, &data, 1);
+	else
+		reg_set(write_addr & regcnt(), data);
+}
+
+static void cp_wait_reg_mem(uint32_t *dwords, uint32_t sizedwords, int level)
+{
+	uint32_t function;
+	bool poll_memory;
+	uint64_t poll_addr;
+	uint32_t ref, mask, val;
+	int i = 1;
+
+	/* FUNCTION, POLL_ADDR, REF, MASK: */
+	if (sizedwords < (addr_dwords() + 3))
+		return;
+
+	function    = dwords[0];
+	poll_memory = !!(function & (1 << 4));
+
+	i += emu_addr(&dwords[i], &poll_addr);
+	ref  = dwords[i++];
+	mask = dwords[i++];
+
+	printl(3, "%spoll: %s%s %s 0x%08x (mask 0x%08x)\n", levels[level],
+			poll_memory ? "mem " : "",
+			poll_memory ? "" : regname(poll_addr & regcnt(), 1),
+			compare_names[function & 0x7], ref, mask);
+	if (poll_memory)
+		printl(3, "%spoll addr: %016llx\n", levels[level],
+				(unsigned long long)poll_addr);
+
+	if (!emulate)
+		return;
+
+	emu_stats.wait++;
+
+	/* the CP would stall here until something else (another engine,
+	 * or the cpu) makes the condition true, which we can't model, so
+	 * just flag it:
+	 */
+	if (!emu_poll(poll_memory, poll_addr, function, ref, mask, &val)) {
+		printl(2, "%swait not satisfied (value 0x%08x)\n", levels[level], val);
+		emu_stats.wait_unsatisfied++;
+	}
+}
+
 static void cp_mem_write(uint32_t *dwords, uint32_t sizedwords, int level)
 {
+	uint64_t gpuaddr;
+	int i;
+
+	if (sizedwords < addr_dwords())
+		return;
+
+	i = emu_addr(dwords, &gpuaddr);
+
+	if (emulate)
+		emu_mem_write(gpuaddr, &dwords[i], sizedwords - i);
 
 	if (quiet(2))
 		return;
 
 	if (is_64b()) {
-		uint64_t gpuaddr = dwords[0] | (((uint64_t)dwords[1]) << 32);
 		printf("%sgpuaddr:%016lx\n", levels[level], gpuaddr);
-		dump_float((float *)&dwords[2], sizedwords-2, level+1);
 	} else {
-		uint32_t gpuaddr = dwords[0];
-		printf("%sgpuaddr:%08x\n", levels[level], gpuaddr);
-		dump_float((float *)&dwords[1], sizedwords-1, level+1);
+		printf("%sgpuaddr:%08x\n", levels[level], (uint32_t)gpuaddr);
 	}
+	dump_float((float *)&dwords[i], sizedwords-i, level+1);
 }
 
 static void cp_rmw(uint32_t *dwords, uint32_t sizedwords, int level)
@@ -1761,54 +2414,142 @@ static void cp_rmw(uint32_t *dwords, uint32_t sizedwords, int level)
 	reg_set(val, (reg_val(val) & and) | or);
 }
 
+/* REG_TO_MEM/MEM_TO_REG count, CNT of zero seems to mean one dword: */
+static uint32_t reg_mem_count(uint32_t dword)
+{
+	uint32_t cnt = (dword & CP_REG_TO_MEM_0_CNT__MASK) >> CP_REG_TO_MEM_0_CNT__SHIFT;
+	return cnt ? cnt : 1;
+}
+
 static void cp_reg_to_mem(uint32_t *dwords, uint32_t sizedwords, int level)
 {
-	uint32_t val = dwords[0] & 0xffff;
-	uint32_t cnt = 1 + ((dwords[0] >> 19) & 0x7ff);   /* not quite sure bitfield size */
-	uint32_t mem = dwords[0];
-	/* no real idea about the top too bits.. */
+	uint32_t val, cnt;
+	uint64_t mem;
+
+	if (sizedwords < (addr_dwords() + 1))
+		return;
+
+	val = dwords[0] & 0xffff;
+	cnt = reg_mem_count(dwords[0]);
+
+	emu_addr(&dwords[1], &mem);
+
 	printl(3, "%sread: %s\n", levels[level], regname(val, 1));
 	printl(3, "%scount: %d\n", levels[level], cnt);
-	printl(3, "%sdest: %08x\n", levels[level], mem);
+	printl(3, "%sdest: %016llx%s\n", levels[level], (unsigned long long)mem,
+			(dwords[0] & CP_REG_TO_MEM_0_ACCUMULATE) ? " (accumulate)" : "");
+
+	if (emulate) {
+		uint32_t vals[cnt], *ptr;
+		int i;
+
+		for (i = 0; i < cnt; i++)
+			vals[i] = reg_val((val + i) & regcnt());
+
+		if ((dwords[0] & CP_REG_TO_MEM_0_ACCUMULATE) &&
+				(ptr = emu_mem(mem, cnt)))
+			for (i = 0; i < cnt; i++)
+				vals[i] += ptr[i];
+
+		emu_mem_write(mem, vals, cnt);
+	}
+}
+
+static void cp_mem_to_reg(uint32_t *dwords, uint32_t sizedwords, int level)
+{
+	uint32_t val, cnt;
+	uint32_t *ptr;
+	uint64_t mem;
+	int i;
+
+	if (sizedwords < (addr_dwords() + 1))
+		return;
+
+	val = dwords[0] & 0xffff;
+	cnt = reg_mem_count(dwords[0]);
+
+	emu_addr(&dwords[1], &mem);
+
+	printl(3, "%swrite: %s\n", levels[level], regname(val, 1));
+	printl(3, "%scount: %d\n", levels[level], cnt);
+	printl(3, "%ssrc: %016llx\n", levels[level], (unsigned long long)mem);
+
+	if (!emulate || !(ptr = emu_mem(mem, cnt)))
+		return;
+
+	for (i = 0; i < cnt; i++) {
+		printl(3, "%s%s: %08x\n", levels[level+1],
+				regname((val + i) & regcnt(), 1), ptr[i]);
+		reg_set((val + i) & regcnt(), ptr[i]);
+	}
 }
 
 static void cp_set_draw_state(uint32_t *dwords, uint32_t sizedwords, int level)
 {
 	uint32_t i;
 
-	for (i = 0; i < sizedwords; ) {
-		uint32_t count = dwords[i] & 0xffff;
+	for (i = 0; (i + 1 + addr_dwords()) <= sizedwords; ) {
+		uint32_t flags = dwords[i];
+		uint32_t count = flags & CP_SET_DRAW_STATE_0_COUNT__MASK;
+		uint32_t group = (flags & CP_SET_DRAW_STATE_0_GROUP_ID__MASK) >>
+				CP_SET_DRAW_STATE_0_GROUP_ID__SHIFT;
 		uint64_t addr;
-		uint32_t *ptr;
-
-		if (is_64b()) {
-			addr = dwords[i + 1];
-			addr |= ((uint64_t)dwords[i + 2]) << 32;
-			i += 3;
-		} else {
-			addr = dwords[i + 1];
-			i += 2;
-		}
 
-		ptr = hostptr(addr);
+		i += 1 + emu_addr(&dwords[i + 1], &addr);
 
 		printl(3, "%scount: %d\n", levels[level], count);
 		printl(3, "%saddr: %016llx\n", levels[level], addr);
 
-		if (ptr) {
-			if (!quiet(2))
-				dump_hex(ptr, count, level+1);
+		if (!emulate) {
+			draw_state_exec(addr, count, level);
+			continue;
+		}
 
-			ib++;
-			dump_commands(ptr, count, level+1);
-			ib--;
+		printl(3, "%sgroup: %u%s%s%s%s\n", levels[level], group,
+				(flags & CP_SET_DRAW_STATE_0_DIRTY) ? " DIRTY" : "",
+				(flags & CP_SET_DRAW_STATE_0_DISABLE) ? " DISABLE" : "",
+				(flags & CP_SET_DRAW_STATE_0_DISABLE_ALL_GROUPS) ? " DISABLE_ALL_GROUPS" : "",
+				(flags & CP_SET_DRAW_STATE_0_LOAD_IMMED) ? " LOAD_IMMED" : "");
+
+		if (flags & CP_SET_DRAW_STATE_0_DISABLE_ALL_GROUPS) {
+			int j;
+			for (j = 0; j < ARRAY_SIZE(draw_state); j++)
+				draw_state[j].enabled = false;
+			continue;
+		}
+
+		if (flags & CP_SET_DRAW_STATE_0_LOAD_IMMED) {
+			draw_state_exec(addr, count, level);
+			continue;
 		}
+
+		draw_state[group].addr    = addr;
+		draw_state[group].count   = count;
+		draw_state[group].enabled = !(flags & CP_SET_DRAW_STATE_0_DISABLE);
 	}
 }
 
+static void emu_summary(void)
+{
+	if (!emulate)
+		return;
+
+	printf("emulate: %u COND_EXEC (%u false, %u dwords skipped), "
+			"%u COND_WRITE (%u taken), %u WAIT_REG_MEM (%u not satisfied), "
+			"%u memory writes (%u dwords), %u draw state group loads, "
+			"%u unresolved addresses\n",
+			emu_stats.cond_exec, emu_stats.cond_exec_skipped,
+			emu_stats.dwords_skipped, emu_stats.cond_write,
+			emu_stats.cond_write_taken, emu_stats.wait,
+			emu_stats.wait_unsatisfied, emu_stats.mem_writes,
+			emu_stats.mem_dwords, emu_stats.draw_states,
+			emu_stats.unresolved);
+}
+
 /* execute compute shader */
 static void cp_exec_cs(uint32_t *dwords, uint32_t sizedwords, int level)
 {
+	timeline_draw("compute", "EXEC_CS", 0, draw_count);
 	dump_register_summary(level);
 }
 
@@ -1882,10 +2623,12 @@ static void cp_set_render_mode(uint32_t *dwords, uint32_t sizedwords, int level)
 
 static void cp_blit(uint32_t *dwords, uint32_t sizedwords, int level)
 {
+	const char *name = rnn_enumname(rnn, "cp_blit_cmd", dwords[0]);
 	bool saved_summary = summary;
 	summary = false;
 
-	do_query(rnn_enumname(rnn, "cp_blit_cmd", dwords[0]), 0);
+	do_query(name, 0);
+	timeline_draw("blit", name, 0, draw_count);
 	dump_register_summary(level);
 
 	draw_count++;
@@ -1901,7 +2644,7 @@ static const struct {
 		CP(INDIRECT_BUFFER, cp_indirect),
 		CP(INDIRECT_BUFFER_PFD, cp_indirect),
 		CP(WAIT_FOR_IDLE, cp_wfi),
-		CP(WAIT_REG_MEM, NULL),
+		CP(WAIT_REG_MEM, cp_wait_reg_mem),
 		CP(WAIT_REG_EQ, NULL),
 		CP(WAIT_REG_GTE, NULL),
 		CP(WAIT_UNTIL_READ, NULL),
@@ -1910,8 +2653,8 @@ static const struct {
 		CP(REG_TO_MEM, cp_reg_to_mem),
 		CP(MEM_WRITE, cp_mem_write),
 		CP(MEM_WRITE_CNTR, NULL),
-		CP(COND_EXEC, NULL),
-		CP(COND_WRITE, NULL),
+		CP(COND_EXEC, cp_cond_exec),
+		CP(COND_WRITE, cp_cond_write),
 		CP(EVENT_WRITE, cp_event_write),
 		CP(EVENT_WRITE_SHD, NULL),
 		CP(EVENT_WRITE_CFL, NULL),
@@ -1950,6 +2693,7 @@ static const struct {
 
 		/* for a4xx */
 		CP(SET_DRAW_STATE, cp_set_draw_state),
+		CP(MEM_TO_REG, cp_mem_to_reg),
 		CP(DRAW_INDX_OFFSET, cp_draw_indx_offset),
 		CP(EXEC_CS, cp_exec_cs),
 
@@ -1958,55 +2702,17 @@ static const struct {
 		CP(BLIT, cp_blit),
 };
 
-
-static inline uint pm4_calc_odd_parity_bit(uint val)
+/* account for packets in the analysis modes, called before the
+ * packet handler:
+ */
+static void advance(uint32_t count)
 {
-	return (0x9669 >> (0xf & ((val) ^
-			((val) >> 4) ^ ((val) >> 8) ^ ((val) >> 12) ^
-			((val) >> 16) ^ ((val) >> 20) ^ ((val) >> 24) ^
-			((val) >> 28)))) & 1;
+	timeline_advance(count);
+	binning_advance(count);
+	drawmerge_advance(count);
+	apicost_advance(count);
 }
 
-#define pkt_is_type0(pkt) (((pkt) & 0XC0000000) == CP_TYPE0_PKT)
-#define type0_pkt_size(pkt) ((((pkt) >> 16) & 0x3FFF) + 1)
-#define type0_pkt_offset(pkt) ((pkt) & 0x7FFF)
-
-#define pkt_is_type2(pkt) ((pkt) == CP_TYPE2_PKT)
-
-/*
- * Check both for the type3 opcode and make sure that the reserved bits [1:7]
- * and 15 are 0
- */
-
-#define pkt_is_type3(pkt) \
-        ((((pkt) & 0xC0000000) == CP_TYPE3_PKT) && \
-         (((pkt) & 0x80FE) == 0))
-
-#define cp_type3_opcode(pkt) (((pkt) >> 8) & 0xFF)
-#define type3_pkt_size(pkt) ((((pkt) >> 16) & 0x3FFF) + 1)
-
-#define pkt_is_type4(pkt) \
-        ((((pkt) & 0xF0000000) == CP_TYPE4_PKT) && \
-         ((((pkt) >> 27) & 0x1) == \
-         pm4_calc_odd_parity_bit(type4_pkt_offset(pkt))) \
-         && ((((pkt) >> 7) & 0x1) == \
-         pm4_calc_odd_parity_bit(type4_pkt_size(pkt))))
-
-#define type4_pkt_offset(pkt) (((pkt) >> 8) & 0x7FFFF)
-#define type4_pkt_size(pkt) ((pkt) & 0x7F)
-
-#define pkt_is_type7(pkt) \
-        ((((pkt) & 0xF0000000) == CP_TYPE7_PKT) && \
-         (((pkt) & 0x0F000000) == 0) && \
-         ((((pkt) >> 23) & 0x1) == \
-         pm4_calc_odd_parity_bit(cp_type7_opcode(pkt))) \
-         && ((((pkt) >> 15) & 0x1) == \
-         pm4_calc_odd_parity_bit(type7_pkt_size(pkt))))
-
-#define cp_type7_opcode(pkt) (((pkt) >> 16) & 0x7F)
-#define type7_pkt_size(pkt) ((pkt) & 0x3FFF)
-
-
 static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 {
 	int dwords_left = sizedwords;
@@ -2022,6 +2728,17 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 
 	while (dwords_left > 0) {
 
+		if (stopped)
+			break;
+
+		if (ib < ARRAY_SIZE(pkt_stack))
+			pkt_stack[ib] = dwords;
+
+		if (stop_ptr && (dwords == stop_ptr)) {
+			set_stopped();
+			break;
+		}
+
 		current_draw_count = draw_count;
 
 		/* hack, this looks like a -1 underflow, in some versions
@@ -2034,6 +2751,7 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 			printl(3, "t0");
 			count = type0_pkt_size(dwords[0]) + 1;
 			val = type0_pkt_offset(dwords[0]);
+			advance(count);
 			printl(3, "%swrite %s%s (%04x)\n", levels[level+1], regname(val, 1),
 					(dwords[0] & 0x8000) ? " (same register)" : "", val);
 			dump_registers(val, dwords+1, count-1, level+2);
@@ -2044,6 +2762,7 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 			printl(3, "t4");
 			count = type4_pkt_size(dwords[0]) + 1;
 			val = type4_pkt_offset(dwords[0]);
+			advance(count);
 			printl(3, "%swrite %s (%04x)\n", levels[level+1], regname(val, 1), val);
 			dump_registers(val, dwords+1, count-1, level+2);
 			if (!quiet(3))
@@ -2071,15 +2790,16 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 			printl(3, "t3");
 			count = type3_pkt_size(dwords[0]) + 1;
 			val = cp_type3_opcode(dwords[0]);
+			advance(count);
 			init();
 			if (!quiet(2)) {
 				const char *name;
-				name = rnn_enumname(rnn, "adreno_pm4_type3_packets", val);
+				name = packet_name(val);
 				printf("\t%sopcode: %s%s%s (%02x) (%d dwords)%s\n", levels[level],
 						rnn->vc->colors->bctarg, name, rnn->vc->colors->reset,
 						val, count, (dwords[0] & 0x1) ? " (predicated)" : "");
 				if (name)
-					dump_domain(dwords+1, count-1, level+2, name);
+					dump_packet(dwords+1, count-1, level+2, val, name);
 			}
 			if (type3_op[val].fxn)
 				type3_op[val].fxn(dwords+1, count-1, level+1);
@@ -2089,15 +2809,16 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 			printl(3, "t7");
 			count = type7_pkt_size(dwords[0]) + 1;
 			val = cp_type7_opcode(dwords[0]);
+			advance(count);
 			init();
 			if (!quiet(2)) {
 				const char *name;
-				name = rnn_enumname(rnn, "adreno_pm4_type3_packets", val);
+				name = packet_name(val);
 				printf("\t%sopcode: %s%s%s (%02x) (%d dwords)\n", levels[level],
 						rnn->vc->colors->bctarg, name, rnn->vc->colors->reset,
 						val, count);
 				if (name)
-					dump_domain(dwords+1, count-1, level+2, name);
+					dump_packet(dwords+1, count-1, level+2, val, name);
 			}
 			if (type3_op[val].fxn)
 				type3_op[val].fxn(dwords+1, count-1, level+1);
@@ -2111,6 +2832,17 @@ static void dump_commands(uint32_t *dwords, uint32_t sizedwords, int level)
 			return;
 		}
 
+		if (stop && (stop->draw >= 0) && (draw_count > stop->draw))
+			set_stopped();
+
+		/* packets predicated off by COND_EXEC (--emulate): */
+		if (skip_dwords) {
+			skip_dwords = min(skip_dwords, dwords_left - count);
+			printl(3, "%sskipped %u dwords\n", levels[level+1], skip_dwords);
+			count += skip_dwords;
+			skip_dwords = 0;
+		}
+
 		dwords += count;
 		dwords_left -= count;
 
@@ -2126,6 +2858,8 @@ static void print_usage(const char *name)
 {
 	printf("Usage: %s [OPTIONS]... FILE...\n", name);
 	printf("    --verbose         - more verbose disassembly\n");
+	printf("    --shader-stats    - print ALU slot utilization, co-issue, fetch and\n");
+	printf("                        clause stats after each a2xx shader\n");
 	printf("    --dump-shaders    - dump each shader to raw file\n");
 	printf("    --no-color        - disable colorized output (default for non-console\n");
 	printf("                        output)\n");
@@ -2140,6 +2874,55 @@ static void print_usage(const char *name)
 	printf("    --draw N          - decode specified draw number\n");
 	printf("    --textures        - dump texture contents (if possible)\n");
 	printf("    --script FILE     - run specified lua script to analyze state at draws\n");
+	printf("    --timeline FILE   - write submit/ib/bin/draw hierarchy to FILE as chrome\n");
+	printf("                        trace-event json (dword counts are used as time)\n");
+	printf("    --binning         - report bins, draws per bin, per-bin overhead and\n");
+	printf("                        binning pass cost for each frame\n");
+	printf("    --rewrite FILE    - write an optimized copy of the cmdstream to FILE,\n");
+	printf("                        dropping redundant register writes and nops\n");
+	printf("    --strip-wfi       - with --rewrite, also drop WAIT_FOR_IDLEs which are\n");
+	printf("                        only followed by context register writes\n");
+	printf("    --diff            - compare the state at each draw between two cmdstream\n");
+	printf("                        files, aligning draws by primtype/shaders/RT format\n");
+	printf("    --vertex-cache P  - simulate the post-transform vertex cache for indexed\n");
+	printf("                        draws and report ACMR/ATVR per draw and frame, P is\n");
+	printf("                        fifo or lru, optionally with :SIZE (ie. fifo:16)\n");
+	printf("    --census FLAGS    - report unique pipeline states per frame, state reuse\n");
+	printf("                        and most frequent state changes, FLAGS is default,\n");
+	printf("                        or consts and/or addrs to include shader constants\n");
+	printf("                        and address registers in the state (ie. consts,addrs)\n");
+	printf("    --merge           - report runs of consecutive draws which only differ in\n");
+	printf("                        constants, index offsets or vertex buffers, as\n");
+	printf("                        candidates for merging or instancing\n");
+	printf("    --reuse           - report IBs and submits which are byte-identical\n");
+	printf("                        (including referenced IBs and buffers) to ones\n");
+	printf("                        from earlier frames\n");
+	printf("    --api-cost        - attribute cmdstream dwords, packets, register writes,\n");
+	printf("                        draws and buffer uploads to the GL/EGL calls\n");
+	printf("                        recorded in the capture, per entrypoint\n");
+	printf("    --export-textures DIR - write the textures used by each draw to DIR as\n");
+	printf("                        .bmp images (detiled, converted to BGRA8, one file\n");
+	printf("                        per unique mip level/layer), with an index.txt\n");
+	printf("    --tex-inventory   - report the format, size, tiling and compression of\n");
+	printf("                        the textures used per frame, sorted by size times\n");
+	printf("                        number of draws\n");
+	printf("    --const-usage     - compare the shader constants uploaded with the ones\n");
+	printf("                        read by the shaders of the following draws, and\n");
+	printf("                        report unchanged, overwritten and unread uploads\n");
+	printf("    --run-vs          - run the vertex shader of each a3xx draw on the cpu,\n");
+	printf("                        and report the vertices behind the eye or outside\n");
+	printf("                        of the view volume and the rejected triangles\n");
+	printf("    --pkt-stats       - count packets and dwords per opcode, including the\n");
+	printf("                        IBs called, indexing each buffer up front so large\n");
+	printf("                        submits are counted in parallel\n");
+	printf("    --emulate         - emulate the CP: honor COND_EXEC predication, COND_WRITE,\n");
+	printf("                        memory writes/reads by MEM_WRITE, REG_TO_MEM and\n");
+	printf("                        MEM_TO_REG, and load SET_DRAW_STATE groups at each\n");
+	printf("                        draw, so decoded and analyzed state is exact\n");
+	printf("                        (memory writes modify the captured buffers, and\n");
+	printf("                        draw-state groups count once per draw for --reuse,\n");
+	printf("                        --apicost and --timeline)\n");
+	printf("    --browse          - interactive browser, decoding packets on demand\n");
 	printf("    --query/-q REG    - query mode, dump only specified query registers on\n");
 	printf("                        each draw; multiple --query/-q args can be given to\n");
 	printf("                        dump multiple registers; register can be specified\n");
@@ -2213,13 +2996,22 @@ int main(int argc, char **argv)
 {
 	int ret, n = 1;
 	int start = 0, end = 0x7ffffff, draw = -1;
+	enum debug_t disasm_debug = 0;
 	int interactive = isatty(STDOUT_FILENO);
 
 	no_color = !interactive;
 
 	while (n < argc) {
 		if (!strcmp(argv[n], "--verbose")) {
-			disasm_set_debug(PRINT_RAW);
+			disasm_debug |= PRINT_RAW;
+			disasm_set_debug(disasm_debug);
+			n++;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--shader-stats")) {
+			disasm_debug |= PRINT_STATS;
+			disasm_set_debug(disasm_debug);
 			n++;
 			continue;
 		}
@@ -2299,6 +3091,148 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		if (!strcmp(argv[n], "--timeline")) {
+			n++;
+			if (timeline_open(argv[n])) {
+				fprintf(stderr, "error opening %s\n", argv[n]);
+				return 1;
+			}
+			n++;
+			analyze = true;
+			interactive = 0;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--binning")) {
+			n++;
+			binning_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--rewrite")) {
+			n++;
+			if (rewrite_open(argv[n])) {
+				fprintf(stderr, "error opening %s\n", argv[n]);
+				return 1;
+			}
+			n++;
+			analyze = true;
+			interactive = 0;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--strip-wfi")) {
+			n++;
+			rewrite_strip_wfi();
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--vertex-cache")) {
+			n++;
+			if (vtxcache_enable(argv[n])) {
+				fprintf(stderr, "invalid vertex cache config: %s\n", argv[n]);
+				return 1;
+			}
+			n++;
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--census")) {
+			n++;
+			if (census_enable(argv[n])) {
+				fprintf(stderr, "invalid census flags: %s\n", argv[n]);
+				return 1;
+			}
+			n++;
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--emulate")) {
+			n++;
+			emulate = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--merge")) {
+			n++;
+			drawmerge_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--reuse")) {
+			n++;
+			ibreuse_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--api-cost")) {
+			n++;
+			apicost_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--export-textures")) {
+			n++;
+			if (texexport_open(argv[n])) {
+				fprintf(stderr, "error creating %s\n", argv[n]);
+				return 1;
+			}
+			n++;
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--tex-inventory")) {
+			n++;
+			texinv_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--const-usage")) {
+			n++;
+			constuse_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--run-vs")) {
+			n++;
+			vsrun_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--pkt-stats")) {
+			n++;
+			pktstats_enable();
+			analyze = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--browse")) {
+			n++;
+			browse_enable();
+			analyze = true;
+			interactive = 0;
+			no_color = true;
+			continue;
+		}
+
+		if (!strcmp(argv[n], "--diff")) {
+			n++;
+			statediff_enable();
+			analyze = true;
+			interactive = 0;
+			continue;
+		}
+
 		if (!strcmp(argv[n], "--query") ||
 				!strcmp(argv[n], "-q")) {
 			n++;
@@ -2340,6 +3274,11 @@ int main(int argc, char **argv)
 	}
 
 	script_finish();
+	timeline_close();
+	rewrite_close();
+	texexport_close();
+	statediff_finish();
+	browse_run();
 
 	if (interactive) {
 		pager_close();
@@ -2371,6 +3310,22 @@ static int handle_file(const char *filename, int start, int end, int draw)
 	printf("Reading %s...\n", filename);
 
 	script_start_cmdstream(filename);
+	timeline_start_cmdstream(filename);
+	binning_start_cmdstream(filename);
+	statediff_start_cmdstream(filename);
+	browse_start_cmdstream(filename);
+	vtxcache_start_cmdstream(filename);
+	census_start_cmdstream(filename);
+	drawmerge_start_cmdstream(filename);
+	ibreuse_start_cmdstream(filename);
+	apicost_start_cmdstream(filename);
+	texexport_start_cmdstream(filename);
+	texinv_start_cmdstream(filename);
+	constuse_start_cmdstream(filename);
+	vsrun_start_cmdstream(filename);
+	pktstats_start_cmdstream(filename);
+	texdesc_start_cmdstream();
+	emu_reset();
 
 	if (!strcmp(filename, "-"))
 		io = io_openfd(0);
@@ -2463,12 +3418,16 @@ static int handle_file(const char *filename, int start, int end, int draw)
 		if (ret < 0)
 			goto end;
 
+		rewrite_section(type, buf, sz);
+		browse_section(type, buf, sz, io_offset(io) - sz - 8);
+
 		switch(type) {
 		case RD_TEST:
 			printl(1, "test: %s\n", (char *)buf);
 			break;
 		case RD_CMD:
 			printl(2, "cmd: %s\n", (char *)buf);
+			apicost_cmd(buf);
 			break;
 		case RD_VERT_SHADER:
 			printl(2, "vertex shader:\n%s\n", (char *)buf);
@@ -2476,6 +3435,15 @@ static int handle_file(const char *filename, int start, int end, int draw)
 		case RD_FRAG_SHADER:
 			printl(2, "fragment shader:\n%s\n", (char *)buf);
 			break;
+		case RD_TESS_CTRL_SHADER:
+			printl(2, "tess control shader:\n%s\n", (char *)buf);
+			break;
+		case RD_TESS_EVAL_SHADER:
+			printl(2, "tess eval shader:\n%s\n", (char *)buf);
+			break;
+		case RD_GEOM_SHADER:
+			printl(2, "geometry shader:\n%s\n", (char *)buf);
+			break;
 		case RD_GPUADDR:
 			if (needs_reset) {
 				for (i = 0; i < nbuffers; i++) {
@@ -2488,6 +3456,7 @@ static int handle_file(const char *filename, int start, int end, int draw)
 			parse_addr(buf, sz, &buffers[nbuffers].len, &buffers[nbuffers].gpuaddr);
 			break;
 		case RD_BUFFER_CONTENTS:
+			apicost_buffer(buffers[nbuffers].gpuaddr, buf, sz);
 			buffers[nbuffers].hostptr = buf;
 			nbuffers++;
 			assert(nbuffers < ARRAY_SIZE(buffers));
@@ -2500,10 +3469,34 @@ static int handle_file(const char *filename, int start, int end, int draw)
 				parse_addr(buf, sz, &sizedwords, &gpuaddr);
 				printl(2, "############################################################\n");
 				printl(2, "cmdstream: %d dwords\n", sizedwords);
+				timeline_begin(TIMELINE_SUBMIT, gpuaddr, sizedwords);
+				binning_start_submit(submit);
+				vtxcache_start_submit(submit);
+				census_start_submit(submit);
+				drawmerge_start_submit(submit);
+				ibreuse_start_submit(submit, gpuaddr, hostptr(gpuaddr), sizedwords);
+				apicost_start_submit();
+				texexport_start_submit(submit);
+				texinv_start_submit(submit);
+				constuse_start_submit(submit);
+				vsrun_start_submit(submit);
+				pktstats_submit(gpuaddr, sizedwords);
 				dump_commands(hostptr(gpuaddr), sizedwords, 0);
+				vsrun_end_submit();
+				constuse_end_submit();
+				texinv_end_submit();
+				texexport_end_submit();
+				apicost_end_submit();
+				ibreuse_end_submit();
+				drawmerge_end_submit();
+				census_end_submit();
+				vtxcache_end_submit();
+				binning_end_submit();
+				timeline_end(TIMELINE_SUBMIT);
 				printl(2, "############################################################\n");
 				printl(2, "vertices: %d\n", vertices);
 			}
+			browse_end_submit(draw_count);
 			needs_reset = true;
 			submit++;
 			break;
@@ -2511,6 +3504,11 @@ static int handle_file(const char *filename, int start, int end, int draw)
 			if (!got_gpu_id) {
 				gpu_id = *((unsigned int *)buf);
 				printl(2, "gpu_id: %d\n", gpu_id);
+				vtxcache_set_gpu(gpu_id);
+				census_set_gpu(gpu_id);
+				texdesc_set_gpu(gpu_id);
+				vsrun_set_gpu(gpu_id);
+				pktstats_set_gpu(gpu_id);
 				if (gpu_id >= 500)
 					init_a5xx();
 				else if (gpu_id >= 400)
@@ -2529,6 +3527,21 @@ static int handle_file(const char *filename, int start, int end, int draw)
 
 end:
 	script_end_cmdstream();
+	timeline_end_cmdstream();
+	binning_end_cmdstream();
+	statediff_end_cmdstream();
+	browse_end_cmdstream();
+	vtxcache_end_cmdstream();
+	census_end_cmdstream();
+	drawmerge_end_cmdstream();
+	ibreuse_end_cmdstream();
+	apicost_end_cmdstream();
+	texexport_end_cmdstream();
+	texinv_end_cmdstream();
+	constuse_end_cmdstream();
+	vsrun_end_cmdstream();
+	pktstats_end_cmdstream();
+	emu_summary();
 
 	io_close(io);
 
@@ -2537,3 +3550,89 @@ end:
 	}
 	return 0;
 }
+
+/*
+ * Decoding on demand, for --browse (see browse.h), and buffer lookup
+ * for --export-textures:
+ */
+
+void cffdump_reset_buffers(void)
+{
+	int i;
+	for (i = 0; i < nbuffers; i++) {
+		free(buffers[i].hostptr);
+		buffers[i].hostptr = NULL;
+	}
+	nbuffers = 0;
+}
+
+void cffdump_add_buffer(uint64_t gpuaddr, uint32_t len, void *hostptr)
+{
+	assert(nbuffers < ARRAY_SIZE(buffers));
+	buffers[nbuffers].gpuaddr = gpuaddr;
+	buffers[nbuffers].len = len;
+	buffers[nbuffers].hostptr = hostptr;
+	nbuffers++;
+}
+
+void *cffdump_hostptr(uint64_t gpuaddr)
+{
+	return hostptr(gpuaddr);
+}
+
+uint32_t cffdump_hostlen(uint64_t gpuaddr)
+{
+	return hostlen(gpuaddr);
+}
+
+void cffdump_set_regs(const uint32_t *vals)
+{
+	memcpy(type0_reg_vals, vals, sizeof(type0_reg_vals));
+	clear_written();
+}
+
+/* decode (without output) until the stop condition is hit: */
+int cffdump_replay(uint64_t gpuaddr, uint32_t sizedwords, int first_draw,
+		struct browse_stop *s)
+{
+	bool ret;
+
+	stop = s;
+	stop->depth = 0;
+	stop_ptr = s->gpuaddr ? hostptr(s->gpuaddr) : NULL;
+	stop_reg_count = 0;
+	stopped = false;
+	draw_count = first_draw;
+
+	dump_commands(hostptr(gpuaddr), sizedwords, 0);
+
+	ret = stopped;
+	stop = NULL;
+	stop_ptr = NULL;
+	stopped = false;
+
+	return ret;
+}
+
+/* decode a single packet, without descending into IBs: */
+void cffdump_decode(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	bool saved_analyze = analyze;
+
+	analyze = false;
+	no_recurse = true;
+	dump_commands(hostptr(gpuaddr), sizedwords, 0);
+	no_recurse = false;
+	analyze = saved_analyze;
+}
+
+const char *cffdump_opcode_name(uint32_t opcode)
+{
+	init();
+	return packet_name(opcode);
+}
+
+uint32_t cffdump_regbase(const char *name)
+{
+	return regbase(name);
+}
@@ -0,0 +1,291 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "constuse.h"
+#include "util.h"
+#include "disasm.h"
+
+#define MAX_DWORDS  (DISASM_MAX_CONSTS * 4)
+
+enum {
+	UPLOADED,
+	UNCHANGED,
+	OVERWRITTEN,
+	UNREAD,
+	USED,
+	UNKNOWN,      /* read by a draw, with unknown shader */
+	NCOUNTERS,
+};
+
+static const char *counter_names[] = {
+		[UPLOADED]    = "uploaded",
+		[UNCHANGED]   = "unchanged",
+		[OVERWRITTEN] = "overwritten",
+		[UNREAD]      = "unread",
+		[USED]        = "used",
+		[UNKNOWN]     = "unknown",
+};
+
+static const char *stage_names[] = {
+		[CONSTUSE_VS] = "vs",
+		[CONSTUSE_FS] = "fs",
+};
+
+/* the consts read by a shader, cached by the hash of the shader: */
+struct shader {
+	uint64_t hash;
+	struct disasm_consts consts;
+};
+
+static int enabled;
+
+static struct {
+	uint32_t vals[MAX_DWORDS];
+	uint8_t valid[MAX_DWORDS / 8];
+	uint8_t pending[MAX_DWORDS / 8];    /* uploaded, not read by a draw yet */
+	unsigned npending;
+	int shader;                         /* index into shaders, or -1 */
+	uint64_t frame[NCOUNTERS], total[NCOUNTERS];
+	unsigned draws_with_unread;         /* in the frame */
+} stages[2];
+
+static struct shader *shaders;
+static unsigned nshaders, maxshaders;
+
+static int submit_nr;
+
+static int test(const uint8_t *mask, unsigned n)
+{
+	return (mask[n / 8] >> (n % 8)) & 1;
+}
+
+static void set(uint8_t *mask, unsigned n, int val)
+{
+	mask[n / 8] = (mask[n / 8] & ~(1 << (n % 8))) | (val << (n % 8));
+}
+
+void constuse_enable(void)
+{
+	enabled = 1;
+}
+
+void constuse_upload(enum constuse_stage stage, uint32_t off,
+		const uint32_t *buf, uint32_t sizedwords)
+{
+	unsigned i;
+
+	if (!enabled || !buf)
+		return;
+
+	for (i = 0; (i < sizedwords) && (off + i < MAX_DWORDS); i++) {
+		unsigned n = off + i;
+
+		stages[stage].frame[UPLOADED]++;
+
+		if (test(stages[stage].valid, n) && (stages[stage].vals[n] == buf[i])) {
+			stages[stage].frame[UNCHANGED]++;
+			continue;
+		}
+
+		if (test(stages[stage].pending, n))
+			stages[stage].frame[OVERWRITTEN]++;
+		else
+			stages[stage].npending++;
+
+		stages[stage].vals[n] = buf[i];
+		set(stages[stage].valid, n, 1);
+		set(stages[stage].pending, n, 1);
+	}
+}
+
+void constuse_shader(enum constuse_stage stage, const void *buf,
+		uint32_t sizedwords)
+{
+	const uint32_t *dwords = buf;
+	uint64_t hash = sizedwords;
+	unsigned i;
+
+	if (!enabled)
+		return;
+
+	stages[stage].shader = -1;
+
+	if (!buf)
+		return;
+
+	for (i = 0; i < sizedwords; i++)
+		hash = mix(hash ^ dwords[i]);
+
+	for (i = 0; i < nshaders; i++) {
+		if (shaders[i].hash == hash) {
+			stages[stage].shader = i;
+			return;
+		}
+	}
+
+	if (nshaders == maxshaders) {
+		maxshaders = maxshaders ? maxshaders * 2 : 16;
+		shaders = xrealloc(shaders, maxshaders * sizeof(shaders[0]));
+	}
+
+	shaders[nshaders].hash = hash;
+	if (disasm_a3xx_consts((uint32_t *)dwords, sizedwords, &shaders[nshaders].consts))
+		return;
+
+	stages[stage].shader = nshaders++;
+}
+
+void constuse_draw(int draw)
+{
+	unsigned s, n;
+
+	if (!enabled)
+		return;
+
+	for (s = 0; s < 2; s++) {
+		const struct disasm_consts *consts = NULL;
+
+		if (!stages[s].npending)
+			continue;
+
+		if (stages[s].shader >= 0)
+			consts = &shaders[stages[s].shader].consts;
+
+		for (n = 0; n < MAX_DWORDS; n++) {
+			if (!test(stages[s].pending, n))
+				continue;
+
+			if (!consts) {
+				stages[s].frame[UNKNOWN]++;
+			} else if (consts->relative || test(consts->used, n / 4)) {
+				stages[s].frame[USED]++;
+			} else {
+				continue;
+			}
+
+			set(stages[s].pending, n, 0);
+			stages[s].npending--;
+		}
+
+		if (stages[s].npending)
+			stages[s].draws_with_unread++;
+	}
+}
+
+static void print_counters(const char *prefix, const uint64_t *c)
+{
+	uint64_t wasted = c[UNCHANGED] + c[OVERWRITTEN] + c[UNREAD];
+	unsigned i;
+
+	printf("%s%"PRIu64" bytes uploaded, %"PRIu64" bytes wasted (%.1f%%):",
+			prefix, c[UPLOADED] * 4, wasted * 4, pct(wasted, c[UPLOADED]));
+	for (i = UNCHANGED; i < NCOUNTERS; i++)
+		if (c[i])
+			printf(" %s %"PRIu64, counter_names[i], c[i] * 4);
+	printf("\n");
+}
+
+void constuse_start_cmdstream(const char *name)
+{
+	unsigned s;
+
+	if (!enabled)
+		return;
+
+	memset(stages, 0, sizeof(stages));
+	for (s = 0; s < 2; s++)
+		stages[s].shader = -1;
+
+	printf("constant upload efficiency for %s:\n", name);
+}
+
+void constuse_end_cmdstream(void)
+{
+	uint64_t total[NCOUNTERS] = {0};
+	char prefix[32];
+	unsigned s, i;
+
+	if (!enabled)
+		return;
+
+	printf("total:\n");
+	for (s = 0; s < 2; s++) {
+		snprintf(prefix, sizeof(prefix), "\t%s: ", stage_names[s]);
+		print_counters(prefix, stages[s].total);
+		for (i = 0; i < NCOUNTERS; i++)
+			total[i] += stages[s].total[i];
+	}
+	print_counters("\tall: ", total);
+}
+
+void constuse_start_submit(int submit)
+{
+	unsigned s;
+
+	if (!enabled)
+		return;
+
+	submit_nr = submit;
+	for (s = 0; s < 2; s++) {
+		memset(stages[s].frame, 0, sizeof(stages[s].frame));
+		stages[s].draws_with_unread = 0;
+	}
+}
+
+void constuse_end_submit(void)
+{
+	char prefix[48];
+	unsigned s, i;
+
+	if (!enabled)
+		return;
+
+	for (s = 0; s < 2; s++) {
+		/* anything not read by now was uploaded for nothing: */
+		stages[s].frame[UNREAD] += stages[s].npending;
+		memset(stages[s].pending, 0, sizeof(stages[s].pending));
+		stages[s].npending = 0;
+
+		if (!stages[s].frame[UPLOADED])
+			continue;
+
+		snprintf(prefix, sizeof(prefix), "frame %d: %s: ", submit_nr, stage_names[s]);
+		print_counters(prefix, stages[s].frame);
+		if (stages[s].draws_with_unread)
+			printf("\t%u draws left uploaded constants unread by their shader\n",
+					stages[s].draws_with_unread);
+
+		for (i = 0; i < NCOUNTERS; i++)
+			stages[s].total[i] += stages[s].frame[i];
+	}
+}
@@ -0,0 +1,77 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef CONSTUSE_H_
+#define CONSTUSE_H_
+
+#include <stdint.h>
+
+/* Constant upload efficiency.
+ *
+ * Shader constants uploaded (CP_LOAD_STATE, CP_SET_CONSTANT) are compared
+ * with the constants read by the shaders bound at the following draws
+ * (from the a3xx disassembler's register tracking), to count, per frame
+ * and per shader stage, the bytes which were:
+ *
+ *   unchanged   - re-uploaded with the same value
+ *   overwritten - replaced before any draw read them
+ *   unread      - not read by any draw before the end of the frame
+ *   used        - read by at least one draw
+ *
+ * On a2xx, and for shaders which could not be found in the capture, it
+ * is not known which constants are read, so only the first two apply.
+ */
+
+enum constuse_stage {
+	CONSTUSE_VS,
+	CONSTUSE_FS,
+};
+
+/* called at start to enable the report: */
+void constuse_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void constuse_start_cmdstream(const char *name);
+void constuse_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void constuse_start_submit(int submit);
+void constuse_end_submit(void);
+
+/* constants uploaded, offset and size in dwords: */
+void constuse_upload(enum constuse_stage stage, uint32_t off,
+		const uint32_t *buf, uint32_t sizedwords);
+
+/* a3xx+ shader uploaded: */
+void constuse_shader(enum constuse_stage stage, const void *buf,
+		uint32_t sizedwords);
+
+/* called at each draw: */
+void constuse_draw(int draw);
+
+#endif /* CONSTUSE_H_ */
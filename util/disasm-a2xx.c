@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "disasm.h"
+#include "util.h"
 #include "adreno_common.xml.h"
 #include "adreno_pm4.xml.h"
 #include "a2xx.xml.h"
@@ -53,6 +54,14 @@ static const char *levels[] = {
 
 enum debug_t debug;
 
+/* ALU/clause statistics, for PRINT_STATS: */
+static struct {
+	unsigned cf, clauses, cond_clauses;
+	unsigned alu, vector, scalar, coissue;
+	unsigned vtx_fetch, tex_fetch;
+	unsigned sync;
+} stats;
+
 /*
  * ALU instructions:
  */
@@ -209,10 +218,36 @@ struct {
 #undef INSTR
 };
 
+/* ops which do something besides writing their dst register, so they
+ * are not a nop even without a write mask:
+ */
+static int vector_side_effects(instr_vector_opc_t opc)
+{
+	return ((PRED_SETE_PUSHv <= opc) && (opc <= KILLNEv)) || (opc == MOVAv);
+}
+
+static int scalar_side_effects(instr_scalar_opc_t opc)
+{
+	return ((PRED_SETEs <= opc) && (opc <= KILLONEs)) ||
+			(opc == MOVAs) || (opc == MOVA_FLOORs);
+}
+
 static int disasm_alu(uint32_t *dwords, uint32_t alu_off,
 		int level, int sync, enum shader_t type)
 {
 	instr_alu_t *alu = (instr_alu_t *)dwords;
+	int vector = alu->vector_write_mask ||
+			vector_side_effects(alu->vector_opc);
+	int scalar = alu->scalar_write_mask ||
+			scalar_side_effects(alu->scalar_opc);
+
+	/* a slot is used unless its op is a nop, ie. it has no write mask
+	 * and does not set the predicate, kill or load the address register:
+	 */
+	stats.alu++;
+	stats.vector += vector;
+	stats.scalar += scalar;
+	stats.coissue += vector && scalar;
 
 	printf("%s", levels[level]);
 	if (debug & PRINT_RAW) {
@@ -455,6 +490,11 @@ static int disasm_fetch(uint32_t *dwords, uint32_t alu_off, int level, int sync)
 {
 	instr_fetch_t *fetch = (instr_fetch_t *)dwords;
 
+	if (fetch->opc == VTX_FETCH)
+		stats.vtx_fetch++;
+	else
+		stats.tex_fetch++;
+
 	printf("%s", levels[level]);
 	if (debug & PRINT_RAW) {
 		printf("%02x: %08x %08x %08x\t", alu_off,
@@ -586,6 +626,38 @@ static void print_cf(instr_cf_t *cf, int level)
 	printf("\n");
 }
 
+static void print_stats(int level)
+{
+	unsigned fetch = stats.vtx_fetch + stats.tex_fetch;
+
+	printf("%sShader Stats:\n", levels[level]);
+	printf("%s- cf: %u, exec clauses: %u (%u conditional), %.1f instrs per clause\n",
+			levels[level], stats.cf, stats.clauses, stats.cond_clauses,
+			stats.clauses ? (double)(stats.alu + fetch) / stats.clauses : 0.0);
+	printf("%s- alu: %u, vector slot: %u (%.1f%%), scalar slot: %u (%.1f%%), "
+			"co-issued: %u (%.1f%%)\n", levels[level], stats.alu,
+			stats.vector, pct(stats.vector, stats.alu),
+			stats.scalar, pct(stats.scalar, stats.alu),
+			stats.coissue, pct(stats.coissue, stats.alu));
+	printf("%s- fetch: %u (%u vertex, %u texture), fetch:alu %.2f\n",
+			levels[level], fetch, stats.vtx_fetch, stats.tex_fetch,
+			stats.alu ? (double)fetch / stats.alu : 0.0);
+	printf("%s- sync points: %u\n", levels[level], stats.sync);
+}
+
+int disasm_a2xx_cf_slots(uint32_t *dwords, int sizedwords)
+{
+	instr_cf_t *cfs = (instr_cf_t *)dwords;
+	int idx;
+
+	/* the ALU/FETCH instructions start at the first exec's address: */
+	for (idx = 0; idx < (sizedwords / 3) * 2; idx++)
+		if (cf_exec(&cfs[idx]))
+			return cfs[idx].exec.address;
+
+	return -1;
+}
+
 /*
  * The adreno shader microcode consists of two parts:
  *   1) A CF (control-flow) program, at the header of the compiled shader,
@@ -598,24 +670,29 @@ int disasm_a2xx(uint32_t *dwords, int sizedwords, int level, enum shader_t type)
 	instr_cf_t *cfs = (instr_cf_t *)dwords;
 	int idx, max_idx;
 
-	for (idx = 0; ; idx++) {
-		instr_cf_t *cf = &cfs[idx];
-		if (cf_exec(cf)) {
-			max_idx = 2 * cf->exec.address;
-			break;
-		}
+	memset(&stats, 0, sizeof(stats));
+
+	max_idx = 2 * disasm_a2xx_cf_slots(dwords, sizedwords);
+	if (max_idx < 0) {
+		fprintf(stderr, "no exec in CF program\n");
+		return -1;
 	}
 
 	for (idx = 0; idx < max_idx; idx++) {
 		instr_cf_t *cf = &cfs[idx];
 
 		print_cf(cf, level);
+		stats.cf++;
 
 		if (cf_exec(cf)) {
 			uint32_t sequence = cf->exec.serialize;
 			uint32_t i;
+			stats.clauses++;
+			stats.cond_clauses += cf_cond_exec(cf);
 			for (i = 0; i < cf->exec.count; i++) {
 				uint32_t alu_off = (cf->exec.address + i);
+				if (sequence & 0x2)
+					stats.sync++;
 				if (sequence & 0x1) {
 					disasm_fetch(dwords + alu_off * 3, alu_off, level, sequence & 0x2);
 				} else {
@@ -626,6 +703,9 @@ int disasm_a2xx(uint32_t *dwords, int sizedwords, int level, enum shader_t type)
 		}
 	}
 
+	if (debug & PRINT_STATS)
+		print_stats(level);
+
 	return 0;
 }
 
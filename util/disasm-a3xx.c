@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdarg.h>
 #include <string.h>
 #include <assert.h>
 
@@ -36,6 +37,21 @@ typedef enum {
 
 extern enum debug_t debug;
 
+/* set when only collecting register stats, to skip the output: */
+static bool quiet;
+
+static void print(const char *fmt, ...)
+{
+	va_list args;
+
+	if (quiet)
+		return;
+
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
 static const char *levels[] = {
 		"",
 		"\t",
@@ -77,33 +93,33 @@ static void print_reg(reg_t reg, bool full, bool r, bool c, bool im,
 	// by libllvm-a3xx for easy diffing..
 
 	if (abs && neg)
-		printf("(absneg)");
+		print("(absneg)");
 	else if (neg)
-		printf("(neg)");
+		print("(neg)");
 	else if (abs)
-		printf("(abs)");
+		print("(abs)");
 
 	if (r)
-		printf("(r)");
+		print("(r)");
 
 	if (im) {
-		printf("%d", reg.iim_val);
+		print("%d", reg.iim_val);
 	} else if (addr_rel) {
 		/* I would just use %+d but trying to make it diff'able with
 		 * libllvm-a3xx...
 		 */
 		if (reg.iim_val < 0)
-			printf("%s%c<a0.x - %d>", full ? "" : "h", type, -reg.iim_val);
+			print("%s%c<a0.x - %d>", full ? "" : "h", type, -reg.iim_val);
 		else if (reg.iim_val > 0)
-			printf("%s%c<a0.x + %d>", full ? "" : "h", type, reg.iim_val);
+			print("%s%c<a0.x + %d>", full ? "" : "h", type, reg.iim_val);
 		else
-			printf("%s%c<a0.x>", full ? "" : "h", type);
+			print("%s%c<a0.x>", full ? "" : "h", type);
 	} else if ((reg.num == REG_A0) && !c) {
-		printf("a0.%c", component[reg.comp]);
+		print("a0.%c", component[reg.comp]);
 	} else if ((reg.num == REG_P0) && !c) {
-		printf("p0.%c", component[reg.comp]);
+		print("p0.%c", component[reg.comp]);
 	} else {
-		printf("%s%c%d.%c", full ? "" : "h", type, reg.num & 0x3f, component[reg.comp]);
+		print("%s%c%d.%c", full ? "" : "h", type, reg.num & 0x3f, component[reg.comp]);
 	}
 }
 
@@ -160,6 +176,7 @@ static struct {
 	regmask_t rbw;      /* read before write */
 	regmask_t war;      /* write after read */
 	regmask_t cnst;     /* used consts */
+	bool cnst_rel;      /* relative (a0.x) const access */
 } regs;
 
 static void print_regs(regmask_t *regmask, bool full)
@@ -171,9 +188,9 @@ static void print_regs(regmask_t *regmask, bool full)
 	{
 		if (first != MAX_REG) {
 			if (first == last) {
-				printf(" %d", first);
+				print(" %d", first);
 			} else {
-				printf(" %d-%d", first, last);
+				print(" %d-%d", first, last);
 			}
 		}
 	}
@@ -194,36 +211,36 @@ static void print_regs(regmask_t *regmask, bool full)
 
 	print_sequence();
 
-	printf(" (cnt=%d, max=%d)", cnt, max);
+	print(" (cnt=%d, max=%d)", cnt, max);
 }
 
 static void print_reg_stats(int level)
 {
-	printf("%sRegister Stats:\n", levels[level]);
-	printf("%s- used (half):", levels[level]);
+	print("%sRegister Stats:\n", levels[level]);
+	print("%s- used (half):", levels[level]);
 	print_regs(&regs.used, false);
-	printf("\n");
-	printf("%s- used (full):", levels[level]);
+	print("\n");
+	print("%s- used (full):", levels[level]);
 	print_regs(&regs.used, true);
-	printf("\n");
-	printf("%s- input (half):", levels[level]);
+	print("\n");
+	print("%s- input (half):", levels[level]);
 	print_regs(&regs.rbw, false);
-	printf("\n");
-	printf("%s- input (full):", levels[level]);
+	print("\n");
+	print("%s- input (full):", levels[level]);
 	print_regs(&regs.rbw, true);
-	printf("\n");
-	printf("%s- const (half):", levels[level]);
+	print("\n");
+	print("%s- const (half):", levels[level]);
 	print_regs(&regs.cnst, false);
-	printf("\n");
-	printf("%s- const (full):", levels[level]);
+	print("\n");
+	print("%s- const (full):", levels[level]);
 	print_regs(&regs.cnst, true);
-	printf("\n");
-	printf("%s- output (half):", levels[level]);
+	print("\n");
+	print("%s- output (half):", levels[level]);
 	print_regs(&regs.war, false);
-	printf("  (estimated)\n");
-	printf("%s- output (full):", levels[level]);
+	print("  (estimated)\n");
+	print("%s- output (full):", levels[level]);
 	print_regs(&regs.war, true);
-	printf("  (estimated)\n");
+	print("  (estimated)\n");
 }
 
 /* we have to process the dst register after src to avoid tripping up
@@ -287,6 +304,11 @@ static void print_reg_src(reg_t reg, bool full, bool r, bool c, bool im,
 		}
 	} else if (c) {
 		int i, num = regidx(reg);
+
+		/* with relative addressing any const could be read: */
+		if (addr_rel)
+			regs.cnst_rel = true;
+
 		for (i = 0; i <= repeat; i++) {
 			unsigned src = num + i;
 
@@ -335,21 +357,21 @@ static void print_instr_cat0(instr_t *instr)
 
 	switch (cat0->opc) {
 	case OPC_KILL:
-		printf(" %sp0.%c", cat0->inv ? "!" : "",
+		print(" %sp0.%c", cat0->inv ? "!" : "",
 				component[cat0->comp]);
 		break;
 	case OPC_BR:
-		printf(" %sp0.%c, #%d", cat0->inv ? "!" : "",
+		print(" %sp0.%c, #%d", cat0->inv ? "!" : "",
 				component[cat0->comp], cat0->immed);
 		break;
 	case OPC_JUMP:
 	case OPC_CALL:
-		printf(" #%d", cat0->immed);
+		print(" #%d", cat0->immed);
 		break;
 	}
 
 	if ((debug & PRINT_VERBOSE) && (cat0->dummy1|cat0->dummy2|cat0->dummy3|cat0->dummy4))
-		printf("\t{0: %x,%x,%x,%x}", cat0->dummy1, cat0->dummy2, cat0->dummy3, cat0->dummy4);
+		print("\t{0: %x,%x,%x,%x}", cat0->dummy1, cat0->dummy2, cat0->dummy3, cat0->dummy4);
 }
 
 static void print_instr_cat1(instr_t *instr)
@@ -357,56 +379,56 @@ static void print_instr_cat1(instr_t *instr)
 	instr_cat1_t *cat1 = &instr->cat1;
 
 	if (cat1->ul)
-		printf("(ul)");
+		print("(ul)");
 
 	if (cat1->src_type == cat1->dst_type) {
 		if ((cat1->src_type == TYPE_S16) && (((reg_t)cat1->dst).num == REG_A0)) {
 			/* special case (nmemonic?): */
-			printf("mova.%s%s", type[cat1->src_type], type[cat1->dst_type]);
+			print("mova.%s%s", type[cat1->src_type], type[cat1->dst_type]);
 		} else {
-			printf("mov.%s%s", type[cat1->src_type], type[cat1->dst_type]);
+			print("mov.%s%s", type[cat1->src_type], type[cat1->dst_type]);
 		}
 	} else {
-		printf("cov.%s%s", type[cat1->src_type], type[cat1->dst_type]);
+		print("cov.%s%s", type[cat1->src_type], type[cat1->dst_type]);
 	}
 
-	printf(" ");
+	print(" ");
 
 	if (cat1->even)
-		printf("(even)");
+		print("(even)");
 
 	if (cat1->pos_inf)
-		printf("(pos_infinity)");
+		print("(pos_infinity)");
 
 	print_reg_dst((reg_t)(cat1->dst), type_size(cat1->dst_type) == 32,
 			cat1->dst_rel);
 
-	printf(", ");
+	print(", ");
 
 	/* ugg, have to special case this.. vs print_reg().. */
 	if (cat1->src_im) {
 		if (type_float(cat1->src_type))
-			printf("(%f)", cat1->fim_val);
+			print("(%f)", cat1->fim_val);
 		else
-			printf("%d", cat1->iim_val);
+			print("%d", cat1->iim_val);
 	} else if (cat1->src_rel && !cat1->src_c) {
 		/* I would just use %+d but trying to make it diff'able with
 		 * libllvm-a3xx...
 		 */
 		char type = cat1->src_rel_c ? 'c' : 'r';
 		if (cat1->off < 0)
-			printf("%c<a0.x - %d>", type, -cat1->off);
+			print("%c<a0.x - %d>", type, -cat1->off);
 		else if (cat1->off > 0)
-			printf("%c<a0.x + %d>", type, cat1->off);
+			print("%c<a0.x + %d>", type, cat1->off);
 		else
-			printf("%c<a0.x>", type);
+			print("%c<a0.x>", type);
 	} else {
 		print_reg_src((reg_t)(cat1->src), type_size(cat1->src_type) == 32,
 				cat1->src_r, cat1->src_c, cat1->src_im, false, false, false);
 	}
 
 	if ((debug & PRINT_VERBOSE) && (cat1->must_be_0))
-		printf("\t{1: %x}", cat1->must_be_0);
+		print("\t{1: %x}", cat1->must_be_0);
 }
 
 static void print_instr_cat2(instr_t *instr)
@@ -429,15 +451,15 @@ static void print_instr_cat2(instr_t *instr)
 	case OPC_CMPV_F:
 	case OPC_CMPV_U:
 	case OPC_CMPV_S:
-		printf(".%s", cond[cat2->cond]);
+		print(".%s", cond[cat2->cond]);
 		break;
 	}
 
-	printf(" ");
+	print(" ");
 	if (cat2->ei)
-		printf("(ei)");
+		print("(ei)");
 	print_reg_dst((reg_t)(cat2->dst), cat2->full ^ cat2->dst_half, false);
-	printf(", ");
+	print(", ");
 
 	if (cat2->c1.src1_c) {
 		print_reg_src((reg_t)(cat2->c1.src1), cat2->full, cat2->src1_r,
@@ -471,7 +493,7 @@ static void print_instr_cat2(instr_t *instr)
 		/* these only have one src reg */
 		break;
 	default:
-		printf(", ");
+		print(", ");
 		if (cat2->c2.src2_c) {
 			print_reg_src((reg_t)(cat2->c2.src2), cat2->full, cat2->src2_r,
 					cat2->c2.src2_c, cat2->src2_im, cat2->src2_neg,
@@ -508,9 +530,9 @@ static void print_instr_cat3(instr_t *instr)
 		break;
 	}
 
-	printf(" ");
+	print(" ");
 	print_reg_dst((reg_t)(cat3->dst), full ^ cat3->dst_half, false);
-	printf(", ");
+	print(", ");
 	if (cat3->c1.src1_c) {
 		print_reg_src((reg_t)(cat3->c1.src1), full,
 				cat3->src1_r, cat3->c1.src1_c, false, cat3->src1_neg,
@@ -524,11 +546,11 @@ static void print_instr_cat3(instr_t *instr)
 				cat3->src1_r, false, false, cat3->src1_neg,
 				false, false);
 	}
-	printf(", ");
+	print(", ");
 	print_reg_src((reg_t)cat3->src2, full,
 			cat3->src2_r, cat3->src2_c, false, cat3->src2_neg,
 			false, false);
-	printf(", ");
+	print(", ");
 	if (cat3->c2.src3_c) {
 		print_reg_src((reg_t)(cat3->c2.src3), full,
 				cat3->src3_r, cat3->c2.src3_c, false, cat3->src3_neg,
@@ -548,9 +570,9 @@ static void print_instr_cat4(instr_t *instr)
 {
 	instr_cat4_t *cat4 = &instr->cat4;
 
-	printf(" ");
+	print(" ");
 	print_reg_dst((reg_t)(cat4->dst), cat4->full ^ cat4->dst_half, false);
-	printf(", ");
+	print(", ");
 
 	if (cat4->c.src_c) {
 		print_reg_src((reg_t)(cat4->c.src), cat4->full,
@@ -567,7 +589,7 @@ static void print_instr_cat4(instr_t *instr)
 	}
 
 	if ((debug & PRINT_VERBOSE) && (cat4->dummy1|cat4->dummy2))
-		printf("\t{4: %x,%x}", cat4->dummy1, cat4->dummy2);
+		print("\t{4: %x,%x}", cat4->dummy1, cat4->dummy2);
 }
 
 static void print_instr_cat5(instr_t *instr)
@@ -607,64 +629,64 @@ static void print_instr_cat5(instr_t *instr)
 	instr_cat5_t *cat5 = &instr->cat5;
 	int i;
 
-	if (cat5->is_3d)   printf(".3d");
-	if (cat5->is_a)    printf(".a");
-	if (cat5->is_o)    printf(".o");
-	if (cat5->is_p)    printf(".p");
-	if (cat5->is_s)    printf(".s");
-	if (cat5->is_s2en) printf(".s2en");
+	if (cat5->is_3d)   print(".3d");
+	if (cat5->is_a)    print(".a");
+	if (cat5->is_o)    print(".o");
+	if (cat5->is_p)    print(".p");
+	if (cat5->is_s)    print(".s");
+	if (cat5->is_s2en) print(".s2en");
 
-	printf(" ");
+	print(" ");
 
 	switch (cat5->opc) {
 	case OPC_DSXPP_1:
 	case OPC_DSYPP_1:
 		break;
 	default:
-		printf("(%s)", type[cat5->type]);
+		print("(%s)", type[cat5->type]);
 		break;
 	}
 
-	printf("(");
+	print("(");
 	for (i = 0; i < 4; i++)
 		if (cat5->wrmask & (1 << i))
-			printf("%c", "xyzw"[i]);
-	printf(")");
+			print("%c", "xyzw"[i]);
+	print(")");
 
 	print_reg_dst((reg_t)(cat5->dst), type_size(cat5->type) == 32, false);
 
 	if (info[cat5->opc].src1) {
-		printf(", ");
+		print(", ");
 		print_reg_src((reg_t)(cat5->src1), cat5->full, false, false, false,
 				false, false, false);
 	}
 
 	if (cat5->is_s2en) {
-		printf(", ");
+		print(", ");
 		print_reg_src((reg_t)(cat5->s2en.src2), cat5->full, false, false, false,
 				false, false, false);
-		printf(", ");
+		print(", ");
 		print_reg_src((reg_t)(cat5->s2en.src3), false, false, false, false,
 				false, false, false);
 	} else {
 		if (cat5->is_o || info[cat5->opc].src2) {
-			printf(", ");
+			print(", ");
 			print_reg_src((reg_t)(cat5->norm.src2), cat5->full,
 					false, false, false, false, false, false);
 		}
 		if (info[cat5->opc].samp)
-			printf(", s#%d", cat5->norm.samp);
+			print(", s#%d", cat5->norm.samp);
 		if (info[cat5->opc].tex)
-			printf(", t#%d", cat5->norm.tex);
+			print(", t#%d", cat5->norm.tex);
 	}
 
 	if (debug & PRINT_VERBOSE) {
 		if (cat5->is_s2en) {
 			if ((debug & PRINT_VERBOSE) && (cat5->s2en.dummy1|cat5->s2en.dummy2|cat5->dummy2))
-				printf("\t{5: %x,%x,%x}", cat5->s2en.dummy1, cat5->s2en.dummy2, cat5->dummy2);
+				print("\t{5: %x,%x,%x}", cat5->s2en.dummy1, cat5->s2en.dummy2, cat5->dummy2);
 		} else {
 			if ((debug & PRINT_VERBOSE) && (cat5->norm.dummy1|cat5->dummy2))
-				printf("\t{5: %x,%x}", cat5->norm.dummy1, cat5->dummy2);
+				print("\t{5: %x,%x}", cat5->norm.dummy1, cat5->dummy2);
 		}
 	}
 }
@@ -728,15 +750,15 @@ static void print_instr_cat6(instr_t *instr)
 	case OPC_ATOMIC_OR:
 	case OPC_ATOMIC_XOR:
 		ss = cat6->g ? 'g' : 'l';
-		printf(".%c", ss);
-		printf(".%s", type[cat6->type]);
+		print(".%c", ss);
+		print(".%s", type[cat6->type]);
 		break;
 	default:
 		dst.im = cat6->g && !cat6->dst_off;
-		printf(".%s", type[cat6->type]);
+		print(".%s", type[cat6->type]);
 		break;
 	}
-	printf(" ");
+	print(" ");
 
 	switch (cat6->opc) {
 	case OPC_STG:
@@ -804,37 +826,37 @@ static void print_instr_cat6(instr_t *instr)
 
 	if (!nodst) {
 		if (sd)
-			printf("%c[", sd);
+			print("%c[", sd);
 		/* note: dst might actually be a src (ie. address to store to) */
 		print_src(&dst);
 		if (dstoff)
-			printf("%+d", dstoff);
+			print("%+d", dstoff);
 		if (sd)
-			printf("]");
-		printf(", ");
+			print("]");
+		print(", ");
 	}
 
 	if (ss)
-		printf("%c[", ss);
+		print("%c[", ss);
 
 	/* can have a larger than normal immed, so hack: */
 	if (src1.im) {
-		printf("%u", src1.reg.dummy13);
+		print("%u", src1.reg.dummy13);
 	} else {
 		print_src(&src1);
 	}
 
 	if (src1off)
-		printf("%+d", src1off);
+		print("%+d", src1off);
 	if (ss)
-		printf("]");
+		print("]");
 
 	switch (cat6->opc) {
 	case OPC_RESINFO:
 	case OPC_RESFMT:
 		break;
 	default:
-		printf(", ");
+		print(", ");
 		print_src(&src2);
 		break;
 	}
@@ -1031,15 +1053,15 @@ static bool print_instr(uint32_t *dwords, int level, int n)
 	uint32_t opc = getopc(instr);
 	const char *name;
 
-	printf("%s%04d[%08xx_%08xx] ", levels[level], n, dwords[1], dwords[0]);
+	print("%s%04d[%08xx_%08xx] ", levels[level], n, dwords[1], dwords[0]);
 
 #if 0
 	/* print unknown bits: */
 	if (debug & PRINT_RAW)
-		printf("[%08xx_%08xx] ", dwords[1] & 0x001ff800, dwords[0] & 0x00000000);
+		print("[%08xx_%08xx] ", dwords[1] & 0x001ff800, dwords[0] & 0x00000000);
 
 	if (debug & PRINT_VERBOSE)
-		printf("%d,%02d ", instr->opc_cat, opc);
+		print("%d,%02d ", instr->opc_cat, opc);
 #endif
 
 	/* NOTE: order flags are printed is a bit fugly.. but for now I
@@ -1048,30 +1070,30 @@ static bool print_instr(uint32_t *dwords, int level, int n)
 	 */
 
 	if (instr->sync)
-		printf("(sy)");
+		print("(sy)");
 	if (instr->ss && (instr->opc_cat <= 4))
-		printf("(ss)");
+		print("(ss)");
 	if (instr->jmp_tgt)
-		printf("(jp)");
+		print("(jp)");
 	if (instr->repeat && (instr->opc_cat <= 4)) {
-		printf("(rpt%d)", instr->repeat);
+		print("(rpt%d)", instr->repeat);
 		repeat = instr->repeat;
 	} else {
 		repeat = 0;
 	}
 	if (instr->ul && ((2 <= instr->opc_cat) && (instr->opc_cat <= 4)))
-		printf("(ul)");
+		print("(ul)");
 
 	name = GETINFO(instr)->name;
 
 	if (name) {
-		printf("%s", name);
+		print("%s", name);
 		GETINFO(instr)->print(instr);
 	} else {
-		printf("unknown(%d,%d)", instr->opc_cat, opc);
+		print("unknown(%d,%d)", instr->opc_cat, opc);
 	}
 
-	printf("\n");
+	print("\n");
 
 	process_reg_dst();
 
@@ -1079,16 +1101,16 @@ static bool print_instr(uint32_t *dwords, int level, int n)
 		int i;
 		for (i = 0; i < instr->repeat; i++) {
 			repeatidx = i + 1;
-			printf("%s%04d[                   ] ", levels[level], n);
+			print("%s%04d[                   ] ", levels[level], n);
 
 			if (name) {
-				printf("%s", name);
+				print("%s", name);
 				GETINFO(instr)->print(instr);
 			} else {
-				printf("unknown(%d,%d)", instr->opc_cat, opc);
+				print("unknown(%d,%d)", instr->opc_cat, opc);
 			}
 
-			printf("\n");
+			print("\n");
 		}
 		repeatidx = 0;
 	}
@@ -1112,3 +1134,28 @@ int disasm_a3xx(uint32_t *dwords, int sizedwords, int level, enum shader_t type)
 
 	return 0;
 }
+
+int disasm_a3xx_consts(uint32_t *dwords, int sizedwords,
+		struct disasm_consts *consts)
+{
+	bool end = false;
+	int i;
+
+	quiet = true;
+
+	memset(&regs, 0, sizeof(regs));
+
+	for (i = 0; i < sizedwords && !end; i += 2)
+		end = print_instr(&dwords[i], 0, i/2);
+
+	memset(consts, 0, sizeof(*consts));
+	for (i = 0; i < MAX_REG; i++) {
+		if (regmask_get(&regs.cnst, i, true) || regmask_get(&regs.cnst, i, false))
+			consts->used[i / 32] |= 1 << ((i / 4) % 8);
+	}
+	consts->relative = regs.cnst_rel;
+
+	quiet = false;
+
+	return 0;
+}
@@ -35,10 +35,26 @@ enum debug_t {
 	PRINT_RAW      = 0x1,    /* dump raw hexdump */
 	PRINT_VERBOSE  = 0x2,
 	EXPAND_REPEAT  = 0x4,
+	PRINT_STATS    = 0x8,    /* a2xx ALU slot/clause stats, per shader */
 };
 
 int disasm_a2xx(uint32_t *dwords, int sizedwords, int level, enum shader_t type);
+/* number of 96b instruction slots taken by the CF program at the start of
+ * an a2xx shader, or -1 if it has no exec:
+ */
+int disasm_a2xx_cf_slots(uint32_t *dwords, int sizedwords);
 int disasm_a3xx(uint32_t *dwords, int sizedwords, int level, enum shader_t type);
+
+/* consts read by an a3xx+ shader, from the same tracking as the register
+ * stats printed by disasm_a3xx(), but without any output:
+ */
+#define DISASM_MAX_CONSTS 1024   /* vec4 */
+struct disasm_consts {
+	uint8_t used[DISASM_MAX_CONSTS / 8];   /* bitmask of vec4 consts */
+	int relative;                          /* indexed with a0.x */
+};
+int disasm_a3xx_consts(uint32_t *dwords, int sizedwords,
+		struct disasm_consts *consts);
 void disasm_set_debug(enum debug_t debug);
 
 #endif /* DISASM_H_ */
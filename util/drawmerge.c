@@ -0,0 +1,279 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "drawmerge.h"
+#include "statehash.h"
+#include "util.h"
+
+const char *regname(uint32_t regbase, int color);
+
+#define NREGS    STATEHASH_NREGS
+#define NCLASSES 4
+
+static int enabled;
+
+/* incrementally updated hash of each class of state: */
+static struct statehash sh;
+
+/* 0 - not classified yet, otherwise class + 1: */
+static uint8_t reg_class[NREGS];
+
+static const char *class_name[] = {
+		[DRAWMERGE_STATE]   = "state",
+		[DRAWMERGE_CONSTS]  = "consts",
+		[DRAWMERGE_OFFSETS] = "offsets",
+		[DRAWMERGE_VBO]     = "vbo",
+};
+
+/* state at the previous draw: */
+static struct {
+	int valid;
+	uint64_t hash[NCLASSES];
+} prev;
+
+/* cmdstream since the previous draw: */
+static uint32_t packets, dwords;
+
+/* the current run of mergeable draws: */
+static struct {
+	int first_draw, last_draw;
+	unsigned draws;
+	char primtype[32];
+	uint32_t num_indices;
+	int uniform;           /* all draws have the same num_indices */
+	unsigned diff;         /* mask of classes which differ */
+	uint64_t packets, dwords;
+} run;
+
+struct drawmerge_stats {
+	unsigned draws, runs, run_draws;
+	uint64_t dwords;
+	uint64_t saved_packets, saved_dwords;
+};
+static struct drawmerge_stats frame, capture;
+static int submit_nr;
+
+void drawmerge_enable(void)
+{
+	statehash_init(&sh, "drawmerge", 8192);
+	enabled = 1;
+}
+
+static enum drawmerge_class classify(uint32_t reg)
+{
+	const char *name = regname(reg, 0);
+
+	if (!name)
+		return DRAWMERGE_STATE;
+
+	if (strstr(name, "VFD_INDEX_") || strstr(name, "VFD_INSTANCE") ||
+			strstr(name, "VGT_INDX_OFFSET") || strstr(name, "VTX_INDX"))
+		return DRAWMERGE_OFFSETS;
+
+	/* VFD_FETCH[n].INSTR_1/INSTR_2 on a3xx/a4xx, BASE_LO/BASE_HI/SIZE on a5xx: */
+	if (strstr(name, "VFD_FETCH") &&
+			(strstr(name, "INSTR_1") || strstr(name, "INSTR_2") ||
+			 strstr(name, "BASE") || strstr(name, "SIZE")))
+		return DRAWMERGE_VBO;
+
+	return DRAWMERGE_STATE;
+}
+
+void drawmerge_reg(uint32_t regbase, uint32_t val)
+{
+	if (!enabled)
+		return;
+
+	regbase &= NREGS - 1;
+	if (!reg_class[regbase])
+		reg_class[regbase] = classify(regbase) + 1;
+
+	statehash_reg(&sh, reg_class[regbase] - 1, regbase, val);
+}
+
+void drawmerge_state(uint32_t slot, enum drawmerge_class cls,
+		const void *buf, uint32_t sizedwords)
+{
+	if (!enabled || !buf)
+		return;
+
+	statehash_state(&sh, cls, slot, buf, sizedwords);
+}
+
+void drawmerge_advance(uint32_t sizedwords)
+{
+	packets++;
+	dwords += sizedwords;
+	frame.dwords += sizedwords;
+}
+
+static void end_run(void)
+{
+	const char *kind;
+	unsigned i;
+
+	if (run.draws >= 2) {
+		if (!run.diff)
+			kind = "same state";
+		else if (run.uniform)
+			kind = "instancing";
+		else
+			kind = "merge";
+
+		printf("\tdraws %d-%d: %ux %s", run.first_draw, run.last_draw,
+				run.draws, run.primtype);
+		if (run.uniform)
+			printf(" (%u indices)", run.num_indices);
+		printf(", differ in ");
+		if (!run.diff)
+			printf("nothing");
+		for (i = 0; i < NCLASSES; i++)
+			if (run.diff & (1 << i))
+				printf("%s%s", class_name[i],
+						(run.diff >> (i + 1)) ? "," : "");
+		printf(" -> %s, saves up to %u draws, %"PRIu64" packets, %"PRIu64" dwords\n",
+				kind, run.draws - 1, run.packets, run.dwords);
+
+		frame.runs++;
+		frame.run_draws += run.draws;
+		frame.saved_packets += run.packets;
+		frame.saved_dwords += run.dwords;
+	}
+
+	memset(&run, 0, sizeof(run));
+}
+
+void drawmerge_draw(int draw, const char *primtype, uint32_t num_indices)
+{
+	unsigned diff = 0;
+	int i;
+
+	if (!enabled)
+		return;
+
+	frame.draws++;
+
+	if (!num_indices) {
+		/* blits, etc, end the current run: */
+		end_run();
+		prev.valid = 0;
+		packets = dwords = 0;
+		return;
+	}
+
+	for (i = 0; i < NCLASSES; i++)
+		if (sh.hash[i] != prev.hash[i])
+			diff |= (1 << i);
+
+	if (prev.valid && run.draws && !(diff & (1 << DRAWMERGE_STATE)) &&
+			!strcmp(run.primtype, primtype)) {
+		run.last_draw = draw;
+		run.draws++;
+		run.diff |= diff;
+		run.packets += packets;
+		run.dwords += dwords;
+		if (num_indices != run.num_indices)
+			run.uniform = 0;
+	} else {
+		end_run();
+		run.first_draw = run.last_draw = draw;
+		run.draws = 1;
+		snprintf(run.primtype, sizeof(run.primtype), "%s", primtype);
+		run.num_indices = num_indices;
+		run.uniform = 1;
+	}
+
+	memcpy(prev.hash, sh.hash, sizeof(sh.hash));
+	prev.valid = 1;
+	packets = dwords = 0;
+}
+
+static void print_stats(const char *prefix, const struct drawmerge_stats *s)
+{
+	printf("%s%u draws, %u candidate runs covering %u draws, saves up to %u draws, "
+			"%"PRIu64" packets, %"PRIu64" dwords (%.1f%%)\n", prefix,
+			s->draws, s->runs, s->run_draws, s->run_draws - s->runs,
+			s->saved_packets, s->saved_dwords, pct(s->saved_dwords, s->dwords));
+}
+
+void drawmerge_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	memset(&capture, 0, sizeof(capture));
+	statehash_reset(&sh);
+	memset(&run, 0, sizeof(run));
+	prev.valid = 0;
+
+	printf("draw merge candidates for %s:\n", name);
+}
+
+void drawmerge_end_cmdstream(void)
+{
+	if (!enabled)
+		return;
+
+	print_stats("total: ", &capture);
+}
+
+void drawmerge_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	submit_nr = submit;
+	packets = dwords = 0;
+	prev.valid = 0;
+
+	printf("frame %d:\n", submit_nr);
+}
+
+void drawmerge_end_submit(void)
+{
+	if (!enabled)
+		return;
+
+	/* draws are not merged across submits: */
+	end_run();
+
+	print_stats("\t", &frame);
+
+	capture.draws += frame.draws;
+	capture.runs += frame.runs;
+	capture.run_draws += frame.run_draws;
+	capture.dwords += frame.dwords;
+	capture.saved_packets += frame.saved_packets;
+	capture.saved_dwords += frame.saved_dwords;
+}
@@ -0,0 +1,80 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef DRAWMERGE_H_
+#define DRAWMERGE_H_
+
+#include <stdint.h>
+
+/* Detect runs of consecutive draws whose state only differs in shader
+ * constants, index/instance offsets or vertex buffer addresses, which
+ * are candidates for being merged into a single draw or instanced.
+ *
+ * The state is tracked as an incrementally updated hash per class of
+ * state, so consecutive draws can be compared in constant time.  The
+ * cmdstream emitted between the draws of a run (state setup plus the
+ * draw packet itself) is reported as the upper bound of the overhead
+ * that merging the run would save.
+ */
+
+enum drawmerge_class {
+	DRAWMERGE_STATE,       /* anything else, must match within a run */
+	DRAWMERGE_CONSTS,      /* shader constants */
+	DRAWMERGE_OFFSETS,     /* index/instance offset, min/max index */
+	DRAWMERGE_VBO,         /* vertex fetch base address/size */
+};
+
+/* called at start to enable the report: */
+void drawmerge_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void drawmerge_start_cmdstream(const char *name);
+void drawmerge_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void drawmerge_start_submit(int submit);
+void drawmerge_end_submit(void);
+
+/* called for each packet decoded, before the packet handler runs: */
+void drawmerge_advance(uint32_t sizedwords);
+
+/* called for each register write: */
+void drawmerge_reg(uint32_t regbase, uint32_t val);
+
+/* called for each state upload, where slot identifies the state that
+ * is replaced (ie. state block and offset):
+ */
+void drawmerge_state(uint32_t slot, enum drawmerge_class cls,
+		const void *buf, uint32_t sizedwords);
+
+/* called at each draw/blit/dispatch, num_indices is zero for things
+ * which cannot be merged (blits, etc):
+ */
+void drawmerge_draw(int draw, const char *primtype, uint32_t num_indices);
+
+#endif /* DRAWMERGE_H_ */
@@ -0,0 +1,155 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+/* Check the a3xx shader emulator against a small program covering
+ * (rptN)/(r), relative addressing, the half register file and divergent
+ * branches, run with r0.x set to the lane index:
+ *
+ *   emu-a3xx-check
+ *
+ * Prints each mismatch and exits non-zero if there are any.  See the
+ * check-emu-a3xx make target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util.h"
+#include "emu-a3xx.h"
+
+#define R(n, c)  (((n) << 2) | (c))
+#define LANES    4
+
+/* as printed by disasm-a3xx: */
+static const uint32_t prog[] = {
+	0x00000000, 0x20244b04,  /* (rpt3)mov.f32f32 r1.x, (r)c0.x */
+	0x00060004, 0x40180908,  /* (rpt1)add.f r2.x, (r)r1.x, (r)r1.z */
+	0x00000000, 0x200d00f4,  /* cov.u32s16 a0.x, r0.x */
+	0x00000c04, 0x2004400c,  /* mov.f32f32 r3.x, c<a0.x + 4> */
+	0x00000804, 0x2004400d,  /* mov.f32f32 r3.y, r<a0.x + 4> */
+	0x00000004, 0x20040010,  /* cov.f32f16 hr4.x, r1.x */
+	0x00100010, 0x40000011,  /* add.f hr4.y, hr4.x, hr4.x */
+	0x00000011, 0x20004010,  /* cov.f16f32 r4.x, hr4.y */
+	0x20020000, 0x42b000f8,  /* cmps.s.lt p0.x, r0.x, 2 */
+	0x00000003, 0x00800000,  /* br p0.x, #3 */
+	0x40000000, 0x20444018,  /* mov.f32f32 r6.x, (2.000000) */
+	0x00000002, 0x01000000,  /* jump #2 */
+	0x3f800000, 0x20444018,  /* mov.f32f32 r6.x, (1.000000) */
+	0x00180018, 0x40100019,  /* add.f r6.y, r6.x, r6.x */
+	0x00000000, 0x03000000,  /* end */
+};
+
+static const float consts[] = {
+	1.0, 2.0, 3.0, 4.0,       /* c0 */
+	10.0, 20.0, 30.0, 40.0,   /* c1 */
+};
+
+static int failed;
+
+static void check(const char *what, unsigned l, uint32_t val, uint32_t expected)
+{
+	if (val == expected)
+		return;
+	printf("lane %u: %s: 0x%08x, expected 0x%08x\n", l, what, val, expected);
+	failed++;
+}
+
+int main(int argc, char **argv)
+{
+	struct emu_a3xx *emu = emu_a3xx_new(NULL);
+	unsigned l;
+
+	if (!emu)
+		return -1;
+
+	memcpy(emu->consts, consts, sizeof(consts));
+
+	emu_a3xx_reset(emu);
+	for (l = 0; l < LANES; l++)
+		emu->r[R(0, 0)][l] = l;
+
+	if (emu_a3xx_run(emu, prog, sizeof(prog) / 4, (1 << LANES) - 1) < 0) {
+		printf("aborted: %s\n", emu->error);
+		return -1;
+	}
+
+	if (emu->error[0]) {
+		printf("error: %s\n", emu->error);
+		failed++;
+	}
+	if (emu->killed) {
+		printf("killed: 0x%x\n", emu->killed);
+		failed++;
+	}
+	if (!emu->stats.divergent) {
+		printf("branch did not diverge\n");
+		failed++;
+	}
+
+	for (l = 0; l < LANES; l++) {
+		float r6 = (l < 2) ? 1.0 : 2.0;
+
+		/* (rpt3) with (r) on the const: */
+		check("r1.x", l, emu->r[R(1, 0)][l], fui(1.0));
+		check("r1.y", l, emu->r[R(1, 1)][l], fui(2.0));
+		check("r1.z", l, emu->r[R(1, 2)][l], fui(3.0));
+		check("r1.w", l, emu->r[R(1, 3)][l], fui(4.0));
+
+		/* (rpt1) with (r) on both srcs: */
+		check("r2.x", l, emu->r[R(2, 0)][l], fui(1.0 + 3.0));
+		check("r2.y", l, emu->r[R(2, 1)][l], fui(2.0 + 4.0));
+		check("r2.z", l, emu->r[R(2, 2)][l], 0);
+
+		/* relative const and register, offset by the lane: */
+		check("a0.x", l, emu->a0[l], l);
+		check("r3.x", l, emu->r[R(3, 0)][l], fui(consts[4 + l]));
+		check("r3.y", l, emu->r[R(3, 1)][l], fui(consts[l]));
+
+		/* the half registers don't alias the full ones: */
+		check("hr4.x", l, emu->hr[R(4, 0)][l], 0x3c00);
+		check("hr4.y", l, emu->hr[R(4, 1)][l], 0x4000);
+		check("r4.x", l, emu->r[R(4, 0)][l], fui(2.0));
+		check("r4.y", l, emu->r[R(4, 1)][l], 0);
+
+		/* both sides of the branch, reconverged for r6.y: */
+		check("p0.x", l, emu->p0[0][l], l < 2);
+		check("r6.x", l, emu->r[R(6, 0)][l], fui(r6));
+		check("r6.y", l, emu->r[R(6, 1)][l], fui(r6 + r6));
+	}
+
+	free(emu);
+
+	if (failed) {
+		printf("%d failures\n", failed);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1265 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "emu-a3xx.h"
+#include "util.h"
+
+#define W          EMU_A3XX_LANES
+#define ALL_LANES  ((W == 32) ? ~0u : ((1u << W) - 1))
+
+/* one value per lane: */
+typedef union {
+	uint32_t u[W];
+	int32_t  i[W];
+	float    f[W];
+} vec_t;
+
+/* a decoded src or dst operand: */
+struct opnd {
+	unsigned idx;        /* (num << 2) | comp, or the offset if rel */
+	int32_t imm;
+	unsigned full : 1;
+	unsigned im   : 1;   /* immediate */
+	unsigned c    : 1;   /* const */
+	unsigned rel  : 1;   /* relative to a0.x */
+	unsigned r    : 1;   /* incremented by (rptN) */
+	unsigned neg  : 1;
+	unsigned abs  : 1;
+	unsigned flt  : 1;   /* float, consts are converted for half srcs */
+};
+
+static void unsupported(struct emu_a3xx *emu, const char *what, unsigned opc)
+{
+	if (!emu->error[0])
+		snprintf(emu->error, sizeof(emu->error), "unsupported %s (opc %u)",
+				what, opc);
+	emu->stats.unsupported++;
+}
+
+/*
+ * Operands:
+ */
+
+/* the 16 bit src encoding shared by cat2/cat3/cat4 (see instr-a3xx.h),
+ * plain register, relative (bit 11) or const (bit 12):
+ */
+static void decode_src(struct opnd *o, uint32_t raw, int full, int has_im)
+{
+	memset(o, 0, sizeof(*o));
+	o->full = full;
+
+	if (raw & (1 << 12)) {
+		o->c = 1;
+		o->idx = raw & 0xfff;
+	} else if (raw & (1 << 11)) {
+		o->rel = 1;
+		o->c = !!(raw & (1 << 10));
+		o->idx = ((int32_t)(raw << 22)) >> 22;
+	} else if (has_im && (raw & (1 << 13))) {
+		o->im = 1;
+		o->imm = ((int32_t)(raw << 21)) >> 21;
+	} else {
+		o->idx = raw & 0xff;
+	}
+}
+
+static void decode_reg(struct opnd *o, uint32_t reg, int full)
+{
+	memset(o, 0, sizeof(*o));
+	o->full = full;
+	o->idx = reg;
+}
+
+static uint32_t const_val(struct emu_a3xx *emu, unsigned n,
+		const struct opnd *o)
+{
+	uint32_t v = (n < EMU_A3XX_CONSTS) ? emu->consts[n] : 0;
+
+	if (o->full)
+		return v;
+	return o->flt ? util_float_to_half(uif(v)) : (v & 0xffff);
+}
+
+static uint32_t reg_val(struct emu_a3xx *emu, unsigned n, unsigned l,
+		int full)
+{
+	if (n >= EMU_A3XX_REGS)
+		return 0;
+	if ((n >> 2) == REG_A0)
+		return full ? (uint32_t)emu->a0[l] : (emu->a0[l] & 0xffff);
+	if ((n >> 2) == REG_P0)
+		return emu->p0[n & 3][l];
+	return full ? emu->r[n][l] : emu->hr[n][l];
+}
+
+/* raw bits of a src operand, for iteration i of (rptN).  Half values
+ * are zero-extended:
+ */
+static void fetch(struct emu_a3xx *emu, const struct opnd *o, unsigned i,
+		vec_t *v)
+{
+	unsigned inc = o->r ? i : 0;
+	unsigned l, n = o->idx + inc;
+
+	if (o->im) {
+		for (l = 0; l < W; l++)
+			v->u[l] = o->imm + inc;
+	} else if (o->rel) {
+		for (l = 0; l < W; l++) {
+			n = emu->a0[l] + o->idx + inc;
+			v->u[l] = o->c ? const_val(emu, n, o) : reg_val(emu, n, l, o->full);
+		}
+	} else if (o->c) {
+		uint32_t c = const_val(emu, n, o);
+		for (l = 0; l < W; l++)
+			v->u[l] = c;
+	} else if ((n >= EMU_A3XX_REGS) || ((n >> 2) == REG_A0) ||
+			((n >> 2) == REG_P0)) {
+		for (l = 0; l < W; l++)
+			v->u[l] = reg_val(emu, n, l, o->full);
+	} else if (o->full) {
+		memcpy(v->u, emu->r[n], sizeof(v->u));
+	} else {
+		for (l = 0; l < W; l++)
+			v->u[l] = emu->hr[n][l];
+	}
+}
+
+/* src operand as float, with the abs/neg modifiers applied: */
+static void fetch_f(struct emu_a3xx *emu, const struct opnd *o, unsigned i,
+		vec_t *v)
+{
+	unsigned l;
+
+	fetch(emu, o, i, v);
+
+	if (o->im) {
+		for (l = 0; l < W; l++)
+			v->f[l] = (float)v->i[l];
+	} else if (!o->full) {
+		for (l = 0; l < W; l++)
+			v->f[l] = util_half_to_float(v->u[l]);
+	}
+
+	if (o->abs)
+		for (l = 0; l < W; l++)
+			v->f[l] = fabsf(v->f[l]);
+	if (o->neg)
+		for (l = 0; l < W; l++)
+			v->f[l] = -v->f[l];
+}
+
+/* src operand as integer, half values extended according to sign: */
+static void fetch_i(struct emu_a3xx *emu, const struct opnd *o, unsigned i,
+		vec_t *v, int sign)
+{
+	unsigned l;
+
+	fetch(emu, o, i, v);
+
+	if (!o->full && !o->im) {
+		if (sign)
+			for (l = 0; l < W; l++)
+				v->i[l] = (int16_t)v->u[l];
+		else
+			for (l = 0; l < W; l++)
+				v->u[l] &= 0xffff;
+	}
+
+	if (o->abs)
+		for (l = 0; l < W; l++)
+			v->i[l] = (v->i[l] < 0) ? -v->i[l] : v->i[l];
+	if (o->neg)
+		for (l = 0; l < W; l++)
+			v->i[l] = -v->i[l];
+}
+
+/* write the raw bits of a result, for iteration i of (rptN): */
+static void store(struct emu_a3xx *emu, const struct opnd *d, unsigned i,
+		const vec_t *v, uint32_t mask)
+{
+	unsigned l, n = d->idx + i;
+
+	if (!d->rel && d->full && (n < EMU_A3XX_REGS) &&
+			((n >> 2) != REG_A0) && ((n >> 2) != REG_P0)) {
+		for (l = 0; l < W; l++)
+			emu->r[n][l] = (mask & (1u << l)) ? v->u[l] : emu->r[n][l];
+		return;
+	}
+
+	for (l = 0; l < W; l++) {
+		if (!(mask & (1u << l)))
+			continue;
+		if (d->rel)
+			n = emu->a0[l] + d->idx + i;
+		if (n >= EMU_A3XX_REGS)
+			continue;
+		if ((n >> 2) == REG_A0)
+			emu->a0[l] = (int16_t)v->u[l];
+		else if ((n >> 2) == REG_P0)
+			emu->p0[n & 3][l] = (d->full ? v->u[l] : (v->u[l] & 0xffff)) != 0;
+		else if (d->full)
+			emu->r[n][l] = v->u[l];
+		else
+			emu->hr[n][l] = v->u[l];
+	}
+}
+
+/* float results to the dst register size: */
+static void pack_f(vec_t *v, int full)
+{
+	unsigned l;
+
+	if (!full)
+		for (l = 0; l < W; l++)
+			v->u[l] = util_float_to_half(v->f[l]);
+}
+
+static int compare(unsigned cond, int lt, int eq)
+{
+	switch (cond) {
+	case 0:  return lt;
+	case 1:  return lt || eq;
+	case 2:  return !lt && !eq;
+	case 3:  return !lt;
+	case 4:  return eq;
+	case 5:  return !eq;
+	default: return 0;
+	}
+}
+
+/*
+ * Conversions (cat1):
+ */
+
+static uint32_t type_mask(type_t type)
+{
+	return (type_size(type) == 32) ? ~0u : ((1u << type_size(type)) - 1);
+}
+
+static int type_signed(type_t type)
+{
+	return (type == TYPE_S16) || (type == TYPE_S32) || (type == TYPE_S8);
+}
+
+static uint32_t cov(uint32_t v, type_t st, type_t dt)
+{
+	int64_t x;
+
+	if (type_float(st)) {
+		float f = (st == TYPE_F16) ? util_half_to_float(v) : uif(v);
+		double lo, hi;
+
+		if (dt == TYPE_F32)
+			return fui(f);
+		if (dt == TYPE_F16)
+			return util_float_to_half(f);
+
+		/* float -> int truncates, and saturates: */
+		if (isnan(f))
+			return 0;
+		hi = (double)(type_signed(dt) ? (type_mask(dt) >> 1) : type_mask(dt));
+		lo = type_signed(dt) ? -hi - 1 : 0;
+		x = (int64_t)fmin(fmax(trunc(f), lo), hi);
+		return (uint32_t)x & type_mask(dt);
+	}
+
+	v &= type_mask(st);
+	if (type_signed(st) && (v & (1u << (type_size(st) - 1))))
+		x = (int64_t)v - ((int64_t)type_mask(st) + 1);
+	else
+		x = v;
+
+	if (dt == TYPE_F32)
+		return fui((float)x);
+	if (dt == TYPE_F16)
+		return util_float_to_half((float)x);
+
+	return (uint32_t)x & type_mask(dt);
+}
+
+/*
+ * Instruction categories:
+ */
+
+static void exec_cat1(struct emu_a3xx *emu, instr_cat1_t *cat1, unsigned rpt,
+		uint32_t mask)
+{
+	struct opnd dst, src;
+	unsigned i, l;
+	vec_t v;
+
+	decode_reg(&dst, cat1->dst, type_size(cat1->dst_type) == 32);
+	dst.rel = cat1->dst_rel;
+
+	memset(&src, 0, sizeof(src));
+	src.full = type_size(cat1->src_type) == 32;
+	src.flt = type_float(cat1->src_type);
+	src.r = cat1->src_r;
+
+	if (cat1->src_im) {
+		src.im = 1;
+		if (cat1->src_type == TYPE_F16)
+			src.imm = util_float_to_half(cat1->fim_val);
+		else
+			src.imm = cat1->iim_val;
+		src.r = 0;
+	} else if (cat1->src_rel) {
+		src.rel = 1;
+		src.c = cat1->src_rel_c;
+		src.idx = cat1->off;
+	} else {
+		src.c = cat1->src_c;
+		src.idx = cat1->src & (src.c ? 0x7ff : 0xff);
+	}
+
+	for (i = 0; i <= rpt; i++) {
+		fetch(emu, &src, i, &v);
+		if (cat1->src_type != cat1->dst_type)
+			for (l = 0; l < W; l++)
+				v.u[l] = cov(v.u[l], cat1->src_type, cat1->dst_type);
+		store(emu, &dst, i, &v, mask);
+	}
+}
+
+static int cat2_nsrc(unsigned opc)
+{
+	switch (opc) {
+	case OPC_SIGN_F:
+	case OPC_ABSNEG_F:
+	case OPC_FLOOR_F:
+	case OPC_CEIL_F:
+	case OPC_RNDNE_F:
+	case OPC_RNDAZ_F:
+	case OPC_TRUNC_F:
+	case OPC_ABSNEG_S:
+	case OPC_NOT_B:
+	case OPC_BFREV_B:
+	case OPC_CLZ_S:
+	case OPC_CLZ_B:
+	case OPC_CBITS_B:
+	case OPC_BARY_F:
+		return 1;
+	default:
+		return 2;
+	}
+}
+
+static uint32_t bitrev(uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+	x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+	x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+static void exec_cat2(struct emu_a3xx *emu, instr_cat2_t *cat2,
+		uint32_t dw0, unsigned rpt, uint32_t mask)
+{
+	unsigned opc = cat2->opc, cond = cat2->cond, i, l;
+	int full = cat2->full, nsrc = cat2_nsrc(opc);
+	int flt = (opc < 16) || (opc == OPC_BARY_F);
+	int sign = (opc == OPC_ADD_S) || (opc == OPC_SUB_S) ||
+			(opc == OPC_CMPS_S) || (opc == OPC_MIN_S) ||
+			(opc == OPC_MAX_S) || (opc == OPC_ABSNEG_S) ||
+			(opc == OPC_CMPV_S) || (opc == OPC_MUL_S) ||
+			(opc == OPC_CLZ_S) || (opc == OPC_ASHR_B);
+	int dfull = full ^ cat2->dst_half;
+	struct opnd dst, src1, src2;
+	vec_t a, b, d;
+
+	decode_reg(&dst, cat2->dst, dfull);
+
+	decode_src(&src1, dw0 & 0xffff, full, 1);
+	src1.neg = (dw0 >> 14) & 1;
+	src1.abs = (dw0 >> 15) & 1;
+	src1.r = cat2->src1_r;
+	src1.flt = flt;
+
+	decode_src(&src2, dw0 >> 16, full, 1);
+	src2.neg = (dw0 >> 30) & 1;
+	src2.abs = (dw0 >> 31) & 1;
+	src2.r = cat2->src2_r;
+	src2.flt = flt;
+
+	for (i = 0; i <= rpt; i++) {
+		if (opc == OPC_BARY_F) {
+			fetch(emu, &src1, i, &a);
+			for (l = 0; l < W; l++) {
+				unsigned n = a.u[l];
+				d.f[l] = (n < emu->nvaryings) ? emu->varyings[n][l] : 0.0;
+			}
+			pack_f(&d, dfull);
+			store(emu, &dst, i, &d, mask);
+			continue;
+		}
+
+		if (flt) {
+			fetch_f(emu, &src1, i, &a);
+			if (nsrc > 1)
+				fetch_f(emu, &src2, i, &b);
+		} else {
+			fetch_i(emu, &src1, i, &a, sign);
+			if (nsrc > 1)
+				fetch_i(emu, &src2, i, &b, sign);
+		}
+
+		switch (opc) {
+		case OPC_ADD_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = a.f[l] + b.f[l];
+			break;
+		case OPC_MIN_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = fminf(a.f[l], b.f[l]);
+			break;
+		case OPC_MAX_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = fmaxf(a.f[l], b.f[l]);
+			break;
+		case OPC_MUL_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = a.f[l] * b.f[l];
+			break;
+		case OPC_SIGN_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = (a.f[l] > 0.0) ? 1.0 : (a.f[l] < 0.0) ? -1.0 : 0.0;
+			break;
+		case OPC_ABSNEG_F:
+			d = a;
+			break;
+		case OPC_FLOOR_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = floorf(a.f[l]);
+			break;
+		case OPC_CEIL_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = ceilf(a.f[l]);
+			break;
+		case OPC_RNDNE_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = nearbyintf(a.f[l]);
+			break;
+		case OPC_RNDAZ_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = roundf(a.f[l]);
+			break;
+		case OPC_TRUNC_F:
+			for (l = 0; l < W; l++)
+				d.f[l] = truncf(a.f[l]);
+			break;
+
+		/* compares produce integer 0/1 (or ~0 for cmpv): */
+		case OPC_CMPS_F:
+		case OPC_CMPV_F:
+			for (l = 0; l < W; l++)
+				d.u[l] = compare(cond, a.f[l] < b.f[l], a.f[l] == b.f[l]);
+			break;
+		case OPC_CMPS_U:
+		case OPC_CMPV_U:
+			for (l = 0; l < W; l++)
+				d.u[l] = compare(cond, a.u[l] < b.u[l], a.u[l] == b.u[l]);
+			break;
+		case OPC_CMPS_S:
+		case OPC_CMPV_S:
+			for (l = 0; l < W; l++)
+				d.u[l] = compare(cond, a.i[l] < b.i[l], a.i[l] == b.i[l]);
+			break;
+
+		case OPC_ADD_U:
+		case OPC_ADD_S:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] + b.u[l];
+			break;
+		case OPC_SUB_U:
+		case OPC_SUB_S:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] - b.u[l];
+			break;
+		case OPC_MIN_U:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] < b.u[l]) ? a.u[l] : b.u[l];
+			break;
+		case OPC_MIN_S:
+			for (l = 0; l < W; l++)
+				d.i[l] = (a.i[l] < b.i[l]) ? a.i[l] : b.i[l];
+			break;
+		case OPC_MAX_U:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] > b.u[l]) ? a.u[l] : b.u[l];
+			break;
+		case OPC_MAX_S:
+			for (l = 0; l < W; l++)
+				d.i[l] = (a.i[l] > b.i[l]) ? a.i[l] : b.i[l];
+			break;
+		case OPC_ABSNEG_S:
+			d = a;
+			break;
+		case OPC_AND_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] & b.u[l];
+			break;
+		case OPC_OR_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] | b.u[l];
+			break;
+		case OPC_NOT_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = ~a.u[l];
+			break;
+		case OPC_XOR_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] ^ b.u[l];
+			break;
+
+		/* mul.u/mul.s are 24 bit multiplies, mull.u 16x16: */
+		case OPC_MUL_U:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] & 0xffffff) * (b.u[l] & 0xffffff);
+			break;
+		case OPC_MUL_S:
+			for (l = 0; l < W; l++)
+				d.i[l] = (int32_t)((uint32_t)(((int32_t)(a.u[l] << 8) >> 8) *
+						((int32_t)(b.u[l] << 8) >> 8)));
+			break;
+		case OPC_MULL_U:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] & 0xffff) * (b.u[l] & 0xffff);
+			break;
+
+		case OPC_BFREV_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = bitrev(a.u[l]);
+			break;
+		case OPC_CLZ_S:
+			for (l = 0; l < W; l++) {
+				uint32_t x = (a.i[l] < 0) ? ~a.u[l] : a.u[l];
+				d.u[l] = x ? __builtin_clz(x) : 32;
+			}
+			break;
+		case OPC_CLZ_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] ? __builtin_clz(a.u[l]) : 32;
+			break;
+		case OPC_SHL_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] << (b.u[l] & 31);
+			break;
+		case OPC_SHR_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = a.u[l] >> (b.u[l] & 31);
+			break;
+		case OPC_ASHR_B:
+			for (l = 0; l < W; l++)
+				d.i[l] = a.i[l] >> (b.u[l] & 31);
+			break;
+		case OPC_GETBIT_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] >> (b.u[l] & 31)) & 1;
+			break;
+		case OPC_CBITS_B:
+			for (l = 0; l < W; l++)
+				d.u[l] = __builtin_popcount(a.u[l]);
+			break;
+
+		default:
+			unsupported(emu, "cat2", opc);
+			return;
+		}
+
+		if ((opc == OPC_CMPV_F) || (opc == OPC_CMPV_U) || (opc == OPC_CMPV_S))
+			for (l = 0; l < W; l++)
+				d.u[l] = d.u[l] ? ~0u : 0;
+
+		if (flt && (opc != OPC_CMPS_F) && (opc != OPC_CMPV_F))
+			pack_f(&d, dfull);
+		else if (!dfull)
+			for (l = 0; l < W; l++)
+				d.u[l] &= 0xffff;
+
+		store(emu, &dst, i, &d, mask);
+	}
+}
+
+static void exec_cat3(struct emu_a3xx *emu, instr_cat3_t *cat3,
+		uint32_t dw0, unsigned rpt, uint32_t mask)
+{
+	unsigned opc = cat3->opc, i, l;
+	struct opnd dst, src1, src2, src3;
+	int full, flt, sign;
+	vec_t a, b, c, d;
+
+	switch (opc) {
+	case OPC_MAD_F16:
+	case OPC_MAD_U16:
+	case OPC_MAD_S16:
+	case OPC_SEL_B16:
+	case OPC_SEL_S16:
+	case OPC_SEL_F16:
+	case OPC_SAD_S16:
+	case OPC_SAD_S32:
+		full = 0;
+		break;
+	default:
+		full = 1;
+		break;
+	}
+
+	flt = (opc == OPC_MAD_F16) || (opc == OPC_MAD_F32) ||
+			(opc == OPC_SEL_F16) || (opc == OPC_SEL_F32);
+	sign = (opc == OPC_MAD_S16) || (opc == OPC_MAD_S24) ||
+			(opc == OPC_SEL_S16) || (opc == OPC_SEL_S32) ||
+			(opc == OPC_SAD_S16) || (opc == OPC_SAD_S32);
+
+	decode_reg(&dst, cat3->dst, full ^ cat3->dst_half);
+
+	decode_src(&src1, dw0 & 0xffff, full, 0);
+	src1.neg = cat3->src1_neg;
+	src1.r = cat3->src1_r;
+	src1.flt = flt;
+
+	decode_reg(&src2, cat3->src2, full);
+	src2.c = cat3->src2_c;
+	src2.neg = cat3->src2_neg;
+	src2.r = cat3->src2_r;
+	src2.flt = flt;
+
+	decode_src(&src3, dw0 >> 16, full, 0);
+	src3.neg = cat3->src3_neg;
+	src3.r = cat3->src3_r;
+	src3.flt = flt;
+
+	for (i = 0; i <= rpt; i++) {
+		if (flt) {
+			fetch_f(emu, &src1, i, &a);
+			fetch_f(emu, &src2, i, &b);
+			fetch_f(emu, &src3, i, &c);
+		} else {
+			fetch_i(emu, &src1, i, &a, sign);
+			fetch_i(emu, &src2, i, &b, sign);
+			fetch_i(emu, &src3, i, &c, sign);
+		}
+
+		switch (opc) {
+		case OPC_MAD_F16:
+		case OPC_MAD_F32:
+			for (l = 0; l < W; l++)
+				d.f[l] = a.f[l] * b.f[l] + c.f[l];
+			break;
+		case OPC_MAD_U16:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] & 0xffff) * (b.u[l] & 0xffff) + c.u[l];
+			break;
+		case OPC_MAD_S16:
+			for (l = 0; l < W; l++)
+				d.i[l] = (int16_t)a.u[l] * (int16_t)b.u[l] + c.i[l];
+			break;
+		case OPC_MADSH_U16:
+			for (l = 0; l < W; l++)
+				d.u[l] = (((a.u[l] & 0xffff) * (b.u[l] & 0xffff)) >> 16) + c.u[l];
+			break;
+		case OPC_MADSH_M16:
+			/* the high half of a 32x32 multiply is built from these: */
+			for (l = 0; l < W; l++)
+				d.u[l] = (((a.u[l] >> 16) * (b.u[l] & 0xffff)) << 16) + c.u[l];
+			break;
+		case OPC_MAD_U24:
+			for (l = 0; l < W; l++)
+				d.u[l] = (a.u[l] & 0xffffff) * (b.u[l] & 0xffffff) + c.u[l];
+			break;
+		case OPC_MAD_S24:
+			for (l = 0; l < W; l++)
+				d.u[l] = (uint32_t)(((int32_t)(a.u[l] << 8) >> 8) *
+						((int32_t)(b.u[l] << 8) >> 8)) + c.u[l];
+			break;
+		case OPC_SEL_B16:
+		case OPC_SEL_B32:
+		case OPC_SEL_S16:
+		case OPC_SEL_S32:
+			for (l = 0; l < W; l++)
+				d.u[l] = b.u[l] ? a.u[l] : c.u[l];
+			break;
+		case OPC_SEL_F16:
+		case OPC_SEL_F32:
+			for (l = 0; l < W; l++)
+				d.f[l] = (b.f[l] != 0.0) ? a.f[l] : c.f[l];
+			break;
+		case OPC_SAD_S16:
+		case OPC_SAD_S32:
+			for (l = 0; l < W; l++)
+				d.u[l] = ((a.i[l] > b.i[l]) ? (a.u[l] - b.u[l]) :
+						(b.u[l] - a.u[l])) + c.u[l];
+			break;
+		default:
+			unsupported(emu, "cat3", opc);
+			return;
+		}
+
+		if (flt)
+			pack_f(&d, dst.full);
+		else if (!dst.full)
+			for (l = 0; l < W; l++)
+				d.u[l] &= 0xffff;
+
+		store(emu, &dst, i, &d, mask);
+	}
+}
+
+static void exec_cat4(struct emu_a3xx *emu, instr_cat4_t *cat4,
+		uint32_t dw0, unsigned rpt, uint32_t mask)
+{
+	unsigned i, l;
+	struct opnd dst, src;
+	vec_t a, d;
+
+	decode_reg(&dst, cat4->dst, cat4->full ^ cat4->dst_half);
+
+	decode_src(&src, dw0 & 0xffff, cat4->full, 1);
+	src.neg = (dw0 >> 14) & 1;
+	src.abs = (dw0 >> 15) & 1;
+	src.r = cat4->src_r;
+	src.flt = 1;
+
+	for (i = 0; i <= rpt; i++) {
+		fetch_f(emu, &src, i, &a);
+
+		switch (cat4->opc) {
+		case OPC_RCP:
+			for (l = 0; l < W; l++)
+				d.f[l] = 1.0f / a.f[l];
+			break;
+		case OPC_RSQ:
+			for (l = 0; l < W; l++)
+				d.f[l] = 1.0f / sqrtf(a.f[l]);
+			break;
+		case OPC_LOG2:
+			for (l = 0; l < W; l++)
+				d.f[l] = log2f(a.f[l]);
+			break;
+		case OPC_EXP2:
+			for (l = 0; l < W; l++)
+				d.f[l] = exp2f(a.f[l]);
+			break;
+		case OPC_SIN:
+			for (l = 0; l < W; l++)
+				d.f[l] = sinf(a.f[l]);
+			break;
+		case OPC_COS:
+			for (l = 0; l < W; l++)
+				d.f[l] = cosf(a.f[l]);
+			break;
+		case OPC_SQRT:
+			for (l = 0; l < W; l++)
+				d.f[l] = sqrtf(a.f[l]);
+			break;
+		default:
+			unsupported(emu, "cat4", cat4->opc);
+			return;
+		}
+
+		pack_f(&d, dst.full);
+		store(emu, &dst, i, &d, mask);
+	}
+}
+
+static void exec_cat5(struct emu_a3xx *emu, instr_cat5_t *cat5, uint32_t mask)
+{
+	int full = cat5->full, isint, dfull = type_size(cat5->type) == 32;
+	unsigned src1 = cat5->src1, src2 = cat5->norm.src2;
+	unsigned i, l, n;
+	struct emu_a3xx_tex tex;
+	uint32_t result[4];
+
+	switch (cat5->opc) {
+	case OPC_DSX:
+	case OPC_DSY:
+		/* no neighbouring pixels, so derivatives are zero: */
+		for (l = 0; l < W; l++) {
+			if (!(mask & (1u << l)))
+				continue;
+			for (i = 0; i < 4; i++)
+				if ((cat5->wrmask & (1 << i)) && (cat5->dst + i < EMU_A3XX_REGS))
+					emu->r[cat5->dst + i][l] = 0;
+		}
+		return;
+	case OPC_ISAM:
+	case OPC_ISAML:
+	case OPC_ISAMM:
+	case OPC_SAM:
+	case OPC_SAMB:
+	case OPC_SAML:
+	case OPC_GETSIZE:
+	case OPC_GATHER4R:
+	case OPC_GATHER4G:
+	case OPC_GATHER4B:
+	case OPC_GATHER4A:
+		break;
+	default:
+		unsupported(emu, "cat5", cat5->opc);
+		return;
+	}
+
+	if (cat5->is_s2en) {
+		/* sampler/texture from a register, encoding not known well
+		 * enough:
+		 */
+		unsupported(emu, "cat5 s2en", cat5->opc);
+		return;
+	}
+
+	isint = (cat5->opc == OPC_ISAM) || (cat5->opc == OPC_ISAML) ||
+			(cat5->opc == OPC_ISAMM) || (cat5->opc == OPC_GETSIZE);
+
+	memset(&tex, 0, sizeof(tex));
+	tex.opc = cat5->opc;
+	tex.type = cat5->type;
+	tex.tex = cat5->norm.tex;
+	tex.samp = cat5->norm.samp;
+	tex.is_3d = cat5->is_3d;
+	tex.is_a = cat5->is_a;
+	tex.ncoord = (cat5->opc == OPC_GETSIZE) ? 1 :
+			2 + cat5->is_3d + cat5->is_a;
+
+	for (l = 0; l < W; l++) {
+		if (!(mask & (1u << l)))
+			continue;
+
+		for (i = 0; i < tex.ncoord + cat5->is_p; i++) {
+			uint32_t v = reg_val(emu, src1 + i, l, full);
+			if (isint) {
+				tex.icoord[i] = full ? (int32_t)v : (int16_t)v;
+			} else if (i < 4) {
+				tex.coord[i] = full ? uif(v) : util_half_to_float(v);
+			}
+		}
+
+		if (cat5->is_p && !isint) {
+			float q = full ? uif(reg_val(emu, src1 + tex.ncoord, l, full)) :
+					util_half_to_float(reg_val(emu, src1 + tex.ncoord, l, full));
+			for (i = 0; i < tex.ncoord - cat5->is_a; i++)
+				tex.coord[i] /= q;
+		}
+
+		tex.lod = 0.0;
+		if ((cat5->opc == OPC_SAMB) || (cat5->opc == OPC_SAML)) {
+			uint32_t v = reg_val(emu, src2, l, full);
+			tex.lod = full ? uif(v) : util_half_to_float(v);
+		} else if (cat5->opc == OPC_ISAML) {
+			uint32_t v = reg_val(emu, src2, l, full);
+			tex.lod = full ? (int32_t)v : (int16_t)v;
+		}
+
+		memset(result, 0, sizeof(result));
+		if (emu->funcs.sample)
+			emu->funcs.sample(emu->funcs.data, &tex, result);
+		emu->stats.tex++;
+
+		for (i = 0; i < 4; i++) {
+			if (!(cat5->wrmask & (1 << i)))
+				continue;
+			n = cat5->dst + i;
+			if (n >= EMU_A3XX_REGS)
+				continue;
+			if (dfull)
+				emu->r[n][l] = result[i];
+			else if (type_float(cat5->type))
+				emu->hr[n][l] = util_float_to_half(uif(result[i]));
+			else
+				emu->hr[n][l] = result[i];
+		}
+	}
+}
+
+/* host pointer to memory in one of the address spaces ('g'lobal, 'l'ocal
+ * or 'p'rivate), NULL if outside of it:
+ */
+static uint8_t * mem_ptr(struct emu_a3xx *emu, char space, unsigned l,
+		uint32_t addr, uint32_t size)
+{
+	emu->stats.mem++;
+
+	switch (space) {
+	case 'g':
+		if (emu->funcs.mem)
+			return emu->funcs.mem(emu->funcs.data, addr, size);
+		break;
+	case 'l':
+		if ((addr < EMU_A3XX_LOCAL) && (size <= EMU_A3XX_LOCAL - addr))
+			return &emu->local[addr];
+		break;
+	case 'p':
+		if ((addr < EMU_A3XX_PRIVATE) && (size <= EMU_A3XX_PRIVATE - addr))
+			return &emu->priv[l][addr];
+		break;
+	}
+
+	emu->stats.faults++;
+	return NULL;
+}
+
+static uint32_t mem_load(uint8_t *ptr, type_t type)
+{
+	uint32_t v = 0;
+
+	if (!ptr)
+		return 0;
+
+	memcpy(&v, ptr, type_size(type) / 8);
+	if (type == TYPE_S8)
+		v = (int8_t)v & 0xffff;
+
+	return v;
+}
+
+static void mem_store(uint8_t *ptr, type_t type, uint32_t v)
+{
+	if (ptr)
+		memcpy(ptr, &v, type_size(type) / 8);
+}
+
+static void exec_cat6(struct emu_a3xx *emu, instr_cat6_t *cat6, uint32_t mask)
+{
+	type_t type = cat6->type;
+	unsigned sz = type_size(type) / 8, l, i;
+	unsigned dst, src1, src2;
+	int src1_im, src2_im, src1off = 0, dstoff = 0;
+	int full = type_size(type) == 32;
+	char space;
+
+	if (cat6->dst_off) {
+		dst = cat6->c.dst;
+		dstoff = cat6->c.off;
+	} else {
+		dst = cat6->d.dst;
+	}
+
+	if (cat6->src_off) {
+		src1 = cat6->a.src1;
+		src1_im = cat6->a.src1_im;
+		src2 = cat6->a.src2;
+		src2_im = cat6->a.src2_im;
+		src1off = cat6->a.off;
+	} else {
+		src1 = cat6->b.src1;
+		src1_im = cat6->b.src1_im;
+		src2 = cat6->b.src2;
+		src2_im = cat6->b.src2_im;
+	}
+
+	switch (cat6->opc) {
+	case OPC_LDG:
+	case OPC_LDL:
+	case OPC_LDLW:
+	case OPC_LDP:
+		space = (cat6->opc == OPC_LDG) ? 'g' : (cat6->opc == OPC_LDP) ? 'p' : 'l';
+		for (l = 0; l < W; l++) {
+			uint32_t addr, count;
+
+			if (!(mask & (1u << l)))
+				continue;
+
+			addr = (src1_im ? src1 : reg_val(emu, src1, l, 1)) + src1off;
+			count = src2_im ? src2 : reg_val(emu, src2, l, 1);
+
+			for (i = 0; (i < count) && (dst + i < EMU_A3XX_REGS); i++) {
+				uint32_t v = mem_load(mem_ptr(emu, space, l, addr + i * sz, sz), type);
+				if (full)
+					emu->r[dst + i][l] = v;
+				else
+					emu->hr[dst + i][l] = v;
+			}
+		}
+		break;
+
+	case OPC_STG:
+	case OPC_STL:
+	case OPC_STLW:
+	case OPC_STP:
+		space = (cat6->opc == OPC_STG) ? 'g' : (cat6->opc == OPC_STP) ? 'p' : 'l';
+		for (l = 0; l < W; l++) {
+			uint32_t addr, count;
+
+			if (!(mask & (1u << l)))
+				continue;
+
+			/* dst is the address, src1 the value(s) and src2 the count: */
+			if (cat6->g && !cat6->dst_off)
+				addr = dst;
+			else
+				addr = reg_val(emu, dst, l, 1) + dstoff;
+			count = src2_im ? src2 : reg_val(emu, src2, l, full);
+
+			for (i = 0; i < count; i++) {
+				mem_store(mem_ptr(emu, space, l, addr + i * sz, sz), type,
+						reg_val(emu, src1 + i, l, full));
+			}
+		}
+		break;
+
+	case OPC_ATOMIC_ADD:
+	case OPC_ATOMIC_SUB:
+	case OPC_ATOMIC_XCHG:
+	case OPC_ATOMIC_INC:
+	case OPC_ATOMIC_DEC:
+	case OPC_ATOMIC_MIN:
+	case OPC_ATOMIC_MAX:
+	case OPC_ATOMIC_AND:
+	case OPC_ATOMIC_OR:
+	case OPC_ATOMIC_XOR:
+		/* dst = old value of [src1 + off], combined with src2.  The lanes
+		 * are applied in order, which is as good an order as any:
+		 */
+		space = cat6->g ? 'g' : 'l';
+		for (l = 0; l < W; l++) {
+			uint32_t addr, old, v, n = 0;
+			uint8_t *ptr;
+
+			if (!(mask & (1u << l)))
+				continue;
+
+			addr = (src1_im ? src1 : reg_val(emu, src1, l, 1)) + src1off;
+			v = reg_val(emu, src2, l, 1);
+			ptr = mem_ptr(emu, space, l, addr, 4);
+			old = mem_load(ptr, TYPE_U32);
+
+			switch (cat6->opc) {
+			case OPC_ATOMIC_ADD:  n = old + v;                       break;
+			case OPC_ATOMIC_SUB:  n = old - v;                       break;
+			case OPC_ATOMIC_XCHG: n = v;                             break;
+			case OPC_ATOMIC_INC:  n = old + 1;                       break;
+			case OPC_ATOMIC_DEC:  n = old - 1;                       break;
+			case OPC_ATOMIC_AND:  n = old & v;                       break;
+			case OPC_ATOMIC_OR:   n = old | v;                       break;
+			case OPC_ATOMIC_XOR:  n = old ^ v;                       break;
+			case OPC_ATOMIC_MIN:
+				if (type_signed(type))
+					n = ((int32_t)old < (int32_t)v) ? old : v;
+				else
+					n = (old < v) ? old : v;
+				break;
+			case OPC_ATOMIC_MAX:
+				if (type_signed(type))
+					n = ((int32_t)old > (int32_t)v) ? old : v;
+				else
+					n = (old > v) ? old : v;
+				break;
+			}
+
+			mem_store(ptr, TYPE_U32, n);
+			if (dst < EMU_A3XX_REGS)
+				emu->r[dst][l] = old;
+		}
+		break;
+
+	default:
+		unsupported(emu, "cat6", cat6->opc);
+		break;
+	}
+}
+
+/*
+ * Control flow:
+ */
+
+static void exec_cat0(struct emu_a3xx *emu, instr_cat0_t *cat0, uint32_t pc,
+		uint32_t mask)
+{
+	unsigned l;
+
+	for (l = 0; l < W; l++) {
+		int cond;
+
+		if (!(mask & (1u << l)))
+			continue;
+
+		cond = (!!emu->p0[cat0->comp][l]) ^ cat0->inv;
+
+		switch (cat0->opc) {
+		case OPC_BR:
+			emu->pc[l] = cond ? pc + cat0->immed : pc + 1;
+			break;
+		case OPC_JUMP:
+			emu->pc[l] = pc + cat0->immed;
+			break;
+		case OPC_CALL:
+			if (emu->sp[l] >= EMU_A3XX_STACK) {
+				snprintf(emu->error, sizeof(emu->error),
+						"call stack overflow at %u", pc);
+				emu->done |= 1u << l;
+				break;
+			}
+			emu->stack[emu->sp[l]++][l] = pc + 1;
+			emu->pc[l] = pc + cat0->immed;
+			break;
+		case OPC_RET:
+			if (emu->sp[l] == 0)
+				emu->done |= 1u << l;
+			else
+				emu->pc[l] = emu->stack[--emu->sp[l]][l];
+			break;
+		case OPC_KILL:
+			if (cond) {
+				emu->done |= 1u << l;
+				emu->killed |= 1u << l;
+				emu->stats.kills++;
+			}
+			emu->pc[l] = pc + 1;
+			break;
+		case OPC_END:
+			emu->done |= 1u << l;
+			break;
+		case OPC_NOP:
+			emu->pc[l] = pc + 1;
+			break;
+		default:
+			/* emit/cut/chmask/chsh/flow_rev: */
+			emu->pc[l] = pc + 1;
+			break;
+		}
+	}
+
+	switch (cat0->opc) {
+	case OPC_NOP:
+	case OPC_BR:
+	case OPC_JUMP:
+	case OPC_CALL:
+	case OPC_RET:
+	case OPC_KILL:
+	case OPC_END:
+		break;
+	default:
+		unsupported(emu, "cat0", cat0->opc);
+		break;
+	}
+}
+
+struct emu_a3xx * emu_a3xx_new(const struct emu_a3xx_funcs *funcs)
+{
+	struct emu_a3xx *emu = calloc(1, sizeof(*emu));
+
+	if (!emu)
+		return NULL;
+
+	if (funcs)
+		emu->funcs = *funcs;
+	emu->max_steps = 1 << 20;
+
+	return emu;
+}
+
+void emu_a3xx_reset(struct emu_a3xx *emu)
+{
+	memset(emu->r, 0, sizeof(emu->r));
+	memset(emu->hr, 0, sizeof(emu->hr));
+	memset(emu->a0, 0, sizeof(emu->a0));
+	memset(emu->p0, 0, sizeof(emu->p0));
+}
+
+int emu_a3xx_run(struct emu_a3xx *emu, const uint32_t *dwords,
+		uint32_t sizedwords, uint32_t mask)
+{
+	uint32_t ninstrs = sizedwords / 2;
+	unsigned l, steps = 0;
+
+	mask &= ALL_LANES;
+
+	for (l = 0; l < W; l++) {
+		emu->pc[l] = 0;
+		emu->sp[l] = 0;
+	}
+
+	emu->done = ~mask & ALL_LANES;
+	emu->killed = 0;
+	emu->error[0] = '\0';
+
+	while (emu->done != ALL_LANES) {
+		uint32_t live = ~emu->done & ALL_LANES;
+		uint32_t exec = 0, pc = ~0;
+		instr_t *instr;
+		uint32_t dw0;
+		unsigned rpt;
+
+		/* run the lanes which are furthest behind: */
+		for (l = 0; l < W; l++)
+			if ((live & (1u << l)) && (emu->pc[l] < pc))
+				pc = emu->pc[l];
+		for (l = 0; l < W; l++)
+			if ((live & (1u << l)) && (emu->pc[l] == pc))
+				exec |= 1u << l;
+
+		if (pc >= ninstrs) {
+			snprintf(emu->error, sizeof(emu->error),
+					"ran off the end of the program");
+			emu->done |= exec;
+			continue;
+		}
+
+		if (++steps > emu->max_steps) {
+			snprintf(emu->error, sizeof(emu->error),
+					"aborted after %u steps, at %u", emu->max_steps, pc);
+			return -1;
+		}
+
+		instr = (instr_t *)&dwords[2 * pc];
+		dw0 = dwords[2 * pc];
+		rpt = ((instr->opc_cat >= 1) && (instr->opc_cat <= 4)) ? instr->repeat : 0;
+
+		emu->stats.steps++;
+		emu->stats.instrs += rpt + 1;
+		emu->stats.lane_instrs += (rpt + 1) * __builtin_popcount(exec);
+		if (exec != live)
+			emu->stats.divergent++;
+
+		if (instr->opc_cat != 0)
+			for (l = 0; l < W; l++)
+				if (exec & (1u << l))
+					emu->pc[l] = pc + 1;
+
+		switch (instr->opc_cat) {
+		case 0: exec_cat0(emu, &instr->cat0, pc, exec);       break;
+		case 1: exec_cat1(emu, &instr->cat1, rpt, exec);      break;
+		case 2: exec_cat2(emu, &instr->cat2, dw0, rpt, exec); break;
+		case 3: exec_cat3(emu, &instr->cat3, dw0, rpt, exec); break;
+		case 4: exec_cat4(emu, &instr->cat4, dw0, rpt, exec); break;
+		case 5: exec_cat5(emu, &instr->cat5, exec);           break;
+		case 6: exec_cat6(emu, &instr->cat6, exec);           break;
+		default:
+			unsupported(emu, "category", instr->opc_cat);
+			break;
+		}
+	}
+
+	return 0;
+}
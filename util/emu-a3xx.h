@@ -0,0 +1,145 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef EMU_A3XX_H_
+#define EMU_A3XX_H_
+
+#include <stdint.h>
+
+#include "instr-a3xx.h"
+
+/* CPU interpreter for the a3xx shader ISA (cat0 - cat6).
+ *
+ * Up to EMU_A3XX_LANES invocations of a shader are run in lock-step: each
+ * register holds one value per invocation, and each instruction is a loop
+ * over the lanes (which the compiler can vectorize for the common ALU
+ * ops).  Divergent control flow is handled by always executing the lanes
+ * with the lowest pc, so lanes which branched apart reconverge once they
+ * reach the same instruction again.
+ *
+ * (rptN), relative (a0.x) addressing, the separate half register file,
+ * p0/a0, branches/calls/kill, texture fetch and global/local/private
+ * memory are handled.  Textures and global memory are accessed through
+ * callbacks, so the caller can back them with captured buffers.  Anything
+ * not understood is executed as a nop and counted in stats.unsupported.
+ */
+
+#define EMU_A3XX_LANES     16
+#define EMU_A3XX_REGS      (64 * 4)   /* r0.x - r63.w, indexed by (num << 2) | comp */
+#define EMU_A3XX_CONSTS    (1024 * 4)
+#define EMU_A3XX_LOCAL     16384      /* bytes, shared by all lanes */
+#define EMU_A3XX_PRIVATE   1024       /* bytes, per lane */
+#define EMU_A3XX_STACK     8          /* call depth */
+
+/* a texture fetch (cat5) of one lane: */
+struct emu_a3xx_tex {
+	opc_t opc;
+	type_t type;              /* of the result */
+	unsigned tex, samp;
+	unsigned ncoord;          /* incl. the array index */
+	int is_3d, is_a;
+	float coord[4];           /* sam*, projected if (p) */
+	int32_t icoord[4];        /* isam*, getsize (lod in icoord[0]) */
+	float lod;                /* saml/isaml lod, samb bias, else 0 */
+};
+
+struct emu_a3xx_funcs {
+	/* texture fetch, the result components as raw 32b values (float
+	 * for float result types, integer otherwise).  Zeros if NULL:
+	 */
+	void (*sample)(void *data, const struct emu_a3xx_tex *tex,
+			uint32_t result[4]);
+
+	/* global memory (ldg/stg/atomics), returns a host pointer to the
+	 * given range, or NULL if it isn't backed by anything:
+	 */
+	void *(*mem)(void *data, uint32_t gpuaddr, uint32_t size);
+
+	void *data;
+};
+
+struct emu_a3xx_stats {
+	uint64_t steps;          /* instructions issued, (rptN) counting once */
+	uint64_t instrs;         /* instructions issued, (rptN) counting N+1 */
+	uint64_t lane_instrs;    /* instrs * active lanes */
+	uint64_t divergent;      /* steps not covering all live lanes */
+	uint64_t tex, mem;       /* per-lane texture fetches / memory accesses */
+	uint64_t faults;         /* memory accesses outside of any buffer */
+	uint64_t kills;
+	uint64_t unsupported;    /* instructions executed as nop */
+};
+
+struct emu_a3xx {
+	/* register files, one value per lane: */
+	uint32_t r[EMU_A3XX_REGS][EMU_A3XX_LANES];
+	uint16_t hr[EMU_A3XX_REGS][EMU_A3XX_LANES];
+	int32_t  a0[EMU_A3XX_LANES];
+	uint32_t p0[4][EMU_A3XX_LANES];
+
+	/* constants, indexed like the registers: */
+	uint32_t consts[EMU_A3XX_CONSTS];
+
+	/* bary.f inputs, per varying component (the immediate of bary.f): */
+	const float (*varyings)[EMU_A3XX_LANES];
+	unsigned nvaryings;
+
+	uint8_t local[EMU_A3XX_LOCAL];
+	uint8_t priv[EMU_A3XX_LANES][EMU_A3XX_PRIVATE];
+
+	/* lanes which ran to the end or were killed by the last run: */
+	uint32_t done, killed;
+
+	/* bail out of a run after this many steps (runaway loops): */
+	unsigned max_steps;
+
+	struct emu_a3xx_funcs funcs;
+	struct emu_a3xx_stats stats;
+
+	/* description of the last problem, or empty: */
+	char error[128];
+
+	/* internal: */
+	uint32_t pc[EMU_A3XX_LANES];
+	uint32_t stack[EMU_A3XX_STACK][EMU_A3XX_LANES];
+	unsigned sp[EMU_A3XX_LANES];
+};
+
+/* allocate an interpreter, with zero'd state, free() when done: */
+struct emu_a3xx * emu_a3xx_new(const struct emu_a3xx_funcs *funcs);
+
+/* clear the registers (but not consts, memory or stats): */
+void emu_a3xx_reset(struct emu_a3xx *emu);
+
+/* run the program for the lanes in mask, from the first instruction until
+ * each lane hits end (or ret at the outermost level), is killed or runs
+ * off the end of the program.  Returns -1 if it had to be aborted:
+ */
+int emu_a3xx_run(struct emu_a3xx *emu, const uint32_t *dwords,
+		uint32_t sizedwords, uint32_t mask);
+
+#endif /* EMU_A3XX_H_ */
@@ -0,0 +1,586 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# Authors:
+#    agent <agent@local>
+
+"""Generate specialized PM4 packet decoders from the rnndb XML.
+
+Usage: gen-pm4-decode.py envytools/rnndb/adreno/adreno_pm4.xml > pm4-decode.c
+
+For each generation, the adreno_pm4_type3_packets enum is turned into a
+static opcode -> name table, and each packet payload <domain> into a C
+function which decodes the payload dwords the same way rnndec would
+(see dump_domain() in cffdump.c), but without any runtime string
+lookups or allocation.  See pm4-decode.h for the interface.
+"""
+
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+PACKETS_ENUM = "adreno_pm4_type3_packets"
+
+# generations to assume if the database has no chip enum:
+DEFAULT_GENS = [2, 3, 4, 5]
+
+
+def strip_ns(elem):
+    for e in elem.iter():
+        if "}" in e.tag:
+            e.tag = e.tag.split("}", 1)[1]
+
+
+class Database:
+    def __init__(self):
+        self.enums = {}
+        self.bitsets = {}
+        self.domains = {}
+        self.chips = []
+        self.parsed = set()
+
+    def parse(self, path, root_dir):
+        path = os.path.normpath(path)
+        if path in self.parsed:
+            return
+        self.parsed.add(path)
+        root = ET.parse(path).getroot()
+        strip_ns(root)
+        for e in root:
+            if e.tag == "import":
+                # import paths are relative to the rnndb root:
+                f = os.path.join(root_dir, e.get("file"))
+                if os.path.exists(f):
+                    self.parse(f, root_dir)
+            elif e.tag == "enum":
+                name = e.get("name")
+                if name in self.enums:
+                    self.enums[name].extend(e.findall("value"))
+                else:
+                    self.enums[name] = list(e.findall("value"))
+                if name == "chip":
+                    self.chips = [v.get("name") for v in self.enums[name]]
+            elif e.tag == "bitset":
+                self.bitsets[e.get("name")] = e
+            elif e.tag == "domain":
+                self.domains[e.get("name")] = e
+
+
+def chip_gen(name):
+    m = re.match(r"A(\d)XX$", name)
+    if not m:
+        raise ValueError("unknown chip variant: %s" % name)
+    return int(m.group(1))
+
+
+def chip_gens(db):
+    return [chip_gen(c) for c in db.chips] or DEFAULT_GENS
+
+
+def all_mask(db):
+    return sum(1 << g for g in chip_gens(db))
+
+
+def gen_mask(db, variants):
+    """Bitmask of generations (bit N == aNxx) matching a variants string."""
+    if not variants:
+        return all_mask(db)
+    gens = chip_gens(db)
+    mask = 0
+    for v in re.split(r"[\s,]+", variants.strip()):
+        if not v:
+            continue
+        if "-" in v:
+            lo, hi = v.split("-", 1)
+            lo = chip_gen(lo)
+            hi = chip_gen(hi) if hi else max(gens)
+            for g in range(lo, hi + 1):
+                mask |= 1 << g
+        else:
+            mask |= 1 << chip_gen(v)
+    return mask & all_mask(db)
+
+
+def parse_int(s):
+    return int(s, 0)
+
+
+def fail(msg):
+    sys.stderr.write("gen-pm4-decode.py: %s\n" % msg)
+    sys.exit(1)
+
+
+def required_int(e, attr):
+    """An attribute which rnn requires, for which there is no default."""
+    v = e.get(attr)
+    if v is None:
+        fail("<%s name=\"%s\"> has no %s" % (e.tag, e.get("name"), attr))
+    return parse_int(v)
+
+
+class Gen:
+    def __init__(self, db):
+        self.db = db
+        self.out = []
+        self.funcs = []
+        self.enum_funcs = {}
+        self.nenum = 0
+        self.reg_funcs = set()
+
+    def emit(self, s=""):
+        self.out.append(s)
+
+    def all_mask(self):
+        return all_mask(self.db)
+
+    def cond(self, mask):
+        if mask == self.all_mask():
+            return None
+        return "GEN(0x%x)" % mask
+
+    # enums are emitted as functions returning the value name, or NULL:
+    def enum_func(self, key, values):
+        if key in self.enum_funcs:
+            return self.enum_funcs[key]
+        fname = "enum_%d" % self.nenum
+        self.nenum += 1
+        self.enum_funcs[key] = fname
+        cases = {}
+        order = []
+        for v in values:
+            if v.get("value") is None:
+                continue
+            val = parse_int(v.get("value"))
+            mask = gen_mask(self.db, v.get("variants"))
+            if not mask:
+                continue
+            if val not in cases:
+                cases[val] = []
+                order.append(val)
+            cases[val].append((v.get("name"), mask))
+        f = []
+        f.append("static const char *%s(unsigned gen, uint64_t val)" % fname)
+        f.append("{")
+        f.append("\tswitch (val) {")
+        for val in order:
+            f.append("\tcase 0x%x:" % val)
+            for name, mask in cases[val]:
+                c = self.cond(mask)
+                if c:
+                    f.append("\t\tif (%s)" % c)
+                    f.append("\t\t\treturn \"%s\";" % name)
+                else:
+                    f.append("\t\treturn \"%s\";" % name)
+                    break
+            else:
+                f.append("\t\tbreak;")
+        f.append("\t}")
+        f.append("\treturn NULL;")
+        f.append("}")
+        f.append("")
+        self.funcs.extend(f)
+        return fname
+
+    def value_code(self, e, typ, width, expr, ind):
+        """Code to print a (non-bitset) value of the given type."""
+        vals = e.findall("value")
+        if vals:
+            fn = self.enum_func(id(e), vals)
+            return ["%sprint_enum(c, %s(gen, %s), %s);" % (ind, fn, expr, expr)]
+        if typ in self.db.enums:
+            fn = self.enum_func(typ, self.db.enums[typ])
+            return ["%sprint_enum(c, %s(gen, %s), %s);" % (ind, fn, expr, expr)]
+        if typ is None:
+            typ = "boolean" if width == 1 else "hex"
+        if typ == "uint":
+            return ["%sprint_uint(c, %s);" % (ind, expr)]
+        if typ == "int":
+            return ["%sprint_int(c, %s, %d);" % (ind, expr, width)]
+        if typ == "boolean":
+            return ["%sprint_bool(c, %s);" % (ind, expr)]
+        if typ == "float":
+            return ["%sprint_float(c, %s);" % (ind, expr)]
+        if typ in ("fixed", "ufixed"):
+            radix = parse_int(e.get("radix", "0"))
+            return ["%sprint_fixed(c, %s, %d, %d, %d);" % (ind, expr, radix,
+                    typ == "fixed", width)]
+        # hex, address, waddress, and anything we don't know about:
+        return ["%sprint_hex(c, %s);" % (ind, expr)]
+
+    def bitset_code(self, fields, ind):
+        code = []
+        code.append("%suint64_t mask = 0;" % ind)
+        code.append("%sint n = 0;" % ind)
+        code.append("%sprintf(\"{ \");" % ind)
+        for f in fields:
+            if f.get("pos") is not None:
+                low = high = parse_int(f.get("pos"))
+            else:
+                low = parse_int(f.get("low"))
+                high = parse_int(f.get("high"))
+            width = high - low + 1
+            fmask = ((1 << width) - 1) << low
+            shr = parse_int(f.get("shr", "0"))
+            typ = f.get("type")
+            if typ is None and not f.findall("value"):
+                typ = "boolean" if width == 1 else "hex"
+            m = gen_mask(self.db, f.get("variants"))
+            if not m:
+                continue
+            c = self.cond(m)
+            fi = ind
+            if c:
+                code.append("%sif (%s) {" % (ind, c))
+                fi = ind + "\t"
+            code.append("%smask |= 0x%xull;" % (fi, fmask))
+            name = f.get("name")
+            if typ == "boolean":
+                code.append("%sif (val & 0x%xull) {" % (fi, fmask))
+                code.append("%s\tsep(&n);" % fi)
+                code.append("%s\tprintf(\"%%s%s%%s\", c->mod, c->reset);" % (fi, name))
+                code.append("%s}" % fi)
+            else:
+                expr = "((val & 0x%xull) >> %d)" % (fmask, low)
+                if shr:
+                    expr = "(%s << %d)" % (expr, shr)
+                code.append("%ssep(&n);" % fi)
+                code.append("%sprintf(\"%%s%s%%s = \", c->rname, c->reset);" % (fi, name))
+                code.extend(self.value_code(f, typ, width + shr, expr, fi))
+            if c:
+                code.append("%s}" % ind)
+        code.append("%sif (val & ~mask) {" % ind)
+        code.append("%s\tsep(&n);" % ind)
+        code.append("%s\tprintf(\"%%s%%#\"PRIx64\"%%s\", c->err, val & ~mask, c->reset);" % ind)
+        code.append("%s}" % ind)
+        code.append("%sif (!n)" % ind)
+        code.append("%s\tprintf(\"0\");" % ind)
+        code.append("%sprintf(\" }\");" % ind)
+        return code
+
+    def reg_code(self, r, ind):
+        width = 64 if r.tag == "reg64" else 32
+        typ = r.get("type")
+        fields = r.findall("bitfield")
+        if typ in self.db.bitsets:
+            fields = self.db.bitsets[typ].findall("bitfield")
+        if fields:
+            return self.bitset_code(fields, ind)
+        shr = parse_int(r.get("shr", "0"))
+        expr = "(val << %d)" % shr if shr else "val"
+        return self.value_code(r, typ, width, expr, ind)
+
+    def collect(self, parent, base, mask, regs, arrays):
+        """Flatten a domain into (offset, ndwords, mask, reg) plus arrays
+        of (offset, stride, length, regs, arrays), where the offsets
+        within an array are relative to the start of each element.
+        """
+        for e in parent:
+            m = mask & gen_mask(self.db, e.get("variants"))
+            if not m:
+                continue
+            if e.tag in ("reg32", "reg64"):
+                n = 2 if e.tag == "reg64" else 1
+                regs.append((base + required_int(e, "offset"), n, m, e))
+            elif e.tag == "stripe":
+                self.collect(e, base + parse_int(e.get("offset", "0")), m,
+                        regs, arrays)
+            elif e.tag == "array":
+                # like in rnn, the offset defaults to zero:
+                off = base + parse_int(e.get("offset", "0"))
+                stride = required_int(e, "stride")
+                length = required_int(e, "length")
+                if stride <= 0:
+                    fail("<array name=\"%s\"> has stride %d" %
+                            (e.get("name"), stride))
+                sub = []
+                subarrays = []
+                self.collect(e, 0, m, sub, subarrays)
+                arrays.append((off, stride, length, sub, subarrays))
+
+    def reg_func(self, dom, r):
+        """Emit a function printing the value of one register."""
+        base = "print_%s_%s" % (re.sub(r"\W", "_", dom), re.sub(r"\W", "_", r.get("name")))
+        fname = base
+        n = 1
+        while fname in self.reg_funcs:
+            fname = "%s_%d" % (base, n)
+            n += 1
+        self.reg_funcs.add(fname)
+        f = []
+        f.append("static void %s(unsigned gen, uint64_t val," % fname)
+        f.append("\t\tconst struct pm4_colors *c)")
+        f.append("{")
+        f.extend(self.reg_code(r, "\t"))
+        f.append("}")
+        f.append("")
+        self.funcs.extend(f)
+        return fname
+
+    def case_code(self, dom, regs, var, ind):
+        code = []
+        fnames = [self.reg_func(dom, r) for o, n, m, r in regs]
+        offsets = sorted(set(o + k for o, n, m, r in regs for k in range(n)))
+        if not offsets:
+            return code
+        code.append("%sswitch (%s) {" % (ind, var))
+        for off in offsets:
+            code.append("%scase %d:" % (ind, off))
+            done = False
+            for (o, n, m, r), fname in zip(regs, fnames):
+                if not (o <= off < o + n):
+                    continue
+                c = self.cond(m)
+                line = "return line(%s, gen, val, prefix, c);" % fname
+                if c:
+                    code.append("%s\tif (%s)" % (ind, c))
+                    code.append("%s\t\t%s" % (ind, line))
+                else:
+                    code.append("%s\t%s" % (ind, line))
+                    done = True
+                    break
+            if not done:
+                code.append("%s\tbreak;" % ind)
+        code.append("%s}" % ind)
+        return code
+
+    def arrays_code(self, dom, arrays, var, ind):
+        """Decode the arrays, the index within an element of a nested
+        array is relative to the element of the enclosing one.
+        """
+        code = []
+        idx = "i%d" % len(ind)
+        for off, stride, length, sub, subarrays in arrays:
+            body = self.case_code(dom, sub, idx, ind + "\t")
+            body.extend(self.arrays_code(dom, subarrays, idx, ind + "\t"))
+            if not body:
+                continue
+            if off:
+                code.append("%sif ((%s >= %d) && (%s < %d)) {" % (ind, var, off,
+                        var, off + stride * length))
+                code.append("%s\tuint32_t %s = (%s - %d) %% %d;" % (ind, idx,
+                        var, off, stride))
+            else:
+                code.append("%sif (%s < %d) {" % (ind, var, stride * length))
+                code.append("%s\tuint32_t %s = %s %% %d;" % (ind, idx, var, stride))
+            code.extend(body)
+            code.append("%s}" % ind)
+        return code
+
+    def domain(self, name, dom):
+        regs = []
+        arrays = []
+        self.collect(dom, 0, self.all_mask(), regs, arrays)
+        body = self.case_code(name, regs, "i", "\t")
+        body.extend(self.arrays_code(name, arrays, "i", "\t"))
+        f = []
+        fname = "decode_" + re.sub(r"\W", "_", name)
+        f.append("/* decode one dword of the %s payload, returns 0 if past the"
+                % name)
+        f.append(" * last known dword:")
+        f.append(" */")
+        f.append("static int %s(unsigned gen, uint32_t i, uint64_t val,"
+                % fname)
+        f.append("\t\tconst char *prefix, const struct pm4_colors *c)")
+        f.append("{")
+        f.extend(body)
+        f.append("\treturn 0;")
+        f.append("}")
+        f.append("")
+        self.funcs.extend(f)
+        return fname
+
+    def generate(self, xml):
+        packets = self.db.enums.get(PACKETS_ENUM, [])
+        ngen = max(chip_gens(self.db)) + 1
+        names = [dict() for g in range(ngen)]
+        decoders = [dict() for g in range(ngen)]
+        domfuncs = {}
+        for v in packets:
+            if v.get("value") is None:
+                continue
+            val = parse_int(v.get("value"))
+            name = v.get("name")
+            mask = gen_mask(self.db, v.get("variants"))
+            if name in self.db.domains and name not in domfuncs:
+                domfuncs[name] = self.domain(name, self.db.domains[name])
+            for g in range(ngen):
+                # like rnn_enumname(), first match wins:
+                if (mask & (1 << g)) and val not in names[g]:
+                    names[g][val] = name
+                    if name in domfuncs:
+                        decoders[g][val] = domfuncs[name]
+
+        e = self.emit
+        e("/* generated by gen-pm4-decode.py from %s, do not edit */" % os.path.basename(xml))
+        e("")
+        e("#include <stdio.h>")
+        e("#include <stdlib.h>")
+        e("#include <stdint.h>")
+        e("#include <inttypes.h>")
+        e("")
+        e("#include \"pm4-decode.h\"")
+        e("")
+        e("#define GEN(mask) ((mask) & (1u << gen))")
+        e("")
+        e(PREAMBLE)
+        self.out.extend(self.funcs)
+
+        e("typedef int (*decode_fxn)(unsigned gen, uint32_t i, uint64_t val,")
+        e("\t\tconst char *prefix, const struct pm4_colors *c);")
+        e("")
+        e("static const struct {")
+        e("\tconst char *name;")
+        e("\tdecode_fxn fxn;")
+        e("} packets[%d][256] = {" % ngen)
+        for g in range(ngen):
+            if not names[g]:
+                continue
+            e("\t[%d] = {" % g)
+            for val in sorted(names[g]):
+                e("\t\t[0x%02x] = { \"%s\", %s }," % (val, names[g][val],
+                        decoders[g].get(val, "NULL")))
+            e("\t},")
+        e("};")
+        e(POSTAMBLE % {"ngen": ngen})
+        return "\n".join(self.out) + "\n"
+
+
+PREAMBLE = """\
+static int line(void (*fxn)(unsigned, uint64_t, const struct pm4_colors *),
+		unsigned gen, uint64_t val, const char *prefix,
+		const struct pm4_colors *c)
+{
+	printf("%s", prefix);
+	fxn(gen, val, c);
+	printf("\\n");
+	return 1;
+}
+
+static void sep(int *n)
+{
+	if ((*n)++)
+		printf(" | ");
+}
+
+static inline void print_hex(const struct pm4_colors *c, uint64_t val)
+{
+	printf("%s%#"PRIx64"%s", c->num, val, c->reset);
+}
+
+static inline void print_uint(const struct pm4_colors *c, uint64_t val)
+{
+	printf("%s%"PRIu64"%s", c->num, val, c->reset);
+}
+
+static inline void print_int(const struct pm4_colors *c, uint64_t val, int width)
+{
+	if ((width < 64) && (val & (1ull << (width - 1))))
+		printf("%s-%"PRIu64"%s", c->num, (uint64_t)((1ull << width) - val), c->reset);
+	else
+		printf("%s%"PRIi64"%s", c->num, (int64_t)val, c->reset);
+}
+
+static inline void print_bool(const struct pm4_colors *c, uint64_t val)
+{
+	if (val > 1)
+		print_hex(c, val);
+	else
+		printf("%s%s%s", c->mod, val ? "TRUE" : "FALSE", c->reset);
+}
+
+static inline void print_float(const struct pm4_colors *c, uint64_t val)
+{
+	union {
+		uint32_t u;
+		float f;
+	} u = { .u = val };
+	printf("%s%f%s", c->num, u.f, c->reset);
+}
+
+static inline void print_fixed(const struct pm4_colors *c, uint64_t val,
+		int radix, int is_signed, int width)
+{
+	if (is_signed && (width < 64) && (val & (1ull << (width - 1))))
+		printf("%s-%f%s", c->num, (double)((1ull << width) - val) / (1ull << radix), c->reset);
+	else
+		printf("%s%f%s", c->num, (double)val / (1ull << radix), c->reset);
+}
+
+static inline void print_enum(const struct pm4_colors *c, const char *name,
+		uint64_t val)
+{
+	if (name)
+		printf("%s%s%s", c->eval, name, c->reset);
+	else
+		print_hex(c, val);
+}
+"""
+
+POSTAMBLE = """
+const char *pm4_packet_name(unsigned gen, uint32_t opcode)
+{
+	if ((gen >= %(ngen)d) || (opcode >= 256))
+		return NULL;
+	return packets[gen][opcode].name;
+}
+
+int pm4_decode_packet(unsigned gen, uint32_t opcode, const uint32_t *dwords,
+		uint32_t sizedwords, const char *prefix, const struct pm4_colors *c)
+{
+	decode_fxn fxn;
+	uint32_t i;
+
+	if (!pm4_packet_name(gen, opcode))
+		return -1;
+
+	/* known packet, but with no payload description: */
+	fxn = packets[gen][opcode].fxn;
+	if (!fxn)
+		return 0;
+
+	for (i = 0; i < sizedwords; i++)
+		if (!fxn(gen, i, dwords[i], prefix, c))
+			break;
+
+	return 0;
+}"""
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("usage: %s path/to/rnndb/adreno/adreno_pm4.xml\n" % sys.argv[0])
+        sys.exit(1)
+    xml = sys.argv[1]
+    # the rnndb root is the parent of the adreno/ directory:
+    root_dir = os.path.dirname(os.path.dirname(os.path.abspath(xml)))
+    db = Database()
+    db.parse(xml, root_dir)
+    if PACKETS_ENUM not in db.enums:
+        sys.stderr.write("%s: no %s enum\n" % (xml, PACKETS_ENUM))
+        sys.exit(1)
+    sys.stdout.write(Gen(db).generate(xml))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,345 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "ibreuse.h"
+#include "util.h"
+
+#define NTOP 10
+
+static int enabled;
+
+struct ib {
+	uint64_t hash;
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+	int is_submit;
+	int first_frame, last_frame;
+	unsigned frames, executions;
+};
+
+static struct ib *ibs;
+static unsigned nibs, maxibs;
+static unsigned *ib_idx;         /* open addressing, index + 1 into ibs */
+static unsigned ib_idx_size;
+
+#define NSTACK 32
+
+/* IBs currently being executed, the hash accumulates the nested IBs
+ * and referenced buffers as they are encountered.  IBs nested deeper
+ * than the stack are not tracked by themselves, but still counted in
+ * depth and folded into the innermost tracked IB:
+ */
+static struct {
+	uint64_t hash;
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+} stack[NSTACK];
+static int depth;
+static int warned;
+
+/* the innermost tracked IB: */
+static int top(void)
+{
+	return ((depth < NSTACK) ? depth : NSTACK) - 1;
+}
+
+struct ibreuse_stats {
+	unsigned frames, ibs, reused, repeats;
+	uint64_t bytes, reused_bytes;
+	unsigned reused_submits;
+};
+static struct ibreuse_stats frame, capture;
+static int submit_nr;
+
+static uint64_t hash_buf(const uint32_t *dwords, uint32_t sizedwords)
+{
+	uint64_t h = mix(sizedwords);
+	uint32_t i;
+
+	for (i = 0; i + 1 < sizedwords; i += 2)
+		h = mix(h ^ (dwords[i] | ((uint64_t)dwords[i + 1] << 32)));
+	if (i < sizedwords)
+		h = mix(h ^ dwords[i]);
+
+	return h;
+}
+
+void ibreuse_enable(void)
+{
+	enabled = 1;
+}
+
+static struct ib * lookup(uint64_t hash, int *is_new)
+{
+	unsigned i;
+
+	if ((nibs * 2) >= ib_idx_size) {
+		/* grow and rehash: */
+		unsigned j;
+		ib_idx_size = ib_idx_size ? ib_idx_size * 2 : 1024;
+		free(ib_idx);
+		ib_idx = calloc(ib_idx_size, sizeof(ib_idx[0]));
+		for (j = 0; j < nibs; j++) {
+			for (i = ibs[j].hash % ib_idx_size; ib_idx[i];
+					i = (i + 1) % ib_idx_size)
+				;
+			ib_idx[i] = j + 1;
+		}
+	}
+
+	*is_new = 0;
+
+	for (i = hash % ib_idx_size; ib_idx[i]; i = (i + 1) % ib_idx_size)
+		if (ibs[ib_idx[i] - 1].hash == hash)
+			return &ibs[ib_idx[i] - 1];
+
+	if (nibs == maxibs) {
+		maxibs = maxibs ? maxibs * 2 : 1024;
+		ibs = xrealloc(ibs, maxibs * sizeof(ibs[0]));
+	}
+
+	memset(&ibs[nibs], 0, sizeof(ibs[0]));
+	ibs[nibs].hash = hash;
+	ibs[nibs].first_frame = ibs[nibs].last_frame = -1;
+	ib_idx[i] = nibs + 1;
+	*is_new = 1;
+
+	return &ibs[nibs++];
+}
+
+static void push(uint64_t gpuaddr, const uint32_t *dwords, uint32_t sizedwords)
+{
+	if (depth >= NSTACK) {
+		if (!warned)
+			fprintf(stderr, "ibreuse: IBs nested more than %d deep, "
+					"not tracking the inner ones\n", NSTACK);
+		warned = 1;
+		stack[NSTACK-1].hash = mix(stack[NSTACK-1].hash ^
+				hash_buf(dwords, sizedwords));
+		depth++;
+		return;
+	}
+
+	stack[depth].hash = hash_buf(dwords, sizedwords);
+	stack[depth].gpuaddr = gpuaddr;
+	stack[depth].sizedwords = sizedwords;
+	depth++;
+}
+
+/* finish the hash of the innermost IB, and fold it into the parent,
+ * returns NULL for IBs which are not tracked:
+ */
+static struct ib * pop(int is_submit)
+{
+	struct ib *ib;
+	uint64_t hash;
+	int is_new;
+
+	depth--;
+	if (depth >= NSTACK)
+		return NULL;
+
+	hash = stack[depth].hash;
+	if (is_submit)
+		hash = mix(hash ^ 0x5355424d4954ull);
+
+	if (depth > 0)
+		stack[depth-1].hash = mix(stack[depth-1].hash ^ hash);
+
+	ib = lookup(hash, &is_new);
+	if (is_new) {
+		ib->gpuaddr = stack[depth].gpuaddr;
+		ib->sizedwords = stack[depth].sizedwords;
+		ib->is_submit = is_submit;
+	}
+
+	ib->executions++;
+
+	return ib;
+}
+
+void ibreuse_begin(uint64_t gpuaddr, const uint32_t *dwords,
+		uint32_t sizedwords)
+{
+	if (!enabled)
+		return;
+
+	push(gpuaddr, dwords, sizedwords);
+}
+
+void ibreuse_end(void)
+{
+	struct ib *ib;
+
+	if (!enabled || (depth <= 1))
+		return;
+
+	ib = pop(0);
+	if (!ib)
+		return;
+
+	if (ib->last_frame == submit_nr) {
+		/* already accounted for in this frame, ie. per-bin replay: */
+		frame.repeats++;
+		return;
+	}
+
+	frame.ibs++;
+	frame.bytes += ib->sizedwords * 4;
+
+	if (ib->first_frame < 0) {
+		ib->first_frame = submit_nr;
+	} else if (ib->first_frame < submit_nr) {
+		frame.reused++;
+		frame.reused_bytes += ib->sizedwords * 4;
+	}
+
+	ib->last_frame = submit_nr;
+	ib->frames++;
+}
+
+void ibreuse_ref(const void *buf, uint32_t sizedwords)
+{
+	if (!enabled || !buf || (depth <= 0))
+		return;
+
+	stack[top()].hash = mix(stack[top()].hash ^ hash_buf(buf, sizedwords));
+}
+
+static void print_stats(const char *prefix, const struct ibreuse_stats *s)
+{
+	printf("%s%u IBs (%"PRIu64" bytes), %u reused from earlier frames "
+			"(%"PRIu64" bytes, %.1f%%), %u repeated executions\n", prefix,
+			s->ibs, s->bytes, s->reused, s->reused_bytes,
+			pct(s->reused_bytes, s->bytes), s->repeats);
+}
+
+void ibreuse_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	memset(&capture, 0, sizeof(capture));
+	nibs = 0;
+	if (ib_idx)
+		memset(ib_idx, 0, ib_idx_size * sizeof(ib_idx[0]));
+	depth = 0;
+	warned = 0;
+
+	printf("IB reuse for %s:\n", name);
+}
+
+static int cmp_ib(const void *a, const void *b)
+{
+	const struct ib *ia = a, *ib = b;
+	if (ia->frames != ib->frames)
+		return (int)ib->frames - (int)ia->frames;
+	return (int)ib->sizedwords - (int)ia->sizedwords;
+}
+
+void ibreuse_end_cmdstream(void)
+{
+	unsigned i, n, total = nibs;
+
+	if (!enabled)
+		return;
+
+	print_stats("total: ", &capture);
+	printf("\t%u of %u submits identical to an earlier one\n",
+			capture.reused_submits, capture.frames);
+
+	/* the index is not valid anymore after sorting: */
+	qsort(ibs, total, sizeof(ibs[0]), cmp_ib);
+	nibs = 0;
+
+	printf("\tmost reused IBs:\n");
+	for (i = 0, n = 0; (n < NTOP) && (i < total) && (ibs[i].frames > 1); i++) {
+		if (ibs[i].is_submit)
+			continue;
+		printf("\t\t%016"PRIx64": %u bytes, %u frames, %u executions, first in frame %d\n",
+				ibs[i].gpuaddr, ibs[i].sizedwords * 4, ibs[i].frames,
+				ibs[i].executions, ibs[i].first_frame);
+		n++;
+	}
+}
+
+void ibreuse_start_submit(int submit, uint64_t gpuaddr,
+		const uint32_t *dwords, uint32_t sizedwords)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	submit_nr = submit;
+	depth = 0;
+
+	push(gpuaddr, dwords, sizedwords);
+}
+
+void ibreuse_end_submit(void)
+{
+	struct ib *ib;
+	int first_frame;
+
+	if (!enabled || (depth <= 0))
+		return;
+
+	/* close any IBs left open: */
+	while (depth > 1)
+		ibreuse_end();
+
+	ib = pop(1);
+	first_frame = ib->first_frame;
+	if (first_frame < 0)
+		ib->first_frame = submit_nr;
+	ib->last_frame = submit_nr;
+	ib->frames++;
+
+	frame.bytes += ib->sizedwords * 4;
+	if (first_frame >= 0)
+		frame.reused_bytes += ib->sizedwords * 4;
+
+	printf("frame %d: ", submit_nr);
+	print_stats("", &frame);
+	if (first_frame >= 0)
+		printf("\tsubmit identical to frame %d\n", first_frame);
+
+	capture.frames++;
+	capture.ibs += frame.ibs;
+	capture.reused += frame.reused;
+	capture.repeats += frame.repeats;
+	capture.bytes += frame.bytes;
+	capture.reused_bytes += frame.reused_bytes;
+	if (first_frame >= 0)
+		capture.reused_submits++;
+}
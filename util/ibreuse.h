@@ -0,0 +1,64 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef IBREUSE_H_
+#define IBREUSE_H_
+
+#include <stdint.h>
+
+/* Report how much of each frame's cmdstream is byte-identical to what
+ * was submitted in earlier frames, ie. what a driver could save by
+ * caching pre-built IBs and re-executing them.
+ *
+ * Each IB (and each submit) is hashed along with the contents it
+ * references: nested IBs and draw-state groups, and state loaded from
+ * external buffers.  So an IB only counts as reused if everything it
+ * causes the CP to execute is identical too.
+ */
+
+/* called at start to enable the report: */
+void ibreuse_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void ibreuse_start_cmdstream(const char *name);
+void ibreuse_end_cmdstream(void);
+
+/* called at start/end of each submit, with the top level cmdstream: */
+void ibreuse_start_submit(int submit, uint64_t gpuaddr,
+		const uint32_t *dwords, uint32_t sizedwords);
+void ibreuse_end_submit(void);
+
+/* called at start/end of each IB or draw-state group: */
+void ibreuse_begin(uint64_t gpuaddr, const uint32_t *dwords,
+		uint32_t sizedwords);
+void ibreuse_end(void);
+
+/* called for other buffers referenced by the current IB: */
+void ibreuse_ref(const void *buf, uint32_t sizedwords);
+
+#endif /* IBREUSE_H_ */
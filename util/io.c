@@ -39,7 +39,7 @@
 struct io {
 	struct archive *a;
 	struct archive_entry *entry;
-	unsigned offset;
+	uint64_t offset;
 };
 
 static void io_error(struct io *io)
@@ -136,7 +136,7 @@ void io_close(struct io *io)
 	free(io);
 }
 
-unsigned io_offset(struct io *io)
+uint64_t io_offset(struct io *io)
 {
 	return io->offset;
 }
@@ -25,8 +25,11 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <math.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <fcntl.h>
 #include <string.h>
 
@@ -34,6 +37,11 @@
 #include "disasm.h"
 #include "io.h"
 
+/* The program sections are parsed in place (see next_sect()), and are
+ * not necessarily 32b aligned, so all the structs describing them are
+ * packed to make the compiler use unaligned-safe accesses.
+ */
+
 struct pgm_header {
 	uint32_t size;
 	uint32_t unknown1;
@@ -49,7 +57,7 @@ struct pgm_header {
 	uint32_t num_samplers;
 	uint32_t num_varyings;
 	uint32_t num_uniformblocks;
-};
+} __attribute__((__packed__));
 
 struct vs_header {
 	uint32_t unknown1;  /* seems to be # of sections up to and including shader */
@@ -61,11 +69,11 @@ struct vs_header {
 	uint32_t unknown7;
 	uint32_t unknown8;
 	uint32_t unknown9;  /* seems to be # of sections following shader */
-};
+} __attribute__((__packed__));
 
 struct fs_header {
 	uint32_t unknown1;
-};
+} __attribute__((__packed__));
 /*
 	// Covers a lot of type_info
 	// varying, attribute, uniform, sampler
@@ -126,7 +134,7 @@ struct attribute {
 	uint32_t unknown4;
 	uint32_t unknown5;
 	char name[];
-};
+} __attribute__((__packed__));
 
 struct uniform {
 	uint32_t type_info;
@@ -142,15 +150,15 @@ struct uniform {
 	union {
 		struct {
 			char name[1];
-		} v1;
+		} __attribute__((__packed__)) v1;
 		struct {
 			uint32_t unknown10;
 			uint32_t unknown11;
 			uint32_t unknown12;
 			char name[];
-		} v2;
-	};
-};
+		} __attribute__((__packed__)) v2;
+	} __attribute__((__packed__));
+} __attribute__((__packed__));
 
 struct uniformblockmember {
 	uint32_t type_info;
@@ -168,7 +176,7 @@ struct uniformblockmember {
 	uint32_t unknown11;
 	uint32_t unknown12;
 	char name[];
-};
+} __attribute__((__packed__));
 
 struct uniformblock
 {
@@ -183,7 +191,7 @@ struct uniformblock
 	uint32_t unknown6;
 	uint32_t unknown7;
 	char name[];
-};
+} __attribute__((__packed__));
 
 
 struct sampler {
@@ -196,7 +204,7 @@ struct sampler {
 	uint32_t const_idx; /* the CONST() indx value for the sampler */
 	uint32_t unknown7;
 	char name[];
-};
+} __attribute__((__packed__));
 
 struct varying {
 	uint32_t type_info;
@@ -204,7 +212,7 @@ struct varying {
 	uint32_t unknown3;
 	uint32_t reg;       /* the register holding the value (on entry to the shader) */
 	char name[];
-};
+} __attribute__((__packed__));
 
 struct output {
 	uint32_t type_info;
@@ -216,7 +224,7 @@ struct output {
 	uint32_t unknown7;
 	uint32_t unknown8;
 	char name[];
-};
+} __attribute__((__packed__));
 
 struct constant {
 	uint32_t unknown1;
@@ -224,7 +232,7 @@ struct constant {
 	uint32_t unknown3;
 	uint32_t const_idx;
 	float val[];
-};
+} __attribute__((__packed__));
 
 struct state {
 	char *buf;
@@ -238,7 +246,17 @@ struct state {
 		struct uniformblock *header;
 		struct uniformblockmember **members; /* GL ES 3.0 spec mandates minimum 16K support. a3xx supports 65K */
 	} uniformblocks[24]; /* Maximum a330 supports */
-	struct output  *outputs[0];  /* I guess only one?? */
+	struct output  *outputs[1];  /* I guess only one?? */
+
+	/* collected while dumping the shaders, for --json: */
+	struct {
+		const char *type;
+		uint32_t *dwords;
+		int sizedwords;
+		struct constant *constants[32];
+		int nconsts;
+	} shaders[4];
+	int nshaders;
 };
 
 const char *infile;
@@ -246,6 +264,15 @@ static int full_dump = 1;
 static int dump_shaders = 0;
 static int gpu_id;
 
+/* with --json, the structured output goes here (the text output goes
+ * to /dev/null):
+ */
+static FILE *json;
+static int nentries, nprograms;
+
+/* name of the current test (RD_TEST section): */
+static char test[256];
+
 char *find_sect_end(char *buf, int sz)
 {
 	uint8_t *ptr = (uint8_t *)buf;
@@ -280,6 +307,20 @@ static inline float d2f(uint32_t d)
 	return u.f;
 }
 
+/* read a (possibly unaligned) dword, the part past the end of the
+ * section reads as zero:
+ */
+static inline uint32_t get_dword(const uint8_t *ptr, const uint8_t *end)
+{
+	uint32_t d = 0;
+	int i;
+
+	for (i = 0; (i < 4) && (ptr + i < end); i++)
+		d |= ptr[i] << (8 * i);
+
+	return d;
+}
+
 static void dump_hex(char *buf, int sz)
 {
 	uint8_t *ptr = (uint8_t *)buf;
@@ -287,14 +328,12 @@ static void dump_hex(char *buf, int sz)
 	int i = 0;
 
 	while (ptr < end) {
-		uint32_t d = 0;
+		uint32_t d;
 
 		printf((i % 8) ? " " : "\t");
 
-		d |= *(ptr++) <<  0;
-		d |= *(ptr++) <<  8;
-		d |= *(ptr++) << 16;
-		d |= *(ptr++) << 24;
+		d = get_dword(ptr, end);
+		ptr += 4;
 
 		printf("%08x", d);
 
@@ -313,18 +352,16 @@ static void dump_hex(char *buf, int sz)
 static void dump_float(char *buf, int sz)
 {
 	uint8_t *ptr = (uint8_t *)buf;
-	uint8_t *end = ptr + sz - 3;
+	uint8_t *end = ptr + sz;
 	int i = 0;
 
-	while (ptr < end) {
-		uint32_t d = 0;
+	while ((ptr + 3) < end) {
+		uint32_t d;
 
 		printf((i % 8) ? " " : "\t");
 
-		d |= *(ptr++) <<  0;
-		d |= *(ptr++) <<  8;
-		d |= *(ptr++) << 16;
-		d |= *(ptr++) << 24;
+		d = get_dword(ptr, end);
+		ptr += 4;
 
 		printf("%8f", d2f(d));
 
@@ -383,14 +420,12 @@ static void dump_hex_ascii(char *buf, int sz)
 	printf("%d (0x%x) bytes\n", sz, sz);
 
 	while (ptr < end) {
-		uint32_t d = 0;
+		uint32_t d;
 
 		printf((i % 4) ? " " : "\t");
 
-		d |= *(ptr++) <<  0;
-		d |= *(ptr++) <<  8;
-		d |= *(ptr++) << 16;
-		d |= *(ptr++) << 24;
+		d = get_dword(ptr, end);
+		ptr += 4;
 
 		printf("%08x", d);
 
@@ -398,7 +433,8 @@ static void dump_hex_ascii(char *buf, int sz)
 			int j;
 			printf("\t|");
 			for (j = 0; j < 16; j++) {
-				uint8_t c = *(ascii++);
+				uint8_t c = (ascii < end) ? *ascii : 0;
+				ascii++;
 				c ^= 0xff;
 				printf("%c", (isascii(c) && !iscntrl(c)) ? c : '.');
 			}
@@ -420,19 +456,20 @@ static void dump_hex_ascii(char *buf, int sz)
 	}
 }
 
+/* Returns a pointer to the section in place, rather than a copy.  The
+ * 0xba5eba11 terminating it isn't needed anymore, so the first byte is
+ * overwritten with a '\0', to terminate names at the end of a section.
+ */
 void *next_sect(struct state *state, int *sect_size)
 {
 	char *end = find_sect_end(state->buf, state->sz);
-	void *sect;
+	void *sect = state->buf;
 
 	if (!end)
 		return NULL;
 
 	*sect_size = end - state->buf;
-
-	/* copy the section to keep things nicely 32b aligned: */
-	sect = malloc(ALIGN(*sect_size, 4));
-	memcpy(sect, state->buf, *sect_size);
+	*end = '\0';
 
 	state->sz -= *sect_size + 4;
 	state->buf = end + 4;
@@ -440,6 +477,42 @@ void *next_sect(struct state *state, int *sect_size)
 	return sect;
 }
 
+/* the disassemblers want 32b aligned dwords: */
+static uint32_t *aligned_dwords(void *ptr, int sizedwords)
+{
+	static uint32_t *buf;
+	static int bufsize;
+
+	if (!((uintptr_t)ptr & 3))
+		return ptr;
+
+	if (sizedwords > bufsize) {
+		bufsize = sizedwords;
+		buf = realloc(buf, bufsize * 4);
+	}
+	memcpy(buf, ptr, sizedwords * 4);
+
+	return buf;
+}
+
+static void add_shader(struct state *state, const char *type,
+		uint32_t *dwords, int sizedwords, int nconsts,
+		struct constant **constants)
+{
+	int i;
+
+	if (state->nshaders == ARRAY_SIZE(state->shaders))
+		return;
+
+	state->shaders[state->nshaders].type = type;
+	state->shaders[state->nshaders].dwords = dwords;
+	state->shaders[state->nshaders].sizedwords = sizedwords;
+	state->shaders[state->nshaders].nconsts = nconsts;
+	for (i = 0; i < nconsts; i++)
+		state->shaders[state->nshaders].constants[i] = constants[i];
+	state->nshaders++;
+}
+
 static int valid_type(uint32_t type_info)
 {
 	switch ((type_info >> 8) & 0xff) {
@@ -558,6 +631,7 @@ static void dump_raw_shader(uint32_t *dwords, uint32_t sizedwords, int n, char *
 static void dump_shaders_a2xx(struct state *state)
 {
 	int i, sect_size;
+	uint32_t *dwords;
 	uint8_t *ptr;
 
 	/* dump vertex shaders: */
@@ -591,9 +665,11 @@ static void dump_shaders_a2xx(struct state *state)
 		} else {
 			dump_short_summary(state, vs_hdr->unknown1 - 1, constants);
 		}
-		disasm_a2xx((uint32_t *)(ptr + 32), (sect_size - 32) / 4, level+1, SHADER_VERTEX);
-		dump_raw_shader((uint32_t *)(ptr + 32), (sect_size - 32) / 4, i, "vo");
-		free(ptr);
+		dwords = aligned_dwords(ptr + 32, (sect_size - 32) / 4);
+		disasm_a2xx(dwords, (sect_size - 32) / 4, level+1, SHADER_VERTEX);
+		dump_raw_shader(dwords, (sect_size - 32) / 4, i, "vo");
+		add_shader(state, "vs", (uint32_t *)(ptr + 32), (sect_size - 32) / 4,
+				vs_hdr->unknown1 - 1, constants);
 
 		for (j = 0; j < vs_hdr->unknown9; j++) {
 			ptr = next_sect(state, &sect_size);
@@ -601,14 +677,7 @@ static void dump_shaders_a2xx(struct state *state)
 				printf("######## VS%d CONST?: (size=%d)\n", i, sect_size);
 				dump_hex(ptr, sect_size);
 			}
-			free(ptr);
-		}
-
-		for (j = 0; j < vs_hdr->unknown1 - 1; j++) {
-			free(constants[j]);
 		}
-
-		free(vs_hdr);
 	}
 
 	/* dump fragment shaders: */
@@ -642,15 +711,11 @@ static void dump_shaders_a2xx(struct state *state)
 		} else {
 			dump_short_summary(state, fs_hdr->unknown1 - 1, constants);
 		}
-		disasm_a2xx((uint32_t *)(ptr + 32), (sect_size - 32) / 4, level+1, SHADER_FRAGMENT);
-		dump_raw_shader((uint32_t *)(ptr + 32), (sect_size - 32) / 4, i, "fo");
-		free(ptr);
-
-		for (j = 0; j < fs_hdr->unknown1 - 1; j++) {
-			free(constants[j]);
-		}
-
-		free(fs_hdr);
+		dwords = aligned_dwords(ptr + 32, (sect_size - 32) / 4);
+		disasm_a2xx(dwords, (sect_size - 32) / 4, level+1, SHADER_FRAGMENT);
+		dump_raw_shader(dwords, (sect_size - 32) / 4, i, "fo");
+		add_shader(state, "fs", (uint32_t *)(ptr + 32), (sect_size - 32) / 4,
+				fs_hdr->unknown1 - 1, constants);
 	}
 }
 
@@ -664,6 +729,7 @@ static void dump_shaders_a3xx(struct state *state)
 		uint8_t *vs_hdr;
 		struct constant *constants[32];
 		uint8_t *instrs = NULL;
+		uint32_t *dwords;
 
 		vs_hdr = next_sect(state, &hdr_size);
 printf("hdr_size=%d\n", hdr_size);
@@ -732,9 +798,11 @@ printf("hdr_size=%d\n", hdr_size);
 			instrs_size -= 32;
 		}
 
-		disasm_a3xx((uint32_t *)instrs, instrs_size / 4, level+1, SHADER_VERTEX);
-		dump_raw_shader((uint32_t *)instrs, instrs_size / 4, i, "vo3");
-		free(vs_hdr);
+		dwords = aligned_dwords(instrs, instrs_size / 4);
+		disasm_a3xx(dwords, instrs_size / 4, level+1, SHADER_VERTEX);
+		dump_raw_shader(dwords, instrs_size / 4, i, "vo3");
+		add_shader(state, "vs", (uint32_t *)instrs, instrs_size / 4,
+				nconsts, constants);
 	}
 
 	/* dump fragment shaders: */
@@ -743,6 +811,7 @@ printf("hdr_size=%d\n", hdr_size);
 		uint8_t *fs_hdr;
 		struct constant *constants[32];
 		uint8_t *instrs = NULL;
+		uint32_t *dwords;
 
 		fs_hdr = next_sect(state, &hdr_size);
 
@@ -811,12 +880,146 @@ printf("hdr_size=%d\n", hdr_size);
 				instrs_size -= 32;
 			}
 		}
-		disasm_a3xx((uint32_t *)instrs, instrs_size / 4, level+1, SHADER_FRAGMENT);
-		dump_raw_shader((uint32_t *)instrs, instrs_size / 4, i, "fo3");
-		free(fs_hdr);
+		dwords = aligned_dwords(instrs, instrs_size / 4);
+		disasm_a3xx(dwords, instrs_size / 4, level+1, SHADER_FRAGMENT);
+		dump_raw_shader(dwords, instrs_size / 4, i, "fo3");
+		add_shader(state, "fs", (uint32_t *)instrs, instrs_size / 4,
+				nconsts, constants);
 	}
 }
 
+static void json_string(const char *str)
+{
+	fputc('"', json);
+	for (; str && *str; str++) {
+		unsigned char c = *str;
+		if ((c == '"') || (c == '\\'))
+			fprintf(json, "\\%c", c);
+		else if ((c < 0x20) || (c >= 0x7f))
+			fprintf(json, "\\u%04x", c);
+		else
+			fputc(c, json);
+	}
+	fputc('"', json);
+}
+
+static void json_float(float f)
+{
+	if (isfinite(f))
+		fprintf(json, "%g", f);
+	else
+		fprintf(json, "null");
+}
+
+static const char *uniform_name(struct uniform *uniform)
+{
+	return is_uniform_v2(uniform) ? uniform->v2.name : uniform->v1.name;
+}
+
+/* one object per program, with the same info as the short summary, plus
+ * some per shader stats:
+ */
+static void dump_json(struct state *state, const char *test)
+{
+	struct pgm_header *hdr = state->hdr;
+	int i, j;
+
+	fprintf(json, "%s\n\t\t{\"test\":", nprograms++ ? "," : "");
+	json_string(test);
+	fprintf(json, ",\"gpu_id\":%d,\"revision\":%u,\"size\":%u",
+			gpu_id, hdr->revision, hdr->size);
+
+	fprintf(json, ",\n\t\t \"attributes\":[");
+	for (i = 0; i < hdr->num_attribs; i++) {
+		fprintf(json, "%s{\"name\":", i ? "," : "");
+		json_string(state->attribs[i]->name);
+		fprintf(json, ",\"reg\":%u,\"const_idx\":%u}",
+				state->attribs[i]->reg, state->attribs[i]->const_idx);
+	}
+
+	fprintf(json, "],\n\t\t \"uniforms\":[");
+	for (i = 0; i < hdr->num_uniforms; i++) {
+		struct uniform *uniform = state->uniforms[i];
+		fprintf(json, "%s{\"name\":", i ? "," : "");
+		json_string(uniform_name(uniform));
+		if (uniform->const_reg == -1)
+			fprintf(json, ",\"const_base\":%u}", uniform->const_base);
+		else
+			fprintf(json, ",\"const_reg\":%u}", uniform->const_reg);
+	}
+
+	fprintf(json, "],\n\t\t \"samplers\":[");
+	for (i = 0; i < hdr->num_samplers; i++) {
+		fprintf(json, "%s{\"name\":", i ? "," : "");
+		json_string(state->samplers[i]->name);
+		fprintf(json, ",\"const_idx\":%u,\"array_size\":%u}",
+				state->samplers[i]->const_idx, state->samplers[i]->array_size);
+	}
+
+	fprintf(json, "],\n\t\t \"varyings\":[");
+	for (i = 0; i < hdr->num_varyings; i++) {
+		fprintf(json, "%s{\"name\":", i ? "," : "");
+		json_string(state->varyings[i]->name);
+		fprintf(json, ",\"reg\":%u}", state->varyings[i]->reg);
+	}
+
+	fprintf(json, "],\n\t\t \"uniform_blocks\":[");
+	for (i = 0; i < hdr->num_uniformblocks; i++) {
+		fprintf(json, "%s{\"name\":", i ? "," : "");
+		json_string(state->uniformblocks[i].header->name);
+		fprintf(json, ",\"members\":%u}",
+				state->uniformblocks[i].header->num_members);
+	}
+
+	fprintf(json, "],\n\t\t \"shaders\":[");
+	for (i = 0; i < state->nshaders; i++) {
+		int sizedwords = state->shaders[i].sizedwords;
+		uint32_t *dwords = aligned_dwords(state->shaders[i].dwords, sizedwords);
+		int n = 0;
+
+		fprintf(json, "%s\n\t\t\t{\"type\":\"%s\",\"sizedwords\":%d",
+				i ? "," : "", state->shaders[i].type, sizedwords);
+
+		if (gpu_id >= 300) {
+			struct disasm_consts consts;
+			int nconstregs = 0;
+
+			/* instructions are 64b, a2xx ALU/fetch are 96b: */
+			fprintf(json, ",\"instrs\":%d", sizedwords / 2);
+			if (!disasm_a3xx_consts(dwords, sizedwords, &consts)) {
+				for (j = 0; j < DISASM_MAX_CONSTS; j++)
+					if (consts.used[j / 8] & (1 << (j % 8)))
+						nconstregs++;
+				fprintf(json, ",\"consts_read\":%d,\"consts_relative\":%s",
+						nconstregs, consts.relative ? "true" : "false");
+			}
+		} else {
+			int cf_slots = disasm_a2xx_cf_slots(dwords, sizedwords);
+			if (cf_slots >= 0)
+				fprintf(json, ",\"instrs\":%d", sizedwords / 3 - cf_slots);
+		}
+
+		fprintf(json, ",\"constants\":[");
+		for (j = 0; j < state->shaders[i].nconsts; j++) {
+			struct constant *constant = state->shaders[i].constants[j];
+			if (constant->unknown2 != 0)
+				continue;
+			fprintf(json, "%s{\"const_idx\":%u,\"val\":[", n++ ? "," : "",
+					constant->const_idx);
+			json_float(constant->val[0]);
+			fputc(',', json);
+			json_float(constant->val[1]);
+			fputc(',', json);
+			json_float(constant->val[2]);
+			fputc(',', json);
+			json_float(constant->val[3]);
+			fprintf(json, "]}");
+		}
+		fprintf(json, "]}");
+	}
+	fprintf(json, "]}");
+}
+
 void dump_program(struct state *state)
 {
 	int i, sect_size;
@@ -1008,6 +1211,9 @@ void dump_program(struct state *state)
 		dump_shaders_a2xx(state);
 	}
 
+	if (json)
+		dump_json(state, test);
+
 	if (!full_dump)
 		return;
 
@@ -1016,11 +1222,12 @@ void dump_program(struct state *state)
 	printf("\n#######################################################\n");
 	printf("######## SHADER SRC: (size=%d)\n", sect_size);
 	dump_ascii(ptr, sect_size);
-	free(ptr);
 
 	/* dump remaining sections (there shouldn't be any): */
 	while (state->sz > 0) {
 		ptr = next_sect(state, &sect_size);
+		if (!ptr)
+			break;
 		printf("######## section (size=%d)\n", sect_size);
 		printf("as hex:\n");
 		dump_hex(ptr, sect_size);
@@ -1028,21 +1235,325 @@ void dump_program(struct state *state)
 		dump_float(ptr, sect_size);
 		printf("as ascii:\n");
 		dump_ascii(ptr, sect_size);
-		free(ptr);
 	}
 	/* cleanup the uniform buffer members we allocated */
 	if (state->hdr->num_uniformblocks > 0)
 		free (state->uniformblocks[i].members);
 }
 
+static int raw_program = 0;
+static int default_gpu_id;
+static int multi;
+
+/* Uncompressed files are mapped (privately, since the sections are
+ * modified in place), anything else is read in through io:
+ */
+static void *load_file(const char *file, int *size, int *mapped)
+{
+	struct stat st;
+	struct io *io;
+	char *buf = NULL;
+	int fd, ret, max = 0;
+
+	*mapped = 0;
+	*size = 0;
+
+	if (!check_extension(file, ".gz")) {
+		fd = open(file, O_RDONLY);
+		if (fd < 0)
+			return NULL;
+
+		if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size) {
+			buf = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (buf == MAP_FAILED)
+				return NULL;
+			*size = st.st_size;
+			*mapped = 1;
+			return buf;
+		}
+
+		close(fd);
+	}
+
+	io = io_open(file);
+	if (!io)
+		return NULL;
+
+	do {
+		if ((max - *size) < 4096) {
+			max = max ? max * 2 : 64 * 1024;
+			buf = realloc(buf, max);
+		}
+		ret = io_readn(io, buf + *size, max - *size);
+		if (ret > 0)
+			*size += ret;
+	} while (ret > 0);
+
+	io_close(io);
+
+	if (ret < 0) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+static void unload_file(void *buf, int size, int mapped)
+{
+	if (mapped)
+		munmap(buf, size);
+	else
+		free(buf);
+}
+
+static void dump_prog(void *buf, int sz)
+{
+	struct state state = {
+			.buf = buf,
+			.sz = sz,
+	};
+	printf("############################################################\n");
+	printf("program:\n");
+	dump_program(&state);
+	printf("############################################################\n");
+}
+
+static int dump_file(const char *file)
+{
+	uint32_t type, sz;
+	char *buf;
+	int size, mapped, off = 0;
+
+	infile = file;
+	gpu_id = default_gpu_id;
+	test[0] = '\0';
+	nprograms = 0;
+
+	buf = load_file(file, &size, &mapped);
+	if (!buf) {
+		fprintf(stderr, "could not open: %s\n", file);
+		return -1;
+	}
+
+	if (multi)
+		printf("==> %s <==\n", file);
+
+	if (raw_program) {
+		if (size >= 4) {
+			memcpy(&sz, buf, 4);
+			if (sz <= size - 4)
+				dump_prog(buf, sz);
+		}
+		unload_file(buf, size, mapped);
+		return 0;
+	}
+
+	/* figure out what sort of input we are dealing with: */
+	if (!(check_extension(file, ".rd") || check_extension(file, ".rd.gz"))) {
+		int (*disasm)(uint32_t *dwords, int sizedwords, int level, enum shader_t type);
+		enum shader_t shader = 0;
+		int ret;
+		if (check_extension(file, ".vo")) {
+			disasm = disasm_a2xx;
+			shader = SHADER_VERTEX;
+		} else if (check_extension(file, ".fo")) {
+			disasm = disasm_a2xx;
+			shader = SHADER_FRAGMENT;
+		} else if (check_extension(file, ".vo3")) {
+			disasm = disasm_a3xx;
+			shader = SHADER_VERTEX;
+		} else if (check_extension(file, ".fo3")) {
+			disasm = disasm_a3xx;
+			shader = SHADER_FRAGMENT;
+		} else if (check_extension(file, ".co3")) {
+			disasm = disasm_a3xx;
+			shader = SHADER_COMPUTE;
+		} else {
+			fprintf(stderr, "invalid input file: %s\n", file);
+			unload_file(buf, size, mapped);
+			return -1;
+		}
+		ret = disasm((uint32_t *)buf, size / 4, 0, shader);
+		unload_file(buf, size, mapped);
+		return ret;
+	}
+
+	if (json) {
+		fprintf(json, "%s\t{\"file\":", nentries++ ? ",\n" : "");
+		json_string(file);
+		fprintf(json, ",\"programs\":[");
+	}
+
+	/* sections are parsed in place, the header is read with memcpy()
+	 * since the sections aren't necessarily 32b aligned:
+	 */
+	while ((size - off) >= 8) {
+		uint32_t hdr[2];
+		char *data;
+
+		memcpy(hdr, buf + off, 8);
+		off += 8;
+
+		/* skip the ~0 markers libwrap writes in front of each section: */
+		if ((hdr[0] == 0xffffffff) && (hdr[1] == 0xffffffff))
+			continue;
+
+		type = hdr[0];
+		sz = hdr[1];
+		if (sz > (size - off)) {
+			fprintf(stderr, "%s: truncated section at offset %d\n", file, off - 8);
+			break;
+		}
+
+		data = buf + off;
+		off += sz;
+
+		switch(type) {
+		case RD_TEST:
+			snprintf(test, sizeof(test), "%.*s", sz, data);
+			if (full_dump)
+				printf("test: %s\n", test);
+			break;
+		case RD_VERT_SHADER:
+			printf("vertex shader:\n%.*s\n", sz, data);
+			break;
+		case RD_FRAG_SHADER:
+			printf("fragment shader:\n%.*s\n", sz, data);
+			break;
+		case RD_TESS_CTRL_SHADER:
+			printf("tess control shader:\n%.*s\n", sz, data);
+			break;
+		case RD_TESS_EVAL_SHADER:
+			printf("tess eval shader:\n%.*s\n", sz, data);
+			break;
+		case RD_GEOM_SHADER:
+			printf("geometry shader:\n%.*s\n", sz, data);
+			break;
+		case RD_PROGRAM:
+			dump_prog(data, sz);
+			break;
+		case RD_GPU_ID:
+			memcpy(&gpu_id, data, 4);
+			printf("gpu_id: %d\n", gpu_id);
+			break;
+		}
+	}
+
+	if (json)
+		fprintf(json, "\n\t]}");
+
+	unload_file(buf, size, mapped);
+
+	return 0;
+}
+
+/* with --json the structured output goes to 'out', otherwise the text
+ * output does:
+ */
+static int dump_file_to(const char *file, FILE *out)
+{
+	if (json) {
+		json = out;
+	} else {
+		fflush(stdout);
+		dup2(fileno(out), STDOUT_FILENO);
+	}
+
+	return dump_file(file);
+}
+
+/* Dump each file in a separate process (the disassemblers are full of
+ * global state, so threads are not an option), at most 'jobs' at a time.
+ * Each writes to its own tmpfile, which are copied to stdout in order as
+ * soon as all the files before them are done.  So that one slow file
+ * doesn't keep an unbounded number of tmpfiles open, no new jobs are
+ * started while more than PENDING_PER_JOB per job are waiting on it.
+ */
+#define PENDING_PER_JOB 4
+
+static int dump_parallel(char **files, int nfiles, int jobs)
+{
+	FILE **outs = calloc(nfiles, sizeof(*outs));
+	pid_t *pids = calloc(nfiles, sizeof(*pids));
+	char *done = calloc(nfiles, 1);
+	int started = 0, emitted = 0, running = 0, ret = 0;
+
+	while (emitted < nfiles) {
+		int i, status;
+		pid_t pid;
+
+		while ((running < jobs) && (started < nfiles) &&
+				(started - emitted < jobs * PENDING_PER_JOB)) {
+			i = started++;
+
+			outs[i] = tmpfile();
+			if (!outs[i]) {
+				fprintf(stderr, "could not create tmpfile: %m\n");
+				exit(-1);
+			}
+
+			fflush(stdout);
+			if (json)
+				fflush(json);
+
+			pid = fork();
+			if (pid < 0) {
+				fprintf(stderr, "fork failed: %m\n");
+				exit(-1);
+			} else if (pid == 0) {
+				exit(dump_file_to(files[i], outs[i]) ? 1 : 0);
+			}
+
+			pids[i] = pid;
+			running++;
+		}
+
+		pid = wait(&status);
+		if (pid < 0)
+			break;
+		running--;
+
+		for (i = 0; i < started; i++)
+			if (pids[i] == pid)
+				done[i] = 1;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			ret = -1;
+
+		while ((emitted < started) && done[emitted]) {
+			FILE *out = json ? json : stdout;
+			char buf[4096];
+			size_t n;
+
+			/* files that failed to load, or that aren't .rd, don't
+			 * produce a json object:
+			 */
+			fseek(outs[emitted], 0, SEEK_END);
+			if (json && ftell(outs[emitted]) && nentries++)
+				fprintf(json, ",\n");
+
+			rewind(outs[emitted]);
+			while ((n = fread(buf, 1, sizeof(buf), outs[emitted])) > 0)
+				fwrite(buf, 1, n, out);
+			fclose(outs[emitted]);
+			emitted++;
+		}
+	}
+
+	free(outs);
+	free(pids);
+	free(done);
+
+	return ret;
+}
+
 int main(int argc, char **argv)
 {
-	enum rd_sect_type type = RD_NONE;
 	enum debug_t debug = 0;
-	void *buf = NULL;
-	int sz, i;
-	struct io *io;
-	int raw_program = 0;
+	int i, jobs = 1, ret = 0;
 
 	/* lame argument parsing: */
 
@@ -1053,6 +1564,12 @@ int main(int argc, char **argv)
 			argc--;
 			continue;
 		}
+		if ((argc > 1) && !strcmp(argv[1], "--stats")) {
+			debug |= PRINT_STATS;
+			argv++;
+			argc--;
+			continue;
+		}
 		if ((argc > 1) && !strcmp(argv[1], "--expand")) {
 			debug |= EXPAND_REPEAT;
 			argv++;
@@ -1079,125 +1596,60 @@ int main(int argc, char **argv)
 			continue;
 		}
 		if ((argc > 1) && !strcmp(argv[1], "--gpu300")) {
-			gpu_id = 320;
+			default_gpu_id = 320;
+			argv++;
+			argc--;
+			continue;
+		}
+		if ((argc > 1) && !strcmp(argv[1], "--json")) {
+			/* structured summary of each program, rather than the text dump: */
+			json = stdout;
+			full_dump = 0;
 			argv++;
 			argc--;
 			continue;
 		}
+		if ((argc > 2) && !strcmp(argv[1], "--jobs")) {
+			jobs = strtol(argv[2], NULL, 0);
+			argv += 2;
+			argc -= 2;
+			continue;
+		}
 		break;
 	}
 
-	if (argc != 2) {
-		fprintf(stderr, "usage: pgmdump [--verbose] [--short] [--dump-shaders] testlog.rd\n");
+	if (argc < 2) {
+		fprintf(stderr, "usage: pgmdump [--verbose] [--stats] [--short] [--dump-shaders] [--json] [--jobs N] testlog.rd...\n");
 		return -1;
 	}
 
 	disasm_set_debug(debug);
 
-	infile = argv[1];
+	multi = (argc > 2) && !json;
 
-	io = io_open(infile);
-	if (!io) {
-		fprintf(stderr, "could not open: %s\n", infile);
-		return -1;
-	}
-
-	if (raw_program)
-	{
-		io_readn(io, &sz, 4);
-		free(buf);
-
-		/* note: allow hex dumps to go a bit past the end of the buffer..
-		 * might see some garbage, but better than missing the last few bytes..
-		 */
-		buf = calloc(1, sz + 3);
-		io_readn(io, buf + 4, sz);
-		(*(int*)buf) = sz;
-
-		struct state state = {
-				.buf = buf,
-				.sz = sz,
-		};
-		printf("############################################################\n");
-		printf("program:\n");
-		dump_program(&state);
-		printf("############################################################\n");
-		return 0;
-	}
-
-	/* figure out what sort of input we are dealing with: */
-	if (!(check_extension(infile, ".rd") || check_extension(infile, ".rd.gz"))) {
-		int (*disasm)(uint32_t *dwords, int sizedwords, int level, enum shader_t type);
-		enum shader_t shader = 0;
-		int ret;
-		if (check_extension(infile, ".vo")) {
-			disasm = disasm_a2xx;
-			shader = SHADER_VERTEX;
-		} else if (check_extension(infile, ".fo")) {
-			disasm = disasm_a2xx;
-			shader = SHADER_FRAGMENT;
-		} else if (check_extension(infile, ".vo3")) {
-			disasm = disasm_a3xx;
-			shader = SHADER_VERTEX;
-		} else if (check_extension(infile, ".fo3")) {
-			disasm = disasm_a3xx;
-			shader = SHADER_FRAGMENT;
-		} else if (check_extension(infile, ".co3")) {
-			disasm = disasm_a3xx;
-			shader = SHADER_COMPUTE;
-		} else {
-			fprintf(stderr, "invalid input file: %s\n", infile);
-			return -1;
-		}
-		buf = calloc(1, 100 * 1024);
-		ret = io_readn(io, buf, 100 * 1024);
-		if (ret < 0) {
-			fprintf(stderr, "error: %m");
+	if (json) {
+		/* text output is not wanted, but still generated: */
+		json = fdopen(dup(STDOUT_FILENO), "w");
+		if (!json || !freopen("/dev/null", "w", stdout)) {
+			fprintf(stderr, "could not redirect stdout: %m\n");
 			return -1;
 		}
-		return disasm(buf, ret/4, 0, shader);
+		fprintf(json, "[\n");
 	}
 
-	while ((io_readn(io, &type, sizeof(type)) > 0) && (io_readn(io, &sz, 4) > 0)) {
-		free(buf);
-
-		/* note: allow hex dumps to go a bit past the end of the buffer..
-		 * might see some garbage, but better than missing the last few bytes..
-		 */
-		buf = calloc(1, sz + 3);
-		io_readn(io, buf, sz);
-
-		switch(type) {
-		case RD_TEST:
-			if (full_dump)
-				printf("test: %s\n", (char *)buf);
-			break;
-		case RD_VERT_SHADER:
-			printf("vertex shader:\n%s\n", (char *)buf);
-			break;
-		case RD_FRAG_SHADER:
-			printf("fragment shader:\n%s\n", (char *)buf);
-			break;
-		case RD_PROGRAM: {
-			struct state state = {
-					.buf = buf,
-					.sz = sz,
-			};
-			printf("############################################################\n");
-			printf("program:\n");
-			dump_program(&state);
-			printf("############################################################\n");
-			break;
-		}
-		case RD_GPU_ID:
-			gpu_id = *((unsigned int *)buf);
-			printf("gpu_id: %d\n", gpu_id);
-			break;
+	if ((jobs > 1) && (argc > 2)) {
+		ret = dump_parallel(&argv[1], argc - 1, jobs);
+	} else {
+		for (i = 1; i < argc; i++) {
+			if (dump_file(argv[i]))
+				ret = -1;
 		}
 	}
 
-	io_close(io);
+	if (json) {
+		fprintf(json, "\n]\n");
+		fclose(json);
+	}
 
-	return 0;
+	return ret;
 }
-
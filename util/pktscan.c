@@ -0,0 +1,309 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pktscan.h"
+#include "util.h"
+#include "pm4.h"
+
+#define MAX_THREADS 16
+
+/* buffers smaller than this (in dwords) are scanned and decoded in the
+ * calling thread, it isn't worth the cost of starting threads:
+ */
+#define PARALLEL_MIN (256 * 1024)
+
+static unsigned nthreads;
+
+unsigned pktscan_nsegs(void)
+{
+	if (!nthreads) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = (n < 1) ? 1 : (n > MAX_THREADS) ? MAX_THREADS : n;
+	}
+	return nthreads;
+}
+
+/* same as pm4_calc_odd_parity_bit(), but without the table lookup (a
+ * variable shift), so it vectorizes without AVX2:
+ */
+static inline uint32_t parity(uint32_t val)
+{
+	val ^= val >> 16;
+	val ^= val >> 8;
+	val ^= val >> 4;
+	val ^= val >> 2;
+	val ^= val >> 1;
+	return ~val & 1;
+}
+
+/* 1 if val is zero, else 0, without a compare (which gcc doesn't
+ * vectorize when mixed with the integer math below):
+ */
+static inline uint32_t is_zero(uint32_t val)
+{
+	return ((val | -val) >> 31) ^ 1;
+}
+
+/* size in dwords (including the header) of the packet pkt would start
+ * if it were a header, or 0.  The same checks as the pkt_is_typeN()
+ * macros, but without branches so the loop over the buffer vectorizes
+ * (at -O3, which this file is built with).  The types are mutually
+ * exclusive, so the order doesn't matter:
+ */
+static inline uint32_t pkt_len(uint32_t pkt)
+{
+	uint32_t t0, t2, t3, t4, t7;
+
+	t0 = is_zero((pkt & 0xc0000000) ^ CP_TYPE0_PKT);
+	t2 = is_zero(pkt ^ CP_TYPE2_PKT);
+	t3 = is_zero((pkt & 0xc0000000) ^ CP_TYPE3_PKT) & is_zero(pkt & 0x80fe);
+	t4 = is_zero((pkt & 0xf0000000) ^ CP_TYPE4_PKT) &
+			~((pkt >> 27) ^ parity(type4_pkt_offset(pkt))) &
+			~((pkt >> 7) ^ parity(type4_pkt_size(pkt)));
+	t7 = is_zero((pkt & 0xf0000000) ^ CP_TYPE7_PKT) &
+			is_zero(pkt & 0x0f000000) &
+			~((pkt >> 23) ^ parity(cp_type7_opcode(pkt))) &
+			~((pkt >> 15) ^ parity(type7_pkt_size(pkt)));
+
+	return (-t0 & (type0_pkt_size(pkt) + 1)) |
+			(-t3 & (type3_pkt_size(pkt) + 1)) |
+			(-t4 & (type4_pkt_size(pkt) + 1)) |
+			(-t7 & (type7_pkt_size(pkt) + 1)) |
+			t2;
+}
+
+static void classify(uint16_t *len, const uint32_t *dwords, uint32_t n)
+{
+	uint32_t i;
+	for (i = 0; i < n; i++)
+		len[i] = pkt_len(dwords[i]);
+}
+
+struct classify_job {
+	uint16_t *len;
+	const uint32_t *dwords;
+	uint32_t n;
+};
+
+static void *classify_thread(void *arg)
+{
+	struct classify_job *job = arg;
+	classify(job->len, job->dwords, job->n);
+	return NULL;
+}
+
+static void classify_parallel(uint16_t *len, const uint32_t *dwords,
+		uint32_t sizedwords)
+{
+	pthread_t threads[MAX_THREADS];
+	struct classify_job jobs[MAX_THREADS];
+	unsigned i, n = pktscan_nsegs();
+	uint32_t start = 0;
+
+	for (i = 0; i < n; i++) {
+		uint32_t end = (uint64_t)sizedwords * (i + 1) / n;
+		jobs[i].len = len + start;
+		jobs[i].dwords = dwords + start;
+		jobs[i].n = end - start;
+		start = end;
+	}
+
+	/* the last chunk is done by the calling thread, and any chunk a
+	 * thread couldn't be started for too:
+	 */
+	for (i = 0; i < n - 1; i++)
+		if (pthread_create(&threads[i], NULL, classify_thread, &jobs[i]))
+			break;
+	n = i;
+	for (; i < pktscan_nsegs(); i++)
+		classify_thread(&jobs[i]);
+	for (i = 0; i < n; i++)
+		pthread_join(threads[i], NULL);
+}
+
+int pktscan_build(struct pktscan *scan, const uint32_t *dwords,
+		uint32_t sizedwords)
+{
+	uint32_t off = 0;
+
+	scan->npkts = 0;
+	scan->sizedwords = sizedwords;
+	scan->valid = 1;
+	scan->bad = 0;
+
+	if (sizedwords > scan->maxlen) {
+		scan->maxlen = sizedwords;
+		scan->len = xrealloc(scan->len, sizedwords * sizeof(scan->len[0]));
+	}
+
+	if (sizedwords >= PARALLEL_MIN)
+		classify_parallel(scan->len, dwords, sizedwords);
+	else
+		classify(scan->len, dwords, sizedwords);
+
+	while (off < sizedwords) {
+		uint32_t pkt = dwords[off];
+		uint32_t count = scan->len[off];
+		struct pktscan_pkt *p;
+
+		if (!count || (count > (sizedwords - off))) {
+			scan->valid = 0;
+			scan->bad = off;
+			break;
+		}
+
+		if (scan->npkts >= scan->maxpkts) {
+			scan->maxpkts = scan->maxpkts ? scan->maxpkts * 2 : 256;
+			scan->pkts = xrealloc(scan->pkts,
+					scan->maxpkts * sizeof(scan->pkts[0]));
+		}
+
+		p = &scan->pkts[scan->npkts++];
+		p->offset = off;
+		p->count = count;
+		p->pad = 0;
+
+		if (pkt_is_type0(pkt)) {
+			p->type = 0;
+			p->val = type0_pkt_offset(pkt);
+		} else if (pkt_is_type4(pkt)) {
+			p->type = 4;
+			p->val = type4_pkt_offset(pkt);
+		} else if (pkt_is_type3(pkt)) {
+			p->type = 3;
+			p->val = cp_type3_opcode(pkt);
+		} else if (pkt_is_type7(pkt)) {
+			p->type = 7;
+			p->val = cp_type7_opcode(pkt);
+		} else {
+			p->type = 2;
+			p->val = 0;
+		}
+
+		off += count;
+	}
+
+	return scan->valid ? 0 : -1;
+}
+
+void pktscan_fini(struct pktscan *scan)
+{
+	free(scan->pkts);
+	free(scan->len);
+	memset(scan, 0, sizeof(*scan));
+}
+
+struct segment_job {
+	pktscan_fxn fxn;
+	void *data;
+	unsigned seg;
+	const uint32_t *dwords;
+	const struct pktscan_pkt *pkts;
+	uint32_t npkts;
+};
+
+static void *segment_thread(void *arg)
+{
+	struct segment_job *job = arg;
+	job->fxn(job->data, job->seg, job->dwords, job->pkts, job->npkts);
+	return NULL;
+}
+
+/* index of the first packet at or after the given dword offset: */
+static uint32_t find_pkt(const struct pktscan *scan, uint32_t off)
+{
+	uint32_t lo = 0, hi = scan->npkts;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (scan->pkts[mid].offset < off)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+unsigned pktscan_parallel(const struct pktscan *scan, const uint32_t *dwords,
+		pktscan_fxn fxn, void *data)
+{
+	pthread_t threads[MAX_THREADS];
+	struct segment_job jobs[MAX_THREADS];
+	uint32_t covered, start = 0;
+	unsigned i, n, nsegs;
+
+	if (!scan->npkts)
+		return 0;
+
+	/* for an invalid index, only the packets before the bad one: */
+	covered = scan->valid ? scan->sizedwords : scan->bad;
+
+	if ((covered < PARALLEL_MIN) || (scan->npkts < 2)) {
+		fxn(data, 0, dwords, scan->pkts, scan->npkts);
+		return 1;
+	}
+
+	nsegs = pktscan_nsegs();
+	if (nsegs > scan->npkts)
+		nsegs = scan->npkts;
+
+	/* cut at the first packet starting at or after each multiple of
+	 * covered / nsegs dwords, a segment can be empty if a single packet
+	 * is bigger than that:
+	 */
+	for (i = 0; i < nsegs; i++) {
+		uint32_t end = (i == nsegs - 1) ? scan->npkts :
+				find_pkt(scan, (uint64_t)covered * (i + 1) / nsegs);
+		jobs[i].fxn = fxn;
+		jobs[i].data = data;
+		jobs[i].seg = i;
+		jobs[i].dwords = dwords;
+		jobs[i].pkts = scan->pkts + start;
+		jobs[i].npkts = end - start;
+		start = end;
+	}
+
+	for (i = 0; i < nsegs - 1; i++)
+		if (pthread_create(&threads[i], NULL, segment_thread, &jobs[i]))
+			break;
+	n = i;
+	for (; i < nsegs; i++)
+		segment_thread(&jobs[i]);
+	for (i = 0; i < n; i++)
+		pthread_join(threads[i], NULL);
+
+	return nsegs;
+}
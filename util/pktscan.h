@@ -0,0 +1,113 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef PKTSCAN_H_
+#define PKTSCAN_H_
+
+#include <stdint.h>
+
+/* Packet index of a cmdstream buffer.
+ *
+ * Where each packet starts is only known by following the chain of
+ * packet headers from the start of the buffer, so decoding is serial.
+ * The pre-scan splits that into two passes:
+ *
+ *   1) every dword is classified as if it were a packet header (per
+ *      pkt_is_type0/4/3/7/2, in the same order as dump_commands()),
+ *      giving the size of the packet it would start, or 0 if it is not
+ *      a valid header.  This is a branch-free loop over the buffer which
+ *      the compiler can vectorize, and which is split across threads for
+ *      large buffers.
+ *
+ *   2) the chain of headers is followed using the sizes from (1), which
+ *      only touches one entry per packet, recording the offset, type,
+ *      opcode (or register) and size of each packet.
+ *
+ * The index is valid if the chain ends exactly at the end of the buffer,
+ * otherwise bad is the offset of the first invalid header (or of the
+ * packet which runs past the end of the buffer).
+ *
+ * With a valid index, pktscan_parallel() cuts the buffer at packet
+ * boundaries into segments of about equal size, which are decoded in
+ * parallel.  This is only useful for decoders which don't depend on the
+ * state left behind by earlier packets (register values, etc).
+ */
+
+struct pktscan_pkt {
+	uint32_t offset;           /* offset of the header, in dwords */
+	uint16_t count;            /* size in dwords, including the header */
+	uint8_t type;              /* 0, 2, 3, 4 or 7 */
+	uint8_t pad;
+	uint32_t val;              /* opcode (type3/7) or register (type0/4) */
+};
+
+struct pktscan {
+	struct pktscan_pkt *pkts;
+	uint32_t npkts;
+	uint32_t sizedwords;
+	int valid;
+	uint32_t bad;              /* if !valid, see above */
+
+	/* internal: */
+	uint32_t maxpkts;
+	uint16_t *len;
+	uint32_t maxlen;
+};
+
+/* build (or rebuild, re-using the allocations of a previous scan) the
+ * index of a buffer, returns 0 if it is valid.  A zero-initialized
+ * struct pktscan is a valid empty scan:
+ */
+int pktscan_build(struct pktscan *scan, const uint32_t *dwords,
+		uint32_t sizedwords);
+
+/* free the index: */
+void pktscan_fini(struct pktscan *scan);
+
+/* the number of segments pktscan_parallel() splits a buffer into, at
+ * most, ie. the size of per-segment state a decoder needs:
+ */
+unsigned pktscan_nsegs(void);
+
+/* called for each segment, with the packets of the segment (dwords is
+ * the whole buffer, the packet offsets are relative to it).  seg counts
+ * up from zero in buffer order so per-segment results can be merged in
+ * order, a segment can be empty:
+ */
+typedef void (*pktscan_fxn)(void *data, unsigned seg,
+		const uint32_t *dwords, const struct pktscan_pkt *pkts,
+		uint32_t npkts);
+
+/* decode the packets of the index in parallel (for an invalid index,
+ * the ones before the bad header), returns the number of segments used.
+ * Small buffers are a single segment, decoded in the calling thread:
+ */
+unsigned pktscan_parallel(const struct pktscan *scan, const uint32_t *dwords,
+		pktscan_fxn fxn, void *data);
+
+#endif /* PKTSCAN_H_ */
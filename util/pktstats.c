@@ -0,0 +1,316 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "pktstats.h"
+#include "util.h"
+#include "pktscan.h"
+#include "pm4.h"
+
+void *cffdump_hostptr(uint64_t gpuaddr);
+uint32_t cffdump_hostlen(uint64_t gpuaddr);
+const char *cffdump_opcode_name(uint32_t opcode);
+
+/* max depth of IBs followed, submit is level 0: */
+#define MAX_LEVEL 4
+
+struct counts {
+	uint64_t pkts[256], dwords[256];    /* per type3/type7 opcode */
+	uint64_t regpkts, regdwords;        /* type0/type4 */
+	uint64_t nops;                      /* type2 */
+	uint64_t ibs;
+};
+
+struct ib {
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+};
+
+/* per-segment results of pktscan_parallel(): */
+struct segment {
+	struct counts counts;
+	struct ib *ibs;
+	unsigned nibs, maxibs;
+};
+
+/* counts of the IBs already seen in the current submit, including the
+ * IBs they call:
+ */
+static struct {
+	struct ib ib;
+	struct counts counts;
+} *cache;
+static unsigned ncache, maxcache;
+
+static int enabled;
+static int is_64b;
+static char *cmdstream;
+static struct counts total;
+static unsigned nsubmits, nbad, nmissing, maxsegs;
+static uint64_t submit_dwords;
+
+void pktstats_enable(void)
+{
+	enabled = 1;
+}
+
+void pktstats_set_gpu(unsigned gpu_id)
+{
+	is_64b = gpu_id >= 500;
+}
+
+void pktstats_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	free(cmdstream);
+	cmdstream = strdup(name);
+	memset(&total, 0, sizeof(total));
+	nsubmits = nbad = nmissing = maxsegs = 0;
+	submit_dwords = 0;
+}
+
+static void add_counts(struct counts *dst, const struct counts *src)
+{
+	unsigned i;
+
+	for (i = 0; i < 256; i++) {
+		dst->pkts[i] += src->pkts[i];
+		dst->dwords[i] += src->dwords[i];
+	}
+	dst->regpkts += src->regpkts;
+	dst->regdwords += src->regdwords;
+	dst->nops += src->nops;
+	dst->ibs += src->ibs;
+}
+
+/* runs on the pktscan threads, only touches its own segment: */
+static void count_segment(void *data, unsigned seg, const uint32_t *dwords,
+		const struct pktscan_pkt *pkts, uint32_t npkts)
+{
+	struct segment *s = &((struct segment *)data)[seg];
+	uint32_t i;
+
+	for (i = 0; i < npkts; i++) {
+		const struct pktscan_pkt *p = &pkts[i];
+		const uint32_t *payload = dwords + p->offset + 1;
+		struct ib *ib;
+
+		switch (p->type) {
+		case 0:
+		case 4:
+			s->counts.regpkts++;
+			s->counts.regdwords += p->count;
+			continue;
+		case 2:
+			s->counts.nops++;
+			continue;
+		}
+
+		s->counts.pkts[p->val]++;
+		s->counts.dwords[p->val] += p->count;
+
+		if ((p->val != CP_INDIRECT_BUFFER_PFE) &&
+				(p->val != CP_INDIRECT_BUFFER_PFD))
+			continue;
+		if (p->count < (is_64b ? 4 : 3))
+			continue;
+
+		if (s->nibs >= s->maxibs) {
+			s->maxibs = s->maxibs ? s->maxibs * 2 : 16;
+			s->ibs = xrealloc(s->ibs, s->maxibs * sizeof(s->ibs[0]));
+		}
+
+		ib = &s->ibs[s->nibs++];
+		if (is_64b) {
+			ib->gpuaddr = payload[0] | ((uint64_t)payload[1] << 32);
+			ib->sizedwords = payload[2];
+		} else {
+			ib->gpuaddr = payload[0];
+			ib->sizedwords = payload[1];
+		}
+	}
+}
+
+static void count_buffer(struct counts *counts, uint64_t gpuaddr,
+		uint32_t sizedwords, int level)
+{
+	struct pktscan scan = {0};
+	struct counts c;
+	struct segment *segs;
+	const uint32_t *dwords;
+	unsigned i, j, n;
+
+	memset(&c, 0, sizeof(c));
+
+	for (i = 0; i < ncache; i++) {
+		if ((cache[i].ib.gpuaddr == gpuaddr) &&
+				(cache[i].ib.sizedwords == sizedwords)) {
+			add_counts(counts, &cache[i].counts);
+			return;
+		}
+	}
+
+	dwords = cffdump_hostptr(gpuaddr);
+	if (!dwords || ((cffdump_hostlen(gpuaddr) / 4) < sizedwords)) {
+		nmissing++;
+		return;
+	}
+
+	if (pktscan_build(&scan, dwords, sizedwords)) {
+		printf("%s: bad packet header %08x at dword %u of %u in %s %016"PRIx64"\n",
+				cmdstream, dwords[scan.bad], scan.bad, sizedwords,
+				level ? "ib" : "submit", gpuaddr);
+		nbad++;
+	}
+
+	segs = calloc(pktscan_nsegs(), sizeof(segs[0]));
+	if (!segs) {
+		fprintf(stderr, "pktstats: out of memory\n");
+		exit(1);
+	}
+
+	n = pktscan_parallel(&scan, dwords, count_segment, segs);
+	if (n > maxsegs)
+		maxsegs = n;
+
+	for (i = 0; i < n; i++) {
+		add_counts(&c, &segs[i].counts);
+		for (j = 0; j < segs[i].nibs; j++) {
+			c.ibs++;
+			if (level < MAX_LEVEL)
+				count_buffer(&c, segs[i].ibs[j].gpuaddr,
+						segs[i].ibs[j].sizedwords, level + 1);
+		}
+		free(segs[i].ibs);
+	}
+
+	free(segs);
+	pktscan_fini(&scan);
+
+	if (ncache >= maxcache) {
+		maxcache = maxcache ? maxcache * 2 : 64;
+		cache = xrealloc(cache, maxcache * sizeof(cache[0]));
+	}
+	cache[ncache].ib.gpuaddr = gpuaddr;
+	cache[ncache].ib.sizedwords = sizedwords;
+	cache[ncache].counts = c;
+	ncache++;
+
+	add_counts(counts, &c);
+}
+
+void pktstats_submit(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	if (!enabled)
+		return;
+
+	/* buffers are re-loaded for each submit: */
+	ncache = 0;
+
+	nsubmits++;
+	submit_dwords += sizedwords;
+	count_buffer(&total, gpuaddr, sizedwords, 0);
+}
+
+static const struct counts *sort_counts;
+
+static int cmp_opcode(const void *a, const void *b)
+{
+	unsigned oa = *(const unsigned *)a, ob = *(const unsigned *)b;
+	if (sort_counts->dwords[oa] != sort_counts->dwords[ob])
+		return (sort_counts->dwords[oa] < sort_counts->dwords[ob]) ? 1 : -1;
+	return (int)oa - (int)ob;
+}
+
+static void print_row(const char *name, uint64_t pkts, uint64_t dwords,
+		uint64_t all)
+{
+	printf("%-28s %10"PRIu64" %12"PRIu64" %8.1f %6.1f%%\n", name, pkts,
+			dwords, pkts ? (double)dwords / pkts : 0.0,
+			all ? 100.0 * dwords / all : 0.0);
+}
+
+void pktstats_end_cmdstream(void)
+{
+	unsigned opcodes[256], nopcodes = 0, i;
+	uint64_t pkts = total.regpkts + total.nops;
+	uint64_t dwords = total.regdwords + total.nops;
+
+	if (!enabled || !cmdstream)
+		return;
+
+	for (i = 0; i < 256; i++) {
+		if (!total.pkts[i])
+			continue;
+		opcodes[nopcodes++] = i;
+		pkts += total.pkts[i];
+		dwords += total.dwords[i];
+	}
+
+	sort_counts = &total;
+	qsort(opcodes, nopcodes, sizeof(opcodes[0]), cmp_opcode);
+
+	printf("packet stats for %s:\n", cmdstream);
+	printf("%u submits, %"PRIu64" submit dwords, %"PRIu64" IBs called, "
+			"%"PRIu64" packets, %"PRIu64" dwords executed\n",
+			nsubmits, submit_dwords, total.ibs, pkts, dwords);
+	printf("%-28s %10s %12s %8s %7s\n", "packet", "count", "dwords",
+			"avg", "dwords");
+
+	for (i = 0; i < nopcodes; i++) {
+		const char *name = cffdump_opcode_name(opcodes[i]);
+		char buf[32];
+		if (!name) {
+			snprintf(buf, sizeof(buf), "opcode %02x", opcodes[i]);
+			name = buf;
+		}
+		print_row(name, total.pkts[opcodes[i]], total.dwords[opcodes[i]],
+				dwords);
+	}
+	if (total.regpkts)
+		print_row("register writes", total.regpkts, total.regdwords, dwords);
+	if (total.nops)
+		print_row("type2 nop", total.nops, total.nops, dwords);
+
+	if (nbad || nmissing)
+		printf("%u buffers with bad packet headers (counted up to the bad "
+				"header), %u IBs not found in the capture\n", nbad, nmissing);
+	if (maxsegs > 1)
+		printf("largest buffer counted in %u parallel segments\n", maxsegs);
+	printf("\n");
+
+	free(cmdstream);
+	cmdstream = NULL;
+}
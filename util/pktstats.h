@@ -0,0 +1,58 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef PKTSTATS_H_
+#define PKTSTATS_H_
+
+#include <stdint.h>
+
+/* Packet statistics: the number of packets and dwords per opcode, for
+ * register writes and type2 nops, per cmdstream file.  IBs are counted
+ * each time they are called, so the totals are what the CP executes.
+ *
+ * Nothing depends on the state left by earlier packets, so each submit
+ * and IB is indexed with pktscan (see pktscan.h) and its segments are
+ * counted in parallel, rather than walked by dump_commands().  Buffers
+ * with an invalid packet header are reported, with the offset of the
+ * header.
+ */
+
+/* called at start to enable the report: */
+void pktstats_enable(void);
+
+/* called once the gpu_id is known: */
+void pktstats_set_gpu(unsigned gpu_id);
+
+/* called at start/end of each cmdstream file: */
+void pktstats_start_cmdstream(const char *name);
+void pktstats_end_cmdstream(void);
+
+/* called for each submit: */
+void pktstats_submit(uint64_t gpuaddr, uint32_t sizedwords);
+
+#endif /* PKTSTATS_H_ */
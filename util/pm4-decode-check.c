@@ -0,0 +1,147 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+/* Cross-check the generated packet decoders against rnndec.
+ *
+ * Decodes the same payloads with either the generated decoder or the
+ * generic rnndec path used by cffdump's dump_domain(), for every packet
+ * which has a payload domain in each generation, so the output of the
+ * two runs can be compared:
+ *
+ *   pm4-decode-check gen > gen.txt
+ *   pm4-decode-check rnn > rnn.txt
+ *   cmp gen.txt rnn.txt
+ *
+ * See the check-pm4-decode make target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rnnutil.h"
+#include "pm4-decode.h"
+
+#define MAXDWORDS 256
+
+static const char *gpunames[] = { [2] = "a2xx", "a3xx", "a4xx", "a5xx" };
+
+static void fill(uint32_t *dwords, int pattern)
+{
+	uint32_t x = 0x12345678 + pattern;
+	int i;
+
+	for (i = 0; i < MAXDWORDS; i++) {
+		switch (pattern) {
+		case 0:  dwords[i] = 0;                break;
+		case 1:  dwords[i] = ~0;               break;
+		case 2:  dwords[i] = 0x55555555 << (i & 1); break;
+		case 3:  dwords[i] = 1u << (i % 32);   break;
+		default:
+			/* xorshift, to exercise enum values and signed fields: */
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			dwords[i] = x;
+			break;
+		}
+	}
+}
+
+static void decode_rnn(struct rnn *rnn, struct rnndomain *dom,
+		const uint32_t *dwords)
+{
+	int i;
+
+	/* like dump_domain() in cffdump.c: */
+	for (i = 0; i < MAXDWORDS; i++) {
+		struct rnndecaddrinfo *info = rnndec_decodeaddr(rnn->vc, dom, i, 0);
+		char *decoded;
+		if (!(info && info->typeinfo))
+			break;
+		decoded = rnndec_decodeval(rnn->vc, info->typeinfo, dwords[i], info->width);
+		printf("\t%s\n", decoded);
+		free(decoded);
+		free(info->name);
+		free(info);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct pm4_colors colors = { "", "", "", "", "", "" };
+	uint32_t dwords[MAXDWORDS];
+	int use_rnn, ndomains = 0;
+	unsigned gen;
+
+	if ((argc != 2) || (strcmp(argv[1], "gen") && strcmp(argv[1], "rnn"))) {
+		fprintf(stderr, "usage: %s gen|rnn\n", argv[0]);
+		return 1;
+	}
+	use_rnn = !strcmp(argv[1], "rnn");
+
+	for (gen = 2; gen <= 5; gen++) {
+		struct rnn *rnn = rnn_new(1);
+		uint32_t opcode;
+
+		rnn_load(rnn, gpunames[gen]);
+
+		for (opcode = 0; opcode < 256; opcode++) {
+			const char *name = pm4_packet_name(gen, opcode);
+			struct rnndomain *dom;
+			int pattern;
+
+			if (!name)
+				continue;
+
+			/* packets without a payload domain are not decoded by
+			 * either path:
+			 */
+			dom = rnn_finddomain(rnn->db, name);
+			if (!dom)
+				continue;
+
+			ndomains++;
+
+			for (pattern = 0; pattern < 8; pattern++) {
+				fill(dwords, pattern);
+				printf("%s %s, pattern %d:\n", gpunames[gen], name, pattern);
+				if (use_rnn)
+					decode_rnn(rnn, dom, dwords);
+				else
+					pm4_decode_packet(gen, opcode, dwords, MAXDWORDS,
+							"\t", &colors);
+			}
+		}
+	}
+
+	fprintf(stderr, "%s: decoded %d packet domains\n", argv[1], ndomains);
+
+	return 0;
+}
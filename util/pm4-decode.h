@@ -0,0 +1,61 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#ifndef PM4_DECODE_H_
+#define PM4_DECODE_H_
+
+#include <stdint.h>
+
+/* Specialized decoders for type3/type7 packet payloads, generated at
+ * build time from the packet domains in adreno_pm4.xml by
+ * gen-pm4-decode.py.  The output matches what rnndec would print for
+ * the same domain, one line per dword, but the opcode name lookup is a
+ * static per-generation table and nothing is allocated.
+ *
+ * gen is the gpu generation, ie. gpu_id / 100.
+ */
+
+/* the escape sequences to use, normally from the rnndec context: */
+struct pm4_colors {
+	const char *reset, *err, *rname, *mod, *num, *eval;
+};
+
+/* returns the packet name, or NULL if the opcode is not known for
+ * this generation:
+ */
+const char *pm4_packet_name(unsigned gen, uint32_t opcode);
+
+/* decode the payload (not including the packet header), prefixing
+ * each line with prefix.  Returns -1 if the opcode is not known, in
+ * which case the caller should fall back to the generic rnn path:
+ */
+int pm4_decode_packet(unsigned gen, uint32_t opcode, const uint32_t *dwords,
+		uint32_t sizedwords, const char *prefix, const struct pm4_colors *c);
+
+#endif /* PM4_DECODE_H_ */
@@ -39,6 +39,9 @@ enum rd_sect_type {
 	RD_FRAG_SHADER,
 	RD_BUFFER_CONTENTS,
 	RD_GPU_ID,
+	RD_TESS_CTRL_SHADER,
+	RD_TESS_EVAL_SHADER,
+	RD_GEOM_SHADER,
 };
 
 /* RD_PARAM types: */
@@ -0,0 +1,648 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "rewrite.h"
+#include "util.h"
+#include "pm4.h"
+
+static FILE *out;
+static int strip_wfi;
+static unsigned gpu_id;
+
+/* sections read since the last submit, written out (possibly with
+ * additional buffers) when we get the RD_CMDSTREAM_ADDR.  The contents
+ * of RD_BUFFER_CONTENTS sections are owned by bufs[]:
+ */
+static struct {
+	enum rd_sect_type type;
+	void *buf;
+	int sz;
+} *sects;
+static int nsects, maxsects;
+
+/* cffdump asserts on more buffers than this in a submit: */
+#define MAX_BUFFERS 511
+
+static struct {
+	uint64_t gpuaddr;
+	uint32_t len;
+	void *hostptr;
+} *bufs;
+static int nbufs, maxbufs;
+static int needs_reset;
+static int fresh_bufs;        /* buffers were (re)sent for this submit */
+
+/* rewritten IBs go into this buffer, which is placed after the
+ * captured buffers in the gpu address space:
+ */
+struct obuf {
+	uint32_t *dwords;
+	uint32_t len, max;
+};
+static struct obuf arena;
+static uint64_t arena_base;
+
+/* IBs already rewritten for the current submit: */
+static struct {
+	uint64_t gpuaddr, newaddr;
+	uint32_t sizedwords, newsize;
+} *ibs;
+static int nibs, maxibs;
+
+/* register values known to be written earlier in the current IB.  A
+ * register is known if known_gen[reg] == gen, so we can forget all
+ * state by bumping gen:
+ */
+static uint32_t known_val[0x10000];
+static uint32_t known_gen[0x10000];
+static uint32_t gen = 1;
+
+/* registers written by draw-state groups, these are applied by the CP
+ * at draw time so they can never be considered redundant:
+ */
+static uint8_t drawstate_regs[0x10000 / 8];
+
+/* pending register writes, merged into as few packets as possible
+ * when flushed:
+ */
+static struct {
+	uint32_t reg, val;
+} pending[0x4000];
+static unsigned npending;
+
+static struct {
+	unsigned submits, ibs;
+	uint64_t dwords_in, dwords_out;
+	unsigned writes, writes_dropped;
+	unsigned reg_pkts_in, reg_pkts_out;
+	unsigned nops, wfis, wfis_dropped;
+	unsigned unmodified;
+} stats;
+
+static int is_64b(void)
+{
+	return gpu_id >= 500;
+}
+
+/* registers which can be rewritten without side effects: */
+static int is_context_reg(uint32_t reg)
+{
+	if (drawstate_regs[reg / 8] & (1 << (reg % 8)))
+		return 0;
+	if (gpu_id >= 500)
+		return (0xe000 <= reg) && (reg < 0xf000);
+	return (0x2000 <= reg) && (reg < 0x2400);
+}
+
+static void emit(struct obuf *o, uint32_t dword)
+{
+	if (o->len == o->max) {
+		o->max = o->max ? o->max * 2 : 1024;
+		o->dwords = xrealloc(o->dwords, o->max * sizeof(o->dwords[0]));
+	}
+	o->dwords[o->len++] = dword;
+}
+
+static void emitn(struct obuf *o, const uint32_t *dwords, uint32_t n)
+{
+	while (n--)
+		emit(o, *(dwords++));
+}
+
+static void *hostptr(uint64_t gpuaddr, uint32_t sizedwords)
+{
+	int i;
+	for (i = 0; i < nbufs; i++) {
+		if ((bufs[i].gpuaddr <= gpuaddr) &&
+				((gpuaddr + sizedwords * 4) <= (bufs[i].gpuaddr + bufs[i].len)))
+			return bufs[i].hostptr + (gpuaddr - bufs[i].gpuaddr);
+	}
+	return NULL;
+}
+
+static uint32_t type4_hdr(uint32_t reg, uint32_t cnt)
+{
+	return CP_TYPE4_PKT | cnt | (pm4_calc_odd_parity_bit(cnt) << 7) |
+			(reg << 8) | (pm4_calc_odd_parity_bit(reg) << 27);
+}
+
+static void flush_writes(struct obuf *o)
+{
+	unsigned max = is_64b() ? 0x7f : 0x4000;
+	unsigned i = 0;
+
+	while (i < npending) {
+		unsigned n = 1;
+
+		while ((i + n < npending) && (n < max) &&
+				(pending[i + n].reg == pending[i].reg + n))
+			n++;
+
+		if (is_64b())
+			emit(o, type4_hdr(pending[i].reg, n));
+		else
+			emit(o, ((n - 1) << 16) | pending[i].reg);
+
+		stats.reg_pkts_out++;
+
+		while (n--)
+			emit(o, pending[i++].val);
+	}
+
+	npending = 0;
+}
+
+static void write_reg(struct obuf *o, uint32_t reg, uint32_t val, int drawstate)
+{
+	stats.writes++;
+
+	if (drawstate)
+		drawstate_regs[reg / 8] |= (1 << (reg % 8));
+
+	if (!drawstate && is_context_reg(reg) &&
+			(known_gen[reg] == gen) && (known_val[reg] == val)) {
+		stats.writes_dropped++;
+		return;
+	}
+
+	known_gen[reg] = gen;
+	known_val[reg] = val;
+
+	if (npending == ARRAY_SIZE(pending))
+		flush_writes(o);
+
+	pending[npending].reg = reg;
+	pending[npending].val = val;
+	npending++;
+}
+
+static int is_draw(uint32_t opcode)
+{
+	switch (opcode) {
+	case CP_DRAW_INDX:
+	case CP_DRAW_INDX_2:
+	case CP_DRAW_INDX_OFFSET:
+	case CP_EXEC_CS:
+	case CP_RUN_OPENCL:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* packets which don't touch registers, so they don't invalidate what
+ * we know about register state:
+ */
+static int is_reg_safe(uint32_t opcode)
+{
+	switch (opcode) {
+	case CP_WAIT_FOR_IDLE:
+	case CP_EVENT_WRITE:
+	case CP_LOAD_STATE:
+	case CP_MEM_WRITE:
+	case CP_REG_TO_MEM:
+		return 1;
+	default:
+		return is_draw(opcode);
+	}
+}
+
+/* Is a WFI needed?  Only if something other than context register
+ * writes happens before the next draw (or another WFI).  To be safe,
+ * the end of the IB counts as needing it.
+ */
+static int wfi_needed(uint32_t *dwords, int dwords_left)
+{
+	while (dwords_left > 0) {
+		uint32_t count, reg, i;
+
+		if (pkt_is_type0(dwords[0])) {
+			count = type0_pkt_size(dwords[0]) + 1;
+			reg = type0_pkt_offset(dwords[0]);
+			for (i = 1; i < count; i++)
+				if (!is_context_reg((dwords[0] & 0x8000) ? reg : reg + i - 1))
+					return 1;
+		} else if (pkt_is_type4(dwords[0])) {
+			count = type4_pkt_size(dwords[0]) + 1;
+			reg = type4_pkt_offset(dwords[0]);
+			for (i = 1; i < count; i++)
+				if (!is_context_reg(reg + i - 1))
+					return 1;
+		} else if (pkt_is_type3(dwords[0]) || pkt_is_type7(dwords[0])) {
+			uint32_t opcode;
+			if (pkt_is_type3(dwords[0])) {
+				count = type3_pkt_size(dwords[0]) + 1;
+				opcode = cp_type3_opcode(dwords[0]);
+			} else {
+				count = type7_pkt_size(dwords[0]) + 1;
+				opcode = cp_type7_opcode(dwords[0]);
+			}
+			if (is_draw(opcode) || (opcode == CP_WAIT_FOR_IDLE))
+				return 0;
+			if ((opcode != CP_NOP) && (opcode != CP_LOAD_STATE))
+				return 1;
+		} else if (pkt_is_type2(dwords[0])) {
+			count = 1;
+		} else {
+			return 1;
+		}
+
+		dwords += count;
+		dwords_left -= count;
+	}
+
+	return 1;
+}
+
+static int rewrite_ib(uint64_t gpuaddr, uint32_t sizedwords, int drawstate,
+		uint64_t *newaddr, uint32_t *newsize);
+
+/* patch a CP_INDIRECT_BUFFER style (addr, [addr_hi,] size) triplet: */
+static void rewrite_ib_ref(uint32_t *addr, uint32_t *size, uint32_t sizemask,
+		int drawstate)
+{
+	uint64_t gpuaddr = addr[0];
+	uint64_t newaddr;
+	uint32_t newsize;
+
+	if (is_64b())
+		gpuaddr |= ((uint64_t)addr[1]) << 32;
+
+	if (rewrite_ib(gpuaddr, *size & sizemask, drawstate, &newaddr, &newsize))
+		return;
+
+	addr[0] = newaddr;
+	if (is_64b())
+		addr[1] = newaddr >> 32;
+	*size = (*size & ~sizemask) | newsize;
+}
+
+static void rewrite_cmds(uint32_t *dwords, uint32_t sizedwords, int drawstate,
+		struct obuf *o)
+{
+	int dwords_left = sizedwords;
+
+	/* fresh scope, we can't know what the caller's state is: */
+	gen++;
+
+	while (dwords_left > 0) {
+		uint32_t count, opcode, reg, i;
+
+		if (pkt_is_type0(dwords[0])) {
+			count = type0_pkt_size(dwords[0]) + 1;
+			reg = type0_pkt_offset(dwords[0]);
+			stats.reg_pkts_in++;
+			if (dwords[0] & 0x8000) {
+				/* multiple writes to same register, keep as-is: */
+				flush_writes(o);
+				emitn(o, dwords, count);
+				stats.reg_pkts_out++;
+				known_gen[reg] = 0;
+			} else {
+				for (i = 1; i < count; i++)
+					write_reg(o, reg + i - 1, dwords[i], drawstate);
+			}
+		} else if (pkt_is_type4(dwords[0])) {
+			count = type4_pkt_size(dwords[0]) + 1;
+			reg = type4_pkt_offset(dwords[0]);
+			stats.reg_pkts_in++;
+			for (i = 1; i < count; i++)
+				write_reg(o, reg + i - 1, dwords[i], drawstate);
+		} else if (pkt_is_type3(dwords[0]) || pkt_is_type7(dwords[0])) {
+			uint32_t *pkt;
+
+			if (pkt_is_type3(dwords[0])) {
+				count = type3_pkt_size(dwords[0]) + 1;
+				opcode = cp_type3_opcode(dwords[0]);
+			} else {
+				count = type7_pkt_size(dwords[0]) + 1;
+				opcode = cp_type7_opcode(dwords[0]);
+			}
+
+			flush_writes(o);
+
+			if (opcode == CP_NOP) {
+				stats.nops++;
+				goto next;
+			}
+
+			if (opcode == CP_WAIT_FOR_IDLE) {
+				stats.wfis++;
+				if (strip_wfi && !wfi_needed(dwords + count, dwords_left - count)) {
+					stats.wfis_dropped++;
+					goto next;
+				}
+			}
+
+			if ((opcode == CP_COND_EXEC) || (opcode == CP_COND_REG_EXEC)) {
+				/* these skip a number of dwords following the packet,
+				 * so leave the rest of the IB alone:
+				 */
+				emitn(o, dwords, dwords_left);
+				return;
+			}
+
+			/* nested rewrites go to the arena, not to our obuf, so
+			 * pkt stays valid while we patch it:
+			 */
+			emitn(o, dwords, count);
+			pkt = &o->dwords[o->len - count];
+
+			switch (opcode) {
+			case CP_INDIRECT_BUFFER_PFE:
+			case CP_INDIRECT_BUFFER_PFD:
+				rewrite_ib_ref(&pkt[1], &pkt[is_64b() ? 3 : 2], ~0, 0);
+				break;
+			case CP_SET_DRAW_STATE:
+				for (i = 1; i < count; ) {
+					rewrite_ib_ref(&pkt[i + 1], &pkt[i],
+							CP_SET_DRAW_STATE_0_COUNT__MASK, 1);
+					i += is_64b() ? 3 : 2;
+				}
+				break;
+			}
+
+			if (!is_reg_safe(opcode))
+				gen++;
+		} else if (pkt_is_type2(dwords[0])) {
+			count = 1;
+			stats.nops++;
+		} else {
+			/* not something we understand, leave the rest as-is: */
+			flush_writes(o);
+			emitn(o, dwords, dwords_left);
+			return;
+		}
+
+next:
+		dwords += count;
+		dwords_left -= count;
+	}
+
+	flush_writes(o);
+}
+
+static int rewrite_ib(uint64_t gpuaddr, uint32_t sizedwords, int drawstate,
+		uint64_t *newaddr, uint32_t *newsize)
+{
+	struct obuf o = {0};
+	uint32_t *dwords;
+	uint64_t addr;
+	int i;
+
+	for (i = 0; i < nibs; i++) {
+		if ((ibs[i].gpuaddr == gpuaddr) && (ibs[i].sizedwords == sizedwords)) {
+			*newaddr = ibs[i].newaddr;
+			*newsize = ibs[i].newsize;
+			return 0;
+		}
+	}
+
+	dwords = hostptr(gpuaddr, sizedwords);
+	if (!dwords || !sizedwords)
+		return -1;
+
+	rewrite_cmds(dwords, sizedwords, drawstate, &o);
+
+	/* keep the original if nothing is left, a zero sized IB is not
+	 * something the CP expects:
+	 */
+	if (!o.len) {
+		free(o.dwords);
+		return -1;
+	}
+
+	addr = arena_base + arena.len * 4;
+	if (!is_64b() && ((addr + o.len * 4) > 0xffffffff)) {
+		free(o.dwords);
+		return -1;
+	}
+
+	emitn(&arena, o.dwords, o.len);
+	free(o.dwords);
+
+	if (nibs == maxibs) {
+		maxibs = maxibs ? maxibs * 2 : 64;
+		ibs = xrealloc(ibs, maxibs * sizeof(ibs[0]));
+	}
+
+	ibs[nibs].gpuaddr = gpuaddr;
+	ibs[nibs].sizedwords = sizedwords;
+	ibs[nibs].newaddr = *newaddr = addr;
+	ibs[nibs].newsize = *newsize = o.len;
+	nibs++;
+
+	stats.ibs++;
+	stats.dwords_in += sizedwords;
+	stats.dwords_out += o.len;
+
+	return 0;
+}
+
+static void write_section(enum rd_sect_type type, const void *buf, int sz)
+{
+	uint32_t hdr[2] = { type, sz };
+	fwrite(hdr, sizeof(hdr), 1, out);
+	fwrite(buf, sz, 1, out);
+}
+
+static void write_addr(enum rd_sect_type type, uint64_t gpuaddr, uint32_t len)
+{
+	uint32_t buf[3] = { gpuaddr, len, gpuaddr >> 32 };
+	write_section(type, buf, is_64b() ? 12 : 8);
+}
+
+static void flush_sections(void)
+{
+	int i;
+	for (i = 0; i < nsects; i++) {
+		write_section(sects[i].type, sects[i].buf, sects[i].sz);
+		if (sects[i].type != RD_BUFFER_CONTENTS)
+			free(sects[i].buf);
+	}
+	nsects = 0;
+}
+
+static void parse_addr(const uint32_t *buf, int sz, uint32_t *len, uint64_t *gpuaddr)
+{
+	*gpuaddr = buf[0];
+	*len = buf[1];
+	if (sz > 8)
+		*gpuaddr |= ((uint64_t)(buf[2])) << 32;
+}
+
+static void rewrite_submit(const void *buf, int sz)
+{
+	uint64_t gpuaddr, newaddr, end = 0;
+	uint32_t sizedwords, newsize;
+	int i;
+
+	parse_addr(buf, sz, &sizedwords, &gpuaddr);
+
+	/* if the buffers were not sent again for this submit, we need to
+	 * re-send them, since the new buffer resets the buffer list on
+	 * the reader side:
+	 */
+	if (!fresh_bufs) {
+		for (i = 0; i < nbufs; i++) {
+			write_addr(RD_GPUADDR, bufs[i].gpuaddr, bufs[i].len);
+			write_section(RD_BUFFER_CONTENTS, bufs[i].hostptr, bufs[i].len);
+		}
+	}
+	flush_sections();
+
+	for (i = 0; i < nbufs; i++)
+		end = max(end, bufs[i].gpuaddr + bufs[i].len);
+	arena_base = ALIGN(end, 0x1000);
+	arena.len = 0;
+	nibs = 0;
+
+	stats.submits++;
+
+	/* the arena is one more buffer, if that doesn't fit leave the
+	 * submit alone:
+	 */
+	if (nbufs >= MAX_BUFFERS) {
+		stats.unmodified++;
+		write_section(RD_CMDSTREAM_ADDR, buf, sz);
+	} else if (rewrite_ib(gpuaddr, sizedwords, 0, &newaddr, &newsize)) {
+		write_section(RD_CMDSTREAM_ADDR, buf, sz);
+	} else {
+		write_addr(RD_GPUADDR, arena_base, arena.len * 4);
+		write_section(RD_BUFFER_CONTENTS, arena.dwords, arena.len * 4);
+		write_addr(RD_CMDSTREAM_ADDR, newaddr, newsize);
+	}
+
+	needs_reset = 1;
+	fresh_bufs = 0;
+}
+
+int rewrite_open(const char *file)
+{
+	out = fopen(file, "w");
+	if (!out)
+		return -1;
+	return 0;
+}
+
+void rewrite_strip_wfi(void)
+{
+	strip_wfi = 1;
+}
+
+/* the buffer list starts over with the first buffer after a submit,
+ * and there is always room for one more:
+ */
+static void reset_bufs(void)
+{
+	int i;
+
+	if (needs_reset) {
+		for (i = 0; i < nbufs; i++)
+			free(bufs[i].hostptr);
+		nbufs = 0;
+		needs_reset = 0;
+	}
+
+	if (nbufs == maxbufs) {
+		maxbufs = maxbufs ? maxbufs * 2 : 64;
+		bufs = xrealloc(bufs, maxbufs * sizeof(bufs[0]));
+	}
+}
+
+void rewrite_section(enum rd_sect_type type, const void *buf, int sz)
+{
+	if (!out)
+		return;
+
+	switch (type) {
+	case RD_CMDSTREAM_ADDR:
+		rewrite_submit(buf, sz);
+		return;
+	case RD_GPU_ID:
+		if (!gpu_id)
+			gpu_id = *((unsigned int *)buf);
+		break;
+	case RD_GPUADDR:
+		reset_bufs();
+		parse_addr(buf, sz, &bufs[nbufs].len, &bufs[nbufs].gpuaddr);
+		fresh_bufs = 1;
+		break;
+	case RD_BUFFER_CONTENTS:
+		reset_bufs();
+		break;
+	default:
+		break;
+	}
+
+	if (nsects == maxsects) {
+		maxsects = maxsects ? maxsects * 2 : 64;
+		sects = xrealloc(sects, maxsects * sizeof(sects[0]));
+	}
+
+	sects[nsects].type = type;
+	sects[nsects].sz = sz;
+	sects[nsects].buf = xrealloc(NULL, sz + 1);
+	memcpy(sects[nsects].buf, buf, sz);
+
+	/* the buffer list keeps the section's copy, in case the buffers
+	 * have to be sent again for the next submit:
+	 */
+	if (type == RD_BUFFER_CONTENTS) {
+		bufs[nbufs].hostptr = sects[nsects].buf;
+		nbufs++;
+	}
+
+	nsects++;
+}
+
+void rewrite_close(void)
+{
+	if (!out)
+		return;
+
+	flush_sections();
+	fclose(out);
+	out = NULL;
+
+	printf("rewrite: %u submits, %u IBs, %"PRIu64" -> %"PRIu64" dwords (%.1f%%)\n",
+			stats.submits, stats.ibs, stats.dwords_in, stats.dwords_out,
+			stats.dwords_in ? (100.0 * stats.dwords_out) / stats.dwords_in : 0.0);
+	printf("rewrite: %u of %u register writes dropped, %u -> %u register write packets\n",
+			stats.writes_dropped, stats.writes, stats.reg_pkts_in, stats.reg_pkts_out);
+	printf("rewrite: %u nops dropped, %u of %u wfis dropped\n",
+			stats.nops, stats.wfis_dropped, stats.wfis);
+	if (stats.unmodified)
+		printf("rewrite: %u submits with too many buffers copied unmodified\n",
+				stats.unmodified);
+}
@@ -0,0 +1,60 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef REWRITE_H_
+#define REWRITE_H_
+
+#include "redump.h"
+
+/* Rewrite the cmdstream of each submit and write a new .rd file which
+ * can be replayed to measure the effect:
+ *
+ *  + drop redundant writes to context registers
+ *  + merge adjacent type0/type4 register writes into single packets
+ *  + drop CP_NOP and type2 packets
+ *  + optionally drop CP_WAIT_FOR_IDLE's which are not needed
+ *
+ * Rewritten IBs are placed in a new buffer following the captured
+ * buffers, and the CP_INDIRECT_BUFFER/CP_SET_DRAW_STATE packets which
+ * reference them are patched with the new address and size.  The
+ * original buffers are written out unmodified.
+ */
+
+/* called at start to open the output file: */
+int rewrite_open(const char *file);
+
+/* enable stripping of unneeded WFI's: */
+void rewrite_strip_wfi(void);
+
+/* called for every section read from the input file: */
+void rewrite_section(enum rd_sect_type type, const void *buf, int sz);
+
+/* called after last cmdstream file: */
+void rewrite_close(void);
+
+#endif /* REWRITE_H_ */
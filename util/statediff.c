@@ -0,0 +1,484 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "statediff.h"
+#include "util.h"
+
+const char *regname(uint32_t regbase, int color);
+
+#define NREGS 0x10000
+
+static bool enabled;
+
+struct delta {
+	uint32_t reg, val;
+};
+
+struct draw {
+	uint32_t key;
+	uint32_t first, n;   /* range in trace's deltas[] */
+	int draw;
+	int primtype;        /* index into primtypes[] */
+};
+
+static struct trace {
+	const char *name;
+	struct draw *draws;
+	unsigned ndraws, maxdraws;
+	struct delta *deltas;
+	unsigned ndeltas, maxdeltas;
+	uint32_t shader_hash[4];
+} traces[2];
+static int ntraces;
+static struct trace *cur;
+
+/* registers written since the last draw in the current trace: */
+static uint32_t dirty[NREGS];
+static uint8_t dirty_mask[NREGS / 8];
+static unsigned ndirty;
+static uint32_t vals[NREGS];
+
+static char **primtypes;
+static int nprimtypes;
+
+/* FNV-1a: */
+static uint32_t hash(uint32_t h, const void *buf, uint32_t sz)
+{
+	const uint8_t *p = buf;
+	while (sz--) {
+		h ^= *(p++);
+		h *= 16777619;
+	}
+	return h;
+}
+
+static int primtype_idx(const char *primtype)
+{
+	int i;
+
+	if (!primtype)
+		primtype = "<unknown>";
+
+	for (i = 0; i < nprimtypes; i++)
+		if (!strcmp(primtypes[i], primtype))
+			return i;
+
+	primtypes = xrealloc(primtypes, (nprimtypes + 1) * sizeof(primtypes[0]));
+	primtypes[nprimtypes] = strdup(primtype);
+	return nprimtypes++;
+}
+
+void statediff_enable(void)
+{
+	enabled = true;
+}
+
+void statediff_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	if (ntraces >= 2) {
+		fprintf(stderr, "statediff: expected exactly two cmdstream files\n");
+		exit(1);
+	}
+
+	cur = &traces[ntraces++];
+	cur->name = strdup(name);
+
+	memset(dirty_mask, 0, sizeof(dirty_mask));
+	memset(vals, 0, sizeof(vals));
+	ndirty = 0;
+}
+
+void statediff_end_cmdstream(void)
+{
+	cur = NULL;
+}
+
+void statediff_reg(uint32_t regbase, uint32_t val)
+{
+	if (!cur)
+		return;
+
+	regbase &= NREGS - 1;
+	vals[regbase] = val;
+
+	if (dirty_mask[regbase / 8] & (1 << (regbase % 8)))
+		return;
+
+	dirty_mask[regbase / 8] |= (1 << (regbase % 8));
+	dirty[ndirty++] = regbase;
+}
+
+void statediff_shader(enum statediff_stage stage, const void *buf,
+		uint32_t sizedwords)
+{
+	if (!cur || !buf)
+		return;
+
+	cur->shader_hash[stage] = hash(2166136261u, buf, sizedwords * 4);
+}
+
+void statediff_draw(const char *primtype, uint32_t rt, int draw)
+{
+	struct draw *d;
+	unsigned i;
+
+	if (!cur)
+		return;
+
+	if (cur->ndraws == cur->maxdraws) {
+		cur->maxdraws = cur->maxdraws ? cur->maxdraws * 2 : 1024;
+		cur->draws = xrealloc(cur->draws, cur->maxdraws * sizeof(cur->draws[0]));
+	}
+
+	if ((cur->ndeltas + ndirty) > cur->maxdeltas) {
+		while ((cur->ndeltas + ndirty) > cur->maxdeltas)
+			cur->maxdeltas = cur->maxdeltas ? cur->maxdeltas * 2 : 16384;
+		cur->deltas = xrealloc(cur->deltas, cur->maxdeltas * sizeof(cur->deltas[0]));
+	}
+
+	d = &cur->draws[cur->ndraws++];
+	d->primtype = primtype_idx(primtype);
+	d->draw = draw;
+	d->first = cur->ndeltas;
+	d->n = ndirty;
+
+	d->key = hash(2166136261u, &d->primtype, sizeof(d->primtype));
+	d->key = hash(d->key, cur->shader_hash, sizeof(cur->shader_hash));
+	d->key = hash(d->key, &rt, sizeof(rt));
+
+	for (i = 0; i < ndirty; i++) {
+		uint32_t reg = dirty[i];
+		cur->deltas[cur->ndeltas].reg = reg;
+		cur->deltas[cur->ndeltas].val = vals[reg];
+		cur->ndeltas++;
+		dirty_mask[reg / 8] &= ~(1 << (reg % 8));
+	}
+	ndirty = 0;
+}
+
+/*
+ * Draw alignment, using the linear space variant of Myers' "An O(ND)
+ * Difference Algorithm and Its Variations".  Matched pairs of draws
+ * are recorded in match[] (index into trace B for each draw in A, or
+ * -1 if not matched).
+ */
+
+static const uint32_t *ka, *kb;
+static int *match;
+static int *vf, *vb;            /* indexed by diagonal, offset by voff */
+static int voff;
+
+/* give up on finding the optimal alignment for a sub-sequence beyond
+ * this edit distance, to bound the time spent on very different
+ * captures:
+ */
+#define MAX_COST 4096
+
+static int middle_snake(int a0, int n, int b0, int m,
+		int *sx, int *sy, int *ex, int *ey)
+{
+	int delta = n - m;
+	bool odd = delta & 1;
+	int dmax = (n + m + 1) / 2;
+	int d, k;
+
+	vf[voff + 1] = 0;
+	vb[voff + 1] = 0;
+
+	for (d = 0; d <= dmax; d++) {
+		for (k = -d; k <= d; k += 2) {
+			int x, y, x0;
+
+			if ((k == -d) || ((k != d) && (vf[voff+k-1] < vf[voff+k+1])))
+				x = vf[voff+k+1];
+			else
+				x = vf[voff+k-1] + 1;
+			y = x - k;
+			x0 = x;
+
+			while ((x < n) && (y < m) && (ka[a0+x] == kb[b0+y])) {
+				x++;
+				y++;
+			}
+			vf[voff+k] = x;
+
+			if (odd && ((delta - k) >= -(d - 1)) && ((delta - k) <= (d - 1)) &&
+					((x + vb[voff+delta-k]) >= n)) {
+				*sx = x0;
+				*sy = x0 - k;
+				*ex = x;
+				*ey = y;
+				return 2 * d - 1;
+			}
+		}
+
+		for (k = -d; k <= d; k += 2) {
+			int x, y, x0;
+
+			if ((k == -d) || ((k != d) && (vb[voff+k-1] < vb[voff+k+1])))
+				x = vb[voff+k+1];
+			else
+				x = vb[voff+k-1] + 1;
+			y = x - k;
+			x0 = x;
+
+			while ((x < n) && (y < m) &&
+					(ka[a0+n-x-1] == kb[b0+m-y-1])) {
+				x++;
+				y++;
+			}
+			vb[voff+k] = x;
+
+			if (!odd && ((delta - k) >= -d) && ((delta - k) <= d) &&
+					((x + vf[voff+delta-k]) >= n)) {
+				*sx = n - x;
+				*sy = m - y;
+				*ex = n - x0;
+				*ey = m - (x0 - k);
+				return 2 * d;
+			}
+		}
+
+		if (d >= MAX_COST) {
+			/* too expensive, split at the furthest reaching forward
+			 * path and let the recursion sort out the rest:
+			 */
+			bool found = false;
+			for (k = -d; k <= d; k += 2) {
+				int x = (vf[voff+k] < n) ? vf[voff+k] : n;
+				int y = x - k;
+				if ((y < 0) || (y > m))
+					continue;
+				if (!found || ((x + y) > (*sx + *sy))) {
+					found = true;
+					*sx = x;
+					*sy = y;
+				}
+			}
+			*ex = *sx;
+			*ey = *sy;
+			return 2 * d;
+		}
+	}
+
+	/* not reached */
+	return -1;
+}
+
+static void align(int a0, int n, int b0, int m)
+{
+	int sx = 0, sy = 0, ex = 0, ey = 0, d, i;
+
+	/* common prefix/suffix: */
+	while ((n > 0) && (m > 0) && (ka[a0] == kb[b0])) {
+		match[a0++] = b0++;
+		n--;
+		m--;
+	}
+	while ((n > 0) && (m > 0) && (ka[a0+n-1] == kb[b0+m-1])) {
+		match[a0+n-1] = b0+m-1;
+		n--;
+		m--;
+	}
+
+	if ((n == 0) || (m == 0))
+		return;
+
+	d = middle_snake(a0, n, b0, m, &sx, &sy, &ex, &ey);
+
+	if (d <= 1) {
+		/* at most a single insertion/deletion, which the prefix/suffix
+		 * stripping above already dealt with:
+		 */
+		return;
+	}
+
+	align(a0, sx, b0, sy);
+	for (i = 0; i < (ex - sx); i++)
+		match[a0+sx+i] = b0+sy+i;
+	align(a0+ex, n-ex, b0+ey, m-ey);
+}
+
+/*
+ * Replay the recorded deltas of both traces, tracking the set of
+ * registers whose values currently differ:
+ */
+
+static uint32_t state[2][NREGS];
+static uint32_t diffs[NREGS];          /* set of differing regs */
+static int diff_idx[NREGS];            /* position in diffs[], or -1 */
+static unsigned ndiffs;
+static uint32_t printed[2][NREGS];     /* values at last printed pair */
+
+static void apply(int t, struct draw *d)
+{
+	struct trace *tr = &traces[t];
+	unsigned i;
+
+	for (i = 0; i < d->n; i++) {
+		uint32_t reg = tr->deltas[d->first + i].reg;
+		state[t][reg] = tr->deltas[d->first + i].val;
+
+		if (state[0][reg] != state[1][reg]) {
+			if (diff_idx[reg] < 0) {
+				diff_idx[reg] = ndiffs;
+				diffs[ndiffs++] = reg;
+			}
+		} else if (diff_idx[reg] >= 0) {
+			/* remove, moving the last entry into its place: */
+			uint32_t last = diffs[--ndiffs];
+			diffs[diff_idx[reg]] = last;
+			diff_idx[last] = diff_idx[reg];
+			diff_idx[reg] = -1;
+		}
+	}
+}
+
+static int cmp_reg(const void *a, const void *b)
+{
+	return (int)*(const uint32_t *)a - (int)*(const uint32_t *)b;
+}
+
+static void print_draw(const char *prefix, int t, struct draw *d)
+{
+	printf("%s %s draw %d: %s\n", prefix, t ? "B" : "A", d->draw,
+			primtypes[d->primtype]);
+}
+
+static void print_pair(struct draw *da, struct draw *db)
+{
+	uint32_t *regs;
+	unsigned i;
+
+	if (!ndiffs)
+		return;
+
+	printf("  draw %d <-> %d: %s, %u registers differ\n", da->draw, db->draw,
+			primtypes[da->primtype], ndiffs);
+
+	regs = xrealloc(NULL, ndiffs * sizeof(regs[0]));
+	memcpy(regs, diffs, ndiffs * sizeof(regs[0]));
+	qsort(regs, ndiffs, sizeof(regs[0]), cmp_reg);
+
+	for (i = 0; i < ndiffs; i++) {
+		uint32_t reg = regs[i];
+		const char *name = regname(reg, 0);
+		/* mark differences which are new since the previous pair: */
+		bool changed = (state[0][reg] != printed[0][reg]) ||
+				(state[1][reg] != printed[1][reg]);
+
+		printf("\t%s%08x -> %08x\t", changed ? "!" : " ",
+				state[0][reg], state[1][reg]);
+		if (name)
+			printf("%s\n", name);
+		else
+			printf("<%04x>\n", reg);
+
+		printed[0][reg] = state[0][reg];
+		printed[1][reg] = state[1][reg];
+	}
+
+	free(regs);
+}
+
+void statediff_finish(void)
+{
+	struct trace *a = &traces[0], *b = &traces[1];
+	unsigned i, j, matched = 0, paired = 0;
+
+	if (!enabled)
+		return;
+
+	if (ntraces != 2) {
+		fprintf(stderr, "statediff: expected exactly two cmdstream files\n");
+		return;
+	}
+
+	ka = xrealloc(NULL, (a->ndraws + 1) * sizeof(ka[0]));
+	kb = xrealloc(NULL, (b->ndraws + 1) * sizeof(kb[0]));
+	for (i = 0; i < a->ndraws; i++)
+		((uint32_t *)ka)[i] = a->draws[i].key;
+	for (i = 0; i < b->ndraws; i++)
+		((uint32_t *)kb)[i] = b->draws[i].key;
+
+	match = xrealloc(NULL, (a->ndraws + 1) * sizeof(match[0]));
+	for (i = 0; i < a->ndraws; i++)
+		match[i] = -1;
+
+	voff = a->ndraws + b->ndraws + 1;
+	vf = xrealloc(NULL, (2 * voff + 2) * sizeof(vf[0]));
+	vb = xrealloc(NULL, (2 * voff + 2) * sizeof(vb[0]));
+
+	align(0, a->ndraws, 0, b->ndraws);
+
+	printf("A: %s (%u draws)\n", a->name, a->ndraws);
+	printf("B: %s (%u draws)\n", b->name, b->ndraws);
+
+	for (i = 0; i < NREGS; i++)
+		diff_idx[i] = -1;
+
+	/* walk both traces in order, replaying state: */
+	for (i = 0, j = 0; (i < a->ndraws) || (j < b->ndraws); ) {
+		if ((i < a->ndraws) && (match[i] < 0)) {
+			apply(0, &a->draws[i]);
+			print_draw("-", 0, &a->draws[i]);
+			i++;
+		} else if ((j < b->ndraws) &&
+				((i >= a->ndraws) || (match[i] != (int)j))) {
+			apply(1, &b->draws[j]);
+			print_draw("+", 1, &b->draws[j]);
+			j++;
+		} else {
+			apply(0, &a->draws[i]);
+			apply(1, &b->draws[j]);
+			if (ndiffs)
+				paired++;
+			print_pair(&a->draws[i], &b->draws[j]);
+			matched++;
+			i++;
+			j++;
+		}
+	}
+
+	printf("%u draws matched (%u with differing state), %u removed, %u added\n",
+			matched, paired, a->ndraws - matched, b->ndraws - matched);
+
+	free((void *)ka);
+	free((void *)kb);
+	free(match);
+	free(vf);
+	free(vb);
+}
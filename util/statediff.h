@@ -0,0 +1,75 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef STATEDIFF_H_
+#define STATEDIFF_H_
+
+#include <stdint.h>
+
+/* Compare the state at each draw between two captures (ie. before and
+ * after a driver change).
+ *
+ * Each capture is decoded in turn, recording for every draw only the
+ * registers written since the previous draw, plus a key made from the
+ * primitive type, shader hashes and render target format.  At the end
+ * the two sequences of draw keys are aligned (Myers' O(ND) diff, in
+ * linear space), and for each pair of matching draws the registers
+ * whose values differ are printed, while unmatched draws are reported
+ * as added/removed.
+ */
+
+enum statediff_stage {
+	STATEDIFF_VS,
+	STATEDIFF_GS,
+	STATEDIFF_FS,
+	STATEDIFF_CS,
+};
+
+/* called at start to enable the diff: */
+void statediff_enable(void);
+
+/* called at start/end of each cmdstream file, there must be exactly two: */
+void statediff_start_cmdstream(const char *name);
+void statediff_end_cmdstream(void);
+
+/* called for each register write: */
+void statediff_reg(uint32_t regbase, uint32_t val);
+
+/* called for each shader program upload: */
+void statediff_shader(enum statediff_stage stage, const void *buf,
+		uint32_t sizedwords);
+
+/* called at each draw, rt identifies the render target (format, etc,
+ * but not the address, which is not stable between captures):
+ */
+void statediff_draw(const char *primtype, uint32_t rt, int draw);
+
+/* called after last cmdstream file to align draws and print the diff: */
+void statediff_finish(void);
+
+#endif /* STATEDIFF_H_ */
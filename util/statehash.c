@@ -0,0 +1,95 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "statehash.h"
+#include "util.h"
+
+void statehash_init(struct statehash *sh, const char *name, unsigned nslots)
+{
+	sh->name = name;
+	sh->nslots = nslots;
+	sh->slots = xrealloc(NULL, nslots * sizeof(sh->slots[0]));
+	statehash_reset(sh);
+}
+
+void statehash_reset(struct statehash *sh)
+{
+	memset(sh->hash, 0, sizeof(sh->hash));
+	memset(sh->written, 0, sizeof(sh->written));
+	memset(sh->slots, 0, sh->nslots * sizeof(sh->slots[0]));
+}
+
+void statehash_reg(struct statehash *sh, unsigned cls,
+		uint32_t regbase, uint32_t val)
+{
+	uint64_t key;
+
+	regbase &= STATEHASH_NREGS - 1;
+	key = ((uint64_t)regbase) << 32;
+
+	if (sh->written[regbase / 8] & (1 << (regbase % 8)))
+		sh->hash[cls] ^= mix(key | sh->vals[regbase]);
+	sh->written[regbase / 8] |= (1 << (regbase % 8));
+
+	sh->vals[regbase] = val;
+	sh->hash[cls] ^= mix(key | val);
+}
+
+void statehash_state(struct statehash *sh, unsigned cls, uint32_t slot,
+		const void *buf, uint32_t sizedwords)
+{
+	const uint32_t *dwords = buf;
+	uint64_t h = sizedwords;
+	unsigned i, probe, n = sh->nslots;
+
+	for (i = 0; i < sizedwords; i++)
+		h = mix(h ^ dwords[i]);
+	h = mix(h ^ ((uint64_t)slot << 32));
+
+	/* find the slot, or a free entry: */
+	for (i = mix(slot) % n, probe = 0;
+			sh->slots[i].used && (sh->slots[i].slot != slot);
+			i = (i + 1) % n) {
+		if (++probe == n) {
+			fprintf(stderr, "%s: too many state slots, ignoring %08x\n",
+					sh->name, slot);
+			return;
+		}
+	}
+
+	if (sh->slots[i].used)
+		sh->hash[sh->slots[i].cls] ^= sh->slots[i].hash;
+	sh->slots[i].used = 1;
+	sh->slots[i].slot = slot;
+	sh->slots[i].cls = cls;
+	sh->slots[i].hash = h;
+	sh->hash[cls] ^= h;
+}
@@ -0,0 +1,79 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef STATEHASH_H_
+#define STATEHASH_H_
+
+#include <stdint.h>
+
+/* Incrementally updated hash of the gpu state, shared by --census and
+ * --merge.
+ *
+ * Each register write and each state upload contributes hash(slot,
+ * value) to the hash of its class, combined with xor, and replacing a
+ * register or slot xors out its previous contribution.  So the cost of
+ * comparing the state at two draws does not depend on the size of the
+ * state.
+ */
+
+#define STATEHASH_NREGS    0x10000
+#define STATEHASH_NCLASSES 4
+
+struct statehash_slot {
+	uint32_t slot;
+	uint64_t hash;
+	unsigned cls;
+	int used;
+};
+
+struct statehash {
+	const char *name;      /* for error messages */
+	uint64_t hash[STATEHASH_NCLASSES];
+	uint32_t vals[STATEHASH_NREGS];
+	uint8_t written[STATEHASH_NREGS / 8];
+	struct statehash_slot *slots;
+	unsigned nslots;
+};
+
+/* allocate the table of nslots state upload slots: */
+void statehash_init(struct statehash *sh, const char *name, unsigned nslots);
+
+/* forget all state, at the start of each cmdstream: */
+void statehash_reset(struct statehash *sh);
+
+/* called for each register write, with the class of the register: */
+void statehash_reg(struct statehash *sh, unsigned cls,
+		uint32_t regbase, uint32_t val);
+
+/* called for each state upload, where slot identifies the state that
+ * is replaced (ie. state block and offset):
+ */
+void statehash_state(struct statehash *sh, unsigned cls, uint32_t slot,
+		const void *buf, uint32_t sizedwords);
+
+#endif /* STATEHASH_H_ */
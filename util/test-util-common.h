@@ -59,9 +59,16 @@ void *memcpy(void *dest, const void *src, size_t n);
 
 /*****************************************************************************/
 
+/* set by the tests-3d benchmark mode for all but the first iteration, to
+ * keep debug output and RD_CMD markers out of the measured iterations:
+ */
+static int __quiet __attribute__((unused));
+
 #define DEBUG_MSG(fmt, ...) \
 		do { \
 			static char __rd_buf[4096]; \
+			if (__quiet) \
+				break; \
 			if (rd_write_section) \
 			rd_write_section(RD_CMD, __rd_buf, snprintf(__rd_buf, sizeof(__rd_buf), "%s:%d: "fmt, \
 							__FUNCTION__, __LINE__, ##__VA_ARGS__)); \
@@ -0,0 +1,344 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "texdesc.h"
+
+#define MAX_LAYERS  256
+
+const struct texdesc_fmt_info texdesc_fmts[] = {
+		[TEXDESC_NONE]    = { "unknown", 0,  1 },
+		[TEXDESC_R8]      = { "R8",      1,  1 },
+		[TEXDESC_RG8]     = { "RG8",     2,  1 },
+		[TEXDESC_RGB8]    = { "RGB8",    3,  1 },
+		[TEXDESC_RGBA8]   = { "RGBA8",   4,  1 },
+		[TEXDESC_RGB565]  = { "RGB565",  2,  1 },
+		[TEXDESC_RGB5A1]  = { "RGB5A1",  2,  1 },
+		[TEXDESC_RGBA4]   = { "RGBA4",   2,  1 },
+		[TEXDESC_RGB10A2] = { "RGB10A2", 4,  1 },
+		[TEXDESC_R16F]    = { "R16F",    2,  1 },
+		[TEXDESC_RG16F]   = { "RG16F",   4,  1 },
+		[TEXDESC_RGBA16F] = { "RGBA16F", 8,  1 },
+		[TEXDESC_R32F]    = { "R32F",    4,  1 },
+		[TEXDESC_RG32F]   = { "RG32F",   8,  1 },
+		[TEXDESC_RGBA32F] = { "RGBA32F", 16, 1 },
+		[TEXDESC_ETC1]    = { "ETC1",    8,  4 },
+		[TEXDESC_DXT1]    = { "DXT1",    8,  4 },
+		[TEXDESC_DXT3]    = { "DXT3",    16, 4 },
+		[TEXDESC_DXT5]    = { "DXT5",    16, 4 },
+};
+
+static unsigned gen;
+static unsigned seqno;
+
+static struct {
+	uint32_t dwords[12];
+	unsigned seqno;            /* zero if not bound */
+} consts[2][TEXDESC_MAX_UNITS];
+static uint32_t mipaddrs[2][TEXDESC_MAX_UNITS * TEXDESC_MAX_LEVELS];
+
+static enum texdesc_fmt a3xx_fmt(unsigned f)
+{
+	switch (f) {
+	case 4:  return TEXDESC_RGB565;     /* TFMT_5_6_5_UNORM */
+	case 5:  return TEXDESC_RGB5A1;     /* TFMT_5_5_5_1_UNORM */
+	case 7:  return TEXDESC_RGBA4;      /* TFMT_4_4_4_4_UNORM */
+	case 34: return TEXDESC_ETC1;       /* TFMT_ETC1 */
+	case 36: return TEXDESC_DXT1;       /* TFMT_DXT1 */
+	case 37: return TEXDESC_DXT3;       /* TFMT_DXT3 */
+	case 38: return TEXDESC_DXT5;       /* TFMT_DXT5 */
+	case 41: return TEXDESC_RGB10A2;    /* TFMT_10_10_10_2_UNORM */
+	case 44:                            /* TFMT_A8_UNORM */
+	case 45:                            /* TFMT_L8_UNORM */
+	case 48: return TEXDESC_R8;         /* TFMT_8_UNORM */
+	case 47:                            /* TFMT_L8_A8_UNORM */
+	case 49: return TEXDESC_RG8;        /* TFMT_8_8_UNORM */
+	case 50: return TEXDESC_RGB8;       /* TFMT_8_8_8_UNORM */
+	case 51: return TEXDESC_RGBA8;      /* TFMT_8_8_8_8_UNORM */
+	case 64: return TEXDESC_R16F;       /* TFMT_16_FLOAT */
+	case 65: return TEXDESC_RG16F;      /* TFMT_16_16_FLOAT */
+	case 67: return TEXDESC_RGBA16F;    /* TFMT_16_16_16_16_FLOAT */
+	case 84: return TEXDESC_R32F;       /* TFMT_32_FLOAT */
+	case 85: return TEXDESC_RG32F;      /* TFMT_32_32_FLOAT */
+	case 87: return TEXDESC_RGBA32F;    /* TFMT_32_32_32_32_FLOAT */
+	default: return TEXDESC_NONE;
+	}
+}
+
+static enum texdesc_fmt a4xx_fmt(unsigned f)
+{
+	switch (f) {
+	case 3:                             /* TFMT4_A8_UNORM */
+	case 4:   return TEXDESC_R8;        /* TFMT4_8_UNORM */
+	case 8:   return TEXDESC_RGBA4;     /* TFMT4_4_4_4_4_UNORM */
+	case 9:   return TEXDESC_RGB5A1;    /* TFMT4_5_5_5_1_UNORM */
+	case 11:  return TEXDESC_RGB565;    /* TFMT4_5_6_5_UNORM */
+	case 13:                            /* TFMT4_L8_A8_UNORM */
+	case 14:  return TEXDESC_RG8;       /* TFMT4_8_8_UNORM */
+	case 20:  return TEXDESC_R16F;      /* TFMT4_16_FLOAT */
+	case 28:  return TEXDESC_RGBA8;     /* TFMT4_8_8_8_8_UNORM */
+	case 33:  return TEXDESC_RGB10A2;   /* TFMT4_10_10_10_2_UNORM */
+	case 40:  return TEXDESC_RG16F;     /* TFMT4_16_16_FLOAT */
+	case 43:  return TEXDESC_R32F;      /* TFMT4_32_FLOAT */
+	case 53:  return TEXDESC_RGBA16F;   /* TFMT4_16_16_16_16_FLOAT */
+	case 56:  return TEXDESC_RG32F;     /* TFMT4_32_32_FLOAT */
+	case 63:  return TEXDESC_RGBA32F;   /* TFMT4_32_32_32_32_FLOAT */
+	case 86:  return TEXDESC_DXT1;      /* TFMT4_DXT1 */
+	case 87:  return TEXDESC_DXT3;      /* TFMT4_DXT3 */
+	case 88:  return TEXDESC_DXT5;      /* TFMT4_DXT5 */
+	case 107: return TEXDESC_ETC1;      /* TFMT4_ETC1 */
+	default:  return TEXDESC_NONE;
+	}
+}
+
+static enum texdesc_fmt a5xx_fmt(unsigned f)
+{
+	switch (f) {
+	case 2:                             /* TFMT5_A8_UNORM */
+	case 3:   return TEXDESC_R8;        /* TFMT5_8_UNORM */
+	case 8:   return TEXDESC_RGBA4;     /* TFMT5_4_4_4_4_UNORM */
+	case 10:  return TEXDESC_RGB5A1;    /* TFMT5_5_5_5_1_UNORM */
+	case 14:  return TEXDESC_RGB565;    /* TFMT5_5_6_5_UNORM */
+	case 19:  return TEXDESC_RG8;       /* TFMT5_L8_A8_UNORM */
+	case 23:  return TEXDESC_R16F;      /* TFMT5_16_FLOAT */
+	case 48:  return TEXDESC_RGBA8;     /* TFMT5_8_8_8_8_UNORM */
+	case 54:  return TEXDESC_RGB10A2;   /* TFMT5_10_10_10_2_UNORM */
+	case 69:  return TEXDESC_RG16F;     /* TFMT5_16_16_FLOAT */
+	case 74:  return TEXDESC_R32F;      /* TFMT5_32_FLOAT */
+	case 98:  return TEXDESC_RGBA16F;   /* TFMT5_16_16_16_16_FLOAT */
+	case 103: return TEXDESC_RG32F;     /* TFMT5_32_32_FLOAT */
+	case 130: return TEXDESC_RGBA32F;   /* TFMT5_32_32_32_32_FLOAT */
+	default:  return TEXDESC_NONE;
+	}
+}
+
+
+void texdesc_set_gpu(unsigned gpu_id)
+{
+	gen = gpu_id / 100;
+}
+
+void texdesc_start_cmdstream(void)
+{
+	memset(consts, 0, sizeof(consts));
+	memset(mipaddrs, 0, sizeof(mipaddrs));
+}
+
+void texdesc_tex_const(enum texdesc_stage stage, uint32_t unit,
+		const uint32_t *dwords, uint32_t num_unit)
+{
+	unsigned i, sz = (gen >= 5) ? 12 : (gen == 4) ? 8 : 4;
+
+	if ((gen < 3) || (gen > 5))
+		return;
+
+	for (i = 0; (i < num_unit) && (unit + i < TEXDESC_MAX_UNITS); i++) {
+		const uint32_t *d = dwords + i * sz;
+		int j, zero = 1;
+
+		/* the opencl blob always writes the max # of units: */
+		for (j = 0; j < 4; j++)
+			if (d[j])
+				zero = 0;
+
+		memcpy(consts[stage][unit + i].dwords, d, sz * 4);
+		consts[stage][unit + i].seqno = zero ? 0 : ++seqno;
+	}
+}
+
+void texdesc_mipaddr(enum texdesc_stage stage, uint32_t off,
+		const uint32_t *addrs, uint32_t num_unit)
+{
+	unsigned i;
+
+	for (i = 0; (i < num_unit) && (off + i < TEXDESC_MAX_UNITS * TEXDESC_MAX_LEVELS); i++)
+		mipaddrs[stage][off + i] = addrs[i];
+
+	/* textures using these addresses have changed too: */
+	for (i = off / TEXDESC_MAX_LEVELS; (i <= (off + num_unit) / TEXDESC_MAX_LEVELS) &&
+			(i < TEXDESC_MAX_UNITS); i++)
+		if (consts[stage][i].seqno)
+			consts[stage][i].seqno = ++seqno;
+}
+
+unsigned texdesc_seqno(enum texdesc_stage stage, uint32_t unit)
+{
+	if (unit >= TEXDESC_MAX_UNITS)
+		return 0;
+	return consts[stage][unit].seqno;
+}
+
+int texdesc_get(enum texdesc_stage stage, uint32_t unit, struct texdesc *tex)
+{
+	const uint32_t *d;
+	unsigned i, type;
+
+	memset(tex, 0, sizeof(*tex));
+
+	if (!texdesc_seqno(stage, unit))
+		return -1;
+
+	d = consts[stage][unit].dwords;
+
+	for (i = 0; i < 4; i++)
+		tex->swiz[i] = (d[0] >> (4 + 3 * i)) & 0x7;
+
+	switch (gen) {
+	case 3:
+		tex->tile_mode = d[0] & 0x1;
+		tex->levels    = ((d[0] >> 16) & 0xf) + 1;
+		tex->raw_fmt   = (d[0] >> 22) & 0x7f;
+		tex->fmt       = a3xx_fmt(tex->raw_fmt);
+		type           = (d[0] >> 30) & 0x3;
+		tex->height    = d[1] & 0x3fff;
+		tex->width     = (d[1] >> 14) & 0x3fff;
+		tex->pitch     = (d[2] >> 12) & 0x3ffff;
+		tex->swap      = (d[2] >> 30) & 0x3;
+		tex->layersz   = (d[3] & 0x1ffff) << 12;
+		tex->depth     = (d[3] >> 17) & 0x7ff;
+		for (i = 0; i < TEXDESC_MAX_LEVELS; i++)
+			tex->mipaddrs[i] = mipaddrs[stage][unit * TEXDESC_MAX_LEVELS + i];
+		tex->base      = tex->mipaddrs[0];
+		break;
+	case 4:
+		tex->tile_mode = d[0] & 0x1;
+		tex->levels    = ((d[0] >> 16) & 0xf) + 1;
+		tex->raw_fmt   = (d[0] >> 22) & 0x7f;
+		tex->fmt       = a4xx_fmt(tex->raw_fmt);
+		type           = (d[0] >> 29) & 0x3;
+		tex->height    = d[1] & 0x7fff;
+		tex->width     = (d[1] >> 15) & 0x7fff;
+		tex->pitch     = (d[2] >> 9) & 0x1fffff;
+		tex->swap      = (d[2] >> 30) & 0x3;
+		tex->layersz   = (d[3] & 0x3fff) << 12;
+		tex->depth     = (d[3] >> 18) & 0x1fff;
+		tex->base      = d[4] & ~0x1f;
+		break;
+	case 5:
+		tex->tile_mode = d[0] & 0x3;
+		tex->levels    = 1;
+		tex->raw_fmt   = (d[0] >> 22) & 0xff;
+		tex->fmt       = a5xx_fmt(tex->raw_fmt);
+		tex->width     = d[1] & 0x7fff;
+		tex->height    = (d[1] >> 15) & 0x7fff;
+		tex->pitch     = (d[2] >> 8) & 0x1fffff;
+		type           = (d[2] >> 29) & 0x3;
+		tex->layersz   = (d[3] & 0x3fff) << 12;
+		tex->base      = (d[4] & ~0x1f) | (((uint64_t)d[5] & 0x1ffff) << 32);
+		tex->depth     = (d[5] >> 17) & 0x1fff;
+		break;
+	default:
+		return -1;
+	}
+
+	if (!tex->width || !tex->height)
+		return -1;
+
+	while ((tex->levels > 1) && !((tex->width | tex->height) >> (tex->levels - 1)))
+		tex->levels--;
+	if (tex->levels > TEXDESC_MAX_LEVELS)
+		tex->levels = TEXDESC_MAX_LEVELS;
+
+	/* 1d=0, 2d=1, cube=2, 3d=3 on all generations: */
+	tex->is_cube = (type == 2);
+	tex->is_3d = (type == 3);
+	if (!tex->depth)
+		tex->depth = 1;
+	tex->layers = tex->is_cube ? 6 : tex->depth;
+	if (tex->layers > MAX_LAYERS)
+		tex->layers = MAX_LAYERS;
+
+	return 0;
+}
+
+unsigned texdesc_level_pitch(const struct texdesc *tex, unsigned level)
+{
+	unsigned w = tex->width >> level, bs = texdesc_fmts[tex->fmt].bs;
+
+	if (level == 0)
+		return tex->pitch;
+
+	/* levels > 0 are aligned to 32 texels, like the freedreno driver does: */
+	w = (w + TEXDESC_TILE - 1) & ~(TEXDESC_TILE - 1);
+	return ((w + bs - 1) / bs) * texdesc_fmts[tex->fmt].cpp;
+}
+
+unsigned texdesc_level_size(const struct texdesc *tex, unsigned level)
+{
+	unsigned h = tex->height >> level, bs = texdesc_fmts[tex->fmt].bs;
+	if (!h)
+		h = 1;
+	return texdesc_level_pitch(tex, level) * ((h + bs - 1) / bs);
+}
+
+unsigned texdesc_level_layers(const struct texdesc *tex, unsigned level)
+{
+	/* 3d textures have fewer slices in each level: */
+	if (tex->is_3d)
+		return (tex->layers >> level) ? (tex->layers >> level) : 1;
+	return tex->layers;
+}
+
+uint64_t texdesc_addr(const struct texdesc *tex, unsigned level, unsigned layer)
+{
+	/* array and cube layers are LAYERSZ apart, each containing all the
+	 * levels.  Otherwise (3d) each level contains all of its slices:
+	 */
+	int layer_major = tex->layersz && !tex->is_3d;
+	uint64_t addr;
+
+	if (gen == 3) {
+		addr = tex->mipaddrs[level];
+	} else {
+		unsigned l;
+		/* levels are packed one after the other: */
+		addr = tex->base;
+		for (l = 0; l < level; l++)
+			addr += (uint64_t)texdesc_level_size(tex, l) *
+					(layer_major ? 1 : texdesc_level_layers(tex, l));
+	}
+
+	return addr + (uint64_t)layer *
+			(layer_major ? tex->layersz : texdesc_level_size(tex, level));
+}
+
+uint64_t texdesc_size(const struct texdesc *tex)
+{
+	uint64_t size = 0;
+	unsigned l;
+
+	if (tex->layersz && (!tex->is_3d || !texdesc_fmts[tex->fmt].cpp))
+		return (uint64_t)tex->layersz * tex->layers;
+
+	for (l = 0; l < tex->levels; l++)
+		size += (uint64_t)texdesc_level_size(tex, l) * texdesc_level_layers(tex, l);
+
+	return size;
+}
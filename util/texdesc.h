@@ -0,0 +1,127 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef TEXDESC_H_
+#define TEXDESC_H_
+
+#include <stdint.h>
+
+/* Tracks the texture descriptors (TEX_CONST) and, on a3xx, mipmap address
+ * tables loaded with CP_LOAD_STATE, and decodes them into a generation
+ * independent form (format, size, tiling, mipmap levels and layers, and
+ * the address of each level/layer) for --export-textures and
+ * --tex-inventory.
+ */
+
+#define TEXDESC_MAX_UNITS   32
+#define TEXDESC_MAX_LEVELS  14    /* BASETABLE_SZ, mipaddrs per texture on a3xx */
+#define TEXDESC_TILE        32    /* texels per tile side, a3xx TILE_32X32 */
+
+enum texdesc_stage {
+	TEXDESC_VS,
+	TEXDESC_FS,
+};
+
+/* the a3xx/a4xx/a5xx tex_fmt enums (which can't all be included at once)
+ * are mapped to these:
+ */
+enum texdesc_fmt {
+	TEXDESC_NONE,
+	TEXDESC_R8,
+	TEXDESC_RG8,
+	TEXDESC_RGB8,
+	TEXDESC_RGBA8,
+	TEXDESC_RGB565,
+	TEXDESC_RGB5A1,
+	TEXDESC_RGBA4,
+	TEXDESC_RGB10A2,
+	TEXDESC_R16F,
+	TEXDESC_RG16F,
+	TEXDESC_RGBA16F,
+	TEXDESC_R32F,
+	TEXDESC_RG32F,
+	TEXDESC_RGBA32F,
+	TEXDESC_ETC1,
+	TEXDESC_DXT1,
+	TEXDESC_DXT3,
+	TEXDESC_DXT5,
+};
+
+struct texdesc_fmt_info {
+	const char *name;
+	unsigned cpp;          /* bytes per texel, or per block */
+	unsigned bs;           /* block size (width and height), 1 if not compressed */
+};
+
+extern const struct texdesc_fmt_info texdesc_fmts[];
+
+struct texdesc {
+	enum texdesc_fmt fmt;
+	unsigned raw_fmt;          /* generation specific tex_fmt */
+	unsigned width, height, depth;
+	unsigned levels, layers;
+	unsigned pitch;            /* bytes, of level 0 */
+	unsigned layersz;          /* bytes, 0 if not given */
+	unsigned tile_mode;        /* 0 for linear */
+	int is_cube, is_3d;
+	unsigned swap;
+	unsigned swiz[4];
+	uint64_t base;
+	uint64_t mipaddrs[TEXDESC_MAX_LEVELS];   /* a3xx only */
+};
+
+/* called once the gpu_id is known: */
+void texdesc_set_gpu(unsigned gpu_id);
+
+/* called at start of each cmdstream file: */
+void texdesc_start_cmdstream(void);
+
+/* texture descriptors (CP_LOAD_STATE to SB_*_TEX, ST_CONSTANTS): */
+void texdesc_tex_const(enum texdesc_stage stage, uint32_t unit,
+		const uint32_t *dwords, uint32_t num_unit);
+
+/* mipmap address table (CP_LOAD_STATE to SB_*_MIPADDR), on a3xx: */
+void texdesc_mipaddr(enum texdesc_stage stage, uint32_t off,
+		const uint32_t *addrs, uint32_t num_unit);
+
+/* returns a number which changes whenever the descriptor (or mipmap
+ * addresses) of the unit are written, or zero if no texture is bound:
+ */
+unsigned texdesc_seqno(enum texdesc_stage stage, uint32_t unit);
+
+/* decode the texture bound to a unit, returns -1 if none: */
+int texdesc_get(enum texdesc_stage stage, uint32_t unit, struct texdesc *tex);
+
+/* layout of the levels and layers, sizes in bytes: */
+unsigned texdesc_level_pitch(const struct texdesc *tex, unsigned level);
+unsigned texdesc_level_size(const struct texdesc *tex, unsigned level);
+unsigned texdesc_level_layers(const struct texdesc *tex, unsigned level);
+uint64_t texdesc_addr(const struct texdesc *tex, unsigned level, unsigned layer);
+uint64_t texdesc_size(const struct texdesc *tex);
+
+#endif /* TEXDESC_H_ */
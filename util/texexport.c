@@ -0,0 +1,790 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "texexport.h"
+#include "util.h"
+#include "texdesc.h"
+#include "bmp.h"
+
+void *cffdump_hostptr(uint64_t gpuaddr);
+uint32_t cffdump_hostlen(uint64_t gpuaddr);
+
+#define MAX_THREADS 16
+#define TILE        TEXDESC_TILE
+
+/* a texture used by a draw, exported by one of the threads: */
+struct job {
+	struct texdesc tex;
+	enum texdesc_stage stage;
+	unsigned unit;
+	int draw;
+	char *log;                 /* index lines, written in order at the end */
+	size_t loglen;
+};
+
+static char *outdir;
+static FILE *index_file;
+
+/* seqno of the descriptor last exported, per unit: */
+static unsigned exported[2][TEXDESC_MAX_UNITS];
+
+static struct job *jobs;
+static unsigned njobs, maxjobs;
+static int submit_nr;
+
+static pthread_t threads[MAX_THREADS];
+static unsigned nthreads;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static unsigned next_job, done_jobs;
+static int running, quit;
+
+/* content hashes of the images written so far: */
+static pthread_mutex_t set_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t *set;
+static unsigned nset, set_size;
+
+static struct {
+	unsigned textures, images, written, skipped;
+	uint64_t bytes;
+} stats;
+
+static uint64_t hash_buf(uint64_t h, const uint8_t *buf, size_t sz)
+{
+	size_t i;
+
+	for (i = 0; i + 8 <= sz; i += 8) {
+		uint64_t v;
+		memcpy(&v, buf + i, 8);
+		h = mix(h ^ v);
+	}
+	for (; i < sz; i++)
+		h = mix(h ^ buf[i]);
+
+	return h;
+}
+
+/* returns true if the hash was not seen before: */
+static int claim(uint64_t hash)
+{
+	unsigned i;
+	int ret = 1;
+
+	pthread_mutex_lock(&set_lock);
+
+	if ((nset * 2) >= set_size) {
+		uint64_t *old = set;
+		unsigned j, old_size = set_size;
+		set_size = set_size ? set_size * 2 : 1024;
+		set = calloc(set_size, sizeof(set[0]));
+		for (j = 0; j < old_size; j++) {
+			if (!old[j])
+				continue;
+			for (i = old[j] % set_size; set[i]; i = (i + 1) % set_size)
+				;
+			set[i] = old[j];
+		}
+		free(old);
+	}
+
+	/* zero marks an empty entry: */
+	hash |= 1;
+
+	for (i = hash % set_size; set[i]; i = (i + 1) % set_size) {
+		if (set[i] == hash) {
+			ret = 0;
+			break;
+		}
+	}
+
+	if (ret) {
+		set[i] = hash;
+		nset++;
+	}
+
+	pthread_mutex_unlock(&set_lock);
+
+	return ret;
+}
+
+static void job_log(struct job *job, const char *fmt, ...)
+{
+	char buf[256];
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	if (n >= (int)sizeof(buf))
+		n = sizeof(buf) - 1;
+
+	job->log = xrealloc(job->log, job->loglen + n + 1);
+	memcpy(job->log + job->loglen, buf, n + 1);
+	job->loglen += n;
+}
+
+/*
+ * Conversion to 8 bit components, in the order they are stored (the
+ * first component being in the lowest bits), one row at a time.  The
+ * loops are kept simple (and indexed with a size_t, so the addresses
+ * can't wrap) so that the ones for the integer formats vectorize when
+ * built at -O3.
+ */
+
+static uint8_t half_to_unorm8(uint16_t h)
+{
+	unsigned e = (h >> 10) & 0x1f, m = h & 0x3ff;
+	float f;
+
+	if (h & 0x8000)
+		return 0;
+	if (e == 0x1f)
+		return m ? 0 : 255;
+
+	f = e ? (1.0f + m / 1024.0f) * (float)(1 << e) / (1 << 15) :
+			(m / 1024.0f) / (1 << 14);
+
+	return (f >= 1.0f) ? 255 : (uint8_t)(f * 255.0f + 0.5f);
+}
+
+static uint8_t float_to_unorm8(float f)
+{
+	if (!(f > 0.0f))
+		return 0;
+	return (f >= 1.0f) ? 255 : (uint8_t)(f * 255.0f + 0.5f);
+}
+
+static void convert_row(enum texdesc_fmt fmt, const uint8_t *src, uint8_t *dst,
+		unsigned width)
+{
+	const uint16_t *s16 = (const uint16_t *)src;
+	const uint32_t *s32 = (const uint32_t *)src;
+	const float *sf = (const float *)src;
+	size_t x;
+
+	switch (fmt) {
+	case TEXDESC_R8:
+		for (x = 0; x < width; x++) {
+			dst[4*x+0] = src[x];
+			dst[4*x+1] = 0;
+			dst[4*x+2] = 0;
+			dst[4*x+3] = 255;
+		}
+		break;
+	case TEXDESC_RG8:
+		for (x = 0; x < width; x++) {
+			dst[4*x+0] = src[2*x+0];
+			dst[4*x+1] = src[2*x+1];
+			dst[4*x+2] = 0;
+			dst[4*x+3] = 255;
+		}
+		break;
+	case TEXDESC_RGB8:
+		for (x = 0; x < width; x++) {
+			dst[4*x+0] = src[3*x+0];
+			dst[4*x+1] = src[3*x+1];
+			dst[4*x+2] = src[3*x+2];
+			dst[4*x+3] = 255;
+		}
+		break;
+	case TEXDESC_RGBA8:
+		memcpy(dst, src, width * 4);
+		break;
+	case TEXDESC_RGB565:
+		for (x = 0; x < width; x++) {
+			uint16_t v = s16[x];
+			dst[4*x+0] = ((v & 0x1f) << 3) | ((v >> 2) & 0x7);
+			dst[4*x+1] = ((v >> 3) & 0xfc) | ((v >> 9) & 0x3);
+			dst[4*x+2] = ((v >> 8) & 0xf8) | (v >> 13);
+			dst[4*x+3] = 255;
+		}
+		break;
+	case TEXDESC_RGB5A1:
+		for (x = 0; x < width; x++) {
+			uint16_t v = s16[x];
+			dst[4*x+0] = ((v & 0x1f) << 3) | ((v >> 2) & 0x7);
+			dst[4*x+1] = ((v >> 2) & 0xf8) | ((v >> 7) & 0x7);
+			dst[4*x+2] = ((v >> 7) & 0xf8) | ((v >> 12) & 0x7);
+			dst[4*x+3] = (v & 0x8000) ? 255 : 0;
+		}
+		break;
+	case TEXDESC_RGBA4:
+		for (x = 0; x < width; x++) {
+			uint16_t v = s16[x];
+			dst[4*x+0] = (v & 0xf) * 17;
+			dst[4*x+1] = ((v >> 4) & 0xf) * 17;
+			dst[4*x+2] = ((v >> 8) & 0xf) * 17;
+			dst[4*x+3] = (v >> 12) * 17;
+		}
+		break;
+	case TEXDESC_RGB10A2:
+		for (x = 0; x < width; x++) {
+			uint32_t v = s32[x];
+			dst[4*x+0] = (v >> 2) & 0xff;
+			dst[4*x+1] = (v >> 12) & 0xff;
+			dst[4*x+2] = (v >> 22) & 0xff;
+			dst[4*x+3] = (v >> 30) * 85;
+		}
+		break;
+	case TEXDESC_R16F:
+	case TEXDESC_RG16F:
+	case TEXDESC_RGBA16F: {
+		unsigned i, n = (fmt == TEXDESC_R16F) ? 1 : (fmt == TEXDESC_RG16F) ? 2 : 4;
+		for (x = 0; x < width; x++) {
+			dst[4*x+1] = dst[4*x+2] = 0;
+			dst[4*x+3] = 255;
+			for (i = 0; i < n; i++)
+				dst[4*x+i] = half_to_unorm8(s16[n*x+i]);
+		}
+		break;
+	}
+	case TEXDESC_R32F:
+	case TEXDESC_RG32F:
+	case TEXDESC_RGBA32F: {
+		unsigned i, n = (fmt == TEXDESC_R32F) ? 1 : (fmt == TEXDESC_RG32F) ? 2 : 4;
+		for (x = 0; x < width; x++) {
+			dst[4*x+1] = dst[4*x+2] = 0;
+			dst[4*x+3] = 255;
+			for (i = 0; i < n; i++)
+				dst[4*x+i] = float_to_unorm8(sf[n*x+i]);
+		}
+		break;
+	}
+	default:
+		memset(dst, 0, width * 4);
+		break;
+	}
+}
+
+/*
+ * Block compressed formats, decoded one 4x4 block at a time into the
+ * destination (with a row stride of 'stride' bytes):
+ */
+
+static uint8_t clamp8(int v)
+{
+	return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+static void decode_etc1(const uint8_t *src, uint8_t *dst, unsigned stride)
+{
+	static const int mod[8][4] = {
+			{ 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 },
+			{ 13, 42, -13, -42 }, { 18, 60, -18, -60 }, { 24, 80, -24, -80 },
+			{ 33, 106, -33, -106 }, { 47, 183, -47, -183 },
+	};
+	uint32_t hi = (src[0] << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+	uint32_t lo = (src[4] << 24) | (src[5] << 16) | (src[6] << 8) | src[7];
+	int base[2][3], table[2], flip = hi & 1;
+	unsigned x, y, c;
+
+	if (hi & 2) {
+		/* differential mode: */
+		for (c = 0; c < 3; c++) {
+			int v = (hi >> (27 - 8 * c)) & 0x1f;
+			int d = (hi >> (24 - 8 * c)) & 0x7;
+			int v2 = (v + ((d & 4) ? d - 8 : d)) & 0x1f;
+			base[0][c] = (v << 3) | (v >> 2);
+			base[1][c] = (v2 << 3) | (v2 >> 2);
+		}
+	} else {
+		for (c = 0; c < 3; c++) {
+			base[0][c] = ((hi >> (28 - 8 * c)) & 0xf) * 17;
+			base[1][c] = ((hi >> (24 - 8 * c)) & 0xf) * 17;
+		}
+	}
+
+	table[0] = (hi >> 5) & 7;
+	table[1] = (hi >> 2) & 7;
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			unsigned i = x * 4 + y;
+			unsigned idx = (((lo >> (i + 16)) & 1) << 1) | ((lo >> i) & 1);
+			int sub = flip ? (y >= 2) : (x >= 2);
+			int m = mod[table[sub]][idx];
+			uint8_t *p = dst + y * stride + x * 4;
+			for (c = 0; c < 3; c++)
+				p[c] = clamp8(base[sub][c] + m);
+			p[3] = 255;
+		}
+	}
+}
+
+static void rgb565(uint16_t v, int *rgb)
+{
+	rgb[0] = ((v >> 8) & 0xf8) | (v >> 13);
+	rgb[1] = ((v >> 3) & 0xfc) | ((v >> 9) & 0x3);
+	rgb[2] = ((v << 3) & 0xf8) | ((v >> 2) & 0x7);
+}
+
+static void decode_dxt_color(const uint8_t *src, uint8_t *dst, unsigned stride,
+		int four_color)
+{
+	uint16_t c0 = src[0] | (src[1] << 8), c1 = src[2] | (src[3] << 8);
+	uint32_t bits = src[4] | (src[5] << 8) | (src[6] << 16) | ((uint32_t)src[7] << 24);
+	int pal[4][4], c;
+	unsigned i;
+
+	rgb565(c0, pal[0]);
+	rgb565(c1, pal[1]);
+	pal[0][3] = pal[1][3] = pal[2][3] = pal[3][3] = 255;
+
+	if (four_color || (c0 > c1)) {
+		for (c = 0; c < 3; c++) {
+			pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+			pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+		}
+	} else {
+		for (c = 0; c < 3; c++) {
+			pal[2][c] = (pal[0][c] + pal[1][c]) / 2;
+			pal[3][c] = 0;
+		}
+		pal[3][3] = 0;
+	}
+
+	for (i = 0; i < 16; i++) {
+		uint8_t *p = dst + (i / 4) * stride + (i % 4) * 4;
+		int *e = pal[(bits >> (2 * i)) & 3];
+		for (c = 0; c < 4; c++)
+			p[c] = e[c];
+	}
+}
+
+static void decode_block(enum texdesc_fmt fmt, const uint8_t *src, uint8_t *dst,
+		unsigned stride)
+{
+	unsigned i;
+
+	switch (fmt) {
+	case TEXDESC_ETC1:
+		decode_etc1(src, dst, stride);
+		break;
+	case TEXDESC_DXT1:
+		decode_dxt_color(src, dst, stride, 0);
+		break;
+	case TEXDESC_DXT3:
+		decode_dxt_color(src + 8, dst, stride, 1);
+		for (i = 0; i < 16; i++)
+			dst[(i / 4) * stride + (i % 4) * 4 + 3] =
+					((src[i / 2] >> (4 * (i & 1))) & 0xf) * 17;
+		break;
+	case TEXDESC_DXT5: {
+		uint64_t bits = 0;
+		int a[8];
+
+		decode_dxt_color(src + 8, dst, stride, 1);
+
+		a[0] = src[0];
+		a[1] = src[1];
+		for (i = 2; i < 8; i++) {
+			if (a[0] > a[1])
+				a[i] = ((8 - i) * a[0] + (i - 1) * a[1]) / 7;
+			else if (i < 6)
+				a[i] = ((6 - i) * a[0] + (i - 1) * a[1]) / 5;
+			else
+				a[i] = (i == 6) ? 0 : 255;
+		}
+		for (i = 0; i < 6; i++)
+			bits |= ((uint64_t)src[2 + i]) << (8 * i);
+		for (i = 0; i < 16; i++)
+			dst[(i / 4) * stride + (i % 4) * 4 + 3] = a[(bits >> (3 * i)) & 7];
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* copy 32x32 texel tiles, stored one after the other, to a linear
+ * layout.  Each tile row is a contiguous copy of TILE * cpp bytes:
+ */
+static void detile(const uint8_t *src, uint8_t *dst, unsigned pitch,
+		unsigned width, unsigned height, unsigned cpp)
+{
+	unsigned tiles_x = (width + TILE - 1) / TILE;
+	unsigned tile_size = TILE * TILE * cpp;
+	unsigned tx, ty, y;
+
+	for (ty = 0; ty < (height + TILE - 1) / TILE; ty++) {
+		for (tx = 0; tx < tiles_x; tx++) {
+			const uint8_t *tile = src + (ty * tiles_x + tx) * tile_size;
+			unsigned w = width - tx * TILE;
+			if (w > TILE)
+				w = TILE;
+			for (y = 0; (y < TILE) && (ty * TILE + y < height); y++)
+				memcpy(dst + (ty * TILE + y) * pitch + tx * TILE * cpp,
+						tile + y * TILE * cpp, w * cpp);
+		}
+	}
+}
+
+static void export_image(struct job *job, unsigned level, unsigned layer,
+		const uint8_t *src, uint32_t avail)
+{
+	const struct texdesc *tex = &job->tex;
+	unsigned w = tex->width >> level, h = tex->height >> level;
+	unsigned bs = texdesc_fmts[tex->fmt].bs, cpp = texdesc_fmts[tex->fmt].cpp;
+	unsigned pitch = texdesc_level_pitch(tex, level);
+	unsigned bw, bh, size, x, y, i;
+	uint8_t *linear = NULL, *img, map[4];
+	uint64_t hash;
+	char name[32];
+
+	if (!w)
+		w = 1;
+	if (!h)
+		h = 1;
+
+	bw = (w + bs - 1) / bs;
+	bh = (h + bs - 1) / bs;
+	size = tex->tile_mode ? ((bw + TILE - 1) & ~(TILE - 1)) *
+			((bh + TILE - 1) & ~(TILE - 1)) * cpp : pitch * bh;
+
+	if (!src || (avail < size) || (!tex->tile_mode && (pitch < bw * cpp))) {
+		job_log(job, "draw %d %s unit %u: level %u layer %u: not in captured buffers\n",
+				job->draw, job->stage ? "fs" : "vs", job->unit, level, layer);
+		return;
+	}
+
+	/* dedupe on the source texels plus the things which affect how they
+	 * are decoded:
+	 */
+	hash = mix(((uint64_t)w << 32) | h);
+	hash = mix(hash ^ (((uint64_t)tex->fmt << 32) | (tex->swap << 12) |
+			(tex->swiz[0] << 9) | (tex->swiz[1] << 6) | (tex->swiz[2] << 3) |
+			tex->swiz[3]));
+	hash = hash_buf(hash, src, size);
+
+	snprintf(name, sizeof(name), "%016"PRIx64".bmp", hash);
+	job_log(job, "draw %d %s unit %u: %s %ux%u level %u layer %u: %s\n",
+			job->draw, job->stage ? "fs" : "vs", job->unit, texdesc_fmts[tex->fmt].name,
+			w, h, level, layer, name);
+
+	if (!claim(hash))
+		return;
+
+	if (tex->tile_mode) {
+		pitch = bw * cpp;
+		linear = malloc(pitch * bh);
+		if (!linear)
+			return;
+		detile(src, linear, pitch, bw, bh, cpp);
+		src = linear;
+	}
+
+	/* decode to components in storage order, padding the image out to
+	 * whole blocks:
+	 */
+	img = malloc(bw * bs * 4 * bh * bs);
+	if (!img) {
+		free(linear);
+		return;
+	}
+
+	for (y = 0; y < bh; y++) {
+		const uint8_t *row = src + y * pitch;
+		uint8_t *out = img + y * bs * bw * bs * 4;
+		if (bs == 1) {
+			convert_row(tex->fmt, row, out, bw);
+		} else {
+			for (x = 0; x < bw; x++)
+				decode_block(tex->fmt, row + x * cpp, out + x * bs * 4, bw * bs * 4);
+		}
+	}
+
+	/* apply swap and swizzle, and reorder to BGRA: */
+	{
+		static const uint8_t swap_src[4][4] = {
+				{ 0, 1, 2, 3 },    /* WZYX */
+				{ 2, 1, 0, 3 },    /* WXYZ */
+				{ 1, 2, 3, 0 },    /* ZYXW */
+				{ 3, 2, 1, 0 },    /* XYZW */
+		};
+		static const uint8_t bgra[4] = { 2, 1, 0, 3 };
+		unsigned stride = bw * bs * 4;
+
+		for (i = 0; i < 4; i++) {
+			unsigned s = tex->swiz[bgra[i]];
+			map[i] = (s < 4) ? swap_src[tex->swap & 3][s] : s;   /* 4: zero, 5: one */
+		}
+
+		for (y = 0; y < h; y++) {
+			uint8_t *p = img + y * stride;
+			for (x = 0; x < w; x++, p += 4) {
+				uint8_t t[6] = { p[0], p[1], p[2], p[3], 0, 255 };
+				p[0] = t[map[0]];
+				p[1] = t[map[1]];
+				p[2] = t[map[2]];
+				p[3] = t[map[3]];
+			}
+		}
+
+		{
+			char path[1024];
+			snprintf(path, sizeof(path), "%s/%s", outdir, name);
+			wrap_bmp_dump((char *)img, w, h, stride, path);
+		}
+	}
+
+	pthread_mutex_lock(&set_lock);
+	stats.written++;
+	stats.bytes += size;
+	pthread_mutex_unlock(&set_lock);
+
+	free(img);
+	free(linear);
+}
+
+static void export_job(struct job *job)
+{
+	const struct texdesc *tex = &job->tex;
+	unsigned level, layer;
+
+	for (level = 0; level < tex->levels; level++) {
+		for (layer = 0; layer < texdesc_level_layers(tex, level); layer++) {
+			uint64_t addr = texdesc_addr(tex, level, layer);
+			export_image(job, level, layer, cffdump_hostptr(addr),
+					cffdump_hostlen(addr));
+		}
+	}
+}
+
+static void * worker(void *arg)
+{
+	pthread_mutex_lock(&lock);
+	while (1) {
+		unsigned j;
+
+		while (!quit && !(running && (next_job < njobs)))
+			pthread_cond_wait(&work_cond, &lock);
+		if (quit)
+			break;
+
+		j = next_job++;
+		pthread_mutex_unlock(&lock);
+
+		export_job(&jobs[j]);
+
+		pthread_mutex_lock(&lock);
+		if (++done_jobs == njobs)
+			pthread_cond_signal(&done_cond);
+	}
+	pthread_mutex_unlock(&lock);
+
+	return NULL;
+}
+
+int texexport_open(const char *dir)
+{
+	char path[1024];
+	long n;
+	unsigned i;
+
+	if (mkdir(dir, 0755) && (errno != EEXIST))
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/index.txt", dir);
+	index_file = fopen(path, "w");
+	if (!index_file)
+		return -1;
+
+	outdir = strdup(dir);
+
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = (n < 1) ? 1 : (n > MAX_THREADS) ? MAX_THREADS : n;
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, worker, NULL)) {
+			nthreads = i;
+			break;
+		}
+	}
+
+	if (!nthreads)
+		return -1;
+
+	return 0;
+}
+
+void texexport_start_cmdstream(const char *name)
+{
+	if (!outdir)
+		return;
+
+	memset(exported, 0, sizeof(exported));
+
+	fprintf(index_file, "%s:\n", name);
+}
+
+void texexport_end_cmdstream(void)
+{
+}
+
+/* textures which can't be exported: */
+static int unsupported(const struct texdesc *tex)
+{
+	if (tex->fmt == TEXDESC_NONE)
+		return 1;
+
+	/* block compressed textures are not tiled by the blob, and the a5xx
+	 * tile modes are not known yet (a4xx TILED is assumed to be the same
+	 * as a3xx TILE_32X32):
+	 */
+	if (tex->tile_mode && ((texdesc_fmts[tex->fmt].bs > 1) || (tex->tile_mode > 1)))
+		return 1;
+
+	return 0;
+}
+
+void texexport_draw(int draw)
+{
+	unsigned stage, unit;
+
+	if (!outdir)
+		return;
+
+	for (stage = 0; stage < 2; stage++) {
+		for (unit = 0; unit < TEXDESC_MAX_UNITS; unit++) {
+			unsigned seqno = texdesc_seqno(stage, unit);
+			struct texdesc tex;
+			struct job *job;
+
+			if (!seqno || (seqno == exported[stage][unit]))
+				continue;
+
+			exported[stage][unit] = seqno;
+
+			if (texdesc_get(stage, unit, &tex))
+				continue;
+
+			stats.textures++;
+
+			if (unsupported(&tex)) {
+				stats.skipped++;
+				fprintf(index_file, "frame %d draw %d %s unit %u: unsupported "
+						"texture (fmt %u, tile mode %u)\n", submit_nr, draw,
+						stage ? "fs" : "vs", unit, tex.raw_fmt, tex.tile_mode);
+				continue;
+			}
+
+			pthread_mutex_lock(&lock);
+			if (njobs == maxjobs) {
+				maxjobs = maxjobs ? maxjobs * 2 : 64;
+				jobs = xrealloc(jobs, maxjobs * sizeof(jobs[0]));
+			}
+			job = &jobs[njobs++];
+			memset(job, 0, sizeof(*job));
+			job->tex = tex;
+			job->stage = stage;
+			job->unit = unit;
+			job->draw = draw;
+			pthread_mutex_unlock(&lock);
+		}
+	}
+}
+
+void texexport_start_submit(int submit)
+{
+	if (!outdir)
+		return;
+
+	submit_nr = submit;
+
+	/* buffers are captured again for each submit: */
+	memset(exported, 0, sizeof(exported));
+}
+
+void texexport_end_submit(void)
+{
+	unsigned i;
+
+	if (!outdir || !njobs)
+		return;
+
+	/* export the textures of this submit, before its buffers go away: */
+	pthread_mutex_lock(&lock);
+	next_job = done_jobs = 0;
+	running = 1;
+	pthread_cond_broadcast(&work_cond);
+	while (done_jobs < njobs)
+		pthread_cond_wait(&done_cond, &lock);
+	running = 0;
+	pthread_mutex_unlock(&lock);
+
+	for (i = 0; i < njobs; i++) {
+		char *line, *save;
+		if (!jobs[i].log)
+			continue;
+		for (line = strtok_r(jobs[i].log, "\n", &save); line;
+				line = strtok_r(NULL, "\n", &save)) {
+			fprintf(index_file, "frame %d %s\n", submit_nr, line);
+			stats.images++;
+		}
+		free(jobs[i].log);
+	}
+
+	njobs = 0;
+}
+
+void texexport_close(void)
+{
+	unsigned i;
+
+	if (!outdir)
+		return;
+
+	pthread_mutex_lock(&lock);
+	quit = 1;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&lock);
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("exported %u textures to %s: %u images, %u unique written "
+			"(%"PRIu64" bytes of texels), %u unsupported\n", stats.textures,
+			outdir, stats.images, stats.written, stats.bytes, stats.skipped);
+
+	fclose(index_file);
+	free(outdir);
+	outdir = NULL;
+}
@@ -0,0 +1,64 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef TEXEXPORT_H_
+#define TEXEXPORT_H_
+
+#include <stdint.h>
+
+/* Export the textures used by each draw as .bmp images, decoded from the
+ * a3xx/a4xx/a5xx texture descriptors (see texdesc.h) and converted to 8
+ * bit BGRA.
+ *
+ * Each image (mip level and layer) is written once, named after the hash
+ * of its contents, and the mapping from draw/texture unit to image is
+ * written to the index file in the same directory.
+ *
+ * Textures are collected while decoding a submit, and exported by a pool
+ * of threads at the end of the submit, while its buffers are still
+ * mapped.
+ */
+
+/* called at start to create the output directory and start the threads: */
+int texexport_open(const char *dir);
+
+/* called at start/end of each cmdstream file: */
+void texexport_start_cmdstream(const char *name);
+void texexport_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void texexport_start_submit(int submit);
+void texexport_end_submit(void);
+
+/* called at each draw: */
+void texexport_draw(int draw);
+
+/* called after last cmdstream file: */
+void texexport_close(void);
+
+#endif /* TEXEXPORT_H_ */
@@ -0,0 +1,318 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "texinv.h"
+#include "util.h"
+#include "texdesc.h"
+
+#define NTOP_FRAME   10
+#define NTOP_CAPTURE 25
+
+struct texture {
+	uint64_t key;
+	struct texdesc tex;
+	uint64_t size;
+	unsigned draws, frames;
+	unsigned frame_draws;
+	int last_draw, last_frame;
+};
+
+static int enabled;
+
+static struct texture *textures;
+static unsigned ntextures, maxtextures;
+static unsigned *tex_idx;        /* open addressing, index + 1 into textures */
+static unsigned tex_idx_size;
+
+/* textures used in the current frame: */
+static unsigned *frame_textures;
+static unsigned nframe_textures, maxframe_textures;
+
+static int submit_nr;
+
+void texinv_enable(void)
+{
+	enabled = 1;
+}
+
+/* textures are identified by their address and layout, not by the
+ * swizzle/swap (which don't change what is fetched):
+ */
+static uint64_t tex_key(const struct texdesc *tex)
+{
+	uint64_t h = mix(tex->base);
+	h = mix(h ^ (((uint64_t)tex->raw_fmt << 32) | tex->tile_mode));
+	h = mix(h ^ (((uint64_t)tex->width << 32) | tex->height));
+	h = mix(h ^ (((uint64_t)tex->depth << 32) | tex->levels));
+	h = mix(h ^ (((uint64_t)tex->pitch << 32) | tex->layersz));
+	return mix(h ^ ((tex->is_cube << 1) | tex->is_3d));
+}
+
+static void rehash(void)
+{
+	unsigned i, j;
+
+	tex_idx_size = tex_idx_size ? tex_idx_size * 2 : 256;
+	tex_idx = xrealloc(tex_idx, tex_idx_size * sizeof(tex_idx[0]));
+	memset(tex_idx, 0, tex_idx_size * sizeof(tex_idx[0]));
+
+	for (i = 0; i < ntextures; i++) {
+		for (j = textures[i].key % tex_idx_size; tex_idx[j];
+				j = (j + 1) % tex_idx_size)
+			;
+		tex_idx[j] = i + 1;
+	}
+}
+
+static struct texture * lookup(const struct texdesc *tex)
+{
+	uint64_t key = tex_key(tex);
+	struct texture *t;
+	unsigned i;
+
+	if ((ntextures * 2) >= tex_idx_size)
+		rehash();
+
+	for (i = key % tex_idx_size; tex_idx[i]; i = (i + 1) % tex_idx_size)
+		if (textures[tex_idx[i] - 1].key == key)
+			return &textures[tex_idx[i] - 1];
+
+	if (ntextures == maxtextures) {
+		maxtextures = maxtextures ? maxtextures * 2 : 64;
+		textures = xrealloc(textures, maxtextures * sizeof(textures[0]));
+	}
+
+	t = &textures[ntextures];
+	memset(t, 0, sizeof(*t));
+	t->key = key;
+	t->tex = *tex;
+	t->size = texdesc_size(tex);
+	t->last_draw = t->last_frame = -1;
+	tex_idx[i] = ++ntextures;
+
+	return t;
+}
+
+void texinv_draw(int draw)
+{
+	unsigned stage, unit;
+
+	if (!enabled)
+		return;
+
+	for (stage = 0; stage < 2; stage++) {
+		for (unit = 0; unit < TEXDESC_MAX_UNITS; unit++) {
+			struct texdesc tex;
+			struct texture *t;
+
+			if (texdesc_get(stage, unit, &tex))
+				continue;
+
+			t = lookup(&tex);
+
+			/* count each draw once, even if bound to several units: */
+			if (t->last_draw == draw)
+				continue;
+			t->last_draw = draw;
+
+			if (t->last_frame != submit_nr) {
+				t->last_frame = submit_nr;
+				t->frame_draws = 0;
+				t->frames++;
+				if (nframe_textures == maxframe_textures) {
+					maxframe_textures = maxframe_textures ? maxframe_textures * 2 : 64;
+					frame_textures = xrealloc(frame_textures,
+							maxframe_textures * sizeof(frame_textures[0]));
+				}
+				frame_textures[nframe_textures++] = t - textures;
+			}
+
+			t->frame_draws++;
+			t->draws++;
+		}
+	}
+}
+
+static const char * tiling(const struct texdesc *tex)
+{
+	static const char *modes[] = { "linear", "tiled", "tiled2", "tiled3" };
+	return modes[tex->tile_mode & 0x3];
+}
+
+static void print_texture(const struct texture *t, unsigned draws)
+{
+	const struct texdesc *tex = &t->tex;
+	const char *type = tex->is_cube ? "cube" : tex->is_3d ? "3d" : "";
+	char size[48];
+
+	if (tex->layers > 1)
+		snprintf(size, sizeof(size), "%ux%ux%u%s", tex->width, tex->height,
+				tex->layers, type);
+	else
+		snprintf(size, sizeof(size), "%ux%u%s", tex->width, tex->height, type);
+
+	printf("\t\t%016"PRIx64": %-8s %-16s %2u levels, %s, %s, %"PRIu64" bytes, "
+			"%u draws (%"PRIu64" bytes x draws)\n", tex->base,
+			texdesc_fmts[tex->fmt].name, size, tex->levels, tiling(tex),
+			(tex->fmt == TEXDESC_NONE) ? "?" :
+			(texdesc_fmts[tex->fmt].bs > 1) ? "compressed" : "uncompressed",
+			t->size, draws, t->size * draws);
+	if (tex->fmt == TEXDESC_NONE)
+		printf("\t\t\t(unknown format %u)\n", tex->raw_fmt);
+}
+
+/* sort key, for qsort(), set before sorting: */
+static int sort_capture;
+
+static uint64_t score(unsigned idx)
+{
+	const struct texture *t = &textures[idx];
+	return t->size * (sort_capture ? t->draws : t->frame_draws);
+}
+
+static int cmp_texture(const void *a, const void *b)
+{
+	uint64_t sa = score(*(const unsigned *)a), sb = score(*(const unsigned *)b);
+	return (sa < sb) ? 1 : (sa > sb) ? -1 : 0;
+}
+
+/* bytes x draws, by linear/tiled and compressed/uncompressed: */
+static void print_breakdown(const unsigned *idx, unsigned n)
+{
+	static const char *names[] = {
+			"linear uncompressed", "tiled uncompressed", "compressed", "unknown format",
+	};
+	uint64_t bytes[4] = {0}, traffic[4] = {0}, total = 0;
+	unsigned count[4] = {0};
+	unsigned i;
+
+	for (i = 0; i < n; i++) {
+		const struct texture *t = &textures[idx[i]];
+		unsigned c;
+		if (t->tex.fmt == TEXDESC_NONE)
+			c = 3;
+		else if (texdesc_fmts[t->tex.fmt].bs > 1)
+			c = 2;
+		else
+			c = t->tex.tile_mode ? 1 : 0;
+		count[c]++;
+		bytes[c] += t->size;
+		traffic[c] += score(idx[i]);
+		total += score(idx[i]);
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (!count[i])
+			continue;
+		printf("\t%-20s %5u textures, %10"PRIu64" bytes, %5.1f%% of bytes x draws\n",
+				names[i], count[i], bytes[i], pct(traffic[i], total));
+	}
+}
+
+static void report(const char *prefix, unsigned *idx, unsigned n, unsigned ntop)
+{
+	uint64_t bytes = 0;
+	unsigned i, refs = 0;
+
+	for (i = 0; i < n; i++) {
+		const struct texture *t = &textures[idx[i]];
+		bytes += t->size;
+		refs += sort_capture ? t->draws : t->frame_draws;
+	}
+
+	printf("%s%u textures, %"PRIu64" bytes, %u draw references\n",
+			prefix, n, bytes, refs);
+
+	if (!n)
+		return;
+
+	print_breakdown(idx, n);
+
+	qsort(idx, n, sizeof(idx[0]), cmp_texture);
+
+	printf("\ttop %u by bytes x draws:\n", (n < ntop) ? n : ntop);
+	for (i = 0; (i < n) && (i < ntop); i++) {
+		const struct texture *t = &textures[idx[i]];
+		print_texture(t, sort_capture ? t->draws : t->frame_draws);
+	}
+}
+
+void texinv_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	ntextures = 0;
+	if (tex_idx)
+		memset(tex_idx, 0, tex_idx_size * sizeof(tex_idx[0]));
+
+	printf("texture inventory for %s:\n", name);
+}
+
+void texinv_end_cmdstream(void)
+{
+	unsigned i, *idx;
+
+	if (!enabled)
+		return;
+
+	idx = xrealloc(NULL, (ntextures + 1) * sizeof(idx[0]));
+	for (i = 0; i < ntextures; i++)
+		idx[i] = i;
+
+	sort_capture = 1;
+	report("total: ", idx, ntextures, NTOP_CAPTURE);
+
+	free(idx);
+}
+
+void texinv_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	submit_nr = submit;
+	nframe_textures = 0;
+}
+
+void texinv_end_submit(void)
+{
+	char prefix[32];
+
+	if (!enabled)
+		return;
+
+	snprintf(prefix, sizeof(prefix), "frame %d: ", submit_nr);
+	sort_capture = 0;
+	report(prefix, frame_textures, nframe_textures, NTOP_FRAME);
+}
@@ -0,0 +1,58 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef TEXINV_H_
+#define TEXINV_H_
+
+#include <stdint.h>
+
+/* Inventory of the textures bound at each draw (see texdesc.h): format,
+ * size, mipmap levels, tiling, whether it is block compressed, its size
+ * in bytes and the number of draws which have it bound.
+ *
+ * Textures are reported per frame and per capture, sorted by size times
+ * number of draws, as an estimate of the texture traffic each one can
+ * cause, so that large linear or uncompressed textures which are used
+ * a lot are at the top.
+ */
+
+/* called at start to enable the report: */
+void texinv_enable(void);
+
+/* called at start/end of each cmdstream file: */
+void texinv_start_cmdstream(const char *name);
+void texinv_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void texinv_start_submit(int submit);
+void texinv_end_submit(void);
+
+/* called at each draw: */
+void texinv_draw(int draw);
+
+#endif /* TEXINV_H_ */
@@ -0,0 +1,286 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "timeline.h"
+
+static FILE *out;
+static int nevents;
+static int pid;
+
+/* dword clock: */
+static uint64_t ts;
+
+/* end of the last draw/blit/compute, a new draw covers everything
+ * emitted since then (ie. the state setup for that draw):
+ */
+static uint64_t last_draw_ts;
+
+#define NSTACK 32
+
+/* scopes nested deeper than the stack are not written out, but folded
+ * into the innermost tracked scope:
+ */
+static struct {
+	enum timeline_scope scope;
+	uint64_t start;
+	uint64_t gpuaddr;
+	uint32_t sizedwords;
+	uint32_t x1, y1, x2, y2;
+	int draws;
+} stack[NSTACK];
+static int depth;
+static int untracked;
+static int warned;
+
+static int nsubmit;
+
+static const char *scope_name[] = {
+		[TIMELINE_SUBMIT] = "submit",
+		[TIMELINE_IB]     = "ib",
+		[TIMELINE_BIN]    = "bin",
+};
+
+static void json_string(const char *str)
+{
+	fputc('"', out);
+	for (; str && *str; str++) {
+		unsigned char c = *str;
+		if ((c == '"') || (c == '\\'))
+			fprintf(out, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+/* start a new event record, the caller fills in the remaining fields
+ * and closes the object:
+ */
+static void event_start(const char *ph, const char *cat, const char *name,
+		uint64_t start)
+{
+	fprintf(out, "%s\n{\"ph\":\"%s\",\"pid\":%d,\"tid\":1,\"ts\":%"PRIu64",\"cat\":",
+			nevents++ ? "," : "", ph, pid, start);
+	json_string(cat);
+	fprintf(out, ",\"name\":");
+	json_string(name);
+}
+
+int timeline_open(const char *file)
+{
+	out = fopen(file, "w");
+	if (!out)
+		return -1;
+
+	/* we write a lot of small records, so use a larger buffer: */
+	setvbuf(out, NULL, _IOFBF, 1024 * 1024);
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	return 0;
+}
+
+void timeline_start_cmdstream(const char *name)
+{
+	if (!out)
+		return;
+
+	pid++;
+	ts = last_draw_ts = 0;
+	depth = untracked = 0;
+	nsubmit = 0;
+
+	event_start("M", "__metadata", "process_name", 0);
+	fprintf(out, ",\"args\":{\"name\":");
+	json_string(name);
+	fprintf(out, "}}");
+}
+
+void timeline_end_cmdstream(void)
+{
+	if (!out)
+		return;
+
+	untracked = 0;
+	while (depth > 0)
+		timeline_end(stack[depth-1].scope);
+}
+
+void timeline_advance(uint32_t sizedwords)
+{
+	ts += sizedwords;
+}
+
+/* returns zero if the scope is folded into its parent: */
+static int push(enum timeline_scope scope)
+{
+	if (depth >= NSTACK) {
+		if (!warned)
+			fprintf(stderr, "timeline: scopes nested more than %d deep, "
+					"folding the inner ones into the outer scope\n", NSTACK);
+		warned = 1;
+		untracked++;
+		return 0;
+	}
+
+	memset(&stack[depth], 0, sizeof(stack[depth]));
+	stack[depth].scope = scope;
+	stack[depth].start = ts;
+	depth++;
+
+	return 1;
+}
+
+static void pop(void)
+{
+	char name[64];
+	int i;
+
+	depth--;
+
+	i = depth;
+	switch (stack[i].scope) {
+	case TIMELINE_SUBMIT:
+		snprintf(name, sizeof(name), "submit %d", nsubmit++);
+		break;
+	case TIMELINE_IB:
+		snprintf(name, sizeof(name), "ib %016"PRIx64, stack[i].gpuaddr);
+		break;
+	case TIMELINE_BIN:
+		snprintf(name, sizeof(name), "bin %u,%u-%u,%u",
+				stack[i].x1, stack[i].y1, stack[i].x2, stack[i].y2);
+		break;
+	}
+
+	event_start("X", scope_name[stack[i].scope], name, stack[i].start);
+	fprintf(out, ",\"dur\":%"PRIu64",\"args\":{\"dwords\":%"PRIu64
+			",\"draws\":%d", ts - stack[i].start, ts - stack[i].start,
+			stack[i].draws);
+	if (stack[i].scope != TIMELINE_BIN)
+		fprintf(out, ",\"sizedwords\":%u", stack[i].sizedwords);
+	fprintf(out, "}}");
+
+	/* propagate draw count to parent: */
+	if (depth > 0)
+		stack[depth-1].draws += stack[i].draws;
+}
+
+void timeline_begin(enum timeline_scope scope, uint64_t gpuaddr,
+		uint32_t sizedwords)
+{
+	if (!out)
+		return;
+
+	if (!push(scope))
+		return;
+	stack[depth-1].gpuaddr = gpuaddr;
+	stack[depth-1].sizedwords = sizedwords;
+}
+
+void timeline_end(enum timeline_scope scope)
+{
+	if (!out)
+		return;
+
+	if (untracked > 0) {
+		untracked--;
+		return;
+	}
+
+	while (depth > 0) {
+		enum timeline_scope s = stack[depth-1].scope;
+		pop();
+		if (s == scope)
+			break;
+	}
+}
+
+void timeline_bin(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+{
+	/* a bin inside a folded scope is folded along with it: */
+	if (!out || untracked)
+		return;
+
+	if ((depth > 0) && (stack[depth-1].scope == TIMELINE_BIN))
+		pop();
+
+	if (!push(TIMELINE_BIN))
+		return;
+	stack[depth-1].x1 = x1;
+	stack[depth-1].y1 = y1;
+	stack[depth-1].x2 = x2;
+	stack[depth-1].y2 = y2;
+}
+
+void timeline_draw(const char *cat, const char *name, uint32_t num_indices,
+		int draw)
+{
+	uint64_t start = last_draw_ts;
+
+	if (!out)
+		return;
+
+	/* keep the event nested within the innermost scope: */
+	if ((depth > 0) && (start < stack[depth-1].start))
+		start = stack[depth-1].start;
+
+	event_start("X", cat, name, start);
+	fprintf(out, ",\"dur\":%"PRIu64",\"args\":{\"draw\":%d,\"num_indices\":%u}}",
+			ts - start, draw, num_indices);
+
+	if (depth > 0)
+		stack[depth-1].draws++;
+
+	last_draw_ts = ts;
+}
+
+void timeline_event(const char *name)
+{
+	if (!out)
+		return;
+
+	event_start("i", "event", name, ts);
+	fprintf(out, ",\"s\":\"t\"}");
+}
+
+void timeline_close(void)
+{
+	if (!out)
+		return;
+
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	out = NULL;
+}
@@ -0,0 +1,79 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef TIMELINE_H_
+#define TIMELINE_H_
+
+#include <stdint.h>
+
+/* Export the submit/IB/bin/draw hierarchy of a capture as a chrome
+ * trace-event JSON file (chrome://tracing, ui.perfetto.dev).
+ *
+ * The rd format has no timestamps, so the number of cmdstream dwords
+ * processed is used as the clock (one dword == one "us" in the viewer).
+ * Events are written out as each scope is closed, so memory use only
+ * depends on the nesting depth, not on the size of the capture.
+ */
+
+enum timeline_scope {
+	TIMELINE_SUBMIT,
+	TIMELINE_IB,
+	TIMELINE_BIN,
+};
+
+/* called at start to open the output file: */
+int timeline_open(const char *file);
+
+/* called at start/end of each cmdstream file: */
+void timeline_start_cmdstream(const char *name);
+void timeline_end_cmdstream(void);
+
+/* called for each packet decoded, before the packet handler runs: */
+void timeline_advance(uint32_t sizedwords);
+
+/* open/close a submit or IB scope.  Closing a scope also closes any
+ * bin scope opened within it:
+ */
+void timeline_begin(enum timeline_scope scope, uint64_t gpuaddr,
+		uint32_t sizedwords);
+void timeline_end(enum timeline_scope scope);
+
+/* CP_SET_BIN, ends the previous bin (if any) at the same level: */
+void timeline_bin(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2);
+
+/* draw/blit/compute; covers the dwords since the previous one: */
+void timeline_draw(const char *cat, const char *name, uint32_t num_indices,
+		int draw);
+
+/* CP_EVENT_WRITE and friends, emitted as instant events: */
+void timeline_event(const char *name);
+
+/* called after last cmdstream file: */
+void timeline_close(void);
+
+#endif /* TIMELINE_H_ */
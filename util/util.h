@@ -0,0 +1,132 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef UTIL_H_
+#define UTIL_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Small helpers shared by the cffdump analysis modules. */
+
+/* realloc() which exits on failure, the tools have no sensible way to
+ * continue without the memory:
+ */
+static inline void *xrealloc(void *ptr, size_t sz)
+{
+	ptr = realloc(ptr, sz);
+	if (!ptr && sz) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	return ptr;
+}
+
+/* splitmix64 finalizer, for hashing: */
+static inline uint64_t mix(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+
+/* float bits, also used by the register builders in the a3xx+ headers: */
+static inline uint32_t fui(float f)
+{
+	union { float f; uint32_t u; } v = { .f = f };
+	return v.u;
+}
+
+static inline float uif(uint32_t u)
+{
+	union { float f; uint32_t u; } v = { .u = u };
+	return v.f;
+}
+
+/* f16 <-> f32, for half registers (and the register builders again): */
+static inline float util_half_to_float(uint16_t h)
+{
+	uint32_t s = (h >> 15) << 31;
+	uint32_t e = (h >> 10) & 0x1f;
+	uint32_t m = h & 0x3ff;
+
+	if (e == 0) {
+		float f = ldexpf(m, -24);
+		return s ? -f : f;
+	} else if (e == 31) {
+		return uif(s | 0x7f800000 | (m << 13));
+	}
+
+	return uif(s | ((e + 112) << 23) | (m << 13));
+}
+
+static inline uint16_t util_float_to_half(float f)
+{
+	uint32_t u = fui(f);
+	uint32_t s = (u >> 16) & 0x8000;
+	uint32_t m = u & 0x7fffff;
+	int e = (int)((u >> 23) & 0xff) - 127 + 15;
+	uint32_t h, rem, half;
+	int shift;
+
+	if (((u >> 23) & 0xff) == 0xff)
+		return s | 0x7c00 | (m ? 0x200 : 0);
+	if (e >= 31)
+		return s | 0x7c00;
+
+	if (e <= 0) {
+		/* denormal (or zero), round to nearest even: */
+		if (e < -10)
+			return s;
+		m |= 0x800000;
+		shift = 14 - e;
+	} else {
+		m |= e << 23;
+		shift = 13;
+	}
+
+	/* rounding may carry into the exponent, which is what we want: */
+	h = m >> shift;
+	rem = m & ((1 << shift) - 1);
+	half = 1 << (shift - 1);
+	if ((rem > half) || ((rem == half) && (h & 1)))
+		h++;
+
+	return s | h;
+}
+
+/* n as a percentage of total: */
+static inline double pct(uint64_t n, uint64_t total)
+{
+	return total ? (100.0 * n) / total : 0.0;
+}
+
+#endif /* UTIL_H_ */
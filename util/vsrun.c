@@ -0,0 +1,777 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "vsrun.h"
+#include "emu-a3xx.h"
+#include "texdesc.h"
+#include "util.h"
+
+#include "adreno_common.xml.h"
+#include "adreno_pm4.xml.h"
+#include "a3xx.xml.h"
+
+uint32_t reg_val(uint32_t regbase);
+void *cffdump_hostptr(uint64_t gpuaddr);
+uint32_t cffdump_hostlen(uint64_t gpuaddr);
+
+#define W             EMU_A3XX_LANES
+#define MAX_VERTICES  (1 << 20)    /* unique vertices shaded per draw */
+#define REGID_NONE    0xfc         /* r63.x, for unused outputs */
+
+struct vsrun_stats {
+	unsigned draws, skipped;
+	uint64_t vertices, instrs;
+	uint64_t behind, outside;
+	uint64_t tris, rejected, zero_area, cw;
+	uint64_t faults, unsupported;
+	int has_bbox;
+	float bbox[4];               /* x1, y1, x2, y2 in NDC */
+};
+
+static int enabled;
+static int is_a3xx;
+static int submit_nr;
+static struct vsrun_stats frame, capture;
+
+static uint32_t *shader;
+static uint32_t shader_dwords;
+static struct emu_a3xx *emu;
+
+/* per draw: */
+static uint32_t *uniq;            /* sorted unique vertex indices */
+static float (*pos)[4];           /* clip-space position of each */
+static uint8_t *outcode;
+static uint32_t maxverts;
+static uint64_t draw_faults;
+
+/*
+ * Vertex fetch:
+ */
+
+enum kind {
+	FLOAT, HALF, FIXED, UINT, SINT, UNORM, SNORM,
+};
+
+static const struct {
+	uint8_t ncomp, bits, kind;
+} vfmts[64] = {
+#define V(fmt, n, b, k) [VFMT_ ## fmt] = { n, b, k }
+	V(32_FLOAT, 1, 32, FLOAT), V(32_32_FLOAT, 2, 32, FLOAT),
+	V(32_32_32_FLOAT, 3, 32, FLOAT), V(32_32_32_32_FLOAT, 4, 32, FLOAT),
+	V(16_FLOAT, 1, 16, HALF), V(16_16_FLOAT, 2, 16, HALF),
+	V(16_16_16_FLOAT, 3, 16, HALF), V(16_16_16_16_FLOAT, 4, 16, HALF),
+	V(32_FIXED, 1, 32, FIXED), V(32_32_FIXED, 2, 32, FIXED),
+	V(32_32_32_FIXED, 3, 32, FIXED), V(32_32_32_32_FIXED, 4, 32, FIXED),
+	V(16_SINT, 1, 16, SINT), V(16_16_SINT, 2, 16, SINT),
+	V(16_16_16_SINT, 3, 16, SINT), V(16_16_16_16_SINT, 4, 16, SINT),
+	V(16_UINT, 1, 16, UINT), V(16_16_UINT, 2, 16, UINT),
+	V(16_16_16_UINT, 3, 16, UINT), V(16_16_16_16_UINT, 4, 16, UINT),
+	V(16_SNORM, 1, 16, SNORM), V(16_16_SNORM, 2, 16, SNORM),
+	V(16_16_16_SNORM, 3, 16, SNORM), V(16_16_16_16_SNORM, 4, 16, SNORM),
+	V(16_UNORM, 1, 16, UNORM), V(16_16_UNORM, 2, 16, UNORM),
+	V(16_16_16_UNORM, 3, 16, UNORM), V(16_16_16_16_UNORM, 4, 16, UNORM),
+	V(32_UINT, 1, 32, UINT), V(32_32_UINT, 2, 32, UINT),
+	V(32_32_32_UINT, 3, 32, UINT), V(32_32_32_32_UINT, 4, 32, UINT),
+	V(32_SINT, 1, 32, SINT), V(32_32_SINT, 2, 32, SINT),
+	V(32_32_32_SINT, 3, 32, SINT), V(32_32_32_32_SINT, 4, 32, SINT),
+	V(8_UINT, 1, 8, UINT), V(8_8_UINT, 2, 8, UINT),
+	V(8_8_8_UINT, 3, 8, UINT), V(8_8_8_8_UINT, 4, 8, UINT),
+	V(8_UNORM, 1, 8, UNORM), V(8_8_UNORM, 2, 8, UNORM),
+	V(8_8_8_UNORM, 3, 8, UNORM), V(8_8_8_8_UNORM, 4, 8, UNORM),
+	V(8_SINT, 1, 8, SINT), V(8_8_SINT, 2, 8, SINT),
+	V(8_8_8_SINT, 3, 8, SINT), V(8_8_8_8_SINT, 4, 8, SINT),
+	V(8_SNORM, 1, 8, SNORM), V(8_8_SNORM, 2, 8, SNORM),
+	V(8_8_8_SNORM, 3, 8, SNORM), V(8_8_8_8_SNORM, 4, 8, SNORM),
+	/* packed, bits = 10: */
+	V(10_10_10_2_UINT, 4, 10, UINT), V(10_10_10_2_UNORM, 4, 10, UNORM),
+	V(10_10_10_2_SINT, 4, 10, SINT), V(10_10_10_2_SNORM, 4, 10, SNORM),
+	V(2_10_10_10_UINT, 4, 10, UINT), V(2_10_10_10_UNORM, 4, 10, UNORM),
+	V(2_10_10_10_SINT, 4, 10, SINT), V(2_10_10_10_SNORM, 4, 10, SNORM),
+#undef V
+};
+
+/* host pointer to size bytes at gpuaddr, or NULL: */
+static void * hostptr(uint64_t gpuaddr, uint32_t size)
+{
+	void *ptr = cffdump_hostptr(gpuaddr);
+
+	if (!ptr || (cffdump_hostlen(gpuaddr) < size))
+		return NULL;
+
+	return ptr;
+}
+
+/* decode one attribute into (up to) 4 components, as float or integer: */
+static unsigned decode_attr(const uint8_t *p, unsigned fmt, int isint,
+		uint32_t out[4])
+{
+	unsigned ncomp = vfmts[fmt].ncomp, bits = vfmts[fmt].bits;
+	unsigned kind = vfmts[fmt].kind, i;
+	int64_t v[4];
+	uint32_t max;
+
+	if (bits == 10) {
+		uint32_t packed;
+		memcpy(&packed, p, 4);
+		if (fmt >= VFMT_2_10_10_10_UINT)
+			packed = (packed >> 2) | (packed << 30);
+		for (i = 0; i < 4; i++) {
+			unsigned n = (i < 3) ? 10 : 2;
+			uint32_t x = (packed >> (10 * i)) & ((1 << n) - 1);
+			if ((kind == SINT) || (kind == SNORM))
+				v[i] = (int32_t)(x << (32 - n)) >> (32 - n);
+			else
+				v[i] = x;
+		}
+	} else {
+		for (i = 0; i < ncomp; i++) {
+			const uint8_t *c = p + i * bits / 8;
+			switch (bits) {
+			case 8:
+				v[i] = (kind == SINT || kind == SNORM) ? (int8_t)c[0] : c[0];
+				break;
+			case 16: {
+				uint16_t x;
+				memcpy(&x, c, 2);
+				v[i] = (kind == SINT || kind == SNORM) ? (int16_t)x : x;
+				break;
+			}
+			default: {
+				uint32_t x;
+				memcpy(&x, c, 4);
+				v[i] = (kind == SINT || kind == SNORM || kind == FIXED) ?
+						(int32_t)x : x;
+				break;
+			}
+			}
+		}
+	}
+
+	for (i = 0; i < ncomp; i++) {
+		max = (bits == 10) ? ((i < 3) ? 1023 : 3) : (uint32_t)((1ull << bits) - 1);
+
+		switch (kind) {
+		case FLOAT:
+			out[i] = v[i];
+			break;
+		case HALF:
+			out[i] = fui(util_half_to_float(v[i]));
+			break;
+		case FIXED:
+			out[i] = fui(v[i] / 65536.0);
+			break;
+		case UNORM:
+			out[i] = fui((float)v[i] / max);
+			break;
+		case SNORM:
+			out[i] = fui(fmaxf((float)v[i] / (max >> 1), -1.0));
+			break;
+		default:
+			out[i] = isint ? (uint32_t)v[i] : fui((float)v[i]);
+			break;
+		}
+	}
+
+	return ncomp;
+}
+
+/* fetch the attributes of one vertex into the registers of a lane: */
+static void fetch_vertex(unsigned lane, uint32_t index)
+{
+	uint32_t ctrl = reg_val(REG_A3XX_VFD_CONTROL_0);
+	unsigned ndecode = (ctrl & A3XX_VFD_CONTROL_0_STRMDECINSTRCNT__MASK) >>
+			A3XX_VFD_CONTROL_0_STRMDECINSTRCNT__SHIFT;
+	unsigned nfetch = (ctrl & A3XX_VFD_CONTROL_0_STRMFETCHINSTRCNT__MASK) >>
+			A3XX_VFD_CONTROL_0_STRMFETCHINSTRCNT__SHIFT;
+	unsigned i, c, f = 0;
+
+	index += reg_val(REG_A3XX_VFD_INDEX_OFFSET);
+
+	for (i = 0; (i < ndecode) && (f < nfetch); i++) {
+		uint32_t dec = reg_val(REG_A3XX_VFD_DECODE_INSTR(i));
+		uint32_t fetch = reg_val(REG_A3XX_VFD_FETCH_INSTR_0(f));
+		uint32_t addr = reg_val(REG_A3XX_VFD_FETCH_INSTR_1(f));
+		unsigned fmt = (dec & A3XX_VFD_DECODE_INSTR_FORMAT__MASK) >>
+				A3XX_VFD_DECODE_INSTR_FORMAT__SHIFT;
+		unsigned regid = (dec & A3XX_VFD_DECODE_INSTR_REGID__MASK) >>
+				A3XX_VFD_DECODE_INSTR_REGID__SHIFT;
+		unsigned wrmask = dec & A3XX_VFD_DECODE_INSTR_WRITEMASK__MASK;
+		unsigned shift = (dec & A3XX_VFD_DECODE_INSTR_SHIFTCNT__MASK) >>
+				A3XX_VFD_DECODE_INSTR_SHIFTCNT__SHIFT;
+		unsigned stride = (fetch & A3XX_VFD_FETCH_INSTR_0_BUFSTRIDE__MASK) >>
+				A3XX_VFD_FETCH_INSTR_0_BUFSTRIDE__SHIFT;
+		int isint = !!(dec & A3XX_VFD_DECODE_INSTR_INT);
+		uint32_t val[4] = { 0, 0, 0, isint ? 1 : fui(1.0) };
+		unsigned size = vfmts[fmt].ncomp * vfmts[fmt].bits / 8;
+		const uint8_t *p;
+
+		if (vfmts[fmt].bits == 10)
+			size = 4;
+
+		/* only instance 0 is run: */
+		if (fetch & A3XX_VFD_FETCH_INSTR_0_INSTANCED)
+			p = hostptr(addr + shift, size);
+		else
+			p = hostptr(addr + index * stride + shift, size);
+
+		if (p && size) {
+			decode_attr(p, fmt, isint, val);
+			if (((dec & A3XX_VFD_DECODE_INSTR_SWAP__MASK) >>
+					A3XX_VFD_DECODE_INSTR_SWAP__SHIFT) == ZYXW) {
+				uint32_t t = val[0];
+				val[0] = val[2];
+				val[2] = t;
+			}
+		} else {
+			draw_faults++;
+		}
+
+		for (c = 0; c < 4; c++)
+			if ((wrmask & (1 << c)) && (regid + c < EMU_A3XX_REGS))
+				emu->r[regid + c][lane] = val[c];
+
+		if (dec & A3XX_VFD_DECODE_INSTR_SWITCHNEXT)
+			f++;
+	}
+}
+
+/*
+ * Vertex shader textures, nearest sampling with clamp-to-edge of the
+ * formats which --export-textures also understands (except compressed):
+ */
+
+static float unorm(uint32_t v, unsigned bits)
+{
+	return (float)v / ((1 << bits) - 1);
+}
+
+static void texel(const struct texdesc *tex, const uint8_t *p, float c[4])
+{
+	const uint16_t *s16 = (const uint16_t *)p;
+	uint32_t v;
+	unsigned i;
+
+	c[0] = c[1] = c[2] = 0.0;
+	c[3] = 1.0;
+
+	switch (tex->fmt) {
+	case TEXDESC_R8:
+	case TEXDESC_RG8:
+	case TEXDESC_RGB8:
+	case TEXDESC_RGBA8:
+		for (i = 0; i < texdesc_fmts[tex->fmt].cpp; i++)
+			c[i] = unorm(p[i], 8);
+		break;
+	case TEXDESC_RGB565:
+		v = s16[0];
+		c[0] = unorm(v & 0x1f, 5);
+		c[1] = unorm((v >> 5) & 0x3f, 6);
+		c[2] = unorm(v >> 11, 5);
+		break;
+	case TEXDESC_RGB5A1:
+		v = s16[0];
+		c[0] = unorm(v & 0x1f, 5);
+		c[1] = unorm((v >> 5) & 0x1f, 5);
+		c[2] = unorm((v >> 10) & 0x1f, 5);
+		c[3] = v >> 15;
+		break;
+	case TEXDESC_RGBA4:
+		v = s16[0];
+		for (i = 0; i < 4; i++)
+			c[i] = unorm((v >> (4 * i)) & 0xf, 4);
+		break;
+	case TEXDESC_RGB10A2:
+		memcpy(&v, p, 4);
+		for (i = 0; i < 3; i++)
+			c[i] = unorm((v >> (10 * i)) & 0x3ff, 10);
+		c[3] = unorm(v >> 30, 2);
+		break;
+	case TEXDESC_R16F:
+	case TEXDESC_RG16F:
+	case TEXDESC_RGBA16F:
+		for (i = 0; i < texdesc_fmts[tex->fmt].cpp / 2; i++)
+			c[i] = util_half_to_float(s16[i]);
+		break;
+	case TEXDESC_R32F:
+	case TEXDESC_RG32F:
+	case TEXDESC_RGBA32F:
+		for (i = 0; i < texdesc_fmts[tex->fmt].cpp / 4; i++)
+			memcpy(&c[i], p + 4 * i, 4);
+		break;
+	default:
+		break;
+	}
+}
+
+static int clampi(int v, int lo, int hi)
+{
+	return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+static void sample(void *data, const struct emu_a3xx_tex *s, uint32_t result[4])
+{
+	struct texdesc tex;
+	unsigned level = 0, w, h, cpp, pitch, i;
+	int x, y, layer = 0;
+	const uint8_t *p;
+	uint64_t addr;
+	float c[4];
+
+	if (texdesc_get(TEXDESC_VS, s->tex, &tex) < 0)
+		return;
+
+	if ((s->opc == OPC_SAML) || (s->opc == OPC_ISAML) || (s->opc == OPC_GETSIZE)) {
+		int lod = (s->opc == OPC_GETSIZE) ? s->icoord[0] : (int)(s->lod + 0.5);
+		level = clampi(lod, 0, tex.levels - 1);
+	}
+
+	w = tex.width >> level;
+	h = tex.height >> level;
+	if (!w) w = 1;
+	if (!h) h = 1;
+
+	if (s->opc == OPC_GETSIZE) {
+		result[0] = w;
+		result[1] = h;
+		result[2] = tex.is_3d ? tex.depth >> level : tex.layers;
+		return;
+	}
+
+	cpp = texdesc_fmts[tex.fmt].cpp;
+	if (!cpp || (texdesc_fmts[tex.fmt].bs > 1) || (tex.tile_mode > 1)) {
+		emu->stats.unsupported++;
+		return;
+	}
+
+	if ((s->opc == OPC_ISAM) || (s->opc == OPC_ISAML) || (s->opc == OPC_ISAMM)) {
+		x = s->icoord[0];
+		y = s->icoord[1];
+		if (s->is_a || s->is_3d)
+			layer = s->icoord[2];
+	} else {
+		x = (int)floorf(s->coord[0] * w);
+		y = (int)floorf(s->coord[1] * h);
+		if (s->is_a)
+			layer = (int)(s->coord[2] + 0.5);
+		else if (s->is_3d)
+			layer = (int)floorf(s->coord[2] * (tex.depth >> level));
+	}
+
+	x = clampi(x, 0, w - 1);
+	y = clampi(y, 0, h - 1);
+	layer = clampi(layer, 0, texdesc_level_layers(&tex, level) - 1);
+
+	addr = texdesc_addr(&tex, level, layer);
+	pitch = texdesc_level_pitch(&tex, level);
+	if (tex.tile_mode) {
+		unsigned tiles_x = (w + TEXDESC_TILE - 1) / TEXDESC_TILE;
+		addr += ((y / TEXDESC_TILE) * tiles_x + (x / TEXDESC_TILE)) *
+				TEXDESC_TILE * TEXDESC_TILE * cpp;
+		addr += ((y % TEXDESC_TILE) * TEXDESC_TILE + (x % TEXDESC_TILE)) * cpp;
+	} else {
+		addr += y * pitch + x * cpp;
+	}
+
+	p = hostptr(addr, cpp);
+	if (!p) {
+		draw_faults++;
+		return;
+	}
+
+	texel(&tex, p, c);
+
+	for (i = 0; i < 4; i++) {
+		float v;
+
+		switch (tex.swiz[i]) {
+		case 0: case 1: case 2: case 3: v = c[tex.swiz[i]]; break;
+		case 5:  v = 1.0; break;
+		default: v = 0.0; break;
+		}
+
+		result[i] = type_float(s->type) ? fui(v) : (uint32_t)v;
+	}
+}
+
+static void * mem(void *data, uint32_t gpuaddr, uint32_t size)
+{
+	return hostptr(gpuaddr, size);
+}
+
+/*
+ * Reporting:
+ */
+
+static void accumulate(struct vsrun_stats *dst, const struct vsrun_stats *src)
+{
+	dst->draws       += src->draws;
+	dst->skipped     += src->skipped;
+	dst->vertices    += src->vertices;
+	dst->instrs      += src->instrs;
+	dst->behind      += src->behind;
+	dst->outside     += src->outside;
+	dst->tris        += src->tris;
+	dst->rejected    += src->rejected;
+	dst->zero_area   += src->zero_area;
+	dst->cw          += src->cw;
+	dst->faults      += src->faults;
+	dst->unsupported += src->unsupported;
+
+	if (src->has_bbox) {
+		if (!dst->has_bbox) {
+			memcpy(dst->bbox, src->bbox, sizeof(dst->bbox));
+			dst->has_bbox = 1;
+		} else {
+			dst->bbox[0] = fminf(dst->bbox[0], src->bbox[0]);
+			dst->bbox[1] = fminf(dst->bbox[1], src->bbox[1]);
+			dst->bbox[2] = fmaxf(dst->bbox[2], src->bbox[2]);
+			dst->bbox[3] = fmaxf(dst->bbox[3], src->bbox[3]);
+		}
+	}
+}
+
+static double ratio(uint64_t n, uint64_t d)
+{
+	return d ? (double)n / d : 0.0;
+}
+
+static void print_stats(const char *prefix, const struct vsrun_stats *s)
+{
+	printf("%s", prefix);
+	if (s->draws > 1)
+		printf("%u draws, ", s->draws);
+	printf("%"PRIu64" vertices, %.1f instrs/vertex, ", s->vertices,
+			ratio(s->instrs, s->vertices));
+	if (s->has_bbox)
+		printf("bbox %.3f,%.3f-%.3f,%.3f, ", s->bbox[0], s->bbox[1],
+				s->bbox[2], s->bbox[3]);
+	printf("%"PRIu64" behind, %"PRIu64" outside, %"PRIu64" tris: "
+			"%"PRIu64" rejected, %"PRIu64" zero-area, %"PRIu64" cw",
+			s->behind, s->outside, s->tris, s->rejected, s->zero_area, s->cw);
+	if (s->skipped)
+		printf(", %u draws skipped", s->skipped);
+	if (s->faults)
+		printf(", %"PRIu64" faults", s->faults);
+	if (s->unsupported)
+		printf(", %"PRIu64" unsupported", s->unsupported);
+	printf("\n");
+}
+
+void vsrun_enable(void)
+{
+	enabled = 1;
+}
+
+void vsrun_set_gpu(unsigned gpu_id)
+{
+	is_a3xx = (gpu_id >= 300) && (gpu_id < 400);
+}
+
+void vsrun_start_cmdstream(const char *name)
+{
+	static const struct emu_a3xx_funcs funcs = {
+			.sample = sample,
+			.mem = mem,
+	};
+
+	if (!enabled)
+		return;
+
+	if (!emu)
+		emu = emu_a3xx_new(&funcs);
+
+	memset(&capture, 0, sizeof(capture));
+	memset(emu->consts, 0, sizeof(emu->consts));
+	free(shader);
+	shader = NULL;
+	shader_dwords = 0;
+
+	printf("vertex shader report for %s:\n", name);
+}
+
+void vsrun_end_cmdstream(void)
+{
+	if (!enabled)
+		return;
+
+	if (!is_a3xx)
+		printf("total: not an a3xx capture\n");
+	else
+		print_stats("total: ", &capture);
+}
+
+void vsrun_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	submit_nr = submit;
+}
+
+void vsrun_end_submit(void)
+{
+	char prefix[32];
+
+	if (!enabled || !(frame.draws + frame.skipped))
+		return;
+
+	snprintf(prefix, sizeof(prefix), "frame %d: ", submit_nr);
+	print_stats(prefix, &frame);
+
+	accumulate(&capture, &frame);
+}
+
+void vsrun_shader(const void *buf, uint32_t sizedwords)
+{
+	if (!enabled || !is_a3xx)
+		return;
+
+	free(shader);
+	shader = malloc(sizedwords * 4);
+	memcpy(shader, buf, sizedwords * 4);
+	shader_dwords = sizedwords;
+}
+
+void vsrun_consts(uint32_t off, const uint32_t *buf, uint32_t sizedwords)
+{
+	if (!enabled || !is_a3xx || (off >= EMU_A3XX_CONSTS))
+		return;
+
+	if (sizedwords > EMU_A3XX_CONSTS - off)
+		sizedwords = EMU_A3XX_CONSTS - off;
+	memcpy(&emu->consts[off], buf, sizedwords * 4);
+}
+
+static uint32_t get_index(const void *indices, uint32_t index_size, uint32_t i)
+{
+	if (!indices)
+		return i;
+
+	switch (index_size) {
+	case 1:  return ((const uint8_t *)indices)[i];
+	case 2:  return ((const uint16_t *)indices)[i];
+	default: return ((const uint32_t *)indices)[i];
+	}
+}
+
+static int cmp_index(const void *a, const void *b)
+{
+	uint32_t ia = *(const uint32_t *)a, ib = *(const uint32_t *)b;
+	return (ia > ib) - (ia < ib);
+}
+
+static uint32_t lookup(uint32_t nuniq, uint32_t idx)
+{
+	uint32_t *p = bsearch(&idx, uniq, nuniq, sizeof(uniq[0]), cmp_index);
+	return p - uniq;
+}
+
+/* run the shader over the unique vertices, W at a time.  Returns -1
+ * (with the reason in emu->error) if the shader could not be run:
+ */
+static int shade(struct vsrun_stats *s, uint32_t nuniq)
+{
+	unsigned posregid = reg_val(REG_A3XX_SP_VS_PARAM_REG) &
+			A3XX_SP_VS_PARAM_REG_POSREGID__MASK;
+	uint64_t lane_instrs = emu->stats.lane_instrs;
+	uint64_t unsupported = emu->stats.unsupported;
+	uint32_t base, l, c;
+
+	for (base = 0; base < nuniq; base += W) {
+		unsigned n = (nuniq - base < W) ? nuniq - base : W;
+
+		emu_a3xx_reset(emu);
+		for (l = 0; l < n; l++)
+			fetch_vertex(l, uniq[base + l]);
+
+		if (emu_a3xx_run(emu, shader, shader_dwords, (1u << n) - 1) < 0)
+			return -1;
+
+		for (l = 0; l < n; l++) {
+			for (c = 0; c < 4; c++) {
+				pos[base + l][c] = (posregid + c < EMU_A3XX_REGS) ?
+						uif(emu->r[posregid + c][l]) : 0.0;
+			}
+		}
+	}
+
+	s->instrs = emu->stats.lane_instrs - lane_instrs;
+	s->unsupported = emu->stats.unsupported - unsupported;
+
+	return 0;
+}
+
+/* view volume tests, a bit per clip plane: */
+static uint8_t clip(const float *v)
+{
+	return ((v[0] < -v[3]) << 0) | ((v[0] > v[3]) << 1) |
+			((v[1] < -v[3]) << 2) | ((v[1] > v[3]) << 3) |
+			((v[2] < -v[3]) << 4) | ((v[2] > v[3]) << 5);
+}
+
+static void triangle(struct vsrun_stats *s, uint32_t a, uint32_t b, uint32_t c)
+{
+	float area;
+
+	s->tris++;
+
+	if (outcode[a] & outcode[b] & outcode[c]) {
+		s->rejected++;
+		return;
+	}
+
+	if ((pos[a][3] <= 0.0) || (pos[b][3] <= 0.0) || (pos[c][3] <= 0.0))
+		return;
+
+	area = (pos[b][0] / pos[b][3] - pos[a][0] / pos[a][3]) *
+			(pos[c][1] / pos[c][3] - pos[a][1] / pos[a][3]) -
+			(pos[c][0] / pos[c][3] - pos[a][0] / pos[a][3]) *
+			(pos[b][1] / pos[b][3] - pos[a][1] / pos[a][3]);
+
+	if (area == 0.0)
+		s->zero_area++;
+	else if (area < 0.0)
+		s->cw++;
+}
+
+void vsrun_draw(int draw, uint32_t prim_type, const void *indices,
+		uint32_t index_size, uint32_t num_indices)
+{
+	struct vsrun_stats s = {0};
+	uint32_t i, n, nuniq;
+	uint32_t *map;
+
+	if (!enabled || !is_a3xx || !num_indices)
+		return;
+
+	if (!shader) {
+		printf("draw %d: no vertex shader\n", draw);
+		frame.skipped++;
+		return;
+	}
+
+	n = num_indices;
+	if (n > maxverts) {
+		maxverts = n;
+		uniq = realloc(uniq, maxverts * sizeof(uniq[0]));
+		pos = realloc(pos, maxverts * sizeof(pos[0]));
+		outcode = realloc(outcode, maxverts * sizeof(outcode[0]));
+	}
+
+	for (i = 0; i < n; i++)
+		uniq[i] = get_index(indices, index_size, i);
+	qsort(uniq, n, sizeof(uniq[0]), cmp_index);
+	for (i = nuniq = 0; i < n; i++)
+		if (!i || (uniq[i] != uniq[i - 1]))
+			uniq[nuniq++] = uniq[i];
+
+	if (nuniq > MAX_VERTICES) {
+		printf("draw %d: too many vertices (%u)\n", draw, nuniq);
+		frame.skipped++;
+		return;
+	}
+
+	draw_faults = 0;
+	if (shade(&s, nuniq) < 0) {
+		printf("draw %d: vertex shader: %s\n", draw, emu->error);
+		frame.skipped++;
+		return;
+	}
+	s.faults = draw_faults;
+
+	s.draws = 1;
+	s.vertices = nuniq;
+
+	for (i = 0; i < nuniq; i++) {
+		const float *v = pos[i];
+
+		outcode[i] = clip(v);
+		if (outcode[i])
+			s.outside++;
+
+		if (v[3] <= 0.0) {
+			s.behind++;
+			continue;
+		}
+
+		if (!s.has_bbox) {
+			s.bbox[0] = s.bbox[2] = v[0] / v[3];
+			s.bbox[1] = s.bbox[3] = v[1] / v[3];
+			s.has_bbox = 1;
+		} else {
+			s.bbox[0] = fminf(s.bbox[0], v[0] / v[3]);
+			s.bbox[1] = fminf(s.bbox[1], v[1] / v[3]);
+			s.bbox[2] = fmaxf(s.bbox[2], v[0] / v[3]);
+			s.bbox[3] = fmaxf(s.bbox[3], v[1] / v[3]);
+		}
+	}
+
+	/* index -> unique vertex, reusing the sorted list for the lookups: */
+	map = malloc(n * sizeof(map[0]));
+	for (i = 0; i < n; i++)
+		map[i] = lookup(nuniq, get_index(indices, index_size, i));
+
+	switch (prim_type) {
+	case DI_PT_TRILIST:
+		for (i = 0; i + 2 < n; i += 3)
+			triangle(&s, map[i], map[i + 1], map[i + 2]);
+		break;
+	case DI_PT_TRISTRIP:
+		for (i = 0; i + 2 < n; i++) {
+			if (i & 1)
+				triangle(&s, map[i + 1], map[i], map[i + 2]);
+			else
+				triangle(&s, map[i], map[i + 1], map[i + 2]);
+		}
+		break;
+	case DI_PT_TRIFAN:
+		for (i = 1; i + 1 < n; i++)
+			triangle(&s, map[0], map[i], map[i + 1]);
+		break;
+	default:
+		break;
+	}
+
+	free(map);
+
+	{
+		char prefix[32];
+		snprintf(prefix, sizeof(prefix), "draw %d: ", draw);
+		print_stats(prefix, &s);
+	}
+
+	accumulate(&frame, &s);
+}
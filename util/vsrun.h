@@ -0,0 +1,74 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef VSRUN_H_
+#define VSRUN_H_
+
+#include <stdint.h>
+
+/* Runs the a3xx vertex shader of each draw on the cpu (see emu-a3xx.h),
+ * over the vertex attributes as fetched per the VFD_FETCH_INSTR and
+ * VFD_DECODE_INSTR state, EMU_A3XX_LANES vertices at a time.  From the
+ * clip-space positions it reports, per draw, frame and capture:
+ *
+ *   vertices    - unique vertices shaded, and instructions per vertex
+ *   bbox        - the NDC bounding box of the vertices in front of the eye
+ *   behind      - vertices with w <= 0
+ *   outside     - vertices outside of the view volume
+ *   rejected    - triangles completely outside one of the clip planes
+ *   zero-area   - triangles with no area after projection
+ *   cw          - clockwise (ie. back-facing in GL's default) triangles
+ *
+ * Vertex shader textures are sampled (nearest) from the captured buffers.
+ */
+
+/* called at start to enable the report: */
+void vsrun_enable(void);
+
+/* called once the gpu_id is known: */
+void vsrun_set_gpu(unsigned gpu_id);
+
+/* called at start/end of each cmdstream file: */
+void vsrun_start_cmdstream(const char *name);
+void vsrun_end_cmdstream(void);
+
+/* called at start/end of each submit: */
+void vsrun_start_submit(int submit);
+void vsrun_end_submit(void);
+
+/* vertex shader uploaded: */
+void vsrun_shader(const void *buf, uint32_t sizedwords);
+
+/* vertex shader constants uploaded, offset and size in dwords: */
+void vsrun_consts(uint32_t off, const uint32_t *buf, uint32_t sizedwords);
+
+/* called at each draw, indices is NULL for auto-index draws: */
+void vsrun_draw(int draw, uint32_t prim_type, const void *indices,
+		uint32_t index_size, uint32_t num_indices);
+
+#endif /* VSRUN_H_ */
@@ -0,0 +1,284 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "vtxcache.h"
+#include "util.h"
+#include "adreno_pm4.xml.h"
+
+enum policy {
+	POLICY_FIFO,
+	POLICY_LRU,
+};
+
+struct vtxcache_stats {
+	unsigned draws;
+	uint64_t indices, tris, unique, misses;
+	uint64_t stride;         /* sum of |index delta| between misses */
+	uint64_t nstride;
+};
+
+static int enabled;
+static enum policy policy;
+static unsigned size, config_size;
+static int submit_nr;
+static struct vtxcache_stats frame, capture;
+
+static uint32_t cache[256];
+static unsigned ncache, head;
+
+static uint32_t *sorted;
+static uint32_t maxsorted;
+
+/* post-transform cache size, by generation.  These are best guesses,
+ * use "fifo:N"/"lru:N" to override:
+ */
+static unsigned default_size(unsigned gpu_id)
+{
+	if (gpu_id >= 400)
+		return 32;
+	return 16;
+}
+
+int vtxcache_enable(const char *config)
+{
+	const char *p = strchr(config, ':');
+	int len = p ? p - config : strlen(config);
+
+	if (!strncmp(config, "fifo", len) && (len == 4))
+		policy = POLICY_FIFO;
+	else if (!strncmp(config, "lru", len) && (len == 3))
+		policy = POLICY_LRU;
+	else
+		return -1;
+
+	if (p) {
+		config_size = strtoul(p + 1, NULL, 0);
+		if (!config_size || (config_size > (sizeof(cache) / sizeof(cache[0]))))
+			return -1;
+	}
+
+	/* until the gpu_id is known, if the capture has one: */
+	size = config_size ? config_size : default_size(0);
+
+	enabled = 1;
+	return 0;
+}
+
+void vtxcache_set_gpu(unsigned gpu_id)
+{
+	size = config_size ? config_size : default_size(gpu_id);
+}
+
+static void accumulate(struct vtxcache_stats *dst, const struct vtxcache_stats *src)
+{
+	dst->draws   += src->draws;
+	dst->indices += src->indices;
+	dst->tris    += src->tris;
+	dst->unique  += src->unique;
+	dst->misses  += src->misses;
+	dst->stride  += src->stride;
+	dst->nstride += src->nstride;
+}
+
+static double ratio(uint64_t n, uint64_t d)
+{
+	return d ? (double)n / d : 0.0;
+}
+
+static void print_stats(const char *prefix, const struct vtxcache_stats *s)
+{
+	printf("%s%u draws, %"PRIu64" indices, %"PRIu64" tris, %.1f%% unique, "
+			"ACMR %.3f, ATVR %.3f, fetch stride %.1f\n", prefix, s->draws,
+			s->indices, s->tris, 100.0 * ratio(s->unique, s->indices),
+			ratio(s->misses, s->tris), ratio(s->misses, s->unique),
+			ratio(s->stride, s->nstride));
+}
+
+void vtxcache_start_cmdstream(const char *name)
+{
+	if (!enabled)
+		return;
+
+	memset(&capture, 0, sizeof(capture));
+	printf("vertex cache report for %s (%s):\n", name,
+			(policy == POLICY_FIFO) ? "fifo" : "lru");
+}
+
+void vtxcache_end_cmdstream(void)
+{
+	if (!enabled)
+		return;
+
+	print_stats("total: ", &capture);
+}
+
+void vtxcache_start_submit(int submit)
+{
+	if (!enabled)
+		return;
+
+	memset(&frame, 0, sizeof(frame));
+	submit_nr = submit;
+}
+
+void vtxcache_end_submit(void)
+{
+	char prefix[32];
+
+	if (!enabled || !frame.draws)
+		return;
+
+	snprintf(prefix, sizeof(prefix), "frame %d: ", submit_nr);
+	print_stats(prefix, &frame);
+
+	accumulate(&capture, &frame);
+}
+
+/* returns 1 on a cache miss: */
+static int lookup(uint32_t idx)
+{
+	unsigned i;
+
+	for (i = 0; i < ncache; i++) {
+		if (cache[i] == idx) {
+			if (policy == POLICY_LRU) {
+				/* move to front: */
+				memmove(&cache[1], &cache[0], i * sizeof(cache[0]));
+				cache[0] = idx;
+			}
+			return 0;
+		}
+	}
+
+	if (policy == POLICY_LRU) {
+		if (ncache < size)
+			ncache++;
+		memmove(&cache[1], &cache[0], (ncache - 1) * sizeof(cache[0]));
+		cache[0] = idx;
+	} else {
+		if (ncache < size) {
+			cache[ncache++] = idx;
+		} else {
+			cache[head] = idx;
+			head = (head + 1) % size;
+		}
+	}
+
+	return 1;
+}
+
+static uint32_t get_index(const void *indices, uint32_t index_size, uint32_t i)
+{
+	switch (index_size) {
+	case 1:  return ((const uint8_t *)indices)[i];
+	case 2:  return ((const uint16_t *)indices)[i];
+	default: return ((const uint32_t *)indices)[i];
+	}
+}
+
+static int cmp_index(const void *a, const void *b)
+{
+	uint32_t ia = *(const uint32_t *)a, ib = *(const uint32_t *)b;
+	return (ia > ib) - (ia < ib);
+}
+
+void vtxcache_draw(int draw, uint32_t prim_type, const void *indices,
+		uint32_t index_size, uint32_t num_indices)
+{
+	struct vtxcache_stats s = {0};
+	uint32_t i, last = 0;
+
+	if (!enabled || !indices || !num_indices || !size)
+		return;
+
+	switch (prim_type) {
+	case DI_PT_TRILIST:
+		s.tris = num_indices / 3;
+		break;
+	case DI_PT_TRIFAN:
+	case DI_PT_TRISTRIP:
+		s.tris = (num_indices >= 3) ? num_indices - 2 : 0;
+		break;
+	case DI_PT_TRI_ADJ:
+		s.tris = num_indices / 6;
+		break;
+	case DI_PT_TRISTRIP_ADJ:
+		s.tris = (num_indices >= 6) ? (num_indices - 4) / 2 : 0;
+		break;
+	default:
+		/* only triangles are interesting here */
+		return;
+	}
+
+	if (!s.tris)
+		return;
+
+	/* the cache is not preserved across draws: */
+	ncache = head = 0;
+
+	if (num_indices > maxsorted) {
+		maxsorted = num_indices;
+		sorted = xrealloc(sorted, maxsorted * sizeof(sorted[0]));
+	}
+
+	for (i = 0; i < num_indices; i++) {
+		uint32_t idx = get_index(indices, index_size, i);
+
+		sorted[i] = idx;
+
+		if (lookup(idx)) {
+			if (s.misses) {
+				s.stride += (idx > last) ? idx - last : last - idx;
+				s.nstride++;
+			}
+			last = idx;
+			s.misses++;
+		}
+	}
+
+	qsort(sorted, num_indices, sizeof(sorted[0]), cmp_index);
+	for (i = 0; i < num_indices; i++)
+		if (!i || (sorted[i] != sorted[i - 1]))
+			s.unique++;
+
+	s.draws = 1;
+	s.indices = num_indices;
+
+	printf("draw %d: %u indices, %"PRIu64" tris, %"PRIu64" unique (%.1f%%), "
+			"ACMR %.3f, ATVR %.3f, fetch stride %.1f\n", draw, num_indices,
+			s.tris, s.unique, 100.0 * ratio(s.unique, num_indices),
+			ratio(s.misses, s.tris), ratio(s.misses, s.unique),
+			ratio(s.stride, s.nstride));
+
+	accumulate(&frame, &s);
+}
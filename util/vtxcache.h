@@ -0,0 +1,68 @@
+/* -*- mode: C; c-file-style: "k&r"; tab-width 4; indent-tabs-mode: t; -*- */
+
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Authors:
+ *    agent <agent@local>
+ */
+
+#ifndef VTXCACHE_H_
+#define VTXCACHE_H_
+
+#include <stdint.h>
+
+/* Post-transform vertex cache simulation for indexed draws.
+ *
+ * Each indexed triangle draw is run through a model of the vertex
+ * cache (FIFO or LRU replacement), to report per draw and per frame:
+ *
+ *   ACMR - average cache miss ratio, vertex shader invocations per
+ *          triangle (0.5 is ideal for a regular grid, 3.0 is worst)
+ *   ATVR - average transformed vertex ratio, vertex shader invocations
+ *          per unique vertex (1.0 is ideal)
+ *   the fraction of indices which reference unique vertices, and the
+ *   average index distance between consecutive vertex fetches (cache
+ *   misses), as a measure of vertex fetch locality.
+ */
+
+/* called at start to enable the report, with "fifo" or "lru", with an
+ * optional ":size".  The default size depends on the generation:
+ */
+int vtxcache_enable(const char *config);
+
+/* called at start/end of each cmdstream file: */
+void vtxcache_start_cmdstream(const char *name);
+void vtxcache_end_cmdstream(void);
+
+/* called when the gpu_id is known: */
+void vtxcache_set_gpu(unsigned gpu_id);
+
+/* called at start/end of each submit: */
+void vtxcache_start_submit(int submit);
+void vtxcache_end_submit(void);
+
+/* called for each indexed draw, index_size in bytes (1, 2 or 4): */
+void vtxcache_draw(int draw, uint32_t prim_type, const void *indices,
+		uint32_t index_size, uint32_t num_indices);
+
+#endif /* VTXCACHE_H_ */
@@ -21,9 +21,22 @@
  * SOFTWARE.
  */
 
+/*
+ * Dump z180 (2d core) cmdstream captures:
+ *
+ *   zdump [--summary] file.rd[.gz]...
+ *
+ * Use "-" to read from stdin.  After each cmdstream, and at the end of
+ * each file, a cost report of the blits is printed (pixels filled and
+ * copied, bytes moved, and the formats/blend/rop state they used), to
+ * compare against doing the same thing on the 3d core.  With --summary
+ * only the cost reports are printed.
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,21 +44,207 @@
 #include <string.h>
 
 #include "redump.h"
+#include "io.h"
 
 #include "freedreno_z1xx.h"
 
+/* only print the 2d cost report, not the register writes: */
+static int summary;
+
+/* last value written to each register: */
+static uint32_t regvals[0xff+1];
+
+static const struct {
+	const char *name;
+	unsigned bpp;   /* bits per pixel */
+} formats[16] = {
+		[G2D_1]         = { "1",         1 },
+		[G2D_1BW]       = { "1BW",       1 },
+		[G2D_4]         = { "4",         4 },
+		[G2D_8]         = { "8",         8 },
+		[G2D_4444]      = { "4444",      16 },
+		[G2D_1555]      = { "1555",      16 },
+		[G2D_0565]      = { "0565",      16 },
+		[G2D_8888]      = { "8888",      32 },
+		[G2D_YUY2]      = { "YUY2",      16 },
+		[G2D_UYVY]      = { "UYVY",      16 },
+		[G2D_YVYU]      = { "YVYU",      16 },
+		[G2D_4444_RGBA] = { "4444_RGBA", 16 },
+		[G2D_5551_RGBA] = { "5551_RGBA", 16 },
+		[G2D_8888_RGBA] = { "8888_RGBA", 32 },
+		[G2D_A8]        = { "A8",        8 },
+};
+
+static const char *format_name(uint32_t fmt)
+{
+	return formats[fmt].name ? formats[fmt].name : "unknown";
+}
+
+/* format lives in bits 12..15 of G2D_CFG0 and GRADW_TEXCFG: */
+static uint32_t cfg_format(uint32_t cfg)
+{
+	return (cfg >> 12) & 0xf;
+}
+
+/*
+ * 2d cost accounting.  A blit is a rectangle written via G2D_XY +
+ * G2D_WIDTHHEIGHT.  It is counted once the rectangle is complete,
+ * which is when G2D_COLOR is written (solid fill), the next rectangle
+ * is started, or at G2D_IDLE / end of cmdstream.  Whether it is a
+ * fill or a copy is decided by the G2D_INPUT/G2D_CONFIG state at that
+ * point.
+ */
+
+struct hist {
+	uint32_t val;
+	unsigned blits;
+	uint64_t pixels;
+};
+
+#define MAX_HIST 16
+
+struct cost {
+	unsigned fills, copies;
+	uint64_t fill_pixels, copy_pixels;
+	uint64_t bytes_read, bytes_written;
+	struct hist dst_formats[MAX_HIST], src_formats[MAX_HIST];
+	struct hist blend[MAX_HIST], rop[MAX_HIST];
+	int ndst_formats, nsrc_formats, nblend, nrop;
+};
+
+static struct cost stream_cost, file_cost;
+
+/* rectangle written but not yet counted: */
+static int pending;
+
+static void hist_add(struct hist *h, int *n, uint32_t val, uint64_t pixels)
+{
+	int i;
+
+	for (i = 0; i < *n; i++)
+		if (h[i].val == val)
+			break;
+
+	if (i == *n) {
+		/* lump everything past the table size into the last entry: */
+		if (*n == MAX_HIST)
+			i = MAX_HIST - 1;
+		else
+			h[(*n)++] = (struct hist){ .val = val };
+	}
+
+	h[i].blits++;
+	h[i].pixels += pixels;
+}
+
+static void cost_add(struct cost *c, int copy, uint64_t pixels)
+{
+	uint32_t dst_fmt = cfg_format(regvals[G2D_CFG0]);
+	uint32_t src_fmt = cfg_format(regvals[GRADW_TEXCFG]);
+	uint32_t blend = regvals[G2D_BLENDERCFG];
+
+	if (copy) {
+		c->copies++;
+		c->copy_pixels += pixels;
+		c->bytes_read += pixels * formats[src_fmt].bpp / 8;
+		hist_add(c->src_formats, &c->nsrc_formats, src_fmt, pixels);
+	} else {
+		c->fills++;
+		c->fill_pixels += pixels;
+	}
+
+	/* blending needs to read back the destination: */
+	if (blend & G2D_BLENDERCFG_ENABLE)
+		c->bytes_read += pixels * formats[dst_fmt].bpp / 8;
+	c->bytes_written += pixels * formats[dst_fmt].bpp / 8;
+
+	hist_add(c->dst_formats, &c->ndst_formats, dst_fmt, pixels);
+	hist_add(c->blend, &c->nblend, blend, pixels);
+	hist_add(c->rop, &c->nrop, regvals[G2D_ROP], pixels);
+}
+
+static void flush_blit(void)
+{
+	uint32_t wh = regvals[G2D_WIDTHHEIGHT];
+	uint64_t pixels = (uint64_t)((wh >> 16) & 0xfff) * (wh & 0xfff);
+	uint32_t input = regvals[G2D_INPUT];
+	int copy;
+
+	if (!pending)
+		return;
+	pending = 0;
+
+	copy = (input & (G2D_INPUT_SCOORD1 | G2D_INPUT_COPYCOORD)) ||
+			(regvals[G2D_CONFIG] & G2D_CONFIG_SRC1);
+
+	cost_add(&stream_cost, copy, pixels);
+	cost_add(&file_cost, copy, pixels);
+}
+
+static void dump_hist(const char *name, struct hist *h, int n, int fmt)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (fmt)
+			printf("\t%-12s%-10s", i ? "" : name, format_name(h[i].val));
+		else
+			printf("\t%-12s%08x  ", i ? "" : name, h[i].val);
+		printf("%6u blits, %10"PRIu64" pixels\n", h[i].blits, h[i].pixels);
+	}
+}
+
+static void dump_cost(const char *name, struct cost *c)
+{
+	uint64_t pixels = c->fill_pixels + c->copy_pixels;
+
+	printf("2D cost (%s):\n", name);
+	printf("\tfills:      %6u blits, %10"PRIu64" pixels\n",
+			c->fills, c->fill_pixels);
+	printf("\tcopies:     %6u blits, %10"PRIu64" pixels\n",
+			c->copies, c->copy_pixels);
+	printf("\tbytes:      %"PRIu64" read, %"PRIu64" written",
+			c->bytes_read, c->bytes_written);
+	if (pixels)
+		printf(" (%.2f bytes/pixel)", (double)(c->bytes_read +
+				c->bytes_written) / pixels);
+	printf("\n");
+	dump_hist("dst format:", c->dst_formats, c->ndst_formats, 1);
+	dump_hist("src format:", c->src_formats, c->nsrc_formats, 1);
+	dump_hist("blendercfg:", c->blend, c->nblend, 0);
+	dump_hist("rop:", c->rop, c->nrop, 0);
+}
+
 static void reg_hex(const char *name, uint32_t dword)
 {
 	printf("\t%s: %08x (%d)\n", name, dword, dword);
 }
 
+static void reg_xy(const char *name, uint32_t dword)
+{
+	printf("\t%s: %08x (%u, %u)\n", name, dword,
+			(dword >> 16) & 0xfff, dword & 0xfff);
+}
+
+static void reg_cfg(const char *name, uint32_t dword)
+{
+	printf("\t%s: %08x (pitch=%u, format=%s)\n", name, dword,
+			(dword & 0xfff) * 32, format_name(cfg_format(dword)));
+}
+
+static void reg_texsize(const char *name, uint32_t dword)
+{
+	printf("\t%s: %08x (%ux%u)\n", name, dword,
+			dword & 0x7ff, (dword >> 13) & 0xfff);
+}
+
 static const struct {
 	const char *name;
 	void (*dump)(const char *name, uint32_t dword);
 } regs[0xff+1] = {
 #define REG(name, fxn) [name] = { #name, (fxn) }
 		REG(G2D_BASE0, reg_hex),
-		REG(G2D_CFG0, reg_hex),
+		REG(G2D_CFG0, reg_cfg),
 		REG(G2D_CFG1, reg_hex),
 		REG(G2D_SCISSORX, reg_hex),
 		REG(G2D_SCISSORY, reg_hex),
@@ -66,10 +265,10 @@ static const struct {
 		REG(G2D_CONST6, reg_hex),
 		REG(G2D_CONST7, reg_hex),
 		REG(G2D_GRADIENT, reg_hex),
-		REG(G2D_XY, reg_hex),
-		REG(G2D_WIDTHHEIGHT, reg_hex),
-		REG(G2D_SXY, reg_hex),
-		REG(G2D_SXY2, reg_hex),
+		REG(G2D_XY, reg_xy),
+		REG(G2D_WIDTHHEIGHT, reg_xy),
+		REG(G2D_SXY, reg_xy),
+		REG(G2D_SXY2, reg_xy),
 		REG(G2D_IDLE, reg_hex),
 		REG(G2D_COLOR, reg_hex),
 		REG(G2D_BLEND_A0, reg_hex),
@@ -107,8 +306,8 @@ static const struct {
 		REG(GRADW_CONST9, reg_hex),
 		REG(GRADW_CONSTA, reg_hex),
 		REG(GRADW_CONSTB, reg_hex),
-		REG(GRADW_TEXCFG, reg_hex),
-		REG(GRADW_TEXSIZE, reg_hex),
+		REG(GRADW_TEXCFG, reg_cfg),
+		REG(GRADW_TEXSIZE, reg_texsize),
 		REG(GRADW_TEXBASE, reg_hex),
 		REG(GRADW_TEXCFG2, reg_hex),
 		REG(GRADW_INST0, reg_hex),
@@ -122,8 +321,22 @@ static const struct {
 #undef REG
 };
 
-static void dump_register(uint32_t reg, uint32_t dword)
+static void write_register(uint32_t reg, uint32_t dword)
 {
+	/* a new rectangle, or an idle, completes the previous blit: */
+	if ((reg == G2D_XY) || (reg == G2D_IDLE))
+		flush_blit();
+
+	regvals[reg] = dword;
+
+	if (reg == G2D_WIDTHHEIGHT)
+		pending = 1;
+	else if (reg == G2D_COLOR)
+		flush_blit();
+
+	if (summary)
+		return;
+
 	if (regs[reg].name)
 		regs[reg].dump(regs[reg].name, dword);
 	else
@@ -133,20 +346,27 @@ static void dump_register(uint32_t reg, uint32_t dword)
 static void dump_cmdstream(uint32_t *dwords, uint32_t sizedwords)
 {
 	int i, j;
+
+	memset(&stream_cost, 0, sizeof(stream_cost));
+	pending = 0;
+
 	for (i = 0; i < sizedwords; i++) {
 		uint32_t dword = dwords[i];
 		uint32_t reg = dword >> 24;
 		if (reg == VGV3_WRITERAW) {
 			uint32_t count = (dword >> 8) & 0xffff;
 			reg = dword & 0xff;
-			for (j = 0; (j < count) && (i < sizedwords); j++) {
-				dump_register(reg, dwords[++i]);
-				reg++;
+			for (j = 0; (j < count) && ((i + 1) < sizedwords); j++) {
+				write_register(reg, dwords[++i]);
+				reg = (reg + 1) & 0xff;
 			}
 		} else {
-			dump_register(reg, dword & 0x00ffffff);
+			write_register(reg, dword & 0x00ffffff);
 		}
 	}
+
+	flush_blit();
+	dump_cost("cmdstream", &stream_cost);
 }
 
 static const char *param_names[] = {
@@ -175,51 +395,103 @@ static const char *param_names[] = {
 		"",
 };
 
-static void dump_file(int fd)
+static int dump_file(const char *filename)
 {
 	enum rd_sect_type type = RD_NONE;
+	struct io *io;
 	void *buf = NULL;
-	int sz;
+	uint32_t arr[2];
+	int sz, ret;
+
+	if (!strcmp(filename, "-"))
+		io = io_openfd(0);
+	else
+		io = io_open(filename);
+
+	if (!io) {
+		fprintf(stderr, "could not open: %s\n", filename);
+		return -1;
+	}
+
+	memset(regvals, 0, sizeof(regvals));
+	memset(&file_cost, 0, sizeof(file_cost));
+
+	while (1) {
+		ret = io_readn(io, arr, 8);
+		if (ret <= 0)
+			break;
+
+		/* skip the ~0 markers libwrap writes in front of each section: */
+		while ((ret == 8) && (arr[0] == 0xffffffff) && (arr[1] == 0xffffffff))
+			ret = io_readn(io, arr, 8);
+
+		if (ret <= 0)
+			break;
+
+		type = arr[0];
+		sz = arr[1];
+
+		if ((ret != 8) || (sz < 0)) {
+			fprintf(stderr, "%s: bad section header at offset %"PRIu64"\n",
+					filename, io_offset(io) - ret);
+			break;
+		}
 
-	while ((read(fd, &type, sizeof(type)) > 0) && (read(fd, &sz, 4) > 0)) {
 		free(buf);
 
 		buf = malloc(sz + 1);
 		((char *)buf)[sz] = '\0';
-		read(fd, buf, sz);
+		ret = io_readn(io, buf, sz);
+		if (ret != sz) {
+			fprintf(stderr, "%s: truncated section (%d of %d bytes)\n",
+					filename, ret < 0 ? 0 : ret, sz);
+			break;
+		}
 
 		switch(type) {
 		case RD_TEST:
-			printf("test: %s\n", (char *)buf);
+			if (!summary)
+				printf("test: %s\n", (char *)buf);
 			break;
 		case RD_CMD:
-			printf("cmd: %s\n", (char *)buf);
+			if (!summary)
+				printf("cmd: %s\n", (char *)buf);
 			break;
 		case RD_CMDSTREAM:
 			dump_cmdstream(buf, sz/4);
 			break;
 		case RD_PARAM:
-			printf("param: %s: %u\n", param_names[((uint32_t *)buf)[0]],
-					((uint32_t *)buf)[1]);
+			if ((sz < 8) || (((uint32_t *)buf)[0] >= ARRAY_SIZE(param_names)))
+				break;
+			if (!summary)
+				printf("param: %s: %u\n", param_names[((uint32_t *)buf)[0]],
+						((uint32_t *)buf)[1]);
 			break;
 		default:
 			break;
 		}
 	}
+
+	free(buf);
+	io_close(io);
+
+	dump_cost("total", &file_cost);
+
+	return 0;
 }
 
 int main(int argc, char **argv)
 {
-	int i;
+	int i, ret = 0;
 
 	for (i = 1; i < argc; i++) {
-		int fd = open(argv[i], O_RDONLY);
-		if (fd < 0) {
-			fprintf(stderr, "could not open: %s\n", argv[1]);
-			return -1;
+		if (!strcmp(argv[i], "--summary")) {
+			summary = 1;
+			continue;
 		}
-		dump_file(fd);
+		if (dump_file(argv[i]))
+			ret = -1;
 	}
 
-	return 0;
+	return ret;
 }